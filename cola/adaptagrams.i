@@ -294,6 +294,7 @@ void deleteDoubleArray(double* a) {
 %include "libavoid/geometry.h"
 %include "libavoid/geomtypes.h"
 %include "libavoid/connend.h"
+%include "libavoid/bulkload.h"
 %include "libavoid/router.h"
 %include "libavoid/connector.h"
 %include "libavoid/obstacle.h"
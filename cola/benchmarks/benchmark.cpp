@@ -0,0 +1,739 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * Adaptagrams benchmarks - synthetic diagrams for timing the libraries.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Times the libraries on synthetic diagrams of increasing size, writing one
+// JSON object per line for each run, for example:
+//
+//   adaptagrams_benchmark --suites avoid-orthogonal,cola --sizes 100,1000 --reps 3
+//
+// Run with --help for all the options and the suites. Each suite is run on
+// sizes from 100 up to 100000 shapes, but the libraries differ by orders of
+// magnitude in how far they scale, so each run has a time limit. Outside Windows,
+// each run is made in a child process, which is stopped at the time limit and
+// written out as timed out. Larger sizes of the same suite and generator are
+// skipped once the last run suggests that they would take longer than the limit,
+// taking the time to grow with the square of the size.
+//
+// Peak memory is measured for each run on Linux, where the peak can be reset,
+// and the memory in use at the start of the run is given too, since it counts
+// towards the peak. Elsewhere the peak is that of the whole process, which is
+// marked in the output; that is the run's own process when there is a time limit.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <climits>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "libvpsc/rectangle.h"
+#include "libvpsc/variable.h"
+#include "libvpsc/constraint.h"
+#include "libvpsc/solve_VPSC.h"
+#include "libavoid/libavoid.h"
+#include "libcola/cola.h"
+#include "libcola/cluster.h"
+#include "libdialect/graphs.h"
+#include "libdialect/opts.h"
+#include "libdialect/hola.h"
+
+#include "generators.h"
+
+using bench::Box;
+using bench::Diagram;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Settings shared by all suites.
+struct Settings {
+    // Threads for those steps that can use them, or zero to use none.
+    int threads = 0;
+};
+
+// The measurements from one run of a suite.
+struct Result {
+    double setupMs = 0;
+    double runMs = 0;
+    // Suite-specific counts, written as extra fields of the output.
+    vector<std::pair<string, double> > counts;
+};
+
+// Calls f, adding the wall time it takes to ms.
+template <typename F>
+void timed(double &ms, F f) {
+    Clock::time_point start = Clock::now();
+    f();
+    ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Resets the peak resident set size, if possible, after returning freed memory
+// to the system so that earlier runs are not counted.
+// Returns whether it was reset, so that peakMemoryKiB() measures from now.
+bool resetPeakMemory(void) {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+#ifdef __linux__
+    // Writing 5 to clear_refs resets the peak RSS, since Linux 4.0.
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (f == nullptr) return false;
+    bool reset = fputs("5", f) >= 0;
+    reset = (fclose(f) == 0) && reset;
+    return reset;
+#else
+    return false;
+#endif
+}
+
+// Returns the given field of /proc/self/status in KiB, or zero if it is not there.
+long statusKiB(const char *field) {
+    std::ifstream status("/proc/self/status");
+    string line;
+    size_t length = strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, field) == 0) return atol(line.c_str() + length);
+    }
+    return 0;
+}
+
+// Returns the resident set size in KiB, or zero if it is not known.
+long currentMemoryKiB(void) {
+#ifdef __linux__
+    return statusKiB("VmRSS:");
+#else
+    return 0;
+#endif
+}
+
+// Returns the peak resident set size in KiB, or zero if it is not known.
+long peakMemoryKiB(void) {
+#ifdef __linux__
+    long peak = statusKiB("VmHWM:");
+    if (peak > 0) return peak;
+#endif
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+vpsc::Rectangles makeRectangles(const Diagram &d, double scale = 1) {
+    vpsc::Rectangles rs;
+    for (const Box &b : d.shapes) {
+        double x = b.x*scale, y = b.y*scale;
+        rs.push_back(new vpsc::Rectangle(x, x + b.w, y, y + b.h));
+    }
+    return rs;
+}
+
+void deleteRectangles(vpsc::Rectangles &rs) {
+    for (vpsc::Rectangle *r : rs) delete r;
+    rs.clear();
+}
+
+// libvpsc: remove the overlaps made by moving the shapes to half their spacing.
+Result runVpscOverlap(const Diagram &d, const Settings &) {
+    Result result;
+    vpsc::Rectangles rs;
+    timed(result.setupMs, [&]() { rs = makeRectangles(d, 0.5); });
+    timed(result.runMs, [&]() { vpsc::removeoverlaps(rs); });
+    deleteRectangles(rs);
+    return result;
+}
+
+// libvpsc: in each dimension, pull the shapes to the origin, keeping those
+// joined by an edge separated in the order in which they were generated.
+Result runVpscSolve(const Diagram &d, const Settings &) {
+    Result result;
+    size_t numConstraints = 0;
+    for (unsigned dim = 0; dim < 2; ++dim) {
+        vpsc::Variables vs;
+        vpsc::Constraints cs;
+        vpsc::IncSolver *solver = nullptr;
+        timed(result.setupMs, [&]() {
+            for (size_t i = 0; i < d.shapes.size(); ++i) {
+                vs.push_back(new vpsc::Variable((int) i, 0));
+            }
+            for (const std::pair<unsigned, unsigned> &e : d.edges) {
+                const Box &a = d.shapes[e.first], &b = d.shapes[e.second];
+                double ca = dim == 0 ? a.centreX() : a.centreY(),
+                       cb = dim == 0 ? b.centreX() : b.centreY();
+                // Order by position, then index, so the constraints are acyclic.
+                bool forward = ca < cb || (ca == cb && e.first < e.second);
+                unsigned l = forward ? e.first : e.second, r = forward ? e.second : e.first;
+                double gap = dim == 0 ? (a.w + b.w)/2 : (a.h + b.h)/2;
+                cs.push_back(new vpsc::Constraint(vs[l], vs[r], gap));
+            }
+            solver = new vpsc::IncSolver(vs, cs);
+        });
+        timed(result.runMs, [&]() { solver->solve(); });
+        numConstraints += cs.size();
+        delete solver;
+        for (vpsc::Constraint *c : cs) delete c;
+        for (vpsc::Variable *v : vs) delete v;
+    }
+    result.counts.push_back(std::make_pair("constraints", (double) numConstraints));
+    return result;
+}
+
+// Adds the shapes, with connection pins of class 1, and optionally the clusters.
+vector<Avoid::ShapeRef *> addShapes(Avoid::Router *router, const Diagram &d, bool orthogonal, bool clusters) {
+    vector<Avoid::ShapeRef *> shapes;
+    for (const Box &b : d.shapes) {
+        Avoid::Rectangle rectangle(Avoid::Point(b.x, b.y), Avoid::Point(b.x + b.w, b.y + b.h));
+        Avoid::ShapeRef *shape = new Avoid::ShapeRef(router, rectangle);
+        vector<Avoid::ShapeConnectionPin *> pins;
+        if (orthogonal) {
+            // A pin in the middle of each side.
+            pins.push_back(new Avoid::ShapeConnectionPin(shape, 1, Avoid::ATTACH_POS_CENTRE,
+                    Avoid::ATTACH_POS_TOP, true, 0.0, Avoid::ConnDirUp));
+            pins.push_back(new Avoid::ShapeConnectionPin(shape, 1, Avoid::ATTACH_POS_CENTRE,
+                    Avoid::ATTACH_POS_BOTTOM, true, 0.0, Avoid::ConnDirDown));
+            pins.push_back(new Avoid::ShapeConnectionPin(shape, 1, Avoid::ATTACH_POS_LEFT,
+                    Avoid::ATTACH_POS_CENTRE, true, 0.0, Avoid::ConnDirLeft));
+            pins.push_back(new Avoid::ShapeConnectionPin(shape, 1, Avoid::ATTACH_POS_RIGHT,
+                    Avoid::ATTACH_POS_CENTRE, true, 0.0, Avoid::ConnDirRight));
+        } else {
+            pins.push_back(new Avoid::ShapeConnectionPin(shape, 1, Avoid::ATTACH_POS_CENTRE,
+                    Avoid::ATTACH_POS_CENTRE, true, 0.0, Avoid::ConnDirAll));
+        }
+        // Pins are shared, since hubs may have more connectors than pins.
+        for (Avoid::ShapeConnectionPin *pin : pins) pin->setExclusive(false);
+        shapes.push_back(shape);
+    }
+    for (size_t i = 0; clusters && i < d.clusters.size(); ++i) {
+        Box b = d.clusterBox(i);
+        Avoid::Rectangle rectangle(Avoid::Point(b.x, b.y), Avoid::Point(b.x + b.w, b.y + b.h));
+        new Avoid::ClusterRef(router, rectangle);
+    }
+    return shapes;
+}
+
+Avoid::Router *newRouter(Avoid::RouterFlag flags, const Settings &settings) {
+    Avoid::Router *router = new Avoid::Router(flags);
+    router->setProfilingEnabled(true);
+    router->setRoutingParameter(Avoid::routingThreadCount, settings.threads);
+    if (flags & Avoid::OrthogonalRouting) {
+        router->setRoutingParameter(Avoid::segmentPenalty, 50);
+        router->setRoutingParameter(Avoid::idealNudgingDistance, 4);
+        router->setRoutingOption(Avoid::nudgeOrthogonalSegmentsConnectedToShapes, true);
+    }
+    return router;
+}
+
+// Adds the size of the routing, and the router's profile of where the time went.
+void countRouting(Avoid::Router *router, Result &result) {
+    size_t points = 0;
+    for (Avoid::ConnRef *conn : router->connRefs) points += conn->displayRoute().size();
+    Avoid::RouterProfile profile = router->profile();
+    const std::pair<string, double> counts[] = {
+        {"connectors", (double) router->connRefs.size()},
+        {"route_points", (double) points},
+        {"orthogonal_visibility_ms", profile.orthogonalVisibilityGraph.wallTime},
+        {"route_search_ms", profile.routeSearch.wallTime},
+        {"crossing_detection_ms", profile.crossingDetection.wallTime},
+        {"reroute_search_ms", profile.rerouteSearch.wallTime},
+        {"nudging_ms", profile.orthogonalNudgingX.wallTime + profile.orthogonalNudgingY.wallTime},
+        {"hyperedge_ms", profile.hyperedgeForest.wallTime + profile.hyperedgeMTST.wallTime +
+                profile.hyperedgeInterleaved.wallTime + profile.hyperedgeImprovement.wallTime},
+        {"astar_searches", (double) profile.aStarSearches},
+        {"astar_expansions", (double) profile.aStarExpansions},
+    };
+    result.counts.insert(result.counts.end(), std::begin(counts), std::end(counts));
+}
+
+// libavoid: route a connector for each edge.
+Result runAvoidRouting(const Diagram &d, const Settings &settings, Avoid::RouterFlag flags, bool clusters) {
+    Result result;
+    Avoid::Router *router = nullptr;
+    timed(result.setupMs, [&]() {
+        router = newRouter(flags, settings);
+        vector<Avoid::ShapeRef *> shapes = addShapes(router, d, flags == Avoid::OrthogonalRouting, clusters);
+        for (const std::pair<unsigned, unsigned> &e : d.edges) {
+            new Avoid::ConnRef(router, Avoid::ConnEnd(shapes[e.first], 1), Avoid::ConnEnd(shapes[e.second], 1));
+        }
+    });
+    timed(result.runMs, [&]() { router->processTransaction(); });
+    countRouting(router, result);
+    delete router;
+    return result;
+}
+
+Result runAvoidPolyline(const Diagram &d, const Settings &settings) {
+    return runAvoidRouting(d, settings, Avoid::PolyLineRouting, false);
+}
+
+Result runAvoidOrthogonal(const Diagram &d, const Settings &settings) {
+    return runAvoidRouting(d, settings, Avoid::OrthogonalRouting, false);
+}
+
+Result runAvoidClusters(const Diagram &d, const Settings &settings) {
+    return runAvoidRouting(d, settings, Avoid::OrthogonalRouting, true);
+}
+
+// libavoid: route each hyperedge as a tree, choosing its junctions.
+Result runAvoidHyperedge(const Diagram &d, const Settings &settings) {
+    Result result;
+    Avoid::Router *router = nullptr;
+    timed(result.setupMs, [&]() {
+        router = newRouter(Avoid::OrthogonalRouting, settings);
+        vector<Avoid::ShapeRef *> shapes = addShapes(router, d, true, false);
+        for (const vector<unsigned> &hyperedge : d.hyperedges) {
+            Avoid::ConnEndList terminals;
+            for (unsigned s : hyperedge) terminals.push_back(Avoid::ConnEnd(shapes[s], 1));
+            router->hyperedgeRerouter()->registerHyperedgeForRerouting(terminals);
+        }
+    });
+    timed(result.runMs, [&]() { router->processTransaction(); });
+    countRouting(router, result);
+    delete router;
+    return result;
+}
+
+// libcola: lay out with overlap prevention, either with clusters and the
+// exact stress function, or with the options for large graphs.
+Result runColaLayout(const Diagram &d, bool scalable) {
+    Result result;
+    vpsc::Rectangles rs;
+    cola::RootCluster *root = nullptr;
+    cola::ConstrainedFDLayout *layout = nullptr;
+    timed(result.setupMs, [&]() {
+        rs = makeRectangles(d);
+        vector<cola::Edge> es(d.edges.begin(), d.edges.end());
+        layout = new cola::ConstrainedFDLayout(rs, es, 100);
+        layout->setAvoidNodeOverlaps(true);
+        if (scalable) {
+            layout->setUseApproximateStress(true);
+            layout->setUsePivotDistances(50);
+            layout->setUseNonOverlapCandidatePairs(true);
+            layout->setUseMultilevel(true);
+        } else {
+            root = new cola::RootCluster();
+            for (const vector<unsigned> &members : d.clusters) {
+                cola::RectangularCluster *cluster = new cola::RectangularCluster();
+                for (unsigned s : members) cluster->addChildNode(s);
+                root->addChildCluster(cluster);
+            }
+            layout->setClusterHierarchy(root);
+        }
+    });
+    timed(result.runMs, [&]() { layout->run(); });
+    delete layout;
+    delete root;
+    deleteRectangles(rs);
+    return result;
+}
+
+Result runCola(const Diagram &d, const Settings &) {
+    return runColaLayout(d, false);
+}
+
+Result runColaScalable(const Diagram &d, const Settings &) {
+    return runColaLayout(d, true);
+}
+
+// libdialect: HOLA layout, with the time for each of its stages.
+Result runHola(const Diagram &d, const Settings &settings) {
+    Result result;
+    dialect::Graph graph;
+    timed(result.setupMs, [&]() {
+        vector<dialect::Node_SP> nodes;
+        for (const Box &b : d.shapes) nodes.push_back(graph.addNode(b.centreX(), b.centreY(), b.w, b.h));
+        for (const std::pair<unsigned, unsigned> &e : d.edges) graph.addEdge(nodes[e.first], nodes[e.second]);
+    });
+    dialect::HolaOpts opts;
+    opts.treePlacement_concurrentEstimates = std::max(1, settings.threads);
+    opts.treePlacement_concurrentExpansions = std::max(1, settings.threads);
+    dialect::HolaStats stats;
+    timed(result.runMs, [&]() { dialect::doHOLA(graph, opts, nullptr, &stats); });
+    for (const dialect::HolaStageStats &stage : stats.stages) {
+        result.counts.push_back(std::make_pair("stage_" + stage.name + "_ms", stage.wallTimeMs));
+    }
+    return result;
+}
+
+struct Suite {
+    const char *name;
+    const char *description;
+    Result (*run)(const Diagram &d, const Settings &settings);
+};
+
+const vector<Suite> suites = {
+    {"vpsc-overlap", "libvpsc overlap removal", runVpscOverlap},
+    {"vpsc-solve", "libvpsc IncSolver on edge separation constraints", runVpscSolve},
+    {"avoid-polyline", "libavoid poly-line routing of each edge", runAvoidPolyline},
+    {"avoid-orthogonal", "libavoid orthogonal routing of each edge", runAvoidOrthogonal},
+    {"avoid-clusters", "libavoid orthogonal routing of each edge, with cluster boundaries",
+        runAvoidClusters},
+    {"avoid-hyperedge", "libavoid orthogonal hyperedge routing", runAvoidHyperedge},
+    {"cola", "libcola layout with clusters and overlap prevention", runCola},
+    {"cola-scalable", "libcola layout with approximate stress, pivots and multilevel",
+        runColaScalable},
+    {"hola", "libdialect HOLA layout", runHola},
+};
+
+const vector<unsigned> defaultSizes = {100, 300, 1000, 3000, 10000, 30000, 100000};
+
+string jsonString(const string &s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+string jsonNumber(double x) {
+    char buffer[64];
+    snprintf(buffer, sizeof buffer, "%.3f", x);
+    // Trim trailing zeros so that counts are written as integers.
+    string s = buffer;
+    s.erase(s.find_last_not_of('0') + 1);
+    if (s.back() == '.') s.pop_back();
+    return s;
+}
+
+vector<string> splitList(const string &list) {
+    vector<string> items;
+    std::istringstream in(list);
+    string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parseUnsigned(const string &s, unsigned &value) {
+    if (s.empty() || s.find_first_not_of("0123456789") != string::npos) return false;
+    value = (unsigned) strtoul(s.c_str(), nullptr, 10);
+    return true;
+}
+
+void printUsage(std::ostream &out) {
+    out << "Usage: adaptagrams_benchmark [options]\n"
+           "  --suites NAME,...      suites to run (default: all)\n"
+           "  --generators NAME,...  diagram generators (default: all)\n"
+           "  --sizes N,...          numbers of shapes (default: 100,300,...,100000)\n"
+           "  --time-limit SECONDS   longest time for each run (default: 60, 0 for no\n"
+           "                         limit, running everything in this process)\n"
+           "  --reps N               runs of each case (default: 1)\n"
+           "  --seed N               seed for the generators (default: 1)\n"
+           "  --threads N            threads for routing and HOLA tree placement (default: 0)\n"
+           "  --output FILE          write results to FILE instead of standard output\n"
+           "\nSuites:\n";
+    for (const Suite &suite : suites) {
+        out << "  " << suite.name << ": " << suite.description << "\n";
+    }
+    out << "\nGenerators:";
+    for (const string &name : bench::generatorNames()) out << " " << name;
+    out << "\n";
+}
+
+// The outcome of one run of a suite.
+struct Run {
+    bool ok = false;
+    bool timedOut = false;
+    string error;
+    // The setup and run time together.
+    double ms = 0;
+    // Output fields for the measurements, each starting with a comma.
+    string fields;
+};
+
+// Runs the suite once in this process.
+Run runHere(const Suite &suite, const Diagram &d, const Settings &settings) {
+    Run run;
+    bool peakIsPerRun = resetPeakMemory();
+    long start = currentMemoryKiB();
+    Result result;
+    try {
+        result = suite.run(d, settings);
+        run.ok = true;
+    } catch (const std::exception &e) {
+        run.error = e.what();
+    }
+    long peak = peakMemoryKiB();
+
+    std::ostringstream fields;
+    if (run.ok) {
+        run.ms = result.setupMs + result.runMs;
+        fields << ",\"setup_ms\":" << jsonNumber(result.setupMs)
+               << ",\"run_ms\":" << jsonNumber(result.runMs);
+        for (const std::pair<string, double> &count : result.counts) {
+            fields << "," << jsonString(count.first) << ":" << jsonNumber(count.second);
+        }
+    } else {
+        fields << ",\"error\":" << jsonString(run.error);
+    }
+    fields << ",\"start_rss_kib\":" << start << ",\"peak_rss_kib\":" << peak
+           << ",\"peak_rss_scope\":" << jsonString(peakIsPerRun ? "run" : "process");
+    run.fields = fields.str();
+    return run;
+}
+
+#ifndef _WIN32
+// Runs the suite once in a child process, which is killed if it takes longer
+// than timeLimit seconds. It also keeps a crash from ending the other runs.
+Run runInChild(const Suite &suite, const Diagram &d, const Settings &settings,
+        unsigned timeLimit) {
+    int fds[2];
+    if (pipe(fds) != 0) return runHere(suite, d, settings);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return runHere(suite, d, settings);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        Run run = runHere(suite, d, settings);
+        // The first line gives the outcome, and the second the fields.
+        string message = (run.ok ? "ok " + jsonNumber(run.ms) : "error " + run.error) +
+                "\n" + run.fields;
+        for (size_t done = 0; done < message.size(); ) {
+            ssize_t written = write(fds[1], message.data() + done, message.size() - done);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) break;
+            done += written;
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+
+    string message;
+    bool timedOut = false;
+    Clock::time_point deadline = Clock::now() + std::chrono::seconds(timeLimit);
+    for (;;) {
+        long remaining = (long) std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - Clock::now()).count();
+        pollfd readable = {fds[0], POLLIN, 0};
+        int ready = remaining > 0 ? poll(&readable, 1, (int) std::min(remaining, (long) INT_MAX)) : 0;
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) {
+            timedOut = true;
+            break;
+        }
+        char buffer[4096];
+        ssize_t got = read(fds[0], buffer, sizeof buffer);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        message.append(buffer, got);
+    }
+    close(fds[0]);
+    if (timedOut) kill(pid, SIGKILL);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+    Run run;
+    if (timedOut) {
+        run.timedOut = true;
+        run.ms = timeLimit*1000.0;
+        run.fields = ",\"timed_out\":true";
+        return run;
+    }
+    size_t newline = message.find('\n');
+    if (!WIFEXITED(status) || newline == string::npos) {
+        run.error = WIFSIGNALED(status) ?
+                "killed by signal " + std::to_string(WTERMSIG(status)) : "no result";
+        run.fields = ",\"error\":" + jsonString(run.error);
+        return run;
+    }
+    run.ok = message.compare(0, 3, "ok ") == 0;
+    if (run.ok) {
+        run.ms = atof(message.c_str() + 3);
+    } else {
+        run.error = message.substr(6, newline - 6);
+    }
+    run.fields = message.substr(newline + 1);
+    return run;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    vector<string> suiteNames, generatorNames = bench::generatorNames();
+    vector<unsigned> sizes = defaultSizes;
+    unsigned reps = 1, seed = 1, threads = 0, timeLimit = 60;
+    string outputPath;
+    for (const Suite &suite : suites) suiteNames.push_back(suite.name);
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(std::cout);
+            return 0;
+        }
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return 1;
+        }
+        string value = argv[++i];
+        bool ok = true;
+        if (arg == "--suites") {
+            suiteNames = splitList(value);
+        } else if (arg == "--generators") {
+            generatorNames = splitList(value);
+        } else if (arg == "--sizes") {
+            sizes.clear();
+            for (const string &item : splitList(value)) {
+                unsigned n = 0;
+                ok = ok && parseUnsigned(item, n) && n > 0;
+                sizes.push_back(n);
+            }
+        } else if (arg == "--reps") {
+            ok = parseUnsigned(value, reps);
+        } else if (arg == "--seed") {
+            ok = parseUnsigned(value, seed);
+        } else if (arg == "--time-limit") {
+            ok = parseUnsigned(value, timeLimit);
+        } else if (arg == "--threads") {
+            ok = parseUnsigned(value, threads);
+        } else if (arg == "--output") {
+            outputPath = value;
+        } else {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage(std::cerr);
+            return 1;
+        }
+        if (!ok) {
+            std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+            return 1;
+        }
+    }
+
+    // Sizes are run in increasing order, so that each can be judged by the last.
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+    vector<const Suite *> selected;
+    for (const string &name : suiteNames) {
+        auto it = std::find_if(suites.begin(), suites.end(),
+                [&name](const Suite &suite) { return name == suite.name; });
+        if (it == suites.end()) {
+            std::cerr << "Unknown suite " << name << "\n";
+            return 1;
+        }
+        selected.push_back(&*it);
+    }
+    for (const string &name : generatorNames) {
+        const vector<string> known = bench::generatorNames();
+        if (std::find(known.begin(), known.end(), name) == known.end()) {
+            std::cerr << "Unknown generator " << name << "\n";
+            return 1;
+        }
+    }
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath.c_str());
+        if (!file) {
+            std::cerr << "Cannot write to " << outputPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream &out = outputPath.empty() ? std::cout : file;
+
+    Settings settings;
+    settings.threads = (int) threads;
+    int failures = 0;
+    for (const Suite *suite : selected) {
+        for (const string &generator : generatorNames) {
+            // The size and time of the last run, from which to guess the next.
+            unsigned lastSize = 0;
+            double lastMs = 0;
+            for (unsigned n : sizes) {
+                double growth = (double) n/std::max(lastSize, 1u);
+                if (timeLimit != 0 && lastSize != 0 && lastMs*growth*growth > timeLimit*1000.0) {
+                    std::cerr << suite->name << " " << generator << " " << n
+                              << " and larger: skipped, expected to take over " << timeLimit << " s\n";
+                    break;
+                }
+                Diagram d = bench::generate(generator, n, seed);
+                for (unsigned rep = 0; rep < reps; ++rep) {
+                    std::cerr << suite->name << " " << generator << " " << n << " #" << rep << ": " << std::flush;
+                    out.flush();
+                    Run run;
+#ifndef _WIN32
+                    if (timeLimit != 0) {
+                        run = runInChild(*suite, d, settings, timeLimit);
+                    } else
+#endif
+                    {
+                        run = runHere(*suite, d, settings);
+                    }
+
+                    out << "{\"suite\":" << jsonString(suite->name)
+                        << ",\"generator\":" << jsonString(generator)
+                        << ",\"size\":" << n << ",\"seed\":" << seed << ",\"rep\":" << rep
+                        << ",\"threads\":" << threads
+                        << ",\"shapes\":" << d.shapes.size() << ",\"edges\":" << d.edges.size()
+                        << ",\"clusters\":" << d.clusters.size() << ",\"hyperedges\":" << d.hyperedges.size()
+                        << run.fields << "}\n";
+                    out.flush();
+
+                    if (run.ok) {
+                        std::cerr << jsonNumber(run.ms) << " ms\n";
+                    } else if (run.timedOut) {
+                        std::cerr << "stopped at the time limit\n";
+                    } else {
+                        std::cerr << "failed: " << run.error << "\n";
+                        ++failures;
+                        continue;
+                    }
+                    lastSize = n;
+                    lastMs = run.ms;
+                    if (run.timedOut) break;
+                }
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
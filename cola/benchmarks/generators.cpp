@@ -0,0 +1,283 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * Adaptagrams benchmarks - synthetic diagrams for timing the libraries.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "generators.h"
+
+namespace bench {
+
+namespace {
+
+// Distance between the corners of neighbouring lattice cells. Each shape sits
+// inside one cell, leaving a gap of at least cellGap to the next cell.
+const double cellPitch = 100;
+const double cellGap = 10;
+// Clusters are made from square tiles of this many cells along each side.
+const unsigned clusterTile = 4;
+
+typedef std::mt19937 Random;
+
+// A lattice of cells, each holding at most one shape.
+struct Lattice {
+    Lattice(unsigned columns, unsigned rows)
+        : columns(columns), rows(rows), shapeAt(columns*rows, -1) {}
+
+    unsigned columns;
+    unsigned rows;
+    // The shape in each cell, or -1 if it is empty.
+    std::vector<int> shapeAt;
+    // The cell of each shape.
+    std::vector<unsigned> cellOf;
+
+    void place(unsigned cell) {
+        shapeAt[cell] = (int) cellOf.size();
+        cellOf.push_back(cell);
+    }
+
+    // Calls f(shape) for each shape within the given number of cells of the
+    // cell of shape s in each dimension, besides s itself.
+    template <typename F>
+    void forEachNearby(unsigned s, unsigned reach, F f) const {
+        int cx = cellOf[s] % columns, cy = cellOf[s] / columns, r = (int) reach;
+        for (int y = std::max(0, cy - r); y <= std::min((int) rows - 1, cy + r); ++y) {
+            for (int x = std::max(0, cx - r); x <= std::min((int) columns - 1, cx + r); ++x) {
+                int t = shapeAt[y*columns + x];
+                if (t >= 0 && t != (int) s) f((unsigned) t);
+            }
+        }
+    }
+};
+
+unsigned sideFor(unsigned cells) {
+    return std::max(1u, (unsigned) std::ceil(std::sqrt((double) cells)));
+}
+
+// Places n shapes in distinct cells, chosen at random from about twice as many.
+Lattice scatterCells(unsigned n, Random &rng) {
+    unsigned side = sideFor(2*n);
+    Lattice lattice(side, side);
+    std::vector<unsigned> cells(side*side);
+    for (unsigned i = 0; i < cells.size(); ++i) cells[i] = i;
+    // A partial Fisher-Yates shuffle chooses the first n.
+    for (unsigned i = 0; i < n; ++i) {
+        std::uniform_int_distribution<unsigned> pick(i, (unsigned) cells.size() - 1);
+        std::swap(cells[i], cells[pick(rng)]);
+        lattice.place(cells[i]);
+    }
+    return lattice;
+}
+
+// Places the next shape in a free cell as close as possible to the cell of
+// shape t, choosing at random among the closest.
+void placeNear(Lattice &lattice, unsigned t, Random &rng) {
+    int cx = lattice.cellOf[t] % lattice.columns, cy = lattice.cellOf[t] / lattice.columns;
+    std::vector<unsigned> free;
+    for (int r = 1; free.empty(); ++r) {
+        // The cells of the square ring at distance r.
+        for (int y = cy - r; y <= cy + r; ++y) {
+            if (y < 0 || y >= (int) lattice.rows) continue;
+            int step = (y == cy - r || y == cy + r) ? 1 : 2*r;
+            for (int x = cx - r; x <= cx + r; x += step) {
+                if (x < 0 || x >= (int) lattice.columns) continue;
+                unsigned cell = y*lattice.columns + x;
+                if (lattice.shapeAt[cell] < 0) free.push_back(cell);
+            }
+        }
+    }
+    std::uniform_int_distribution<size_t> pick(0, free.size() - 1);
+    lattice.place(free[pick(rng)]);
+}
+
+// Makes a shape of random size at a random position in each occupied cell.
+void addRandomShapes(Diagram &d, const Lattice &lattice, Random &rng) {
+    std::uniform_real_distribution<double> width(30, 50), height(20, 30), unit(0, 1);
+    for (unsigned cell : lattice.cellOf) {
+        Box b;
+        b.w = width(rng);
+        b.h = height(rng);
+        b.x = (cell % lattice.columns)*cellPitch + unit(rng)*(cellPitch - cellGap - b.w);
+        b.y = (cell / lattice.columns)*cellPitch + unit(rng)*(cellPitch - cellGap - b.h);
+        d.shapes.push_back(b);
+    }
+}
+
+// Makes clusters of the shapes in alternate tiles of the lattice, in a
+// checkerboard pattern, and hyperedges among nearby shapes, for one in ten shapes.
+void addGroups(Diagram &d, const Lattice &lattice, Random &rng) {
+    unsigned tileColumns = (lattice.columns + clusterTile - 1)/clusterTile;
+    unsigned tileRows = (lattice.rows + clusterTile - 1)/clusterTile;
+    std::vector<std::vector<unsigned> > tiles(tileColumns*tileRows);
+    for (unsigned s = 0; s < lattice.cellOf.size(); ++s) {
+        unsigned cell = lattice.cellOf[s];
+        unsigned tx = (cell % lattice.columns)/clusterTile, ty = (cell / lattice.columns)/clusterTile;
+        if ((tx + ty) % 2 == 0) tiles[ty*tileColumns + tx].push_back(s);
+    }
+    for (std::vector<unsigned> &tile : tiles) {
+        if (tile.size() >= 2) d.clusters.push_back(tile);
+    }
+
+    unsigned n = (unsigned) d.shapes.size();
+    std::uniform_int_distribution<unsigned> anyShape(0, n - 1), terminals(3, 5);
+    for (unsigned h = 0; h < n/10; ++h) {
+        unsigned s = anyShape(rng);
+        std::vector<unsigned> nearby;
+        lattice.forEachNearby(s, 2, [&nearby](unsigned t) { nearby.push_back(t); });
+        unsigned k = std::min(terminals(rng) - 1, (unsigned) nearby.size());
+        if (k < 2) continue;
+        std::vector<unsigned> hyperedge(1, s);
+        for (unsigned i = 0; i < k; ++i) {
+            std::uniform_int_distribution<unsigned> pick(i, (unsigned) nearby.size() - 1);
+            std::swap(nearby[i], nearby[pick(rng)]);
+            hyperedge.push_back(nearby[i]);
+        }
+        d.hyperedges.push_back(hyperedge);
+    }
+}
+
+// Union-find root of shape s, halving paths as it goes.
+unsigned findRoot(std::vector<unsigned> &parent, unsigned s) {
+    while (parent[s] != s) {
+        parent[s] = parent[parent[s]];
+        s = parent[s];
+    }
+    return s;
+}
+
+} // namespace
+
+Box Diagram::clusterBox(size_t i) const {
+    double x0 = HUGE_VAL, y0 = HUGE_VAL, x1 = -HUGE_VAL, y1 = -HUGE_VAL;
+    for (unsigned s : clusters[i]) {
+        const Box &b = shapes[s];
+        x0 = std::min(x0, b.x);
+        y0 = std::min(y0, b.y);
+        x1 = std::max(x1, b.x + b.w);
+        y1 = std::max(y1, b.y + b.h);
+    }
+    Box b = {x0 - clusterPadding, y0 - clusterPadding,
+             x1 - x0 + 2*clusterPadding, y1 - y0 + 2*clusterPadding};
+    return b;
+}
+
+Diagram generateGrid(unsigned n, unsigned seed) {
+    Random rng(seed);
+    Diagram d;
+    d.generator = "grid";
+    unsigned columns = sideFor(n);
+    Lattice lattice(columns, (n + columns - 1)/columns);
+    for (unsigned i = 0; i < n; ++i) {
+        lattice.place(i);
+        Box b = {(i % columns)*cellPitch, (i / columns)*cellPitch, 40, 30};
+        d.shapes.push_back(b);
+        if (i % columns != 0) d.edges.push_back(std::make_pair(i - 1, i));
+        if (i >= columns) d.edges.push_back(std::make_pair(i - columns, i));
+    }
+    addGroups(d, lattice, rng);
+    return d;
+}
+
+Diagram generateRandomGeometric(unsigned n, unsigned seed) {
+    Random rng(seed);
+    Diagram d;
+    d.generator = "geometric";
+    Lattice lattice = scatterCells(n, rng);
+    addRandomShapes(d, lattice, rng);
+    // With shapes in half the cells, joining centres within 1.6 cells gives an
+    // average degree of about four. Centres three cells apart in either dimension
+    // are further apart than that, so a reach of two cells finds all the edges.
+    const double radius = 1.6*cellPitch;
+    std::vector<unsigned> parent(n);
+    for (unsigned s = 0; s < n; ++s) parent[s] = s;
+    for (unsigned s = 0; s < n; ++s) {
+        const Box &a = d.shapes[s];
+        lattice.forEachNearby(s, 2, [&](unsigned t) {
+            if (t < s) return;
+            const Box &b = d.shapes[t];
+            double dx = a.centreX() - b.centreX(), dy = a.centreY() - b.centreY();
+            if (dx*dx + dy*dy <= radius*radius) {
+                d.edges.push_back(std::make_pair(s, t));
+                parent[findRoot(parent, s)] = findRoot(parent, t);
+            }
+        });
+    }
+    // Join each component to the one found before it.
+    int previous = -1;
+    for (unsigned s = 0; s < n; ++s) {
+        if (findRoot(parent, s) != s) continue;
+        if (previous >= 0) {
+            d.edges.push_back(std::make_pair((unsigned) previous, s));
+        }
+        previous = (int) s;
+    }
+    addGroups(d, lattice, rng);
+    return d;
+}
+
+Diagram generateScaleFree(unsigned n, unsigned seed) {
+    Random rng(seed);
+    Diagram d;
+    d.generator = "scalefree";
+    unsigned side = sideFor(2*n);
+    Lattice lattice(side, side);
+    lattice.place((side/2)*side + side/2);
+    // Each shape appears in ends once for each edge it is on, so choosing from
+    // ends chooses shapes in proportion to their degrees.
+    std::vector<unsigned> ends;
+    if (n >= 2) {
+        placeNear(lattice, 0, rng);
+        d.edges.push_back(std::make_pair(0u, 1u));
+        ends.push_back(0);
+        ends.push_back(1);
+    }
+    for (unsigned s = 2; s < n; ++s) {
+        std::uniform_int_distribution<size_t> pick(0, ends.size() - 1);
+        unsigned t0 = ends[pick(rng)], t1 = t0;
+        // The first shapes have too few neighbours to be sure of a second one.
+        if (s > 2) {
+            while (t1 == t0) t1 = ends[pick(rng)];
+        }
+        // Each shape goes next to the first it is joined to, as in a layout.
+        placeNear(lattice, t0, rng);
+        for (unsigned t : {t0, t1}) {
+            d.edges.push_back(std::make_pair(t, s));
+            ends.push_back(t);
+            ends.push_back(s);
+            if (t1 == t0) break;
+        }
+    }
+    addRandomShapes(d, lattice, rng);
+    addGroups(d, lattice, rng);
+    return d;
+}
+
+std::vector<std::string> generatorNames(void) {
+    return std::vector<std::string>{"grid", "geometric", "scalefree"};
+}
+
+Diagram generate(const std::string &name, unsigned n, unsigned seed) {
+    if (name == "grid") return generateGrid(n, seed);
+    if (name == "geometric") return generateRandomGeometric(n, seed);
+    if (name == "scalefree") return generateScaleFree(n, seed);
+    throw std::invalid_argument("unknown generator: " + name);
+}
+
+} // namespace bench
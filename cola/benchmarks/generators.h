@@ -0,0 +1,95 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * Adaptagrams benchmarks - synthetic diagrams for timing the libraries.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#ifndef BENCHMARKS_GENERATORS_H
+#define BENCHMARKS_GENERATORS_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace bench {
+
+//! @brief  An axis-aligned box, given by its top-left corner and its size.
+struct Box {
+    double x;
+    double y;
+    double w;
+    double h;
+
+    double centreX(void) const { return x + w/2; }
+    double centreY(void) const { return y + h/2; }
+};
+
+//! @brief  A synthetic diagram, independent of any of the libraries, from
+//!         which each benchmark builds its own input.
+//!
+//! Shapes never overlap one another, and the graph formed by the shapes
+//! and edges is connected.
+struct Diagram {
+    //! The name of the generator that made this diagram.
+    std::string generator;
+    std::vector<Box> shapes;
+    //! Pairs of shape indices, with no loops or repeated edges.
+    std::vector<std::pair<unsigned, unsigned> > edges;
+    //! Disjoint groups of nearby shapes, each of at least two shapes, whose
+    //! bounding boxes, padded by clusterPadding, do not overlap.
+    std::vector<std::vector<unsigned> > clusters;
+    //! Groups of three to five nearby shapes to be joined by a hyperedge.
+    std::vector<std::vector<unsigned> > hyperedges;
+
+    //! @brief  Get the bounding box of the given cluster, padded by clusterPadding.
+    Box clusterBox(size_t i) const;
+};
+
+//! Gap left around the shapes of a cluster by Diagram::clusterBox().
+const double clusterPadding = 4;
+
+//! @brief  Generate a square grid of shapes, each joined to its neighbours
+//!         to the right and below.
+//! @param[in] n  The number of shapes.
+//! @param[in] seed  Seed for the random choice of clusters and hyperedges.
+Diagram generateGrid(unsigned n, unsigned seed);
+
+//! @brief  Generate a random geometric graph: shapes of random sizes placed
+//!         at random, with edges joining shapes whose centres are within about
+//!         1.6 times the average spacing, so the average degree is about four.
+//!         Components are then joined in turn to make the graph connected.
+//! @param[in] n  The number of shapes.
+//! @param[in] seed  Seed for the random generator.
+Diagram generateRandomGeometric(unsigned n, unsigned seed);
+
+//! @brief  Generate a scale-free graph by preferential attachment (the
+//!         Barabasi-Albert model), with each new shape joined to two existing
+//!         ones. Each shape is placed in a free cell as close as possible to
+//!         the first shape it is joined to, so most edges are short but the
+//!         hubs have some long ones, as in a drawn diagram.
+//! @param[in] n  The number of shapes.
+//! @param[in] seed  Seed for the random generator.
+Diagram generateScaleFree(unsigned n, unsigned seed);
+
+//! @brief  Get the names of all generators, as accepted by generate().
+std::vector<std::string> generatorNames(void);
+
+//! @brief  Generate a diagram with the named generator.
+//! @throws  std::invalid_argument if there is no generator of that name.
+Diagram generate(const std::string &name, unsigned n, unsigned seed);
+
+} // namespace bench
+
+#endif // BENCHMARKS_GENERATORS_H
@@ -0,0 +1,91 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <cstdint>
+
+#include "libavoid/bulkload.h"
+
+namespace Avoid {
+
+
+// The shape index of a free-floating endpoint.
+static const size_t unattachedShapeIndex = SIZE_MAX;
+
+
+BulkShape::BulkShape(const Polygon& poly, const unsigned int id)
+    : polygon(poly),
+      id(id)
+{
+}
+
+
+BulkPin::BulkPin(const size_t shapeIndex, const unsigned int classId,
+        const double xOffset, const double yOffset, const bool proportional,
+        const double insideOffset, const ConnDirFlags visDirs)
+    : shapeIndex(shapeIndex),
+      classId(classId),
+      xOffset(xOffset),
+      yOffset(yOffset),
+      proportional(proportional),
+      insideOffset(insideOffset),
+      visDirs(visDirs)
+{
+}
+
+
+BulkConnEnd::BulkConnEnd(const Point& point, const ConnDirFlags visDirs)
+    : point(point),
+      visDirs(visDirs),
+      shapeIndex(unattachedShapeIndex),
+      pinClassId(0)
+{
+}
+
+
+BulkConnEnd::BulkConnEnd(const size_t shapeIndex,
+        const unsigned int pinClassId)
+    : visDirs(ConnDirNone),
+      shapeIndex(shapeIndex),
+      pinClassId(pinClassId)
+{
+}
+
+
+bool BulkConnEnd::isAttached(void) const
+{
+    return shapeIndex != unattachedShapeIndex;
+}
+
+
+BulkConnector::BulkConnector(const BulkConnEnd& src, const BulkConnEnd& dst,
+        const unsigned int id, const ConnType type)
+    : src(src),
+      dst(dst),
+      id(id),
+      type(type)
+{
+}
+
+
+}
+
@@ -0,0 +1,186 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+//! @file    bulkload.h
+//! @brief   Contains the descriptions of objects passed to
+//!          Router::bulkLoad().
+
+
+#ifndef AVOID_BULKLOAD_H
+#define AVOID_BULKLOAD_H
+
+#include <cstddef>
+#include <vector>
+
+#include "libavoid/dllexport.h"
+#include "libavoid/geomtypes.h"
+#include "libavoid/connend.h"
+#include "libavoid/connector.h"
+
+namespace Avoid {
+
+class ShapeRef;
+class ShapeConnectionPin;
+
+
+//! @brief  A description of a shape to be created by Router::bulkLoad().
+//!
+class AVOID_EXPORT BulkShape
+{
+    public:
+        //! @brief  Describes a shape with the given boundary.
+        //!
+        //! @param[in]  poly  A Polygon representing the boundary of the
+        //!                   shape.
+        //! @param[in]  id    Optionally, a positive integer ID unique
+        //!                   among all objects.
+        //!
+        BulkShape(const Polygon& poly, const unsigned int id = 0);
+
+        //! The boundary of the shape.
+        Polygon polygon;
+        //! The ID of the shape, or zero to have the router assign one.
+        unsigned int id;
+};
+
+
+//! @brief  A description of a connection pin to be created by
+//!         Router::bulkLoad() on one of the shapes passed with it.
+//!
+//! The parameters are those of the ShapeConnectionPin constructor, with
+//! the shape given by its index in the list of shapes.
+//!
+class AVOID_EXPORT BulkPin
+{
+    public:
+        //! @brief  Describes a connection pin.
+        //!
+        //! @param[in]  shapeIndex    The index of the shape the pin is on.
+        //! @param[in]  classId       A non-zero integer identifier for the
+        //!                           pin class.
+        //! @param[in]  xOffset       The x offset of the pin from the left
+        //!                           side of the shape.
+        //! @param[in]  yOffset       The y offset of the pin from the top
+        //!                           side of the shape.
+        //! @param[in]  proportional  Whether the offsets are proportions
+        //!                           of the shape's width and height,
+        //!                           rather than absolute distances.
+        //! @param[in]  insideOffset  The offset of the pin from the
+        //!                           boundary into the shape.
+        //! @param[in]  visDirs       One or more Avoid::ConnDirFlag options
+        //!                           giving the directions connectors may
+        //!                           leave the pin.
+        //!
+        BulkPin(const size_t shapeIndex, const unsigned int classId,
+                const double xOffset, const double yOffset,
+                const bool proportional, const double insideOffset,
+                const ConnDirFlags visDirs);
+
+        size_t shapeIndex;
+        unsigned int classId;
+        double xOffset;
+        double yOffset;
+        bool proportional;
+        double insideOffset;
+        ConnDirFlags visDirs;
+};
+
+
+//! @brief  A description of a connector endpoint for Router::bulkLoad(),
+//!         either a free-floating point or a pin class on one of the
+//!         shapes passed with it.
+//!
+class AVOID_EXPORT BulkConnEnd
+{
+    public:
+        //! @brief  Describes an endpoint at a free-floating point.
+        //!
+        //! @param[in]  point    The position of the connector endpoint.
+        //! @param[in]  visDirs  One or more Avoid::ConnDirFlag options
+        //!                      giving the directions the connector may
+        //!                      leave the point.
+        //!
+        BulkConnEnd(const Point& point,
+                const ConnDirFlags visDirs = ConnDirAll);
+
+        //! @brief  Describes an endpoint attached to a connection pin
+        //!         class on a shape.
+        //!
+        //! @param[in]  shapeIndex    The index of the shape.
+        //! @param[in]  pinClassId    The class of pins on the shape to
+        //!                           attach to.
+        //!
+        BulkConnEnd(const size_t shapeIndex, const unsigned int pinClassId);
+
+        //! @brief  Returns whether this endpoint is attached to a shape.
+        bool isAttached(void) const;
+
+        Point point;
+        ConnDirFlags visDirs;
+        size_t shapeIndex;
+        unsigned int pinClassId;
+};
+
+
+//! @brief  A description of a connector to be created by
+//!         Router::bulkLoad().
+//!
+class AVOID_EXPORT BulkConnector
+{
+    public:
+        //! @brief  Describes a connector between two endpoints.
+        //!
+        //! @param[in]  src   The source endpoint.
+        //! @param[in]  dst   The destination endpoint.
+        //! @param[in]  id    Optionally, a positive integer ID unique
+        //!                   among all objects.
+        //! @param[in]  type  Optionally, the routing type for the
+        //!                   connector.  If ConnType_None, the router's
+        //!                   default type is used.
+        //!
+        BulkConnector(const BulkConnEnd& src, const BulkConnEnd& dst,
+                const unsigned int id = 0,
+                const ConnType type = ConnType_None);
+
+        BulkConnEnd src;
+        BulkConnEnd dst;
+        unsigned int id;
+        ConnType type;
+};
+
+
+//! @brief  The objects created by Router::bulkLoad(), each in the order
+//!         of the descriptions they were created from.
+//!
+class AVOID_EXPORT BulkLoadResult
+{
+    public:
+        std::vector<ShapeRef *> shapes;
+        std::vector<ShapeConnectionPin *> pins;
+        std::vector<ConnRef *> connectors;
+};
+
+
+}
+
+#endif
@@ -56,13 +56,15 @@ ConnRef::ConnRef(Router *router, const unsigned int id)
       m_hate_crossings(false),
       m_has_fixed_route(false),
       m_route_dist(0),
+      m_connrefs_order(0),
       m_src_vert(nullptr),
       m_dst_vert(nullptr),
       m_start_vert(nullptr),
       m_callback_func(nullptr),
       m_connector(nullptr),
       m_src_connend(nullptr),
-      m_dst_connend(nullptr)
+      m_dst_connend(nullptr),
+      m_precomputed_search(nullptr)
 {
     COLA_ASSERT(m_router != nullptr);
     m_id = m_router->assignId(id);
@@ -86,12 +88,14 @@ ConnRef::ConnRef(Router *router, const ConnEnd& src, const ConnEnd& dst,
       m_hate_crossings(false),
       m_has_fixed_route(false),
       m_route_dist(0),
+      m_connrefs_order(0),
       m_src_vert(nullptr),
       m_dst_vert(nullptr),
       m_callback_func(nullptr),
       m_connector(nullptr),
       m_src_connend(nullptr),
-      m_dst_connend(nullptr)
+      m_dst_connend(nullptr),
+      m_precomputed_search(nullptr)
 {
     COLA_ASSERT(m_router != nullptr);
     m_id = m_router->assignId(id);
@@ -553,6 +557,8 @@ void ConnRef::makeActive(void)
     
     // Add to connRefs list.
     m_connrefs_pos = m_router->connRefs.insert(m_router->connRefs.begin(), this);
+    m_connrefs_order = ++m_router->m_connrefs_added;
+    m_router->addObjectId(m_id);
     m_active = true;
 }
 
@@ -576,6 +582,7 @@ void ConnRef::makeInactive(void)
     
     // Remove from connRefs list.
     m_router->connRefs.erase(m_connrefs_pos);
+    m_router->removeObjectId(m_id);
     m_active = false;
 }
 
@@ -930,6 +937,84 @@ std::pair<bool, bool> ConnRef::assignConnectionPinVisibility(const bool connect)
 }
 
 
+// Returns whether this connector needs a new route and the search for it
+// only reads the visibility graph.  Connection pins and checkpoints cause
+// the graph to be temporarily modified while routing, and connectors using
+// these must be routed one at a time.
+//
+bool ConnRef::hasIndependentSearch(void) const
+{
+    if (!m_false_path && !m_needs_reroute_flag)
+    {
+        // This connector is up to date, so won't be searched for.
+        return false;
+    }
+
+    if (!m_dst_vert || !m_src_vert)
+    {
+        return false;
+    }
+
+    if (!m_checkpoints.empty())
+    {
+        return false;
+    }
+
+    if ((m_src_connend && m_src_connend->isPinConnection()) ||
+            (m_dst_connend && m_dst_connend->isPinConnection()))
+    {
+        return false;
+    }
+
+    return !m_router->RubberBandRouting && !m_router->debugHandler();
+}
+
+
+// Performs the route search that generatePath() will use for this connector.
+// This does not alter the connector or the visibility graph and so can be
+// called for several connectors simultaneously from different threads.
+//
+void ConnRef::precomputeSearch(AStarPath *search)
+{
+    COLA_ASSERT(hasIndependentSearch());
+    search->search(this, m_src_vert, m_dst_vert, m_src_vert);
+    m_precomputed_search = search;
+}
+
+
+// Returns whether this connector needs a new route and the route found
+// by its previous search can be used instead, provided the part of the 
+// visibility graph within m_search_corridor hasn't changed since.
+//
+bool ConnRef::hasReusableSearchRoute(void) const
+{
+    if ((m_type != ConnType_Orthogonal) || m_search_route.empty() ||
+            !hasIndependentSearch())
+    {
+        return false;
+    }
+
+    // The endpoints must not have moved.
+    return (m_search_route.ps.front() == m_src_vert->point) &&
+            (m_search_route.ps.back() == m_dst_vert->point);
+}
+
+
+// Sets the route of this connector to the one found by its previous 
+// search, in place of generatePath().
+//
+void ConnRef::reuseSearchRoute(void)
+{
+    COLA_ASSERT(hasReusableSearchRoute());
+    m_false_path = true;
+    m_needs_reroute_flag = false;
+    m_start_vert = m_src_vert;
+
+    freeRoutes();
+    m_route = m_search_route;
+}
+
+
 bool ConnRef::generatePath(void)
 {
     // XXX Currently rubber-band routing only works when dragging the
@@ -1009,14 +1094,14 @@ bool ConnRef::generatePath(void)
         }
 
         VertInf *vertex = vertices[i];
-        if (vertex->pathNext && 
-                (vertex->pathNext->point == vertex->point))
+        VertInf *prevVertex = vertices[i - 1];
+        if (prevVertex->point == vertex->point)
         {
-            if (!(vertex->pathNext->id.isConnPt()) && !(vertex->id.isConnPt()))
+            if (!(prevVertex->id.isConnPt()) && !(vertex->id.isConnPt()))
             {
                 // Check for consecutive points on opposite 
                 // corners of two touching shapes.
-                COLA_ASSERT(abs(vertex->pathNext->id.vn - vertex->id.vn) != 2);
+                COLA_ASSERT(abs(prevVertex->id.vn - vertex->id.vn) != 2);
             }
         }
     }
@@ -1044,6 +1129,19 @@ bool ConnRef::generatePath(void)
     freeRoutes();
     PolyLine& output_route = m_route;
     output_route.ps = clippedPath;
+
+    if (!m_router->isInCrossingPenaltyReroutingStage())
+    {
+        // Keep the route for reuse if it was found by a search of the
+        // visibility graph alone.
+        m_search_route.clear();
+        if ((m_type == ConnType_Orthogonal) && !m_needs_reroute_flag &&
+                m_checkpoints.empty() && !isDummyAtEnd.first &&
+                !isDummyAtEnd.second && !m_router->RubberBandRouting)
+        {
+            m_search_route = output_route;
+        }
+    }
  
 #ifdef PATHDEBUG
     db_printf("Output route:\n");
@@ -1102,9 +1200,13 @@ void ConnRef::generateCheckpointsPath(std::vector<Point>& path,
             }
         }
         
+        // The vertex before start on the path so far, if any.
+        VertInf *startPrev = (lastSuccessfulIndex > 0) ? 
+                vertices[vertices.size() - 2] : nullptr;
+
         AStarPath aStar;
         // Route the connector
-        aStar.search(this, start, end, nullptr); 
+        aStar.search(this, start, end, nullptr, startPrev); 
 
         // Restore changes made for checkpoint visibility directions.
         if (lastSuccessfulIndex > 0)
@@ -1117,16 +1219,18 @@ void ConnRef::generateCheckpointsPath(std::vector<Point>& path,
         }
 
         // Process the path.
-        int pathlen = end->pathLeadsBackTo(start);
+        int pathlen = aStar.pathLeadsBackTo(start);
         if (pathlen >= 2)
         {
+            const std::vector<VertInf *>& foundPath = aStar.path();
             size_t prev_path_size = path.size();
             path.resize(prev_path_size + (pathlen - 1));
             vertices.resize(prev_path_size + (pathlen - 1));
-            VertInf *vertInf = end;
+            size_t foundIndex = 0;
             for (size_t index = path.size() - 1; index >= prev_path_size;
                     --index)
             {
+                VertInf *vertInf = foundPath[foundIndex++];
                 path[index] = vertInf->point;
                 if (vertInf->id.isConnPt())
                 {
@@ -1139,7 +1243,6 @@ void ConnRef::generateCheckpointsPath(std::vector<Point>& path,
                     path[index].vn = vertInf->id.vn;
                 }
                 vertices[index] = vertInf;
-                vertInf = vertInf->pathNext;
             }
             lastSuccessfulIndex = i;
         }
@@ -1209,11 +1312,23 @@ void ConnRef::generateStandardPath(std::vector<Point>& path,
     //db_printf("GO\n");
     //db_printf("src: %X strt: %X dst: %X\n", (int) m_src_vert, (int) m_start_vert, (int) m_dst_vert);
     unsigned int pathlen = 0;
+    AStarPath localSearch;
+    AStarPath *aStar = &localSearch;
     while (pathlen == 0)
     {
-        AStarPath aStar;
-        aStar.search(this, src(), dst(), start());
-        pathlen = dst()->pathLeadsBackTo(src());
+        if (m_precomputed_search)
+        {
+            // The router has already performed the search for this
+            // connector as part of parallel route searching.
+            aStar = m_precomputed_search;
+            m_precomputed_search = nullptr;
+        }
+        else
+        {
+            aStar = &localSearch;
+            aStar->search(this, src(), dst(), start());
+        }
+        pathlen = aStar->pathLeadsBackTo(src());
         if (pathlen < 2)
         {
             if (existingPathStart == 0)
@@ -1240,11 +1355,15 @@ void ConnRef::generateStandardPath(std::vector<Point>& path,
 #ifdef PATHDEBUG
             db_printf("\n\n\nSTART:\n\n");
 #endif
+            const std::vector<VertInf *>& foundPath = aStar->path();
+            const size_t startIndex = aStar->pathLeadsBackTo(m_start_vert) - 1;
             VertInf *prior = nullptr;
-            for (VertInf *curr = tar; curr != m_start_vert->pathNext;
-                    curr = curr->pathNext)
+            for (size_t i = 0; i <= startIndex; ++i)
             {
-                if (!validateBendPoint(curr->pathNext, curr, prior))
+                VertInf *curr = foundPath[i];
+                VertInf *next = ((i + 1) < foundPath.size()) ?
+                        foundPath[i + 1] : nullptr;
+                if (!validateBendPoint(next, curr, prior))
                 {
                     unwind = true;
                     break;
@@ -1274,13 +1393,15 @@ void ConnRef::generateStandardPath(std::vector<Point>& path,
         }
     }
 
+    std::vector<VertInf *> foundPath;
     if (pathlen < 2)
     {
         // There is no valid path.
         db_printf("Warning: Path not found...\n");
         m_needs_reroute_flag = true;
         pathlen = 2;
-        tar->pathNext = m_src_vert;
+        foundPath.push_back(tar);
+        foundPath.push_back(m_src_vert);
         if ((m_type == ConnType_PolyLine) && m_router->InvisibilityGrph)
         {
             // TODO:  Could we know this edge already?
@@ -1289,18 +1410,41 @@ void ConnRef::generateStandardPath(std::vector<Point>& path,
             //edge->addCycleBlocker();
         }
     }
+    else
+    {
+        foundPath = aStar->path();
+
+        // The cost of a route is at least its length, except that the step
+        // to the target from one of its neighbours in the orthogonal graph
+        // is free.  A route leaving the box around the endpoints by some 
+        // distance is at least twice that distance longer than the 
+        // Manhattan distance between them, so a route cheaper than this one
+        // must lie within this box expanded by half the difference.
+        double freeDist = 0;
+        for (EdgeInfList::const_iterator edge = tar->orthogVisList.begin();
+                edge != tar->orthogVisList.end(); ++edge)
+        {
+            freeDist = std::max(freeDist, (*edge)->getDist());
+        }
+        const Point& srcPoint = m_src_vert->point;
+        const Point& tarPoint = tar->point;
+        const double slack = (aStar->pathCost() + freeDist - 
+                manhattanDist(srcPoint, tarPoint)) / 2 + 1;
+        m_search_corridor.min.x = std::min(srcPoint.x, tarPoint.x) - slack;
+        m_search_corridor.min.y = std::min(srcPoint.y, tarPoint.y) - slack;
+        m_search_corridor.max.x = std::max(srcPoint.x, tarPoint.x) + slack;
+        m_search_corridor.max.y = std::max(srcPoint.y, tarPoint.y) + slack;
+    }
     path.resize(pathlen);
     vertices.resize(pathlen);
 
-    unsigned int j = pathlen - 1;
-    for (VertInf *i = tar; i != m_src_vert; i = i->pathNext)
+    for (unsigned int j = pathlen - 1; j > 0; --j)
     {
+        VertInf *i = foundPath[pathlen - 1 - j];
         path[j] = i->point;
         vertices[j] = i;
         path[j].id = i->id.objID;
         path[j].vn = i->id.vn;
-
-        j--;
     }
     vertices[0] = m_src_vert;
     path[0] = m_src_vert->point;
@@ -45,6 +45,7 @@ namespace Avoid {
 
 class Router;
 class ConnRef;
+class AStarPath;
 class JunctionRef;
 class ShapeRef;
 typedef std::list<ConnRef *> ConnRefList;
@@ -457,6 +458,10 @@ class AVOID_EXPORT ConnRef
         std::pair<Obstacle *, Obstacle *> endpointAnchors(void) const;
         void outputCode(FILE *fp) const;
         std::pair<bool, bool> assignConnectionPinVisibility(const bool connect);
+        bool hasIndependentSearch(void) const;
+        void precomputeSearch(AStarPath *search);
+        bool hasReusableSearchRoute(void) const;
+        void reuseSearchRoute(void);
 
 
         Router *m_router;
@@ -474,6 +479,8 @@ class AVOID_EXPORT ConnRef
         Polygon m_display_route;
         double m_route_dist;
         ConnRefList::iterator m_connrefs_pos;
+        // When this was added to the router's connRefs list, counting up.
+        unsigned long m_connrefs_order;
         VertInf *m_src_vert;
         VertInf *m_dst_vert;
         VertInf *m_start_vert;
@@ -485,6 +492,15 @@ class AVOID_EXPORT ConnRef
         ConnEnd *m_dst_connend;
         std::vector<Checkpoint> m_checkpoints;
         std::vector<VertInf *> m_checkpoint_vertices;
+        // Search performed ahead of time by the router, to be used by the
+        // next call to generatePath().  Not owned by the connector.
+        AStarPath *m_precomputed_search;
+        // The route found by the last search for this connector outside of
+        // crossing penalty rerouting, kept so the router can reuse it in 
+        // later transactions, and the region that any cheaper route would 
+        // have to pass through.  Empty if the route can't be reused.
+        PolyLine m_search_route;
+        Box m_search_corridor;
 };
 
 
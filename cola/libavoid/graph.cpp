@@ -170,10 +170,14 @@ bool EdgeInf::rotationLessThan(const VertInf *lastV, const EdgeInf *rhs) const
         rhsV = rhs->m_vert1;
     }
 
-    const Point& lhsPt = lhsV->point;
-    const Point& rhsPt = rhsV->point;
-    const Point& commonPt = commonV->point;
-    
+    return Avoid::rotationLessThan(lastV, commonV->point, lhsV->point, 
+            rhsV->point);
+}
+
+
+bool rotationLessThan(const VertInf *lastV, const Point& commonPt,
+        const Point& lhsPt, const Point& rhsPt)
+{
     // If no lastPt, use one directly to the left;
     Point lastPt = (lastV) ? lastV->point : Point(commonPt.x - 10,  commonPt.y);
 
@@ -196,11 +200,13 @@ void EdgeInf::makeActive(void)
         m_vert1->orthogVisListSize++;
         m_pos2 = m_vert2->orthogVisList.insert(m_vert2->orthogVisList.begin(), this);
         m_vert2->orthogVisListSize++;
+        adjacencyChanged();
     }
     else
     {
         if (m_visible)
         {
+            adjacencyChanged();
             m_router->visGraph.addEdge(this);
             m_pos1 = m_vert1->visList.insert(m_vert1->visList.begin(), this);
             m_vert1->visListSize++;
@@ -232,11 +238,13 @@ void EdgeInf::makeInactive(void)
         m_vert1->orthogVisListSize--;
         m_vert2->orthogVisList.erase(m_pos2);
         m_vert2->orthogVisListSize--;
+        adjacencyChanged();
     }
     else
     {
         if (m_visible)
         {
+            adjacencyChanged();
             m_router->visGraph.removeEdge(this);
             m_vert1->visList.erase(m_pos1);
             m_vert1->visListSize--;
@@ -272,11 +280,25 @@ void EdgeInf::setDist(double dist)
         m_visible = true;
         makeActive();
     }
+    else if (m_dist != dist)
+    {
+        adjacencyChanged();
+    }
     m_dist = dist;
     m_blocker = 0;
 }
 
 
+// Records that the adjacency of the ends of this edge in the visibility
+// graph has changed.
+void EdgeInf::adjacencyChanged(void)
+{
+    CompactAdjacency& adjacency = m_router->compactAdjacency(m_orthogonal);
+    adjacency.vertexChanged(m_vert1);
+    adjacency.vertexChanged(m_vert2);
+}
+
+
 void EdgeInf::setMtstDist(const double joinCost)
 {
     m_mtst_dist = joinCost;
@@ -299,6 +321,10 @@ bool EdgeInf::isDisabled(void) const
 
 void EdgeInf::setDisabled(const bool disabled)
 {
+    if (m_added && (m_disabled != disabled))
+    {
+        adjacencyChanged();
+    }
     m_disabled = disabled;
 }
 
@@ -397,30 +423,58 @@ void EdgeInf::checkVis(void)
         db_print();
     }
 
+    m_router->st_checked_edges++;
+
     int blocker = 0;
+    if (verticesVisible(m_vert1, m_vert2, &blocker))
+    {
+
+        // if i and j see each other, add edge
+        db_printf("\tSetting visibility edge... \n\t\t");
+        db_print();
+
+        double d = euclideanDist(m_vert1->point, m_vert2->point);
+
+        setDist(d);
+
+    }
+    else if (m_router->InvisibilityGrph)
+    {
+        // if i and j can't see each other, add blank edge
+        db_printf("\tSetting invisibility edge... \n\t\t");
+        db_print();
+        addBlocker(blocker);
+    }
+}
+
+
+// Returns whether the vertices i and j can see each other for poly-line
+// routing.  If they can't, blocker is set to the ID of the first obstacle
+// found blocking them, or to zero if either is outside the valid region
+// of the other.  This only reads the router's obstacles and vertices, so
+// can be called from multiple threads.
+bool EdgeInf::verticesVisible(VertInf *i, VertInf *j, int *blocker)
+{
+    Router *router = i->_router;
     bool cone1 = true;
     bool cone2 = true;
 
-    VertInf *i = m_vert1;
-    VertInf *j = m_vert2;
     const VertID& iID = i->id;
     const VertID& jID = j->id;
     const Point& iPoint = i->point;
     const Point& jPoint = j->point;
 
-    m_router->st_checked_edges++;
-
     if (!(iID.isConnPt()))
     {
-        cone1 = inValidRegion(m_router->IgnoreRegions, i->shPrev->point,
+        cone1 = inValidRegion(router->IgnoreRegions, i->shPrev->point,
                 iPoint, i->shNext->point, jPoint);
     }
-    else if (m_router->IgnoreRegions == false)
+    else if (router->IgnoreRegions == false)
     {
         // If Ignoring regions then this case is already caught by 
         // the invalid regions, so only check it when not ignoring
         // regions.
-        ShapeSet& ss = m_router->contains[iID];
+        const ShapeSet& ss = router->containingShapes(iID);
 
         if (!(jID.isConnPt()) && (ss.find(jID.objID) != ss.end()))
         {
@@ -436,15 +490,15 @@ void EdgeInf::checkVis(void)
         // If outside the first cone, don't even bother checking.
         if (!(jID.isConnPt()))
         {
-            cone2 = inValidRegion(m_router->IgnoreRegions, j->shPrev->point,
+            cone2 = inValidRegion(router->IgnoreRegions, j->shPrev->point,
                     jPoint, j->shNext->point, iPoint);
         }
-        else if (m_router->IgnoreRegions == false)
+        else if (router->IgnoreRegions == false)
         {
             // If Ignoring regions then this case is already caught by 
             // the invalid regions, so only check it when not ignoring
             // regions.
-            ShapeSet& ss = m_router->contains[jID];
+            const ShapeSet& ss = router->containingShapes(jID);
 
             if (!(iID.isConnPt()) && (ss.find(iID.objID) != ss.end()))
             {
@@ -456,58 +510,42 @@ void EdgeInf::checkVis(void)
         }
     }
 
-    if (cone1 && cone2 && ((blocker = firstBlocker()) == 0))
-    {
-
-        // if i and j see each other, add edge
-        db_printf("\tSetting visibility edge... \n\t\t");
-        db_print();
-
-        double d = euclideanDist(iPoint, jPoint);
-
-        setDist(d);
+    *blocker = 0;
+    return (cone1 && cone2 && ((*blocker = firstBlocker(i, j)) == 0));
+}
 
-    }
-    else if (m_router->InvisibilityGrph)
-    {
-#if 0
-        db_printf("%d, %d, %d\n", cone1, cone2, blocker);
-        db_printf("\t(%d, %d)--(%d, %d)\n", (int) iInfo.point.x,
-                (int) iInfo.point.y, (int) jInfo.point.x,
-                (int) jInfo.point.y);
-#endif
 
-        // if i and j can't see each other, add blank edge
-        db_printf("\tSetting invisibility edge... \n\t\t");
-        db_print();
-        addBlocker(blocker);
-    }
+int EdgeInf::firstBlocker(void)
+{
+    return firstBlocker(m_vert1, m_vert2);
 }
 
 
-int EdgeInf::firstBlocker(void)
+int EdgeInf::firstBlocker(VertInf *i, VertInf *j)
 {
     ShapeSet ss = ShapeSet();
 
-    Point& pti = m_vert1->point;
-    Point& ptj = m_vert2->point;
-    VertID& iID = m_vert1->id;
-    VertID& jID = m_vert2->id;
+    Router *router = i->_router;
+    Point& pti = i->point;
+    Point& ptj = j->point;
+    VertID& iID = i->id;
+    VertID& jID = j->id;
 
-    ContainsMap &contains = m_router->contains;
     if (iID.isConnPt())
     {
-        ss.insert(contains[iID].begin(), contains[iID].end());
+        const ShapeSet& iContains = router->containingShapes(iID);
+        ss.insert(iContains.begin(), iContains.end());
     }
     if (jID.isConnPt())
     {
-        ss.insert(contains[jID].begin(), contains[jID].end());
+        const ShapeSet& jContains = router->containingShapes(jID);
+        ss.insert(jContains.begin(), jContains.end());
     }
 
-    VertInf *last = m_router->vertices.end();
+    VertInf *last = router->vertices.end();
     unsigned int lastId = 0;
     bool seenIntersectionAtEndpoint = false;
-    for (VertInf *k = m_router->vertices.shapesBegin(); k != last; )
+    for (VertInf *k = router->vertices.shapesBegin(); k != last; )
     {
         VertID kID = k->id;
         if (k->id == dummyOrthogID)
@@ -787,6 +825,164 @@ EdgeInf *EdgeList::end(void)
 }
 
 
+
+//============================================================================
+//                            CompactAdjacency
+//============================================================================
+
+const unsigned int CompactAdjacency::noIndex = (unsigned int) -1;
+
+
+void AdjacencyRowStorage::append(EdgeInf *edge, VertInf *other)
+{
+    unsigned char flags = 0;
+    if (edge->isOrthogonal())
+    {
+        flags |= ADJ_ORTHOGONAL;
+    }
+    if (edge->isDummyConnection())
+    {
+        flags |= ADJ_DUMMY_CONNECTION;
+    }
+    if (edge->isDisabled())
+    {
+        flags |= ADJ_DISABLED;
+    }
+    m_edges.push_back(edge);
+    m_others.push_back(other);
+    m_other_points.push_back(other->point);
+    m_dists.push_back(edge->getDist());
+    m_flags.push_back(flags);
+}
+
+
+void AdjacencyRowStorage::clear(void)
+{
+    m_edges.clear();
+    m_others.clear();
+    m_other_points.clear();
+    m_dists.clear();
+    m_flags.clear();
+}
+
+
+AdjacencyRow AdjacencyRowStorage::row(const size_t first) const
+{
+    AdjacencyRow row;
+    row.m_size = m_edges.size() - first;
+    row.m_edges = m_edges.data() + first;
+    row.m_others = m_others.data() + first;
+    row.m_other_points = m_other_points.data() + first;
+    row.m_dists = m_dists.data() + first;
+    row.m_flags = m_flags.data() + first;
+    return row;
+}
+
+
+AdjacencyRow AdjacencyRowStorage::readEdgeList(const VertInf *vert,
+        const bool orthogonal)
+{
+    clear();
+    const EdgeInfList& visList = (orthogonal) ? 
+            vert->orthogVisList : vert->visList;
+    for (EdgeInfList::const_iterator it = visList.begin(); 
+            it != visList.end(); ++it)
+    {
+        append(*it, (*it)->otherVert(vert));
+    }
+    return row();
+}
+
+
+CompactAdjacency::CompactAdjacency(const bool orthogonal)
+    : m_orthogonal(orthogonal),
+      m_changed(true)
+{
+}
+
+
+void CompactAdjacency::update(Router *router)
+{
+    if (!m_changed)
+    {
+        return;
+    }
+
+    m_vertices.clear();
+    m_row_start.clear();
+    m_rows.clear();
+    const size_t indexType = (m_orthogonal) ? 1 : 0;
+    for (VertInf *vert = router->vertices.connsBegin(); 
+            vert != router->vertices.end(); vert = vert->lstNext)
+    {
+        vert->adjacencyIndex[indexType] = (unsigned int) m_vertices.size();
+        m_vertices.push_back(vert);
+        m_row_start.push_back((unsigned int) m_rows.m_edges.size());
+
+        const EdgeInfList& visList = (m_orthogonal) ? 
+                vert->orthogVisList : vert->visList;
+        for (EdgeInfList::const_iterator it = visList.begin(); 
+                it != visList.end(); ++it)
+        {
+            m_rows.append(*it, (*it)->otherVert(vert));
+        }
+    }
+    m_row_start.push_back((unsigned int) m_rows.m_edges.size());
+    m_vertex_changed.assign(m_vertices.size(), 0);
+    m_changed = false;
+}
+
+
+// Returns whether the row for vert is present and up to date.  A vertex
+// may have an index from an earlier build if it was removed from the
+// router and added back, so check it is the vertex for the row.
+bool CompactAdjacency::isCurrent(const VertInf *vert) const
+{
+    unsigned int index = vert->adjacencyIndex[(m_orthogonal) ? 1 : 0];
+    return (index < m_vertices.size()) && (m_vertices[index] == vert) &&
+            !m_vertex_changed[index];
+}
+
+
+void CompactAdjacency::vertexChanged(const VertInf *vert)
+{
+    m_changed = true;
+    unsigned int index = vert->adjacencyIndex[(m_orthogonal) ? 1 : 0];
+    if ((index < m_vertices.size()) && (m_vertices[index] == vert))
+    {
+        m_vertex_changed[index] = 1;
+    }
+}
+
+
+void CompactAdjacency::vertexMoved(const VertInf *vert)
+{
+    vertexChanged(vert);
+    const EdgeInfList& visList = (m_orthogonal) ? 
+            vert->orthogVisList : vert->visList;
+    for (EdgeInfList::const_iterator it = visList.begin(); 
+            it != visList.end(); ++it)
+    {
+        vertexChanged((*it)->otherVert(vert));
+    }
+}
+
+
+AdjacencyRow CompactAdjacency::adjacentEdges(const VertInf *vert, 
+        AdjacencyRowStorage& fallback) const
+{
+    if (!isCurrent(vert))
+    {
+        return fallback.readEdgeList(vert, m_orthogonal);
+    }
+
+    unsigned int index = vert->adjacencyIndex[(m_orthogonal) ? 1 : 0];
+    AdjacencyRow row = m_rows.row(m_row_start[index]);
+    row.m_size = m_row_start[index + 1] - m_row_start[index];
+    return row;
+}
+
+
 }
 
 
@@ -30,6 +30,7 @@
 #include <cassert>
 #include <list>
 #include <utility>
+#include <vector>
 #include "libavoid/vertices.h"
 
 namespace Avoid {
@@ -71,6 +72,7 @@ class EdgeInf
         static EdgeInf *checkEdgeVisibility(VertInf *i, VertInf *j,
                 bool knownNew = false);
         static EdgeInf *existingEdge(VertInf *i, VertInf *j);
+        static bool verticesVisible(VertInf *i, VertInf *j, int *blocker);
         int blocker(void) const;
         
         bool isHyperedgeSegment(void) const;
@@ -87,7 +89,9 @@ class EdgeInf
 
         void makeActive(void);
         void makeInactive(void);
+        void adjacencyChanged(void);
         int firstBlocker(void);
+        static int firstBlocker(VertInf *i, VertInf *j);
         bool isBetween(VertInf *i, VertInf *j);
 
         Router *m_router;
@@ -129,6 +133,140 @@ class EdgeList
 };
 
 
+// Flags for each edge in an AdjacencyRow.
+static const unsigned char ADJ_ORTHOGONAL = 1;
+static const unsigned char ADJ_DUMMY_CONNECTION = 2;
+static const unsigned char ADJ_DISABLED = 4;
+
+
+// A view of the edges out of a vertex, as seen from that vertex, with the
+// values of each edge and the vertex at its other end used by searches.
+// These are read in place from parallel arrays, either a row of a 
+// CompactAdjacency or an AdjacencyRowStorage.
+class AdjacencyRow
+{
+    public:
+        size_t size(void) const
+        {
+            return m_size;
+        }
+        EdgeInf *edge(const size_t i) const
+        {
+            return m_edges[i];
+        }
+        VertInf *other(const size_t i) const
+        {
+            return m_others[i];
+        }
+        const Point& otherPoint(const size_t i) const
+        {
+            return m_other_points[i];
+        }
+        double dist(const size_t i) const
+        {
+            return m_dists[i];
+        }
+        bool isOrthogonal(const size_t i) const
+        {
+            return m_flags[i] & ADJ_ORTHOGONAL;
+        }
+        bool isDummyConnection(const size_t i) const
+        {
+            return m_flags[i] & ADJ_DUMMY_CONNECTION;
+        }
+        bool isDisabled(const size_t i) const
+        {
+            return m_flags[i] & ADJ_DISABLED;
+        }
+    private:
+        friend class CompactAdjacency;
+        friend class AdjacencyRowStorage;
+
+        size_t m_size;
+        EdgeInf *const *m_edges;
+        VertInf *const *m_others;
+        const Point *m_other_points;
+        const double *m_dists;
+        const unsigned char *m_flags;
+};
+
+
+// Parallel arrays of the edges out of a vertex, in the layout of the rows
+// of a CompactAdjacency, for vertices whose rows are missing or out of 
+// date.  Searches keep one of these to reuse for such vertices.
+class AdjacencyRowStorage
+{
+    public:
+        // Sets this to the edges in vert's edge list, and returns a view
+        // of them.
+        AdjacencyRow readEdgeList(const VertInf *vert, const bool orthogonal);
+        // Appends edge, out of a vertex to other.
+        void append(EdgeInf *edge, VertInf *other);
+        // Returns a view of the edges from first onwards.
+        AdjacencyRow row(const size_t first = 0) const;
+        void clear(void);
+    private:
+        friend class CompactAdjacency;
+
+        std::vector<EdgeInf *> m_edges;
+        std::vector<VertInf *> m_others;
+        std::vector<Point> m_other_points;
+        std::vector<double> m_dists;
+        std::vector<unsigned char> m_flags;
+};
+
+
+// A compact copy of the adjacency of the polyline or orthogonal visibility 
+// graph, in compressed sparse row form.  The edges out of each vertex are
+// held contiguously, as parallel arrays of the edges, the vertices at 
+// their other ends and those vertices' points, the edge distances and 
+// flags, for the row given by the vertex's adjacencyIndex.  It is built
+// from the edge lists after the graph is generated, and searches read it
+// in preference to chasing pointers through the lists.
+//
+// Edges are still created and deleted via the lists.  Any vertex whose 
+// edges change afterwards is marked, and it and any new vertex are read 
+// from the lists until the next rebuild, via an AdjacencyRowStorage.
+class CompactAdjacency
+{
+    public:
+        CompactAdjacency(const bool orthogonal);
+        // Rebuilds this from the vertices of router, if the graph has
+        // changed since it was last built.
+        void update(Router *router);
+        // Records that the edges of vert have changed.
+        void vertexChanged(const VertInf *vert);
+        // Records that vert has moved, which changes the edges of its
+        // neighbours too.
+        void vertexMoved(const VertInf *vert);
+        // Returns the edges out of vert, in the order of vert's edge list.
+        // They are read in place from vert's row if it is up to date, or
+        // else copied from its edge list into fallback.  The view is valid
+        // until this or fallback next changes.
+        AdjacencyRow adjacentEdges(const VertInf *vert, 
+                AdjacencyRowStorage& fallback) const;
+
+        static const unsigned int noIndex;
+    private:
+        bool isCurrent(const VertInf *vert) const;
+
+        bool m_orthogonal;
+        bool m_changed;
+        std::vector<VertInf *> m_vertices;
+        std::vector<char> m_vertex_changed;
+        std::vector<unsigned int> m_row_start;
+        // The rows, one after another.
+        AdjacencyRowStorage m_rows;
+};
+
+
+// Returns whether the edge from commonPt to lhsPt comes before the edge 
+// from commonPt to rhsPt in the orthogonal search exploration order, as
+// for EdgeInf::rotationLessThan().
+extern bool rotationLessThan(const VertInf *lastV, const Point& commonPt,
+        const Point& lhsPt, const Point& rhsPt);
+
+
 }
 
 
@@ -1019,7 +1019,7 @@ void HyperedgeImprover::execute(bool canMakeMajorChanges)
         m_router->deleteJunction(*curr);
     }
 
-    TIMER_STOP(m_router);
+    TIMER_STOP(m_router, tmHyperedgeImprove);
 }
 
 
@@ -49,6 +49,7 @@
 #include "libavoid/connectionpin.h"
 #include "libavoid/junction.h"
 #include "libavoid/viscluster.h"
+#include "libavoid/bulkload.h"
 
 #endif
 
@@ -60,6 +60,7 @@ class ANode
         ANode *prevNode; // VertInf for the previous ANode.
         int timeStamp;   // Time-stamp used to determine exploration order of
                          // seemingly equal paths during orthogonal routing.
+        ANode *nextAtVertex; // Next ANode in the same Done or Pending list.
 
         ANode(VertInf *vinf, int time)
             : inf(vinf),
@@ -67,7 +68,8 @@ class ANode
               h(0),
               f(0),
               prevNode(nullptr),
-              timeStamp(time)
+              timeStamp(time),
+              nextAtVertex(nullptr)
         {
         }
         ANode()
@@ -76,54 +78,206 @@ class ANode
               h(0),
               f(0),
               prevNode(nullptr),
-              timeStamp(-1)
+              timeStamp(-1),
+              nextAtVertex(nullptr)
         {
         }
 };
 
-class AStarPathPrivate
+// The ANodes that have been explored (Done) or are waiting to be explored
+// (Pending) at a particular vertex during a search, as lists linked 
+// through ANode::nextAtVertex.
+struct AStarVertexState
+{
+    const VertInf *vert;
+    ANode *done;
+    ANode *pending;
+};
+
+// Scratch space for A* searches.  One of these is kept per thread and 
+// reused by each search run on that thread, so that once it has grown 
+// large enough a search needs no further heap allocation.  Concurrent 
+// searches run on the threads of the Router's ThreadPool, which are kept
+// for the life of the Router, so their workspaces also last from one 
+// transaction to the next.
+//
+// ANodes are allocated in blocks that are kept, not freed, when the 
+// workspace is reset between searches.  The search state for each vertex
+// is held in an open addressing hash table keyed by the VertInf, rather
+// than in the VertInf, so the graph is not modified by the search.
+class AStarWorkspace
 {
     public:
-        AStarPathPrivate()
-            : m_available_nodes(),
-              m_available_array_size(0),
-              m_available_array_index(0),
-              m_available_node_index(0)
+        AStarWorkspace()
+            : m_block_index(0),
+              m_node_index(0),
+              m_vertex_states(64, emptyState())
         {
         }
-        ~AStarPathPrivate()
+        ~AStarWorkspace()
         {
             // Free memory
-            for (size_t i = 0; i < m_available_nodes.size(); ++i)
+            for (size_t i = 0; i < m_blocks.size(); ++i)
             {
-                delete[] m_available_nodes[i];
+                delete[] m_blocks[i];
             }
         }
-        // Returns a pointer to an ANode for aStar search, but allocates
-        // these in blocks 
-        ANode *newANode(const ANode& node, const bool addToPending = true)
+        // Clears the state of the previous search, keeping all memory.
+        void reset(void)
+        {
+            m_block_index = 0;
+            m_node_index = 0;
+            for (size_t i = 0; i < m_used_states.size(); ++i)
+            {
+                m_vertex_states[m_used_states[i]] = emptyState();
+            }
+            m_used_states.clear();
+            pending.clear();
+            costTargets.clear();
+            costTargetsDirections.clear();
+            costTargetsDisplacements.clear();
+        }
+        // Returns a pointer to an ANode for aStar search, allocated from 
+        // the current block.
+        ANode *newANode(const ANode& node)
         {
             const size_t blockSize = 5000;
-            if ((m_available_array_index + 1 > m_available_array_size) ||
-                    (m_available_node_index >= blockSize))
+            if (m_node_index >= blockSize)
             {
-                m_available_nodes.push_back(new ANode[blockSize]);
-                ++m_available_array_size;
-                m_available_node_index = 0;
-                m_available_array_index = m_available_array_size - 1;
+                ++m_block_index;
+                m_node_index = 0;
             }
-            
-            ANode *nodes = m_available_nodes[m_available_array_index];
-            ANode *newNode = &(nodes[m_available_node_index++]);
+            if (m_block_index == m_blocks.size())
+            {
+                m_blocks.push_back(new ANode[blockSize]);
+            }
+            ANode *newNode = &(m_blocks[m_block_index][m_node_index++]);
             *newNode = node;
+            return newNode;
+        }
+        // Returns the Done and Pending lists for vert.
+        AStarVertexState& vertexState(const VertInf *vert)
+        {
+            size_t index = findVertexState(vert);
+            if (m_vertex_states[index].vert == nullptr)
+            {
+                if (2 * (m_used_states.size() + 1) > m_vertex_states.size())
+                {
+                    growVertexStates();
+                    index = findVertexState(vert);
+                }
+                m_vertex_states[index].vert = vert;
+                m_used_states.push_back(index);
+            }
+            return m_vertex_states[index];
+        }
+
+        // Heap of Pending nodes.
+        std::vector<ANode *> pending;
+
+        // Scratch space for the edges out of a vertex without an up to 
+        // date compact adjacency row, and for the order to explore them in.
+        AdjacencyRowStorage adjacentEdges;
+        std::vector<unsigned int> edgeOrder;
+
+        // For determining estimated cost target.
+        std::vector<VertInf *> costTargets;
+        std::vector<unsigned int> costTargetsDirections;
+        std::vector<double> costTargetsDisplacements;
+
+    private:
+        static AStarVertexState emptyState(void)
+        {
+            AStarVertexState state = { nullptr, nullptr, nullptr };
+            return state;
+        }
+        static size_t hashVertex(const VertInf *vert)
+        {
+            size_t hash = (size_t) vert;
+            return hash ^ (hash >> 7) ^ (hash >> 17);
+        }
+        // Returns the index of the entry for vert, or of the empty entry
+        // where it should be added.
+        size_t findVertexState(const VertInf *vert) const
+        {
+            size_t mask = m_vertex_states.size() - 1;
+            size_t index = hashVertex(vert) & mask;
+            while ((m_vertex_states[index].vert != vert) &&
+                    (m_vertex_states[index].vert != nullptr))
+            {
+                index = (index + 1) & mask;
+            }
+            return index;
+        }
+        // Doubles the size of the vertex state table.
+        void growVertexStates(void)
+        {
+            std::vector<AStarVertexState> states(
+                    2 * m_vertex_states.size(), emptyState());
+            states.swap(m_vertex_states);
+            std::vector<size_t> used;
+            used.swap(m_used_states);
+            for (size_t i = 0; i < used.size(); ++i)
+            {
+                const AStarVertexState& state = states[used[i]];
+                AStarVertexState& newState = vertexState(state.vert);
+                newState.done = state.done;
+                newState.pending = state.pending;
+            }
+        }
+
+        std::vector<ANode *> m_blocks;
+        size_t m_block_index;
+        size_t m_node_index;
+
+        std::vector<AStarVertexState> m_vertex_states;
+        // Indexes of the entries of m_vertex_states in use.
+        std::vector<size_t> m_used_states;
+};
+
+// Returns the A* search workspace for the calling thread.
+static AStarWorkspace& threadWorkspace(void)
+{
+    thread_local AStarWorkspace workspace;
+    return workspace;
+}
+
+class AStarPathPrivate
+{
+    public:
+        AStarPathPrivate()
+            : m_path_cost(0),
+              m_workspace(nullptr)
+        {
+        }
+        // Returns a pointer to a new ANode for aStar search, also adding
+        // it to the Pending list for its vertex if addToPending is true.
+        ANode *newANode(const ANode& node, const bool addToPending = true)
+        {
+            ANode *newNode = m_workspace->newANode(node);
             if (addToPending)
             {
-                node.inf->aStarPendingNodes.push_back(newNode);
+                AStarVertexState& state = 
+                        m_workspace->vertexState(node.inf);
+                newNode->nextAtVertex = state.pending;
+                state.pending = newNode;
             }
             return newNode;
         }
+        // Adds node to the Done list for its vertex.
+        void addToDone(ANode *node)
+        {
+            AStarVertexState& state = m_workspace->vertexState(node->inf);
+            node->nextAtVertex = state.done;
+            state.done = node;
+        }
         void search(ConnRef *lineRef, VertInf *src, VertInf *tar, 
-                VertInf *start);
+                VertInf *start, VertInf *startPrev);
+
+        // Vertices of the resulting path, from the target backwards.
+        std::vector<VertInf *> m_path;
+        // The cost of the resulting path.
+        double m_path_cost;
 
     private:
         void determineEndPointLocation(double dist, VertInf *start,
@@ -131,15 +285,8 @@ class AStarPathPrivate
         double estimatedCost(ConnRef *lineRef, const Point *last,
                 const Point& curr) const;
 
-        std::vector<ANode *> m_available_nodes;
-        size_t m_available_array_size;
-        size_t m_available_array_index;
-        size_t m_available_node_index;
- 
-        // For determining estimated cost target.
-        std::vector<VertInf *> m_cost_targets;
-        std::vector<unsigned int> m_cost_targets_directions;
-        std::vector<double> m_cost_targets_displacements;
+        // The workspace of the thread running the current search.
+        AStarWorkspace *m_workspace;
 };
 
 
@@ -857,18 +1004,18 @@ double AStarPathPrivate::estimatedCost(ConnRef *lineRef, const Point *last,
         const Point& curr) const
 {
     double estimate = DBL_MAX;
-    COLA_ASSERT(m_cost_targets.size() > 0);
+    COLA_ASSERT(m_workspace->costTargets.size() > 0);
 
     // Find the minimum cost from the estimates to each of the possible
     // target points from this current point.
-    for (size_t i = 0; i < m_cost_targets.size(); ++i)
+    for (size_t i = 0; i < m_workspace->costTargets.size(); ++i)
     {
         double iEstimate = estimatedCostSpecific(lineRef, last,
-                curr, m_cost_targets[i], m_cost_targets_directions[i]);
+                curr, m_workspace->costTargets[i], m_workspace->costTargetsDirections[i]);
         
         // Add on the distance to the real target, otherwise this difference
         // might may make the comparisons unfair if they vary between targets.
-        iEstimate += m_cost_targets_displacements[i];
+        iEstimate += m_workspace->costTargetsDisplacements[i];
         
         estimate = std::min(estimate, iEstimate);
     }
@@ -879,25 +1026,52 @@ double AStarPathPrivate::estimatedCost(ConnRef *lineRef, const Point *last,
 class CmpVisEdgeRotation 
 {
     public:
-        CmpVisEdgeRotation(const VertInf* lastPt)
-            : _lastPt(lastPt)
+        CmpVisEdgeRotation(const VertInf* lastPt, const Point& commonPt,
+                const AdjacencyRow& edges)
+            : _lastPt(lastPt),
+              _commonPt(commonPt),
+              _edges(edges)
         {
         }
-        bool operator() (const EdgeInf* u, const EdgeInf* v) const 
+        // Compares the edges at positions u and v of the row.
+        bool operator() (const unsigned int u, const unsigned int v) const 
         {
             // Dummy ShapeConnectionPin edges are not orthogonal and 
             // therefore can't be compared in the same way.
-            if (u->isOrthogonal() && v->isOrthogonal())
+            if (_edges.isOrthogonal(u) && _edges.isOrthogonal(v))
             {
-                return u->rotationLessThan(_lastPt, v);
+                return rotationLessThan(_lastPt, _commonPt, 
+                        _edges.otherPoint(u), _edges.otherPoint(v));
             }
-            return u->uniqueId() < v->uniqueId();
+            return _edges.edge(u)->uniqueId() < _edges.edge(v)->uniqueId();
         }
     private:
         const VertInf *_lastPt;
+        const Point _commonPt;
+        const AdjacencyRow& _edges;
 };
 
 
+// Sorts the positions of the few edges out of a vertex, keeping the order
+// of equal edges.  Unlike std::stable_sort, this needs no temporary buffer.
+template <typename Compare>
+static void stableInsertionSort(std::vector<unsigned int>& order, 
+        Compare compare)
+{
+    for (size_t i = 1; i < order.size(); ++i)
+    {
+        unsigned int position = order[i];
+        size_t j = i;
+        while ((j > 0) && compare(position, order[j - 1]))
+        {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = position;
+    }
+}
+
+
 static inline bool pointAlignedWithOneOf(const Point& point, 
         const std::vector<Point>& points, const size_t dim)
 {
@@ -921,9 +1095,34 @@ AStarPath::~AStarPath(void)
     delete m_private;
 }
 
-void AStarPath::search(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
+void AStarPath::search(ConnRef *lineRef, VertInf *src, VertInf *tar,
+        VertInf *start, VertInf *startPrev)
+{
+    m_private->search(lineRef, src, tar, start, startPrev);
+}
+
+const std::vector<VertInf *>& AStarPath::path(void) const
 {
-    m_private->search(lineRef, src, tar, start);
+    return m_private->m_path;
+}
+
+double AStarPath::pathCost(void) const
+{
+    return m_private->m_path_cost;
+}
+
+unsigned int AStarPath::pathLeadsBackTo(const VertInf *vert) const
+{
+    const std::vector<VertInf *>& path = m_private->m_path;
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        if (path[i] == vert)
+        {
+            return (unsigned int) (i + 1);
+        }
+    }
+    // Path not found.
+    return 0;
 }
 
 void AStarPathPrivate::determineEndPointLocation(double dist, VertInf *start, 
@@ -938,9 +1137,9 @@ void AStarPathPrivate::determineEndPointLocation(double dist, VertInf *start,
     COLA_ASSERT(orthogonalDirectionsCount(thisDirs) > 0);
     double displacement = manhattanDist(otherPoint, target->point);
 
-    m_cost_targets.push_back(other);
-    m_cost_targets_directions.push_back(thisDirs);
-    m_cost_targets_displacements.push_back(displacement);
+    m_workspace->costTargets.push_back(other);
+    m_workspace->costTargetsDirections.push_back(thisDirs);
+    m_workspace->costTargetsDisplacements.push_back(displacement);
 
 #ifdef ESTIMATED_COST_DEBUG
     fprintf(stderr," - %g %g ", otherPoint.x, otherPoint.y);
@@ -958,16 +1157,20 @@ void AStarPathPrivate::determineEndPointLocation(double dist, VertInf *start,
 //
 // The path is worked out using the aStar algorithm, and is encoded via
 // prevNode values for each ANode which point back to the previous ANode.
-// At completion, this order is written into the pathNext links in each 
-// of the VerInfs along the path.
+// At completion, this order is written into m_path, starting from the
+// target.  The graph itself is only read, never modified.
 //
 // The aStar STL code is originally based on public domain code available 
 // on the internet.
 //
-void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
+void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, 
+        VertInf *start, VertInf *startPrev)
 {
     ANodeCmp pendingCmp;
 
+    m_workspace = &threadWorkspace();
+    m_workspace->reset();
+
     bool isOrthogonal = (lineRef->routingType() == ConnType_Orthogonal);
 
     if (start == nullptr)
@@ -1035,23 +1238,23 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
     }
 
 
-    if (m_cost_targets.empty())
+    if (m_workspace->costTargets.empty())
     {
-        m_cost_targets.push_back(tar);
+        m_workspace->costTargets.push_back(tar);
         // For polyline routing, assume target has visibility is all 
         // directions for the purpose of cost estimations.
-        m_cost_targets_directions.push_back(CostDirectionN |
+        m_workspace->costTargetsDirections.push_back(CostDirectionN |
                 CostDirectionE | CostDirectionS | CostDirectionW);
-        m_cost_targets_displacements.push_back(0.0);
+        m_workspace->costTargetsDisplacements.push_back(0.0);
     }
 
 #ifdef ESTIMATED_COST_DEBUG
     fprintf(stderr, "------------\n");
-    for (size_t i = 0; i < m_cost_targets.size(); ++i)
+    for (size_t i = 0; i < m_workspace->costTargets.size(); ++i)
     {
-        fprintf(stderr,"== %g %g - ", m_cost_targets[i]->point.x,
-                m_cost_targets[i]->point.y);
-        printDirections(stderr, m_cost_targets_directions[i]);
+        fprintf(stderr,"== %g %g - ", m_workspace->costTargets[i]->point.x,
+                m_workspace->costTargets[i]->point.y);
+        printDirections(stderr, m_workspace->costTargetsDirections[i]);
         fprintf(stderr,"\n");
     }
 #endif
@@ -1071,8 +1274,7 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
     endPoints.push_back(tar->point);
     
     // Heap of PENDING nodes.
-    std::vector<ANode *> PENDING;
-    PENDING.reserve(1000);
+    std::vector<ANode *>& PENDING = m_workspace->pending;
 
     size_t exploredCount = 0;
     ANode node, ati;
@@ -1131,7 +1333,7 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
             {
                 bool addToPending = false;
                 bestNode = newANode(node, addToPending);
-                bestNode->inf->aStarDoneNodes.push_back(bestNode);
+                addToDone(bestNode);
                 ++exploredCount;
             }
             else
@@ -1146,7 +1348,7 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
     }
     else
     {
-        if (start->pathNext)
+        if (startPrev)
         {
             // If we are doing checkpoint routing and have already done one
             // path, then we have an existing segment to consider for the 
@@ -1155,9 +1357,8 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
             // us to first search in a collinear direction from the previous 
             // segment.
             bool addToPending = false;
-            bestNode = newANode(ANode(start->pathNext, timestamp++), 
-                    addToPending);
-            bestNode->inf->aStarDoneNodes.push_back(bestNode);
+            bestNode = newANode(ANode(startPrev, timestamp++), addToPending);
+            addToDone(bestNode);
             ++exploredCount;
         }
 
@@ -1174,7 +1375,8 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
         PENDING.push_back(newNode);
     }
 
-    tar->pathNext = nullptr;
+    m_path.clear();
+    m_path_cost = 0;
 
     // Create a heap from PENDING for sorting
     using std::make_heap; using std::push_heap; using std::pop_heap;
@@ -1183,7 +1385,6 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
     // Continue until the queue is empty.
     while (!PENDING.empty())
     {
-        TIMER_VAR_ADD(router, 0, 1);
         // Set the Node with lowest f value to BESTNODE.
         // Since the ANode operator< is reversed, the head of the
         // heap is the node with the lowest f value.
@@ -1205,16 +1406,15 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
         }
 #endif
 
-        // Remove this node from the aStarPendingList
-        std::list<ANode *>::iterator finishIt = 
-                bestNodeInf->aStarPendingNodes.end();
-        for (std::list<ANode *>::iterator currInd = 
-                bestNodeInf->aStarPendingNodes.begin(); currInd != finishIt; 
-                ++currInd)
+        // Remove this node from the pending list for its vertex.
+        AStarVertexState& bestNodeState = 
+                m_workspace->vertexState(bestNodeInf);
+        for (ANode **link = &(bestNodeState.pending); *link; 
+                link = &((*link)->nextAtVertex))
         {
-            if (*currInd == bestNode)
+            if (*link == bestNode)
             {
-                bestNodeInf->aStarPendingNodes.erase(currInd);
+                *link = bestNode->nextAtVertex;
                 break;
             }
         }
@@ -1228,7 +1428,7 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
         PENDING.pop_back();
 
         // Add the bestNode into the Done set.
-        bestNodeInf->aStarDoneNodes.push_back(bestNode);
+        addToDone(bestNode);
         ++exploredCount;
 
         VertInf *prevInf = (bestNode->prevNode) ? bestNode->prevNode->inf : nullptr;
@@ -1247,20 +1447,20 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
 
         if (bestNodeInf == tar)
         {
-            TIMER_VAR_ADD(router, 1, PENDING.size());
             // This node is our goal.
 #ifdef ASTAR_DEBUG
             db_printf("LINE %10d  Steps: %4d  Cost: %g\n", lineRef->id(), 
                     (int) exploredCount, bestNode->f);
 #endif
      
-            // Correct all the pathNext pointers.
-            for (ANode *curr = bestNode; curr->prevNode; curr = curr->prevNode)
+            // Record the path back from the target.
+            m_path_cost = bestNode->g;
+            for (ANode *curr = bestNode; curr; curr = curr->prevNode)
             {
 #ifdef ASTAR_DEBUG
                 db_printf("[%.12f, %.12f]\n", curr->inf->point.x, curr->inf->point.y);
 #endif
-                curr->inf->pathNext = curr->prevNode->inf;
+                m_path.push_back(curr->inf);
             }
 #ifdef ASTAR_DEBUG
             db_printf("\n");
@@ -1271,26 +1471,31 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
         }
 
         // Check adjacent points in graph and add them to the queue.
-        EdgeInfList& visList = (!isOrthogonal) ?
-                bestNodeInf->visList : bestNodeInf->orthogVisList;
+        const AdjacencyRow edges = router->compactAdjacency(isOrthogonal).
+                adjacentEdges(bestNodeInf, m_workspace->adjacentEdges);
+        std::vector<unsigned int>& edgeOrder = m_workspace->edgeOrder;
+        edgeOrder.resize(edges.size());
+        for (unsigned int i = 0; i < edgeOrder.size(); ++i)
+        {
+            edgeOrder[i] = i;
+        }
         if (isOrthogonal)
         {
             // We would like to explore in a structured way, 
             // so sort the points in the visList...
-            CmpVisEdgeRotation compare(prevInf);
-            visList.sort(compare);
+            CmpVisEdgeRotation compare(prevInf, bestNodeInf->point, edges);
+            stableInsertionSort(edgeOrder, compare);
         }
-        EdgeInfList::const_iterator finish = visList.end();
-        for (EdgeInfList::const_iterator edge = visList.begin(); 
-                edge != finish; ++edge)
+        for (size_t k = 0; k < edgeOrder.size(); ++k)
         {
-            if ((*edge)->isDisabled())
+            const unsigned int edge = edgeOrder[k];
+            if (edges.isDisabled(edge))
             {
                 // Skip disabled edges.
                 continue;
             }
 
-            node = ANode((*edge)->otherVert(bestNodeInf), timestamp++);
+            node = ANode(edges.other(edge), timestamp++);
             
             // Set the index to the previous ANode that we reached
             // this ANode via.
@@ -1330,7 +1535,7 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
                 }
             }
 
-            if (isOrthogonal && !(*edge)->isDummyConnection())
+            if (isOrthogonal && !edges.isDummyConnection(edge))
             {
                 // Orthogonal routing optimisation.
                 // Skip the edges that don't lead to shape edges, or the 
@@ -1387,7 +1592,7 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
                 }
             }
 
-            double edgeDist = (*edge)->getDist();
+            double edgeDist = edges.dist(edge);
 
             if (edgeDist == 0)
             {
@@ -1407,9 +1612,9 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
 
             // Figure out if we are at one of the cost targets.
             bool atCostTarget = false;
-            for (size_t i = 0; i < m_cost_targets.size(); ++i)
+            for (size_t i = 0; i < m_workspace->costTargets.size(); ++i)
             {
-                if (bestNode->inf == m_cost_targets[i])
+                if (bestNode->inf == m_workspace->costTargets[i])
                         
                 {
                     atCostTarget = true;
@@ -1468,11 +1673,11 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
 
     
             // Check to see if already on PENDING
-            std::list<ANode *>::const_iterator finish = node.inf->aStarPendingNodes.end();
-            for (std::list<ANode *>::const_iterator currInd = 
-                    node.inf->aStarPendingNodes.begin(); currInd != finish; ++currInd)
+            AStarVertexState& nodeState = m_workspace->vertexState(node.inf);
+            for (ANode *currInd = nodeState.pending; currInd; 
+                    currInd = currInd->nextAtVertex)
             {
-                ati = **currInd;
+                ati = *currInd;
                 // The (node.prevNode == ati.prevNode) is redundant, but may
                 // save checking the mosre costly prevNode->inf test if the
                 // Nodes are the same.
@@ -1483,8 +1688,10 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
                     // If already on PENDING
                     if (node.g < ati.g)
                     {
-                        // Replace the existing node in PENDING
-                        **currInd = node;
+                        // Replace the existing node in PENDING, keeping
+                        // its place in the list for this vertex.
+                        node.nextAtVertex = ati.nextAtVertex;
+                        *currInd = node;
                         make_heap( PENDING.begin(), PENDING.end(), pendingCmp);
                     }
                     bNodeFound = true;
@@ -1495,11 +1702,10 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
             {
                 // Check to see if it is already in the Done set for this
                 // vertex.
-                for (std::list<ANode *>::const_iterator currInd = 
-                        node.inf->aStarDoneNodes.begin();
-                        currInd != node.inf->aStarDoneNodes.end(); ++currInd)
+                for (ANode *currInd = nodeState.done; currInd; 
+                        currInd = currInd->nextAtVertex)
                 {
-                    ati = **currInd;
+                    ati = *currInd;
                     // The (node.prevNode == ati.prevNode) is redundant, but may
                     // save checking the mosre costly prevNode->inf test if the
                     // Nodes are the same.
@@ -1540,14 +1746,9 @@ void AStarPathPrivate::search(ConnRef *lineRef, VertInf *src, VertInf *tar, Vert
         }
     }
 
-    // Cleanup lists used to store Done and Pending sets for each vertex.
-    VertInf *endVert = router->vertices.end();
-    for (VertInf *k = router->vertices.connsBegin(); k != endVert;
-            k = k->lstNext)
-    {
-        k->aStarDoneNodes.clear();
-        k->aStarPendingNodes.clear();
-    }
+    TIMER_VAR_ADD(router, tvAStarSearches, 1);
+    TIMER_VAR_ADD(router, tvAStarExpansions, exploredCount);
+    TIMER_VAR_MAX(router, tvAStarExpansions, exploredCount);
 }
 
 
@@ -26,6 +26,8 @@
 #ifndef AVOID_MAKEPATH_H
 #define AVOID_MAKEPATH_H
 
+#include <vector>
+
 
 namespace Avoid {
 
@@ -34,13 +36,31 @@ class AStarPathPrivate;
 class ANode;
 class VertInf;
 
+// An A* search for a connector route.  All state for the search, including 
+// the resulting path, is kept in this object rather than in the visibility 
+// graph, so multiple searches may be run concurrently over the same graph
+// as long as it isn't modified while they are in progress.
+//
 class AStarPath
 {
     public:
         AStarPath();
         ~AStarPath();
+        // startPrev is the vertex that preceded start on an existing 
+        // path, if any.  This is used for checkpoint routing to continue
+        // in a collinear direction from the previous path segment.
         void search(ConnRef *lineRef, VertInf *src, VertInf *tar, 
-                VertInf *start);
+                VertInf *start, VertInf *startPrev = nullptr);
+        // Returns the vertices of the path found by the last search,
+        // ordered from the target back to the first vertex of the path,
+        // or an empty list if the target could not be reached.
+        const std::vector<VertInf *>& path(void) const;
+        // Returns the number of vertices in the found path from the target
+        // back to vert (inclusive) or zero if vert isn't on the path.
+        unsigned int pathLeadsBackTo(const VertInf *vert) const;
+        // Returns the cost of the path found by the last search, or zero
+        // if the target could not be reached.
+        double pathCost(void) const;
     private:
         AStarPathPrivate *m_private;        
 };
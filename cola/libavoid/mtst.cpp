@@ -336,14 +336,13 @@ void MinimumTerminalSpanningTree::constructSequential(void)
         vHeap.pop_back();
 
         // For each edge from this vertex...
-        EdgeInfList& visList = (!isOrthogonal) ? u->visList : u->orthogVisList;
-        EdgeInfList::const_iterator finish = visList.end();
+        const AdjacencyRow edges = router->compactAdjacency(isOrthogonal).
+                adjacentEdges(u, adjacentEdges);
         VertInf *extraVertex = nullptr;
-        for (EdgeInfList::const_iterator edge = visList.begin();
-                edge != finish; ++edge)
+        for (size_t edge = 0; edge < edges.size(); ++edge)
         {
-            VertInf *v = (*edge)->otherVert(u);
-            double edgeDist = (*edge)->getDist();
+            VertInf *v = edges.other(edge);
+            double edgeDist = edges.dist(edge);
 
             // Assign a distance (length) of 1 for dummy visibility edges
             // which may not accurately reflect the real distance of the edge.
@@ -435,11 +434,10 @@ void MinimumTerminalSpanningTree::constructSequential(void)
 
                 // The default cost is the cost back to the root of each
                 // forest plus the length of this edge.
-                double cost = (*edge)->m_vert1->sptfDist +
-                        (*edge)->m_vert2->sptfDist + secondJoinCost +
-                        (*edge)->getDist();
-                (*edge)->setMtstDist(cost);
-                beHeap.push_back(*edge);
+                double cost = u->sptfDist + v->sptfDist + secondJoinCost +
+                        edges.dist(edge);
+                edges.edge(edge)->setMtstDist(cost);
+                beHeap.push_back(edges.edge(edge));
 
 #ifdef DEBUGHANDLER
                 if (router->debugHandler())
@@ -452,7 +450,7 @@ void MinimumTerminalSpanningTree::constructSequential(void)
     }
     // Make the bridging edge heap.
     std::make_heap(beHeap.begin(), beHeap.end(), beHeapCompare);
-    TIMER_STOP(router);
+    TIMER_STOP(router, tmHyperedgeForest);
 
     // Next, perform extended Kruskal's algorithm
     // ==========================================
@@ -517,7 +515,7 @@ void MinimumTerminalSpanningTree::constructSequential(void)
     nodes.clear();
     allsets.clear();
 
-    TIMER_STOP(router);
+    TIMER_STOP(router, tmHyperedgeMTST);
 }
 
 VertInf *MinimumTerminalSpanningTree::orthogonalPartner(VertInf *vert,
@@ -587,18 +585,18 @@ LayeredOrthogonalEdgeList MinimumTerminalSpanningTree::
     bool isRealVert = (vert->id != dimensionChangeVertexID);
     VertInf *realVert = (isRealVert) ? vert : orthogonalPartner(vert);
     COLA_ASSERT(realVert->id != dimensionChangeVertexID);
-    EdgeInfList& visList = (!isOrthogonal) ? realVert->visList : realVert->orthogVisList;
-    EdgeInfList::const_iterator finish = visList.end();
-    for (EdgeInfList::const_iterator edge = visList.begin(); edge != finish; ++edge)
+    const AdjacencyRow edges = router->compactAdjacency(isOrthogonal).
+            adjacentEdges(realVert, adjacentEdges);
+    for (size_t edge = 0; edge < edges.size(); ++edge)
     {
-        VertInf *other = (*edge)->otherVert(realVert);
+        VertInf *other = edges.other(edge);
 
         if (other == orthogonalPartner(realVert))
         {
             VertInf *partner = (isRealVert) ? other : orthogonalPartner(other);
             if (partner != prev)
             {
-                edgeList.push_back(std::make_pair(*edge, partner));
+                edgeList.push_back(std::make_pair(edges.edge(edge), partner));
             }
             continue;
         }
@@ -610,20 +608,20 @@ LayeredOrthogonalEdgeList MinimumTerminalSpanningTree::
         {
             if (isRealVert && (prev != partner))
             {
-                edgeList.push_back(std::make_pair(*edge, partner));
+                edgeList.push_back(std::make_pair(edges.edge(edge), partner));
             }
         }
         else if (other->point.x == realVert->point.x)
         {
             if (!isRealVert && (prev != partner))
             {
-                edgeList.push_back(std::make_pair(*edge, partner));
+                edgeList.push_back(std::make_pair(edges.edge(edge), partner));
             }
         }
         else
         {
             printf("Warning, nonorthogonal edge.\n");
-            edgeList.push_back(std::make_pair(*edge, other));
+            edgeList.push_back(std::make_pair(edges.edge(edge), other));
         }
     }
 
@@ -814,7 +812,7 @@ void MinimumTerminalSpanningTree::constructInterleaved(void)
         }
     }
     COLA_ASSERT(origTerminals.size() == 1);
-    TIMER_STOP(router);
+    TIMER_STOP(router, tmHyperedgeAlt);
 
     // Free Root Vertex Points from all vertices.
     for (std::list<VertInf **>::iterator curr = rootVertexPointers.begin();
@@ -29,8 +29,10 @@
 #include <set>
 #include <list>
 #include <utility>
+#include <vector>
 
 #include "libavoid/vertices.h"
+#include "libavoid/graph.h"
 #include "libavoid/hyperedgetree.h"
 
 
@@ -121,6 +123,10 @@ class MinimumTerminalSpanningTree
         std::vector<VertInf *> vHeap;
         HeapCmpVertInf vHeapCompare;
 
+        // Scratch space for the edges out of the vertex being explored, if
+        // it has no up to date compact adjacency row.
+        AdjacencyRowStorage adjacentEdges;
+
         // Bridging edge heap for the extended Kruskal's algorithm.
         std::vector<EdgeInf *> beHeap;
         CmpEdgeInf beHeapCompare;
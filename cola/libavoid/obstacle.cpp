@@ -26,6 +26,7 @@
 #include "libavoid/obstacle.h"
 #include "libavoid/router.h"
 #include "libavoid/connectionpin.h"
+#include "libavoid/spatialindex.h"
 #include "libavoid/debug.h"
 #include "uniqueid.h"
 
@@ -42,6 +43,7 @@ Obstacle::Obstacle(Router *router, Polygon ply, const unsigned int id)
 {
     COLA_ASSERT(m_router != nullptr);
     m_id = m_router->assignId(id);
+    m_router->m_obstacles_by_id.insert(std::make_pair(m_id, this));
 
     VertID i = VertID(m_id, 0);
 
@@ -80,6 +82,18 @@ Obstacle::~Obstacle()
     COLA_ASSERT(m_active == false);
     COLA_ASSERT(m_first_vert != nullptr);
     
+    std::pair<ObstacleIdMap::iterator, ObstacleIdMap::iterator> range =
+            m_router->m_obstacles_by_id.equal_range(m_id);
+    for (ObstacleIdMap::iterator curr = range.first; curr != range.second;
+            ++curr)
+    {
+        if (curr->second == this)
+        {
+            m_router->m_obstacles_by_id.erase(curr);
+            break;
+        }
+    }
+
     VertInf *it = m_first_vert;
     do
     {
@@ -106,6 +120,7 @@ void Obstacle::setNewPoly(const Polygon& poly)
     
     m_polygon = poly;
     Polygon routingPoly = routingPolygon();
+    m_router->m_obstacle_index->moveObstacle(this);
 
     VertInf *curr = m_first_vert;
     for (size_t pt_i = 0; pt_i < routingPoly.size(); ++pt_i)
@@ -140,6 +155,8 @@ void Obstacle::makeActive(void)
     // Add to shapeRefs list.
     m_router_obstacles_pos = m_router->m_obstacles.insert(
             m_router->m_obstacles.begin(), this);
+    m_router->m_obstacle_index->addObstacle(this);
+    m_router->addObjectId(m_id);
 
     // Add points to vertex list.
     VertInf *it = m_first_vert;
@@ -162,6 +179,8 @@ void Obstacle::makeInactive(void)
     
     // Remove from shapeRefs list.
     m_router->m_obstacles.erase(m_router_obstacles_pos);
+    m_router->m_obstacle_index->removeObstacle(this);
+    m_router->removeObjectId(m_id);
 
     // Remove points from vertex list.
     VertInf *it = m_first_vert;
@@ -218,7 +237,12 @@ std::vector<Point> Obstacle::possiblePinPoints(unsigned int pinClassId) const
 size_t Obstacle::addConnectionPin(ShapeConnectionPin *pin)
 {
     m_connection_pins.insert(pin);
-    m_router->modifyConnectionPin(pin);
+    // Pins loaded by Router::bulkLoad() are set up along with their shape,
+    // so there is no change to queue.
+    if (!m_router->m_bulk_loading)
+    {
+        m_router->modifyConnectionPin(pin);
+    }
 
     return m_connection_pins.size();
 }
@@ -28,7 +28,11 @@
 #include <cmath>
 #include <set>
 #include <list>
+#include <vector>
+#include <unordered_set>
 #include <algorithm>
+#include <functional>
+#include <queue>
 
 #include "libavoid/router.h"
 #include "libavoid/geomtypes.h"
@@ -41,6 +45,7 @@
 #include "libavoid/assertions.h"
 #include "libavoid/scanline.h"
 #include "libavoid/debughandler.h"
+#include "libavoid/parallel.h"
 
 
 namespace Avoid {
@@ -639,7 +644,11 @@ struct CmpVertInf
         {
             return u->point.y < v->point.y;
         }
-        return u < v;
+        // Vertices at the same point, such as connection pins in the
+        // same position on a shape, are ordered by creation rather than
+        // address, so which of them gets visibility doesn't depend on
+        // where they happen to be allocated.
+        return u->uniqueId < v->uniqueId;
     }
 };
 
@@ -650,6 +659,81 @@ typedef std::set<VertInf *, CmpVertInf> VertSet;
 // along with vertices for these points.
 typedef std::set<PosVertInf> BreakpointSet;
 
+// A set of closed intervals of positions in one dimension.
+class PositionBand
+{
+    public:
+        void add(const double a, const double b)
+        {
+            m_intervals.push_back(
+                    std::make_pair(std::min(a, b), std::max(a, b)));
+        }
+        // Sorts and merges the intervals.  Must be called after adding
+        // intervals and before querying.
+        void finalise(void)
+        {
+            std::sort(m_intervals.begin(), m_intervals.end());
+            size_t merged = 0;
+            for (size_t i = 0; i < m_intervals.size(); ++i)
+            {
+                if ((merged > 0) &&
+                        (m_intervals[i].first <= m_intervals[merged - 1].second))
+                {
+                    m_intervals[merged - 1].second = std::max(
+                            m_intervals[merged - 1].second,
+                            m_intervals[i].second);
+                }
+                else
+                {
+                    m_intervals[merged++] = m_intervals[i];
+                }
+            }
+            m_intervals.resize(merged);
+        }
+        bool empty(void) const
+        {
+            return m_intervals.empty();
+        }
+        // Returns whether [begin, finish] intersects any of the intervals.
+        bool overlaps(const double begin, const double finish) const
+        {
+            // Find the first interval not ending before begin.
+            size_t lower = 0, upper = m_intervals.size();
+            while (lower < upper)
+            {
+                size_t mid = (lower + upper) / 2;
+                if (m_intervals[mid].second < begin)
+                {
+                    lower = mid + 1;
+                }
+                else
+                {
+                    upper = mid;
+                }
+            }
+            return (lower < m_intervals.size()) &&
+                    (m_intervals[lower].first <= finish);
+        }
+        bool contains(const double pos) const
+        {
+            return overlaps(pos, pos);
+        }
+
+    private:
+        std::vector<std::pair<double, double> > m_intervals;
+};
+
+static OrthogonalVisGraphState::LineVertex lineVertex(const double pos,
+        VertInf *vert, const ScanVisDirFlags dirs)
+{
+    OrthogonalVisGraphState::LineVertex lineVert;
+    lineVert.pos = pos;
+    lineVert.vert = vert;
+    lineVert.dirs = dirs;
+    lineVert.isDummy = (vert->id == dummyOrthogID);
+    return lineVert;
+}
+
 // Temporary structure used to store the possible horizontal visibility
 // lines arising from the vertical sweep.
 class LineSegment
@@ -660,7 +744,9 @@ public:
         : begin(b),
           finish(f),
           pos(p),
-          shapeSide(ss)
+          shapeSide(ss),
+          recordIndex(noRecord),
+          regenerateBand(nullptr)
     {
         COLA_ASSERT(begin < finish);
 
@@ -677,7 +763,9 @@ public:
         : begin(bf),
           finish(bf),
           pos(p),
-          shapeSide(false)
+          shapeSide(false),
+          recordIndex(noRecord),
+          regenerateBand(nullptr)
     {
         if (bfvi)
         {
@@ -1079,7 +1167,6 @@ public:
         // Set flags for orthogonal routing optimisation.
         setLongRangeVisibilityFlags(dim);
 
-        const bool orthogonal = true;
         BreakpointSet::iterator vert, last;
 #if 0
         last = breakPoints.end();
@@ -1132,10 +1219,7 @@ public:
                     bool canSeeDown = (vert->dirs & VisDirDown);
                     if (canSeeDown && !(side->vert->id.isConnPt()))
                     {
-                        EdgeInf *edge = new
-                                EdgeInf(side->vert, vert->vert, orthogonal);
-                        edge->setDist(vert->vert->point[dim] -
-                                side->vert->point[dim]);
+                        addVisibilityEdge(side->vert, vert->vert, dim);
                     }
 
                     // Give last visibility back to the first non-connector
@@ -1149,10 +1233,7 @@ public:
                     bool canSeeUp = (last->dirs & VisDirUp);
                     if (canSeeUp && (side != breakPoints.end()))
                     {
-                        EdgeInf *edge = new
-                                EdgeInf(last->vert, side->vert, orthogonal);
-                        edge->setDist(side->vert->point[dim] -
-                                last->vert->point[dim]);
+                        addVisibilityEdge(last->vert, side->vert, dim);
                     }
                 }
 
@@ -1178,10 +1259,7 @@ public:
                 }
                 if (generateEdge)
                 {
-                    EdgeInf *edge =
-                            new EdgeInf(last->vert, vert->vert, orthogonal);
-                    edge->setDist(vert->vert->point[dim] -
-                            last->vert->point[dim]);
+                    addVisibilityEdge(last->vert, vert->vert, dim);
                 }
 
                 ++last;
@@ -1201,6 +1279,53 @@ public:
                 // position.  Last is now in the right place, so do nothing.
             }
         }
+
+        if (recordIndex != noRecord)
+        {
+            // Remember how the line was split, so the graph can later be
+            // updated incrementally.
+            std::vector<OrthogonalVisGraphState::LineVertex>& record =
+                    router->m_orthogonal_graph_state->lines[dim][
+                        recordIndex].breakPoints;
+            record.clear();
+            for (vert = breakPoints.begin(); vert != breakPoints.end(); ++vert)
+            {
+                record.push_back(lineVertex(vert->pos, vert->vert,
+                        vert->dirs));
+            }
+        }
+    }
+
+    // Adds a visibility edge between the vertices a and b, with a at the
+    // lower position.  When only part of the line is being regenerated,
+    // edges not overlapping the regenerated positions already exist.
+    void addVisibilityEdge(VertInf *a, VertInf *b, size_t dim)
+    {
+        if (regenerateBand &&
+                !regenerateBand->overlaps(a->point[dim], b->point[dim]))
+        {
+            return;
+        }
+        const bool orthogonal = true;
+        EdgeInf *edge = new EdgeInf(a, b, orthogonal);
+        edge->setDist(b->point[dim] - a->point[dim]);
+    }
+
+    // Returns the state of the line as found by the sweep, i.e., before it
+    // has been intersected with any other lines.
+    OrthogonalVisGraphState::Line record(void) const
+    {
+        OrthogonalVisGraphState::Line line;
+        line.begin = begin;
+        line.finish = finish;
+        line.pos = pos;
+        line.shapeSide = shapeSide;
+        for (VertSet::const_iterator v = vertInfs.begin();
+                v != vertInfs.end(); ++v)
+        {
+            line.vertInfs.push_back(lineVertex(0, *v, VisDirNone));
+        }
+        return line;
     }
 
     double begin;
@@ -1212,6 +1337,15 @@ public:
 
     VertSet vertInfs;
     BreakpointSet breakPoints;
+
+    // The index of the line in the lines of the OrthogonalVisGraphState,
+    // if its result is being recorded, otherwise noRecord.
+    static const size_t noRecord = (size_t) -1;
+    size_t recordIndex;
+
+    // If set, the line is being regenerated only at these positions and
+    // its other edges are left as they are.
+    const PositionBand *regenerateBand;
 private:
     // MSVC wants to generate the assignment operator and the default
     // constructor, but fails.  Therefore we declare them private and
@@ -1729,13 +1863,16 @@ void fixConnectionPointVisibilityOnOutsideOfVisibilityGraph(Event **events,
     }
 }
 
-extern void generateStaticOrthogonalVisGraph(Router *router)
+// Creates the events for a sweep through the obstacles and connection
+// points in the given dimension, sorted by their position in it.  Sets
+// totalEvents to the number of events.
+static Event **createSweepEvents(Router *router, const size_t dim,
+        size_t& totalEvents)
 {
+    const size_t altDim = (dim + 1) % 2;
     const size_t n = router->m_obstacles.size();
     const unsigned cpn = router->vertices.connsSize();
-    // Set up the events for the vertical sweep.
-    size_t totalEvents = (2 * n) + cpn;
-    Event **events = new Event*[totalEvents];
+    Event **events = new Event*[(2 * n) + cpn];
     unsigned ctr = 0;
     ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
     for (unsigned i = 0; i < n; i++)
@@ -1747,26 +1884,63 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
         {
             // Junctions that are free to move are not treated as obstacles.
             ++obstacleIt;
-            totalEvents -= 2;
             continue;
         }
 #endif
-
         Box bbox = obstacle->routingBox();
-        double midX = bbox.min.x + ((bbox.max.x - bbox.min.x) / 2);
-        Node *v = new Node(obstacle, midX);
-        events[ctr++] = new Event(Open, v, bbox.min.y);
-        events[ctr++] = new Event(Close, v, bbox.max.y);
+        double mid = bbox.min[altDim] +
+                ((bbox.max[altDim] - bbox.min[altDim]) / 2);
+        Node *v = new Node(obstacle, mid);
+        events[ctr++] = new Event(Open, v, bbox.min[dim]);
+        events[ctr++] = new Event(Close, v, bbox.max[dim]);
 
         ++obstacleIt;
     }
+    for (VertInf *curr = router->vertices.connsBegin();
+            curr && (curr != router->vertices.shapesBegin());
+            curr = curr->lstNext)
+    {
+        if (curr->visDirections == ConnDirNone)
+        {
+            // This is a connector endpoint that is attached to a connection
+            // pin on a shape, so it doesn't need to be given visibility.
+            // Thus, skip it.
+            continue;
+        }
+        Point& point = curr->point;
+
+        Node *v = new Node(curr, point[altDim]);
+        events[ctr++] = new Event(ConnPoint, v, point[dim]);
+    }
+    totalEvents = ctr;
+    qsort((Event*)events, (size_t) totalEvents, sizeof(Event*), compare_events);
+
+    return events;
+}
+
+// Frees events that have not been processed by a sweep.
+static void deleteSweepEvents(Event **events, const size_t totalEvents)
+{
+    for (size_t i = 0; i < totalEvents; ++i)
+    {
+        if (events[i]->type != Close)
+        {
+            // Open and Close events share a node.
+            delete events[i]->v;
+        }
+        delete events[i];
+    }
+    delete [] events;
+}
 
 #ifdef DEBUGHANDLER
+static void updateDebugObstacleBoxes(Router *router)
+{
     if (router->debugHandler())
     {
         std::vector<Box> obstacleBoxes;
         ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
-        for (unsigned i = 0; i < n; i++)
+        for (unsigned i = 0; i < router->m_obstacles.size(); i++)
         {
             Obstacle *obstacle = *obstacleIt;
             JunctionRef *junction = dynamic_cast<JunctionRef *> (obstacle);
@@ -1782,26 +1956,119 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
         }
         router->debugHandler()->updateObstacleBoxes(obstacleBoxes);
     }
+}
 #endif
 
+
+OrthogonalVisGraphState::OrthogonalVisGraphState()
+    : valid(false)
+{
+}
+
+void OrthogonalVisGraphState::clear(void)
+{
+    valid = false;
+    obstacles.clear();
+    connPoints.clear();
+    lines[XDIM].clear();
+    lines[YDIM].clear();
+    edgeIds.clear();
+}
+
+struct CmpObstacleInfoId
+{
+    bool operator()(const OrthogonalVisGraphState::ObstacleInfo& lhs,
+            const OrthogonalVisGraphState::ObstacleInfo& rhs) const
+    {
+        return lhs.id < rhs.id;
+    }
+};
+
+struct CmpConnPointInfoId
+{
+    bool operator()(const OrthogonalVisGraphState::ConnPointInfo& lhs,
+            const OrthogonalVisGraphState::ConnPointInfo& rhs) const
+    {
+        return lhs.id < rhs.id;
+    }
+};
+
+// Returns the number of edges at vert that were created by the sweeps.
+static size_t countGraphEdges(VertInf *vert,
+        const std::unordered_set<unsigned int>& edgeIds)
+{
+    size_t count = 0;
+    for (EdgeInfList::const_iterator edge = vert->orthogVisList.begin();
+            edge != vert->orthogVisList.end(); ++edge)
+    {
+        count += edgeIds.count((*edge)->uniqueId());
+    }
+    return count;
+}
+
+// Records the obstacles and connection points that are the input to the
+// sweeps, for comparison when the graph is next updated.
+static void recordSweepInputs(Router *router,
+        const std::unordered_set<unsigned int>& edgeIds,
+        std::vector<OrthogonalVisGraphState::ObstacleInfo>& obstacles,
+        std::vector<OrthogonalVisGraphState::ConnPointInfo>& connPoints)
+{
+    obstacles.clear();
+    for (ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
+            obstacleIt != router->m_obstacles.end(); ++obstacleIt)
+    {
+        Obstacle *obstacle = *obstacleIt;
+        JunctionRef *junction = dynamic_cast<JunctionRef *> (obstacle);
+        if (junction && ! junction->positionFixed())
+        {
+            continue;
+        }
+        OrthogonalVisGraphState::ObstacleInfo info;
+        info.id = obstacle->uniqueId();
+        info.box = obstacle->routingBox();
+        obstacles.push_back(info);
+    }
+    std::sort(obstacles.begin(), obstacles.end(), CmpObstacleInfoId());
+
+    connPoints.clear();
     for (VertInf *curr = router->vertices.connsBegin();
             curr && (curr != router->vertices.shapesBegin());
             curr = curr->lstNext)
     {
         if (curr->visDirections == ConnDirNone)
         {
-            // This is a connector endpoint that is attached to a connection
-            // pin on a shape, so it doesn't need to be given visibility.
-            // Thus, skip it and record that there is one less total event.
-            --totalEvents;
             continue;
         }
-        Point& point = curr->point;
+        OrthogonalVisGraphState::ConnPointInfo info;
+        info.id = curr->uniqueId;
+        info.vert = curr;
+        info.point = curr->point;
+        info.visDirections = curr->visDirections;
+        info.edgeCount = countGraphEdges(curr, edgeIds);
+        connPoints.push_back(info);
+    }
+    std::sort(connPoints.begin(), connPoints.end(), CmpConnPointInfoId());
+}
 
-        Node *v = new Node(curr, point.x);
-        events[ctr++] = new Event(ConnPoint, v, point.y);
+extern void generateStaticOrthogonalVisGraph(Router *router)
+{
+    // If enabled, the lines found by the sweeps are recorded in the
+    // state so that the graph can be updated incrementally.
+    OrthogonalVisGraphState *state = nullptr;
+    if (router->routingOption(incrementallyUpdateOrthogonalVisibilityGraph))
+    {
+        state = router->m_orthogonal_graph_state;
+        state->clear();
     }
-    qsort((Event*)events, (size_t) totalEvents, sizeof(Event*), compare_events);
+
+    // Set up the events for the vertical sweep.
+    TIMER_START(router, tmOrthogGraphScanX);
+    size_t totalEvents = 0;
+    Event **events = createSweepEvents(router, YDIM, totalEvents);
+
+#ifdef DEBUGHANDLER
+    updateDebugObstacleBoxes(router);
+#endif
 
     // Correct visibility for pins or connector endpoints on the leading or
     // trailing edge of the visibility graph which may only have visibility in
@@ -1859,51 +2126,25 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
     {
         delete events[i];
     }
+    delete [] events;
 
     segments.list().sort();
     // DEBUG HELPER: here you can check horizontal lines, see `segments` variable
-
-    // Set up the events for the horizontal sweep.
-    SegmentListWrapper vertSegments;
-    ctr = 0;
-    obstacleIt = router->m_obstacles.begin();
-    for (unsigned i = 0; i < n; i++)
+    if (state)
     {
-        Obstacle *obstacle = *obstacleIt;
-#ifndef PAPER
-        JunctionRef *junction = dynamic_cast<JunctionRef *> (obstacle);
-        if (junction && ! junction->positionFixed())
+        for (SegmentList::iterator curr = segments.list().begin();
+                curr != segments.list().end(); ++curr)
         {
-            // Junctions that are free to move are not treated as obstacles.
-            ++obstacleIt;
-            continue;
+            curr->recordIndex = state->lines[XDIM].size();
+            state->lines[XDIM].push_back(curr->record());
         }
-#endif
-        Box bbox = obstacle->routingBox();
-        double midY = bbox.min.y + ((bbox.max.y - bbox.min.y) / 2);
-        Node *v = new Node(obstacle, midY);
-        events[ctr++] = new Event(Open, v, bbox.min.x);
-        events[ctr++] = new Event(Close, v, bbox.max.x);
-
-        ++obstacleIt;
     }
-    for (VertInf *curr = router->vertices.connsBegin();
-            curr && (curr != router->vertices.shapesBegin());
-            curr = curr->lstNext)
-    {
-        if (curr->visDirections == ConnDirNone)
-        {
-            // This is a connector endpoint that is attached to a connection
-            // pin on a shape, so it doesn't need to be given visibility.
-            // Thus, skip it.
-            continue;
-        }
-        Point& point = curr->point;
+    TIMER_STOP(router, tmOrthogGraphScanX);
 
-        Node *v = new Node(curr, point.y);
-        events[ctr++] = new Event(ConnPoint, v, point.x);
-    }
-    qsort((Event*)events, (size_t) totalEvents, sizeof(Event*), compare_events);
+    // Set up the events for the horizontal sweep.
+    TIMER_START(router, tmOrthogGraphScanY);
+    SegmentListWrapper vertSegments;
+    events = createSweepEvents(router, XDIM, totalEvents);
 
     // Correct visibility for pins or connector endpoints on the leading or
     // trailing edge of the visibility graph which may only have visibility in
@@ -1942,6 +2183,11 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
             for (SegmentList::iterator curr = vertSegments.list().begin();
                     curr != vertSegments.list().end(); ++curr)
             {
+                if (state)
+                {
+                    curr->recordIndex = state->lines[YDIM].size();
+                    state->lines[YDIM].push_back(curr->record());
+                }
                 intersectSegments(router, segments.list(), *curr);
             }
             vertSegments.list().clear();
@@ -1982,82 +2228,576 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
 
         it = segments.list().erase(it);
     }
+
+    if (state)
+    {
+        for (EdgeInf *edge = router->visOrthogGraph.begin();
+                edge != router->visOrthogGraph.end(); edge = edge->lstNext)
+        {
+            state->edgeIds.insert(edge->uniqueId());
+        }
+        recordSweepInputs(router, state->edgeIds, state->obstacles,
+                state->connPoints);
+        state->valid = true;
+    }
+    TIMER_STOP(router, tmOrthogGraphScanY);
 }
 
 
 //============================================================================
-//                           Path Adjustment code
+//                  Incremental orthogonal visibility graph
 //============================================================================
 
-
-typedef std::pair<Point, Point> RectBounds;
-
-static bool insideRectBounds(const Point& point, const RectBounds& rectBounds)
+// Adds the positions of the obstacles and connection points that differ
+// between the previous and current sweep inputs to the bands.
+static void addChangedInputsToBands(const OrthogonalVisGraphState& state,
+        const std::vector<OrthogonalVisGraphState::ObstacleInfo>& obstacles,
+        const std::vector<OrthogonalVisGraphState::ConnPointInfo>& connPoints,
+        PositionBand bands[2])
 {
-    Point zero(0, 0);
-    if ((rectBounds.first == zero) && (rectBounds.second == zero))
+    size_t i = 0, j = 0;
+    while ((i < state.obstacles.size()) || (j < obstacles.size()))
     {
-        // We can't be inside the invalid rectangle.
-        return false;
+        const OrthogonalVisGraphState::ObstacleInfo *prev =
+                (i < state.obstacles.size()) ? &state.obstacles[i] : nullptr;
+        const OrthogonalVisGraphState::ObstacleInfo *curr =
+                (j < obstacles.size()) ? &obstacles[j] : nullptr;
+        if (prev && curr && (prev->id == curr->id))
+        {
+            ++i;
+            ++j;
+            if ((prev->box.min == curr->box.min) &&
+                    (prev->box.max == curr->box.max))
+            {
+                continue;
+            }
+        }
+        else if (prev && (!curr || (prev->id < curr->id)))
+        {
+            // Removed.
+            ++i;
+            curr = nullptr;
+        }
+        else
+        {
+            // Added.
+            ++j;
+            prev = nullptr;
+        }
+        for (size_t dim = 0; dim < 2; ++dim)
+        {
+            if (prev)
+            {
+                bands[dim].add(prev->box.min[dim], prev->box.max[dim]);
+            }
+            if (curr)
+            {
+                bands[dim].add(curr->box.min[dim], curr->box.max[dim]);
+            }
+        }
     }
 
-    for (size_t i = 0; i < 2; ++i)
+    i = j = 0;
+    while ((i < state.connPoints.size()) || (j < connPoints.size()))
     {
-        if (point[i] < rectBounds.first[i])
+        const OrthogonalVisGraphState::ConnPointInfo *prev =
+                (i < state.connPoints.size()) ? &state.connPoints[i] : nullptr;
+        const OrthogonalVisGraphState::ConnPointInfo *curr =
+                (j < connPoints.size()) ? &connPoints[j] : nullptr;
+        if (prev && curr && (prev->id == curr->id))
+        {
+            ++i;
+            ++j;
+            // Edges at a connection point are removed when the vertex is
+            // removed from the graph, so also check they are all present.
+            if ((prev->point == curr->point) &&
+                    (prev->visDirections == curr->visDirections) &&
+                    (prev->edgeCount == curr->edgeCount))
+            {
+                continue;
+            }
+        }
+        else if (prev && (!curr || (prev->id < curr->id)))
         {
-            return false;
+            ++i;
+            curr = nullptr;
         }
-        if (point[i] > rectBounds.second[i])
+        else
         {
-            return false;
+            ++j;
+            prev = nullptr;
+        }
+        for (size_t dim = 0; dim < 2; ++dim)
+        {
+            if (prev)
+            {
+                bands[dim].add(prev->point[dim], prev->point[dim]);
+            }
+            if (curr)
+            {
+                bands[dim].add(curr->point[dim], curr->point[dim]);
+            }
         }
     }
-    return true;
 }
 
-
-static void buildOrthogonalNudgingSegments(Router *router,
-        const size_t dim, ShiftSegmentList& segmentList)
+// Performs a sweep over the given events, but only processes the events
+// at positions within the band, collecting the resulting lines in segments.
+static void sweepEventsInBand(Router *router, Event **events,
+        const size_t totalEvents, const size_t dim, const PositionBand& band,
+        SegmentListWrapper& segments)
 {
-    if (router->routingParameter(segmentPenalty) == 0)
-    {
-        // The nudging code assumes the routes are pretty optimal.  This will
-        // only be true if a segment penalty is set, so just return if this
-        // is not the case.
-        return;
-    }
-    bool nudgeFinalSegments =
-            router->routingOption(nudgeOrthogonalSegmentsConnectedToShapes);
-    std::vector<RectBounds> shapeLimits;
-    if (nudgeFinalSegments)
-    {
-        // If we're going to nudge final segments, then cache the shape
-        // rectangles to save us rebuilding them multiple times.
-        const size_t n = router->m_obstacles.size();
-        shapeLimits = std::vector<RectBounds>(n);
+    void (*processEvent)(Router *, NodeSet&, SegmentListWrapper&, Event *,
+            unsigned int) = (dim == YDIM) ? processEventVert : processEventHori;
+    unsigned int phase = (dim == YDIM) ?
+            TransactionPhaseOrthogonalVisibilityGraphScanX :
+            TransactionPhaseOrthogonalVisibilityGraphScanY;
+    TimerIndex timer = (dim == YDIM) ? tmOrthogGraphScanX : tmOrthogGraphScanY;
+    TIMER_START(router, timer);
 
-        double zeroBufferDist = 0.0;
+    NodeSet scanline;
+    double thisPos = (totalEvents > 0) ? events[0]->pos : 0;
+    unsigned int posStartIndex = 0;
+    for (unsigned i = 0; i <= totalEvents; ++i)
+    {
+        router->performContinuationCheck(phase, i, totalEvents);
 
-        ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
-        for (unsigned i = 0; i < n; i++)
+        if ((i == totalEvents) || (events[i]->pos != thisPos))
         {
-            ShapeRef *shape = dynamic_cast<ShapeRef *> (*obstacleIt);
-            JunctionRef *junction = dynamic_cast<JunctionRef *> (*obstacleIt);
-            if (shape)
+            bool inBand = band.contains(thisPos);
+            for (unsigned j = posStartIndex; j < i; ++j)
             {
-                // Take the real bounds of the shape
-                Box bBox = shape->polygon().offsetBoundingBox(zeroBufferDist);
-                shapeLimits[i] = std::make_pair(bBox.min, bBox.max);
+                if (inBand)
+                {
+                    processEvent(router, scanline, segments, events[j], 2);
+                }
+                else if (events[j]->type == ConnPoint)
+                {
+                    // Connection points are otherwise only added to the
+                    // scanline and freed while being processed.
+                    delete events[j]->v;
+                }
             }
-            else if (junction)
+            for (unsigned j = posStartIndex; j < i; ++j)
             {
-                // Don't nudge segments attached to junctions,
-                // so just use the junction position here.
-                Point pos = junction->position();
-                shapeLimits[i] = std::make_pair(pos, pos);
+                processEvent(router, scanline, segments, events[j], 3);
             }
-            ++obstacleIt;
-        }
+
+            if (i == totalEvents)
+            {
+                break;
+            }
+
+            thisPos = events[i]->pos;
+            posStartIndex = i;
+        }
+
+        processEvent(router, scanline, segments, events[i], 1);
+    }
+    COLA_ASSERT(scanline.size() == 0);
+    for (unsigned i = 0; i < totalEvents; ++i)
+    {
+        delete events[i];
+    }
+    delete [] events;
+    TIMER_STOP(router, timer);
+}
+
+// Orders lines by position, then begin and finish.
+struct CmpLineSegmentPos
+{
+    bool operator()(const LineSegment& lhs, const LineSegment& rhs) const
+    {
+        if (lhs.pos != rhs.pos)
+        {
+            return lhs.pos < rhs.pos;
+        }
+        if (lhs.begin != rhs.begin)
+        {
+            return lhs.begin < rhs.begin;
+        }
+        return lhs.finish < rhs.finish;
+    }
+};
+
+// Updates the orthogonal visibility graph for changes to the obstacles and
+// connection points since it was generated (or last updated), using the
+// lines recorded from the sweeps.
+//
+// The horizontal lines depend only on the obstacles spanning their y
+// position and the connection points at that position, and similarly for
+// vertical lines.  So the lines at the y positions spanned by the changed
+// obstacles and connection points (the y band) and at the x positions
+// they span (the x band) are found again by sweeps that only process
+// events in those bands.  The remaining lines are unchanged, though those
+// crossing the other band need to be split again where they meet the new
+// lines.  These are rebuilt from their recorded state, keeping their
+// existing vertices outside the band, and only their edges overlapping the
+// band are regenerated.  All other edges are left untouched.
+//
+// Returns false, without changing the graph, if the graph needs to be
+// regenerated instead.
+extern bool updateStaticOrthogonalVisGraph(Router *router)
+{
+    OrthogonalVisGraphState *state = router->m_orthogonal_graph_state;
+    if (!state->valid)
+    {
+        return false;
+    }
+
+    // Build the events for both sweeps.  The visibility fixes are applied
+    // before the inputs are compared, since they alter connection points.
+    size_t totalVertEvents = 0;
+    Event **vertEvents = createSweepEvents(router, YDIM, totalVertEvents);
+    fixConnectionPointVisibilityOnOutsideOfVisibilityGraph(vertEvents,
+            totalVertEvents, (ConnDirLeft | ConnDirRight));
+    size_t totalHoriEvents = 0;
+    Event **horiEvents = createSweepEvents(router, XDIM, totalHoriEvents);
+    fixConnectionPointVisibilityOnOutsideOfVisibilityGraph(horiEvents,
+            totalHoriEvents, (ConnDirUp | ConnDirDown));
+
+    std::vector<OrthogonalVisGraphState::ObstacleInfo> obstacles;
+    std::vector<OrthogonalVisGraphState::ConnPointInfo> connPoints;
+    recordSweepInputs(router, state->edgeIds, obstacles, connPoints);
+
+    // bands[XDIM] is the x band, bands[YDIM] the y band.
+    PositionBand bands[2];
+    addChangedInputsToBands(*state, obstacles, connPoints, bands);
+    bands[XDIM].finalise();
+    bands[YDIM].finalise();
+
+    // Horizontal lines (lines[XDIM]) are at y positions and span x positions
+    // and vertical lines (lines[YDIM]) the opposite.  Count the lines that
+    // need to be rebuilt: those positioned in a band and those crossing the
+    // other band.
+    size_t totalLines = 0, affectedLines = 0;
+    for (size_t dim = 0; dim < 2; ++dim)
+    {
+        const PositionBand& posBand = bands[(dim + 1) % 2];
+        const PositionBand& extentBand = bands[dim];
+        std::vector<OrthogonalVisGraphState::Line>& lines = state->lines[dim];
+        totalLines += lines.size();
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            if (posBand.contains(lines[i].pos) ||
+                    extentBand.overlaps(lines[i].begin, lines[i].finish))
+            {
+                ++affectedLines;
+            }
+        }
+    }
+    if (affectedLines > (totalLines / 2))
+    {
+        // Much of the graph would change, so it is quicker to regenerate.
+        deleteSweepEvents(vertEvents, totalVertEvents);
+        deleteSweepEvents(horiEvents, totalHoriEvents);
+        return false;
+    }
+    state->obstacles.swap(obstacles);
+    state->connPoints.swap(connPoints);
+
+#ifdef DEBUGHANDLER
+    updateDebugObstacleBoxes(router);
+#endif
+
+    // Take out the lines to be rebuilt.  Their dummy vertices' visibility
+    // flags for the line's dimension are reset, since they will be set
+    // again, and the dummy vertices become candidates for deletion.
+    std::vector<OrthogonalVisGraphState::Line> rerunLines[2];
+    std::unordered_set<VertInf *> candidates;
+    for (size_t dim = 0; dim < 2; ++dim)
+    {
+        const PositionBand& posBand = bands[(dim + 1) % 2];
+        const PositionBand& extentBand = bands[dim];
+        const unsigned int flags = (dim == XDIM) ?
+                (XL_EDGE | XL_CONN | XH_EDGE | XH_CONN) :
+                (YL_EDGE | YL_CONN | YH_EDGE | YH_CONN);
+        std::vector<OrthogonalVisGraphState::Line>& lines = state->lines[dim];
+        size_t kept = 0;
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            OrthogonalVisGraphState::Line& line = lines[i];
+            bool inBand = posBand.contains(line.pos);
+            if (!inBand && !extentBand.overlaps(line.begin, line.finish))
+            {
+                if (kept != i)
+                {
+                    lines[kept] = std::move(line);
+                }
+                ++kept;
+                continue;
+            }
+
+            // Connection points may have been deleted, so only the
+            // vertices marked as dummies are looked at.
+            for (size_t v = 0; v < line.breakPoints.size(); ++v)
+            {
+                if (line.breakPoints[v].isDummy)
+                {
+                    line.breakPoints[v].vert->orthogVisPropFlags &= ~flags;
+                    candidates.insert(line.breakPoints[v].vert);
+                }
+            }
+            for (size_t v = 0; v < line.vertInfs.size(); ++v)
+            {
+                if (line.vertInfs[v].isDummy)
+                {
+                    candidates.insert(line.vertInfs[v].vert);
+                }
+            }
+            if (!inBand)
+            {
+                rerunLines[dim].push_back(std::move(line));
+            }
+        }
+        lines.resize(kept);
+    }
+
+    // Delete the edges lying on the lines in the bands and the edges of
+    // other lines overlapping the bands.  Any edge overlapping a band lies
+    // on a line crossing it, i.e., one being rebuilt.  New edges are always
+    // added at the end of the list, so remember the last kept edge.
+    EdgeInf *lastKeptEdge = nullptr;
+    EdgeInf *edge = router->visOrthogGraph.begin();
+    while (edge != router->visOrthogGraph.end())
+    {
+        EdgeInf *nextEdge = edge->lstNext;
+        if (state->edgeIds.count(edge->uniqueId()))
+        {
+            std::pair<Point, Point> points = edge->points();
+            // Horizontal edges are in dimension XDIM.
+            size_t dim = (points.first.y == points.second.y) ? XDIM : YDIM;
+            size_t altDim = (dim + 1) % 2;
+            double pos = points.first[altDim];
+            double begin = std::min(points.first[dim], points.second[dim]);
+            double finish = std::max(points.first[dim], points.second[dim]);
+            if (bands[altDim].contains(pos) ||
+                    bands[dim].overlaps(begin, finish))
+            {
+                state->edgeIds.erase(edge->uniqueId());
+                delete edge;
+                edge = nextEdge;
+                continue;
+            }
+        }
+        lastKeptEdge = edge;
+        edge = nextEdge;
+    }
+
+    // Find the new lines in the bands.
+    SegmentListWrapper segments;
+    sweepEventsInBand(router, vertEvents, totalVertEvents, YDIM, bands[YDIM],
+            segments);
+    SegmentListWrapper vertSegments;
+    sweepEventsInBand(router, horiEvents, totalHoriEvents, XDIM, bands[XDIM],
+            vertSegments);
+
+    // Gather the lines to be built in each dimension.
+    SegmentList& horiLines = segments.list();
+    SegmentList& vertLines = vertSegments.list();
+    size_t firstRebuiltLine[2];
+    for (size_t dim = 0; dim < 2; ++dim)
+    {
+        SegmentList& dimLines = (dim == XDIM) ? horiLines : vertLines;
+        std::vector<OrthogonalVisGraphState::Line>& lines = state->lines[dim];
+        firstRebuiltLine[dim] = lines.size();
+        for (SegmentList::iterator curr = dimLines.begin();
+                curr != dimLines.end(); ++curr)
+        {
+            curr->recordIndex = lines.size();
+            lines.push_back(curr->record());
+        }
+
+        const PositionBand& extentBand = bands[dim];
+        for (size_t i = 0; i < rerunLines[dim].size(); ++i)
+        {
+            OrthogonalVisGraphState::Line& record = rerunLines[dim][i];
+            if (record.begin == record.finish)
+            {
+                dimLines.push_back(LineSegment(record.begin, record.pos));
+            }
+            else
+            {
+                dimLines.push_back(LineSegment(record.begin, record.finish,
+                        record.pos, record.shapeSide));
+            }
+            LineSegment& line = dimLines.back();
+            for (size_t v = 0; v < record.vertInfs.size(); ++v)
+            {
+                line.vertInfs.insert(record.vertInfs[v].vert);
+            }
+            // Keep the intersections with unchanged lines.  The vertical
+            // lines' own vertices are only used for their endpoints, while
+            // the horizontal lines' vertices all become breakpoints.
+            for (size_t v = 0; v < record.breakPoints.size(); ++v)
+            {
+                const OrthogonalVisGraphState::LineVertex& bp =
+                        record.breakPoints[v];
+                if (extentBand.contains(bp.pos))
+                {
+                    continue;
+                }
+                if (dim == XDIM)
+                {
+                    line.vertInfs.insert(bp.vert);
+                }
+                else
+                {
+                    line.breakPoints.insert(
+                            PosVertInf(bp.pos, bp.vert, bp.dirs));
+                }
+            }
+            record.breakPoints.clear();
+            line.regenerateBand = &extentBand;
+            line.recordIndex = lines.size();
+            lines.push_back(std::move(record));
+        }
+    }
+    horiLines.sort();
+    vertLines.sort(CmpLineSegmentPos());
+
+    // Split the lines where they meet, as in the full horizontal sweep.
+    for (SegmentList::iterator curr = vertLines.begin();
+            curr != vertLines.end(); ++curr)
+    {
+        if (horiLines.empty())
+        {
+            curr->generateVisibilityEdgesFromBreakpointSet(router, YDIM);
+        }
+        else
+        {
+            intersectSegments(router, horiLines, *curr);
+        }
+    }
+    for (SegmentList::iterator it = horiLines.begin(); it != horiLines.end(); )
+    {
+        LineSegment& horiLine = *it;
+
+        horiLine.addEdgeHorizontal(router);
+        horiLine.generateVisibilityEdgesFromBreakpointSet(router, XDIM);
+
+        it = horiLines.erase(it);
+    }
+
+    // Record the new edges.
+    for (edge = (lastKeptEdge) ? lastKeptEdge->lstNext :
+                router->visOrthogGraph.begin();
+            edge != router->visOrthogGraph.end(); edge = edge->lstNext)
+    {
+        state->edgeIds.insert(edge->uniqueId());
+    }
+
+    // Delete the dummy vertices no longer used by any line.  These can only
+    // have been on the rebuilt lines.
+    for (size_t dim = 0; dim < 2; ++dim)
+    {
+        const std::vector<OrthogonalVisGraphState::Line>& lines =
+                state->lines[dim];
+        for (size_t i = firstRebuiltLine[dim]; i < lines.size(); ++i)
+        {
+            for (size_t v = 0; v < lines[i].vertInfs.size(); ++v)
+            {
+                candidates.erase(lines[i].vertInfs[v].vert);
+            }
+            for (size_t v = 0; v < lines[i].breakPoints.size(); ++v)
+            {
+                candidates.erase(lines[i].breakPoints[v].vert);
+            }
+        }
+    }
+    for (std::unordered_set<VertInf *>::iterator curr = candidates.begin();
+            curr != candidates.end(); ++curr)
+    {
+        VertInf *vert = *curr;
+        if (vert->orphaned())
+        {
+            router->vertices.removeVertex(vert);
+            delete vert;
+        }
+    }
+
+    for (size_t i = 0; i < state->connPoints.size(); ++i)
+    {
+        state->connPoints[i].edgeCount = countGraphEdges(
+                state->connPoints[i].vert, state->edgeIds);
+    }
+    return true;
+}
+
+
+//============================================================================
+//                           Path Adjustment code
+//============================================================================
+
+
+typedef std::pair<Point, Point> RectBounds;
+
+static bool insideRectBounds(const Point& point, const RectBounds& rectBounds)
+{
+    Point zero(0, 0);
+    if ((rectBounds.first == zero) && (rectBounds.second == zero))
+    {
+        // We can't be inside the invalid rectangle.
+        return false;
+    }
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        if (point[i] < rectBounds.first[i])
+        {
+            return false;
+        }
+        if (point[i] > rectBounds.second[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static void buildOrthogonalNudgingSegments(Router *router,
+        const size_t dim, ShiftSegmentList& segmentList)
+{
+    if (router->routingParameter(segmentPenalty) == 0)
+    {
+        // The nudging code assumes the routes are pretty optimal.  This will
+        // only be true if a segment penalty is set, so just return if this
+        // is not the case.
+        return;
+    }
+    bool nudgeFinalSegments =
+            router->routingOption(nudgeOrthogonalSegmentsConnectedToShapes);
+    std::vector<RectBounds> shapeLimits;
+    if (nudgeFinalSegments)
+    {
+        // If we're going to nudge final segments, then cache the shape
+        // rectangles to save us rebuilding them multiple times.
+        const size_t n = router->m_obstacles.size();
+        shapeLimits = std::vector<RectBounds>(n);
+
+        double zeroBufferDist = 0.0;
+
+        ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
+        for (unsigned i = 0; i < n; i++)
+        {
+            ShapeRef *shape = dynamic_cast<ShapeRef *> (*obstacleIt);
+            JunctionRef *junction = dynamic_cast<JunctionRef *> (*obstacleIt);
+            if (shape)
+            {
+                // Take the real bounds of the shape
+                Box bBox = shape->polygon().offsetBoundingBox(zeroBufferDist);
+                shapeLimits[i] = std::make_pair(bBox.min, bBox.max);
+            }
+            else if (junction)
+            {
+                // Don't nudge segments attached to junctions,
+                // so just use the junction position here.
+                Point pos = junction->position();
+                shapeLimits[i] = std::make_pair(pos, pos);
+            }
+            ++obstacleIt;
+        }
     }
 
     size_t altDim = (dim + 1) % 2;
@@ -2510,6 +3250,126 @@ class PotentialSegmentConstraint
 };
 
 
+// The segments of a region that are nudged together, along with the
+// solver variables and constraints used to position them.
+struct NudgingRegion
+{
+    NudgingRegion()
+        : satisfied(false),
+          precedingSegments(0)
+    {
+    }
+
+    ShiftSegmentList segments;
+    Variables vs;
+    Constraints cs;
+    bool satisfied;
+    // The number of segments in all the regions found before this one,
+    // used for progress reporting.
+    size_t precedingSegments;
+};
+
+
+// Groups the segments into regions of segments that overlap each other,
+// directly or via other segments in the region.  Segments are swept in
+// order of their extent in the other dimension so that only segments with
+// intersecting extents, which are the only ones that can overlap, are
+// compared.  Regions, and the segments within each region, are given in
+// the order found by repeatedly taking the first remaining segment in the
+// list and then adding the first remaining segment that overlaps any of
+// those already in the region.
+//
+static void buildNudgingRegions(const ShiftSegmentList& segmentList,
+        const size_t dimension, std::vector<ShiftSegmentList>& regions)
+{
+    const size_t altDim = (dimension + 1) % 2;
+    std::vector<ShiftSegment *> segments(segmentList.begin(),
+            segmentList.end());
+    const size_t n = segments.size();
+
+    std::vector<double> extentMin(n);
+    std::vector<double> extentMax(n);
+    std::vector<size_t> sweepOrder(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        NudgingShiftSegment *segment =
+                static_cast<NudgingShiftSegment *> (segments[i]);
+        double low = segment->lowPoint()[altDim];
+        double high = segment->highPoint()[altDim];
+        extentMin[i] = std::min(low, high);
+        extentMax[i] = std::max(low, high);
+        sweepOrder[i] = i;
+    }
+    std::sort(sweepOrder.begin(), sweepOrder.end(),
+            [&](size_t lhs, size_t rhs)
+            {
+                if (extentMin[lhs] != extentMin[rhs])
+                {
+                    return extentMin[lhs] < extentMin[rhs];
+                }
+                return lhs < rhs;
+            });
+
+    // Find the overlapping pairs.  Touching segments can also overlap, so
+    // segments stay active until the sweep passes the end of their extent.
+    std::vector<std::vector<size_t> > overlapping(n);
+    std::vector<size_t> active;
+    for (size_t s = 0; s < n; ++s)
+    {
+        const size_t i = sweepOrder[s];
+        size_t stillActive = 0;
+        for (size_t a = 0; a < active.size(); ++a)
+        {
+            const size_t j = active[a];
+            if (extentMax[j] < extentMin[i])
+            {
+                continue;
+            }
+            active[stillActive++] = j;
+            if (segments[i]->overlapsWith(segments[j], dimension))
+            {
+                overlapping[i].push_back(j);
+                overlapping[j].push_back(i);
+            }
+        }
+        active.resize(stillActive);
+        active.push_back(i);
+    }
+
+    // Build the regions, always adding the earliest segment in the list
+    // that overlaps the region so far.
+    std::vector<bool> assigned(n, false);
+    std::priority_queue<size_t, std::vector<size_t>,
+            std::greater<size_t> > candidates;
+    for (size_t first = 0; first < n; ++first)
+    {
+        if (assigned[first])
+        {
+            continue;
+        }
+        regions.push_back(ShiftSegmentList());
+        ShiftSegmentList& region = regions.back();
+        assigned[first] = true;
+        candidates.push(first);
+        while (!candidates.empty())
+        {
+            const size_t i = candidates.top();
+            candidates.pop();
+            region.push_back(segments[i]);
+            for (size_t k = 0; k < overlapping[i].size(); ++k)
+            {
+                const size_t j = overlapping[i][k];
+                if (!assigned[j])
+                {
+                    assigned[j] = true;
+                    candidates.push(j);
+                }
+            }
+        }
+    }
+}
+
+
 class ImproveOrthogonalRoutes
 {
 public:
@@ -2521,6 +3381,8 @@ private:
     void buildOrthogonalNudgingOrderInfo(void);
     void nudgeOrthogonalRoutes(size_t dimension,
            bool justUnifying = false);
+    void solveNudgingRegion(NudgingRegion& region, const size_t dimension,
+            const bool justUnifying) const;
 
     Router *m_router;
     PtOrderMap m_point_orders;
@@ -2536,8 +3398,6 @@ ImproveOrthogonalRoutes::ImproveOrthogonalRoutes(Router *router)
 
 void ImproveOrthogonalRoutes::execute(void)
 {
-    TIMER_START(m_router, tmOrthogNudge);
-
     m_shared_path_connectors_with_common_endpoints.clear();
 
     // Simplify routes.
@@ -2560,12 +3420,16 @@ void ImproveOrthogonalRoutes::execute(void)
     {
         for (size_t dimension = 0; dimension < 2; ++dimension)
         {
+            TimerIndex timer = 
+                    (dimension == XDIM) ? tmOrthogNudgeX : tmOrthogNudgeY;
+            TIMER_START(m_router, timer);
             // Just perform Unifying operation.
             bool justUnifying = true;
             m_segment_list.clear();
             buildOrthogonalNudgingSegments(m_router, dimension, m_segment_list);
             buildOrthogonalChannelInfo(m_router, dimension, m_segment_list);
             nudgeOrthogonalRoutes(dimension, justUnifying);
+            TIMER_STOP(m_router, timer);
         }
     }
 
@@ -2573,6 +3437,9 @@ void ImproveOrthogonalRoutes::execute(void)
     // Do the Nudging and centring.
     for (size_t dimension = 0; dimension < 2; ++dimension)
     {
+        TimerIndex timer = 
+                (dimension == XDIM) ? tmOrthogNudgeX : tmOrthogNudgeY;
+        TIMER_START(m_router, timer);
         m_point_orders.clear();
         // Build nudging info.
         // XXX Needs to be rebuilt for each dimension, cause of shifting
@@ -2584,6 +3451,7 @@ void ImproveOrthogonalRoutes::execute(void)
         buildOrthogonalNudgingSegments(m_router, dimension, m_segment_list);
         buildOrthogonalChannelInfo(m_router, dimension, m_segment_list);
         nudgeOrthogonalRoutes(dimension);
+        TIMER_STOP(m_router, timer);
     }
 #endif // DEBUG_JUST_UNIFY
 
@@ -2594,15 +3462,13 @@ void ImproveOrthogonalRoutes::execute(void)
 
     // Clear the segment-checkpoint cache for connectors.
     clearConnectorRouteCheckpointCache(m_router);
-
-    TIMER_STOP(m_router);
 }
 
-void ImproveOrthogonalRoutes::nudgeOrthogonalRoutes(size_t dimension,
-       bool justUnifying)
+// Builds and solves the nudging problem for the segments of a region,
+// leaving the resulting positions in the segments' solver variables.
+void ImproveOrthogonalRoutes::solveNudgingRegion(NudgingRegion& region,
+        const size_t dimension, const bool justUnifying) const
 {
-    bool nudgeFinalSegments = m_router->routingOption(
-            nudgeOrthogonalSegmentsConnectedToShapes);
     bool nudgeSharedPathsWithCommonEnd = m_router->routingOption(
             nudgeSharedPathsWithCommonEndPoint);
     double baseSepDist = m_router->routingParameter(idealNudgingDistance);
@@ -2611,499 +3477,551 @@ void ImproveOrthogonalRoutes::nudgeOrthogonalRoutes(size_t dimension,
     // we try 10 times, reducing each time by a 10th of the original amount.
     double reductionSteps = 10.0;
 
-    size_t totalSegmentsToShift = m_segment_list.size();
-    size_t numOfSegmentsShifted = 0;
-    // Do the actual nudging.
-    ShiftSegmentList currentRegion;
-    while (!m_segment_list.empty())
-    {
-        // Progress reporting and continuation check.
-        numOfSegmentsShifted = totalSegmentsToShift - m_segment_list.size();
-        m_router->performContinuationCheck(
-                (dimension == XDIM) ? TransactionPhaseOrthogonalNudgingX :
-                TransactionPhaseOrthogonalNudgingY, numOfSegmentsShifted,
-                totalSegmentsToShift);
-
-        // Take a reference segment
-        ShiftSegment *currentSegment = m_segment_list.front();
-        // Then, find the segments that overlap this one.
-        currentRegion.clear();
-        currentRegion.push_back(currentSegment);
-        m_segment_list.erase(m_segment_list.begin());
-        for (ShiftSegmentList::iterator curr = m_segment_list.begin();
-                curr != m_segment_list.end(); )
-        {
-            bool overlaps = false;
-            for (ShiftSegmentList::iterator curr2 = currentRegion.begin();
-                    curr2 != currentRegion.end(); ++curr2)
-            {
-                if ((*curr)->overlapsWith(*curr2, dimension))
-                {
-                    overlaps = true;
-                    break;
-                }
-            }
-            if (overlaps)
-            {
-                currentRegion.push_back(*curr);
-                m_segment_list.erase(curr);
-                // Consider segments from the beginning, since we may have
-                // since passed segments that overlap with the new set.
-                curr = m_segment_list.begin();
-            }
-            else
-            {
-                ++curr;
-            }
-        }
-
-        if (! justUnifying)
-        {
-            CmpLineOrder lineSortComp(m_point_orders, dimension);
-            currentRegion = linesort(nudgeFinalSegments, currentRegion,
-                    lineSortComp);
-        }
-
-        if (currentRegion.size() == 1)
-        {
-            // Save creating the solver instance if there is just one
-            // immovable segment, or if we are in the unifying stage.
-            if (currentRegion.front()->immovable() || justUnifying)
-            {
-                delete currentRegion.front();
-                continue;
-            }
-        }
+    ShiftSegmentList& currentRegion = region.segments;
+    Variables& vs = region.vs;
+    Constraints& cs = region.cs;
 
-        // Process these segments.
-        std::list<size_t> freeIndexes;
-        Variables vs;
-        Constraints cs;
-        Constraints gapcs;
-        ShiftSegmentPtrList prevVars;
-        double sepDist = baseSepDist;
+    std::list<size_t> freeIndexes;
+    Constraints gapcs;
+    ShiftSegmentPtrList prevVars;
+    double sepDist = baseSepDist;
 #ifdef NUDGE_DEBUG
-        fprintf(stderr, "-------------------------------------------------------\n");
-        fprintf(stderr, "%s -- size: %d\n", (justUnifying) ? "Unifying" : "Nudging",
-                (int) currentRegion.size());
+    fprintf(stderr, "-------------------------------------------------------\n");
+    fprintf(stderr, "%s -- size: %d\n", (justUnifying) ? "Unifying" : "Nudging",
+            (int) currentRegion.size());
 #endif
 #ifdef NUDGE_DEBUG_SVG
-        printf("\n\n");
+    printf("\n\n");
 #endif
-        for (ShiftSegmentList::iterator currSegmentIt = currentRegion.begin();
-                currSegmentIt != currentRegion.end(); ++currSegmentIt )
-        {
-            NudgingShiftSegment *currSegment = static_cast<NudgingShiftSegment *> (*currSegmentIt);
+    for (ShiftSegmentList::iterator currSegmentIt = currentRegion.begin();
+            currSegmentIt != currentRegion.end(); ++currSegmentIt )
+    {
+        NudgingShiftSegment *currSegment = static_cast<NudgingShiftSegment *> (*currSegmentIt);
 
-            // Create a solver variable for the position of this segment.
-            currSegment->createSolverVariable(justUnifying);
+        // Create a solver variable for the position of this segment.
+        currSegment->createSolverVariable(justUnifying);
 
-            vs.push_back(currSegment->variable);
-            size_t index = vs.size() - 1;
+        vs.push_back(currSegment->variable);
+        size_t index = vs.size() - 1;
 #ifdef NUDGE_DEBUG
-            fprintf(stderr,"line(%d)  %.15f  dim: %d pos: %.16f\n"
-                   "min: %.16f  max: %.16f\n"
-                   "minEndPt: %.16f  maxEndPt: %.16f weight: %g cc: %d\n",
-                    currSegment->connRef->id(),
-                    currSegment->lowPoint()[dimension], (int) dimension,
-                    currSegment->variable->desiredPosition,
-                    currSegment->minSpaceLimit, currSegment->maxSpaceLimit,
-                    currSegment->lowPoint()[!dimension], currSegment->highPoint()[!dimension],
-                    currSegment->variable->weight,
-                    (int) currSegment->checkpoints.size());
+        fprintf(stderr,"line(%d)  %.15f  dim: %d pos: %.16f\n"
+               "min: %.16f  max: %.16f\n"
+               "minEndPt: %.16f  maxEndPt: %.16f weight: %g cc: %d\n",
+                currSegment->connRef->id(),
+                currSegment->lowPoint()[dimension], (int) dimension,
+                currSegment->variable->desiredPosition,
+                currSegment->minSpaceLimit, currSegment->maxSpaceLimit,
+                currSegment->lowPoint()[!dimension], currSegment->highPoint()[!dimension],
+                currSegment->variable->weight,
+                (int) currSegment->checkpoints.size());
 #endif
 #ifdef NUDGE_DEBUG_SVG
-            // Debugging info:
-            double minP = std::max(currSegment->minSpaceLimit, -5000.0);
-            double maxP = std::min(currSegment->maxSpaceLimit, 5000.0);
-            fprintf(stdout, "<rect style=\"fill: #f00; opacity: 0.2;\" "
-                    "x=\"%g\" y=\"%g\" width=\"%g\" height=\"%g\" />\n",
-                    currSegment->lowPoint()[XDIM], minP,
-                    currSegment->highPoint()[XDIM] - currSegment->lowPoint()[XDIM],
-                    maxP - minP);
-            fprintf(stdout, "<line style=\"stroke: #000;\" x1=\"%g\" "
-                    "y1=\"%g\" x2=\"%g\" y2=\"%g\" />\n",
-                    currSegment->lowPoint()[XDIM], currSegment->lowPoint()[YDIM],
-                    currSegment->highPoint()[XDIM], currSegment->highPoint()[YDIM]);
+        // Debugging info:
+        double minP = std::max(currSegment->minSpaceLimit, -5000.0);
+        double maxP = std::min(currSegment->maxSpaceLimit, 5000.0);
+        fprintf(stdout, "<rect style=\"fill: #f00; opacity: 0.2;\" "
+                "x=\"%g\" y=\"%g\" width=\"%g\" height=\"%g\" />\n",
+                currSegment->lowPoint()[XDIM], minP,
+                currSegment->highPoint()[XDIM] - currSegment->lowPoint()[XDIM],
+                maxP - minP);
+        fprintf(stdout, "<line style=\"stroke: #000;\" x1=\"%g\" "
+                "y1=\"%g\" x2=\"%g\" y2=\"%g\" />\n",
+                currSegment->lowPoint()[XDIM], currSegment->lowPoint()[YDIM],
+                currSegment->highPoint()[XDIM], currSegment->highPoint()[YDIM]);
 #endif
 
-            if (justUnifying)
+        if (justUnifying)
+        {
+            // Just doing centring, not nudging.
+            // Record the index of the variable so we can use it as
+            // a segment to potentially constrain to other segments.
+            if (currSegment->variable->weight == freeWeight)
             {
-                // Just doing centring, not nudging.
-                // Record the index of the variable so we can use it as
-                // a segment to potentially constrain to other segments.
-                if (currSegment->variable->weight == freeWeight)
-                {
-                    freeIndexes.push_back(index);
-                }
-                // Thus, we don't need to constrain position against other
-                // segments.
-                prevVars.push_back(&(*currSegment));
-                continue;
+                freeIndexes.push_back(index);
             }
+            // Thus, we don't need to constrain position against other
+            // segments.
+            prevVars.push_back(&(*currSegment));
+            continue;
+        }
 
-            // The constraints generated here must be in order of
-            // leftBoundary-segment ... segment-segment ... segment-rightBoundary
-            // since this order is leveraged later for rewriting the
-            // separations of unsatisfable channel groups.
+        // The constraints generated here must be in order of
+        // leftBoundary-segment ... segment-segment ... segment-rightBoundary
+        // since this order is leveraged later for rewriting the
+        // separations of unsatisfable channel groups.
 
-            // Constrain to channel boundary.
-            if (!currSegment->fixed)
+        // Constrain to channel boundary.
+        if (!currSegment->fixed)
+        {
+            // If this segment sees a channel boundary to its left,
+            // then constrain its placement as such.
+            if (currSegment->minSpaceLimit > -CHANNEL_MAX)
             {
-                // If this segment sees a channel boundary to its left,
-                // then constrain its placement as such.
-                if (currSegment->minSpaceLimit > -CHANNEL_MAX)
-                {
-                    vs.push_back(new Variable(channelLeftID,
-                                currSegment->minSpaceLimit, fixedWeight));
-                    cs.push_back(new Constraint(vs[vs.size() - 1], vs[index],
-                                0.0));
-                }
+                vs.push_back(new Variable(channelLeftID,
+                            currSegment->minSpaceLimit, fixedWeight));
+                cs.push_back(new Constraint(vs[vs.size() - 1], vs[index],
+                            0.0));
             }
+        }
 
-            // Constrain position in relation to previously seen segments,
-            // if necessary (i.e. when they could overlap).
-            for (ShiftSegmentPtrList::iterator prevVarIt = prevVars.begin();
-                    prevVarIt != prevVars.end(); ++prevVarIt)
-            {
-                NudgingShiftSegment *prevSeg =
-                        static_cast<NudgingShiftSegment *> (*prevVarIt);
-                Variable *prevVar = prevSeg->variable;
+        // Constrain position in relation to previously seen segments,
+        // if necessary (i.e. when they could overlap).
+        for (ShiftSegmentPtrList::iterator prevVarIt = prevVars.begin();
+                prevVarIt != prevVars.end(); ++prevVarIt)
+        {
+            NudgingShiftSegment *prevSeg =
+                    static_cast<NudgingShiftSegment *> (*prevVarIt);
+            Variable *prevVar = prevSeg->variable;
 
-                if (currSegment->overlapsWith(prevSeg, dimension) &&
-                        (!(currSegment->fixed) || !(prevSeg->fixed)))
+            if (currSegment->overlapsWith(prevSeg, dimension) &&
+                    (!(currSegment->fixed) || !(prevSeg->fixed)))
+            {
+                // If there is a previous segment to the left that
+                // could overlap this in the shift direction, then
+                // constrain the two segments to be separated.
+                // Though don't add the constraint if both the
+                // segments are fixed in place.
+                double thisSepDist = sepDist;
+                bool equality = false;
+                if (currSegment->shouldAlignWith(prevSeg, dimension))
                 {
-                    // If there is a previous segment to the left that
-                    // could overlap this in the shift direction, then
-                    // constrain the two segments to be separated.
-                    // Though don't add the constraint if both the
-                    // segments are fixed in place.
-                    double thisSepDist = sepDist;
-                    bool equality = false;
-                    if (currSegment->shouldAlignWith(prevSeg, dimension))
-                    {
-                        // Handles the case where the two end segments can
-                        // be brought together to make a single segment. This
-                        // can help in situations where having the small kink
-                        // can restrict other kinds of nudging.
-                        thisSepDist = 0;
-                        equality = true;
-                    }
-                    else if (currSegment->canAlignWith(prevSeg, dimension))
-                    {
-                        // We need to address the problem of two neighbouring
-                        // segments of the same connector being kept separated
-                        // due only to a kink created in the other dimension.
-                        // Here, we let such segments drift back together.
-                        thisSepDist = 0;
-                    }
-                    else if (!nudgeSharedPathsWithCommonEnd &&
-                            (m_shared_path_connectors_with_common_endpoints.count(
-                                 UnsignedPair(currSegment->connRef->id(), prevSeg->connRef->id())) > 0))
-                    {
-                        // We don't want to nudge apart these two segments
-                        // since they are from a shared path with a common
-                        // endpoint.  There might be multiple chains of
-                        // segments that don't all have the same endpoints
-                        // so we need to make this an equality to prevent
-                        // some of them possibly getting nudged apart.
-                        thisSepDist = 0;
-                        equality = true;
-                    }
-
-                    Constraint *constraint = new Constraint(prevVar,
-                            vs[index], thisSepDist, equality);
-                    cs.push_back(constraint);
-                    if (thisSepDist)
-                    {
-                        // Add to the list of gap constraints so we can
-                        // rewrite the separation distance later.
-                        gapcs.push_back(constraint);
-                    }
+                    // Handles the case where the two end segments can
+                    // be brought together to make a single segment. This
+                    // can help in situations where having the small kink
+                    // can restrict other kinds of nudging.
+                    thisSepDist = 0;
+                    equality = true;
+                }
+                else if (currSegment->canAlignWith(prevSeg, dimension))
+                {
+                    // We need to address the problem of two neighbouring
+                    // segments of the same connector being kept separated
+                    // due only to a kink created in the other dimension.
+                    // Here, we let such segments drift back together.
+                    thisSepDist = 0;
+                }
+                else if (!nudgeSharedPathsWithCommonEnd &&
+                        (m_shared_path_connectors_with_common_endpoints.count(
+                             UnsignedPair(currSegment->connRef->id(), prevSeg->connRef->id())) > 0))
+                {
+                    // We don't want to nudge apart these two segments
+                    // since they are from a shared path with a common
+                    // endpoint.  There might be multiple chains of
+                    // segments that don't all have the same endpoints
+                    // so we need to make this an equality to prevent
+                    // some of them possibly getting nudged apart.
+                    thisSepDist = 0;
+                    equality = true;
                 }
-            }
 
-            if (!currSegment->fixed)
-            {
-                // If this segment sees a channel boundary to its right,
-                // then constrain its placement as such.
-                if (currSegment->maxSpaceLimit < CHANNEL_MAX)
+                Constraint *constraint = new Constraint(prevVar,
+                        vs[index], thisSepDist, equality);
+                cs.push_back(constraint);
+                if (thisSepDist)
                 {
-                    vs.push_back(new Variable(channelRightID,
-                                currSegment->maxSpaceLimit, fixedWeight));
-                    cs.push_back(new Constraint(vs[index], vs[vs.size() - 1],
-                                0.0));
+                    // Add to the list of gap constraints so we can
+                    // rewrite the separation distance later.
+                    gapcs.push_back(constraint);
                 }
             }
+        }
 
-            prevVars.push_back(&(*currSegment));
+        if (!currSegment->fixed)
+        {
+            // If this segment sees a channel boundary to its right,
+            // then constrain its placement as such.
+            if (currSegment->maxSpaceLimit < CHANNEL_MAX)
+            {
+                vs.push_back(new Variable(channelRightID,
+                            currSegment->maxSpaceLimit, fixedWeight));
+                cs.push_back(new Constraint(vs[index], vs[vs.size() - 1],
+                            0.0));
+            }
         }
 
-        std::list<PotentialSegmentConstraint> potentialConstraints;
-        if (justUnifying)
+        prevVars.push_back(&(*currSegment));
+    }
+
+    std::list<PotentialSegmentConstraint> potentialConstraints;
+    if (justUnifying)
+    {
+        for (std::list<size_t>::iterator curr = freeIndexes.begin();
+                curr != freeIndexes.end(); ++curr)
         {
-            for (std::list<size_t>::iterator curr = freeIndexes.begin();
-                    curr != freeIndexes.end(); ++curr)
+            for (std::list<size_t>::iterator curr2 = curr;
+                    curr2 != freeIndexes.end(); ++curr2)
             {
-                for (std::list<size_t>::iterator curr2 = curr;
-                        curr2 != freeIndexes.end(); ++curr2)
+                if (curr == curr2)
                 {
-                    if (curr == curr2)
-                    {
-                        continue;
-                    }
-                    potentialConstraints.push_back(
-                            PotentialSegmentConstraint(*curr, *curr2, vs));
+                    continue;
                 }
+                potentialConstraints.push_back(
+                        PotentialSegmentConstraint(*curr, *curr2, vs));
             }
         }
+    }
 #ifdef NUDGE_DEBUG
-        for (unsigned i = 0;i < vs.size(); ++i)
+    for (unsigned i = 0;i < vs.size(); ++i)
+    {
+        fprintf(stderr, "-vs[%d]=%f\n", i, vs[i]->desiredPosition);
+    }
+#endif
+    // Repeatedly try solving this.  There are two cases:
+    //  -  When Unifying, we greedily place as many free segments as
+    //     possible at the same positions, that way they have more
+    //     accurate nudging orders determined for them in the Nudging
+    //     stage.
+    //  -  When Nudging, if we can't fit all the segments with the
+    //     default nudging distance we try smaller separation
+    //     distances till we find a solution that is satisfied.
+    //
+    // With warmStartOrthogonalNudging, the solver is kept between attempts
+    // while only constraints are added or removed, so each attempt is 
+    // warm-started from the last solution.  It is recreated when the gaps
+    // of existing constraints are changed.
+    const bool keepSolver = 
+            m_router->routingOption(warmStartOrthogonalNudging);
+    bool justAddedConstraint = false;
+    bool satisfied;
+    IncSolver *solver = nullptr;
+
+    typedef std::pair<size_t, size_t> UnsatisfiedRange;
+    std::list<UnsatisfiedRange> unsatisfiedRanges;
+    do
+    {
+        TIMER_VAR_ADD(m_router, tvNudgingConstraints, cs.size());
+        TIMER_VAR_MAX(m_router, tvNudgingConstraints, cs.size());
+        if (solver == nullptr)
         {
-            fprintf(stderr, "-vs[%d]=%f\n", i, vs[i]->desiredPosition);
+            solver = new IncSolver(vs, cs);
         }
-#endif
-        // Repeatedly try solving this.  There are two cases:
-        //  -  When Unifying, we greedily place as many free segments as
-        //     possible at the same positions, that way they have more
-        //     accurate nudging orders determined for them in the Nudging
-        //     stage.
-        //  -  When Nudging, if we can't fit all the segments with the
-        //     default nudging distance we try smaller separation
-        //     distances till we find a solution that is satisfied.
-        bool justAddedConstraint = false;
-        bool satisfied;
-
-        typedef std::pair<size_t, size_t> UnsatisfiedRange;
-        std::list<UnsatisfiedRange> unsatisfiedRanges;
-        do
-        {
-            IncSolver f(vs, cs);
-            f.solve();
-
-            for (size_t i = 0; i < vs.size(); ++i)
-            {
-                // For each variable...
-                if (vs[i]->id != freeSegmentID)
-                {
-                    // If it is a fixed segment (should stay still)...
-                    if (fabs(vs[i]->finalPosition -
-                            vs[i]->desiredPosition) > 0.0001)
+        solver->solve();
+
+        for (size_t i = 0; i < vs.size(); ++i)
+        {
+            // For each variable...
+            if (vs[i]->id != freeSegmentID)
+            {
+                // If it is a fixed segment (should stay still)...
+                if (fabs(vs[i]->finalPosition -
+                        vs[i]->desiredPosition) > 0.0001)
+                {
+                    // We record ranges of unsatisfied variables based on
+                    // the channel edges.
+                    if (vs[i]->id == channelLeftID)
+                    {
+                        // This is the left-hand-side of a channel.
+                        if ((unsatisfiedRanges.empty() ||
+                                (unsatisfiedRanges.back().first !=
+                                unsatisfiedRanges.back().second))
+                                // the next variable can also have id different from `channelRightID`
+                                // e.g. see `orthogonal/nudging` test, there is a case when the next node has id
+                                // `freeSegmentID`. Why?
+                                // Nevertheless, this filtering doesn't affect end result.
+                                && vs[i + 1]->id == channelRightID)
+                        {
+                            // There are no existing unsatisfied ranges,
+                            // or there are but they are a valid range
+                            // (we've encountered the right-hand channel
+                            // edges already).
+                            // So, start a new unsatisfied range.
+                            unsatisfiedRanges.push_back(
+                                    std::make_pair(i, i + 1));
+                        }
+                    }
+                    else if (vs[i]->id == channelRightID)
                     {
-                        // We record ranges of unsatisfied variables based on
-                        // the channel edges.
-                        if (vs[i]->id == channelLeftID)
+                        // This is the right-hand-side of a channel.
+                        if (unsatisfiedRanges.empty())
                         {
-                            // This is the left-hand-side of a channel.
-                            if ((unsatisfiedRanges.empty() ||
-                                    (unsatisfiedRanges.back().first !=
-                                    unsatisfiedRanges.back().second))
-                                    // the next variable can also have id different from `channelRightID`
-                                    // e.g. see `orthogonal/nudging` test, there is a case when the next node has id
-                                    // `freeSegmentID`. Why?
-                                    // Nevertheless, this filtering doesn't affect end result.
-                                    && vs[i + 1]->id == channelRightID)
+                            // There are no existing unsatisfied ranges,
+                            // so start a new unsatisfied range.
+                            // We are looking at a unsatisfied right side
+                            // where the left side was satisfied, so the
+                            // range begins at the previous variable
+                            // which should be a left channel side.
+                            COLA_ASSERT(i > 0);
+                            // the previous variable can also have id different from `channelLeftID`. Why?
+                            // Nevertheless, this filtering doesn't affect end result.
+                            if (vs[i - 1]->id == channelLeftID)
                             {
-                                // There are no existing unsatisfied ranges,
-                                // or there are but they are a valid range
-                                // (we've encountered the right-hand channel
-                                // edges already).
-                                // So, start a new unsatisfied range.
                                 unsatisfiedRanges.push_back(
-                                        std::make_pair(i, i + 1));
+                                        std::make_pair(i - 1, i));
                             }
                         }
-                        else if (vs[i]->id == channelRightID)
+                        else
                         {
-                            // This is the right-hand-side of a channel.
-                            if (unsatisfiedRanges.empty())
-                            {
-                                // There are no existing unsatisfied ranges,
-                                // so start a new unsatisfied range.
-                                // We are looking at a unsatisfied right side
-                                // where the left side was satisfied, so the
-                                // range begins at the previous variable
-                                // which should be a left channel side.
-                                COLA_ASSERT(i > 0);
-                                // the previous variable can also have id different from `channelLeftID`. Why?
-                                // Nevertheless, this filtering doesn't affect end result.
-                                if (vs[i - 1]->id == channelLeftID)
-                                {
-                                    unsatisfiedRanges.push_back(
-                                            std::make_pair(i - 1, i));
-                                }
-                            }
-                            else
-                            {
-                                // Expand the existing range to include index.
-                                unsatisfiedRanges.back().second = i;
-                            }
+                            // Expand the existing range to include index.
+                            unsatisfiedRanges.back().second = i;
                         }
-                        else if (vs[i]->id == fixedSegmentID)
+                    }
+                    else if (vs[i]->id == fixedSegmentID)
+                    {
+                        // Fixed connector segments can also start and
+                        // extend unsatisfied variable ranges.
+                        if (unsatisfiedRanges.empty())
                         {
-                            // Fixed connector segments can also start and
-                            // extend unsatisfied variable ranges.
-                            if (unsatisfiedRanges.empty())
-                            {
-                                // There are no existing unsatisfied ranges,
-                                // so start a new unsatisfied range.
-                                unsatisfiedRanges.push_back(
-                                        std::make_pair(i, i));
-                            }
-                            else
-                            {
-                                // Expand the existing range to include index.
-                                unsatisfiedRanges.back().second = i;
-                            }
+                            // There are no existing unsatisfied ranges,
+                            // so start a new unsatisfied range.
+                            unsatisfiedRanges.push_back(
+                                    std::make_pair(i, i));
+                        }
+                        else
+                        {
+                            // Expand the existing range to include index.
+                            unsatisfiedRanges.back().second = i;
                         }
                     }
                 }
             }
+        }
 
-            // Determine if the problem was satisfied.
-            satisfied = unsatisfiedRanges.empty();
+        // Determine if the problem was satisfied.
+        satisfied = unsatisfiedRanges.empty();
 
 #ifdef NUDGE_DEBUG
-            if (!satisfied)
-            {
-                fprintf(stderr,"unsatisfied\n");
-            }
+        if (!satisfied)
+        {
+            fprintf(stderr,"unsatisfied\n");
+        }
 #endif
 
-            if (justUnifying)
-            {
-                // When we're centring, we'd like to greedily place as many
-                // segments as possible at the same positions, that way they
-                // have more accurate nudging orders determined for them.
-                //
-                // We do this by taking pairs of adjoining free segments and
-                // attempting to constrain them to have the same position,
-                // starting from the closest up to the furthest.
+        if (justUnifying)
+        {
+            // When we're centring, we'd like to greedily place as many
+            // segments as possible at the same positions, that way they
+            // have more accurate nudging orders determined for them.
+            //
+            // We do this by taking pairs of adjoining free segments and
+            // attempting to constrain them to have the same position,
+            // starting from the closest up to the furthest.
 
-                if (justAddedConstraint)
+            if (justAddedConstraint)
+            {
+                COLA_ASSERT(potentialConstraints.size() > 0);
+                if (!satisfied)
                 {
-                    COLA_ASSERT(potentialConstraints.size() > 0);
-                    if (!satisfied)
+                    // We couldn't satisfy the problem with the added
+                    // potential constraint, so we can't position these
+                    // segments together.  Roll back.
+                    potentialConstraints.pop_front();
+                    if (keepSolver)
                     {
-                        // We couldn't satisfy the problem with the added
-                        // potential constraint, so we can't position these
-                        // segments together.  Roll back.
-                        potentialConstraints.pop_front();
-                        delete cs.back();
-                        cs.pop_back();
-                    }
-                    else
-                    {
-                        // We could position these two segments together.
-                        PotentialSegmentConstraint& pc =
-                                potentialConstraints.front();
-
-                        // Rewrite the indexes of these two variables to
-                        // one, so we need not worry about redundant
-                        // equality constraints.
-                        for (std::list<PotentialSegmentConstraint>::iterator
-                                it = potentialConstraints.begin();
-                                it != potentialConstraints.end(); ++it)
-                        {
-                            it->rewriteIndex(pc.index1, pc.index2);
-                        }
-                        potentialConstraints.pop_front();
+                        solver->removeConstraint(cs.back());
                     }
+                    delete cs.back();
+                    cs.pop_back();
                 }
-                potentialConstraints.sort();
-                justAddedConstraint = false;
-
-                // Remove now invalid potential segment constraints.
-                // This could have been caused by the variable rewriting.
-                while (!potentialConstraints.empty() &&
-                       !potentialConstraints.front().stillValid())
+                else
                 {
+                    // We could position these two segments together.
+                    PotentialSegmentConstraint& pc =
+                            potentialConstraints.front();
+
+                    // Rewrite the indexes of these two variables to
+                    // one, so we need not worry about redundant
+                    // equality constraints.
+                    for (std::list<PotentialSegmentConstraint>::iterator
+                            it = potentialConstraints.begin();
+                            it != potentialConstraints.end(); ++it)
+                    {
+                        it->rewriteIndex(pc.index1, pc.index2);
+                    }
                     potentialConstraints.pop_front();
                 }
+            }
+            potentialConstraints.sort();
+            justAddedConstraint = false;
 
-                if (!potentialConstraints.empty())
+            // Remove now invalid potential segment constraints.
+            // This could have been caused by the variable rewriting.
+            while (!potentialConstraints.empty() &&
+                   !potentialConstraints.front().stillValid())
+            {
+                potentialConstraints.pop_front();
+            }
+
+            if (!potentialConstraints.empty())
+            {
+                // We still have more possibilities to consider.
+                // Create a constraint for this, add it, and mark as
+                // unsatisfied, so the problem gets re-solved.
+                PotentialSegmentConstraint& pc =
+                        potentialConstraints.front();
+                COLA_ASSERT(pc.index1 != pc.index2);
+                cs.push_back(new Constraint(vs[pc.index1], vs[pc.index2],
+                        0, true));
+                if (keepSolver)
                 {
-                    // We still have more possibilities to consider.
-                    // Create a constraint for this, add it, and mark as
-                    // unsatisfied, so the problem gets re-solved.
-                    PotentialSegmentConstraint& pc =
-                            potentialConstraints.front();
-                    COLA_ASSERT(pc.index1 != pc.index2);
-                    cs.push_back(new Constraint(vs[pc.index1], vs[pc.index2],
-                            0, true));
-                    satisfied = false;
-                    justAddedConstraint = true;
+                    solver->addConstraint(cs.back());
                 }
+                satisfied = false;
+                justAddedConstraint = true;
             }
-            else
+        }
+        else
+        {
+            if (!satisfied)
             {
-                if (!satisfied)
-                {
-                    // Reduce the separation distance.
-                    sepDist -= (baseSepDist / reductionSteps);
+                // Reduce the separation distance.
+                sepDist -= (baseSepDist / reductionSteps);
 #ifndef NDEBUG
-                    for (std::list<UnsatisfiedRange>::iterator it =
-                            unsatisfiedRanges.begin();
-                            it != unsatisfiedRanges.end(); ++it)
-                    {
-                        COLA_ASSERT(vs[it->first]->id != freeSegmentID);
-                        COLA_ASSERT(vs[it->second]->id != freeSegmentID);
-                    }
+                for (std::list<UnsatisfiedRange>::iterator it =
+                        unsatisfiedRanges.begin();
+                        it != unsatisfiedRanges.end(); ++it)
+                {
+                    COLA_ASSERT(vs[it->first]->id != freeSegmentID);
+                    COLA_ASSERT(vs[it->second]->id != freeSegmentID);
+                }
 #endif
 #ifdef NUDGE_DEBUG
-                    for (std::list<UnsatisfiedRange>::iterator it =
-                            unsatisfiedRanges.begin();
-                            it != unsatisfiedRanges.end(); ++it)
-                    {
-                        fprintf(stderr, "unsatisfiedVarRange(%ld, %ld)\n",
-                                it->first, it->second);
-                    }
-                    fprintf(stderr, "unsatisfied, trying %g\n", sepDist);
+                for (std::list<UnsatisfiedRange>::iterator it =
+                        unsatisfiedRanges.begin();
+                        it != unsatisfiedRanges.end(); ++it)
+                {
+                    fprintf(stderr, "unsatisfiedVarRange(%ld, %ld)\n",
+                            it->first, it->second);
+                }
+                fprintf(stderr, "unsatisfied, trying %g\n", sepDist);
 #endif
-                    // And rewrite all the gap constraints to have the new
-                    // reduced separation distance.
-                    bool withinUnsatisfiedGroup = false;
-                    for (Constraints::iterator cIt = cs.begin();
-                            cIt != cs.end(); ++cIt)
-                    {
-                        UnsatisfiedRange& range = unsatisfiedRanges.front();
-                        Constraint *constraint = *cIt;
+                // And rewrite all the gap constraints to have the new
+                // reduced separation distance.  Active constraints fix the
+                // offsets within the solver's blocks, so it must then be
+                // recreated.
+                delete solver;
+                solver = nullptr;
+                bool withinUnsatisfiedGroup = false;
+                for (Constraints::iterator cIt = cs.begin();
+                        cIt != cs.end(); ++cIt)
+                {
+                    UnsatisfiedRange& range = unsatisfiedRanges.front();
+                    Constraint *constraint = *cIt;
 
-                        if (constraint->left == vs[range.first])
-                        {
-                            // Entered an unsatisfied range of variables.
-                            withinUnsatisfiedGroup = true;
-                        }
+                    if (constraint->left == vs[range.first])
+                    {
+                        // Entered an unsatisfied range of variables.
+                        withinUnsatisfiedGroup = true;
+                    }
 
-                        if (withinUnsatisfiedGroup && (constraint->gap > 0))
-                        {
-                            // Rewrite constraints in unsatisfied ranges
-                            // that have a non-zero gap.
-                            constraint->gap = sepDist;
-                        }
+                    if (withinUnsatisfiedGroup && (constraint->gap > 0))
+                    {
+                        // Rewrite constraints in unsatisfied ranges
+                        // that have a non-zero gap.
+                        constraint->gap = sepDist;
+                    }
 
-                        if (constraint->right == vs[range.second])
+                    if (constraint->right == vs[range.second])
+                    {
+                        // Left an unsatisfied range of variables.
+                        withinUnsatisfiedGroup = false;
+                        unsatisfiedRanges.pop_front();
+                        if (unsatisfiedRanges.empty())
                         {
-                            // Left an unsatisfied range of variables.
-                            withinUnsatisfiedGroup = false;
-                            unsatisfiedRanges.pop_front();
-                            if (unsatisfiedRanges.empty())
-                            {
-                                // And there are no more unsatisfied variables.
-                                break;
-                            }
+                            // And there are no more unsatisfied variables.
+                            break;
                         }
                     }
                 }
             }
         }
-        while (!satisfied && (sepDist > 0.0001));
 
-        if (satisfied)
+        if (!keepSolver)
         {
+            delete solver;
+            solver = nullptr;
+        }
+    }
+    while (!satisfied && (sepDist > 0.0001));
+    delete solver;
+
+    region.satisfied = satisfied;
 #ifdef NUDGE_DEBUG
-            fprintf(stderr,"satisfied at nudgeDist = %g\n", sepDist);
+    if (satisfied)
+    {
+        fprintf(stderr,"satisfied at nudgeDist = %g\n", sepDist);
+    }
 #endif
+}
+
+
+void ImproveOrthogonalRoutes::nudgeOrthogonalRoutes(size_t dimension,
+       bool justUnifying)
+{
+    bool nudgeFinalSegments = m_router->routingOption(
+            nudgeOrthogonalSegmentsConnectedToShapes);
+
+    // Find the regions of overlapping segments.
+    std::vector<ShiftSegmentList> overlappingRegions;
+    buildNudgingRegions(m_segment_list, dimension, overlappingRegions);
+    size_t totalSegmentsToShift = m_segment_list.size();
+    m_segment_list.clear();
+
+    // Order the segments within each region, and set aside the regions
+    // that don't need solving.
+    std::vector<NudgingRegion> regions;
+    size_t numOfSegmentsShifted = 0;
+    for (size_t r = 0; r < overlappingRegions.size(); ++r)
+    {
+        ShiftSegmentList& currentRegion = overlappingRegions[r];
+        size_t precedingSegments = numOfSegmentsShifted;
+        numOfSegmentsShifted += currentRegion.size();
+
+        if (! justUnifying)
+        {
+            CmpLineOrder lineSortComp(m_point_orders, dimension);
+            currentRegion = linesort(nudgeFinalSegments, currentRegion,
+                    lineSortComp);
+        }
+
+        if (currentRegion.size() == 1)
+        {
+            // Save creating the solver instance if there is just one
+            // immovable segment, or if we are in the unifying stage.
+            if (currentRegion.front()->immovable() || justUnifying)
+            {
+                delete currentRegion.front();
+                continue;
+            }
+        }
+
+        regions.push_back(NudgingRegion());
+        regions.back().segments.swap(currentRegion);
+        regions.back().precedingSegments = precedingSegments;
+    }
+
+    // Solve the regions.  Each one only uses its own segments and solver
+    // variables, so they can be solved concurrently.  They are solved in
+    // batches, with the progress reporting and continuation check, which
+    // must happen on this thread, before each batch.  Serially, each
+    // batch is a single region.
+    unsigned int threadCount = (m_router->debugHandler()) ? 1 :
+            threadCountFromSetting(
+                    m_router->routingParameter(routingThreadCount));
+    const size_t regionsPerBatch = (threadCount > 1) ? 4 * threadCount : 1;
+    for (size_t first = 0; first < regions.size(); first += regionsPerBatch)
+    {
+        m_router->performContinuationCheck(
+                (dimension == XDIM) ? TransactionPhaseOrthogonalNudgingX :
+                TransactionPhaseOrthogonalNudgingY,
+                regions[first].precedingSegments, totalSegmentsToShift);
+        size_t batchSize =
+                std::min(regionsPerBatch, regions.size() - first);
+        m_router->m_thread_pool->parallelFor(batchSize, threadCount,
+                [&](size_t index)
+                {
+                    solveNudgingRegion(regions[first + index], dimension,
+                            justUnifying);
+                });
+    }
+
+    // Write back the new positions, in region order.
+    for (size_t r = 0; r < regions.size(); ++r)
+    {
+        ShiftSegmentList& currentRegion = regions[r].segments;
+        Variables& vs = regions[r].vs;
+        Constraints& cs = regions[r].cs;
+        if (regions[r].satisfied)
+        {
             for (ShiftSegmentList::iterator currSegment = currentRegion.begin();
                     currSegment != currentRegion.end(); ++currSegment)
             {
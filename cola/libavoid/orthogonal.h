@@ -26,11 +26,83 @@
 #ifndef AVOID_ORTHOGONAL_H
 #define AVOID_ORTHOGONAL_H
 
+#include <vector>
+#include <unordered_set>
+
+#include "libavoid/geomtypes.h"
+#include "libavoid/vertices.h"
+
 namespace Avoid {
 
 class Router;
 
+
+// The inputs to and the result of the sweeps that built the orthogonal
+// visibility graph, kept by the router so that the graph can be updated
+// for a small change without being regenerated from scratch.
+//
+class OrthogonalVisGraphState
+{
+    public:
+        // A vertex on a visibility line, at position pos along it.
+        struct LineVertex
+        {
+            double pos;
+            VertInf *vert;
+            // The ScanVisDirFlags of the vertex as a breakpoint.
+            unsigned int dirs;
+            // Whether the vertex was created for the graph (i.e., it is
+            // a dummyOrthogID vertex that the graph is responsible for).
+            bool isDummy;
+        };
+
+        // A possible visibility line found by one of the sweeps.
+        struct Line
+        {
+            double begin;
+            double finish;
+            double pos;
+            bool shapeSide;
+            // The vertices given to the line by the sweep.
+            std::vector<LineVertex> vertInfs;
+            // The points the line was finally split at to form edges.
+            std::vector<LineVertex> breakPoints;
+        };
+
+        struct ObstacleInfo
+        {
+            unsigned int id;
+            Box box;
+        };
+
+        struct ConnPointInfo
+        {
+            unsigned int id;
+            VertInf *vert;
+            Point point;
+            ConnDirFlags visDirections;
+            // Number of graph edges at the vertex.
+            size_t edgeCount;
+        };
+
+        OrthogonalVisGraphState();
+        void clear(void);
+
+        // Whether the state describes the current orthogonal graph.
+        bool valid;
+        // Obstacles and connection points, each sorted by unique ID.
+        std::vector<ObstacleInfo> obstacles;
+        std::vector<ConnPointInfo> connPoints;
+        // The horizontal lines (indexed by XDIM) and vertical lines
+        // (indexed by YDIM), in no particular order.
+        std::vector<Line> lines[2];
+        // Unique IDs of the edges in the graph created by the sweeps.
+        std::unordered_set<unsigned int> edgeIds;
+};
+
+
 extern void generateStaticOrthogonalVisGraph(Router *router);
+extern bool updateStaticOrthogonalVisGraph(Router *router);
 extern void improveOrthogonalRoutes(Router *router);
 
 
@@ -0,0 +1,116 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include "libavoid/parallel.h"
+
+namespace Avoid {
+
+
+ThreadPool::ThreadPool()
+    : m_job(nullptr),
+      m_generation(0),
+      m_helpers_wanted(0),
+      m_helpers_running(0),
+      m_stopping(false)
+{
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work_ready.notify_all();
+    for (size_t t = 0; t < m_threads.size(); ++t)
+    {
+        m_threads[t].join();
+    }
+}
+
+
+void ThreadPool::run(const std::function<void()>& job, 
+        const unsigned int helperCount)
+{
+    // Start any further threads needed.  They wait for the next job.
+    while (m_threads.size() < helperCount)
+    {
+        m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, 
+                (unsigned int) m_threads.size(), m_generation));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_helpers_wanted = helperCount;
+        m_helpers_running = helperCount;
+        ++m_generation;
+    }
+    m_work_ready.notify_all();
+
+    job();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_work_done.wait(lock, [this]() { return m_helpers_running == 0; });
+    m_job = nullptr;
+}
+
+
+void ThreadPool::workerLoop(const unsigned int index, unsigned int generation)
+{
+    while (true)
+    {
+        const std::function<void()> *job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_ready.wait(lock, [&]() 
+                    { 
+                        return m_stopping || (m_generation != generation); 
+                    });
+            if (m_stopping)
+            {
+                return;
+            }
+            generation = m_generation;
+            if (index >= m_helpers_wanted)
+            {
+                // Not needed for this job.
+                continue;
+            }
+            job = m_job;
+        }
+
+        (*job)();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_helpers_running;
+        }
+        m_work_done.notify_one();
+    }
+}
+
+
+}
+
@@ -0,0 +1,152 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef AVOID_PARALLEL_H
+#define AVOID_PARALLEL_H
+
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Avoid {
+
+// Returns the number of threads to use for a given thread count setting.
+// Values below one mean the work should be done serially on the calling
+// thread.
+static inline unsigned int threadCountFromSetting(const double setting)
+{
+    return (setting >= 1) ? (unsigned int) setting : 1;
+}
+
+// A set of worker threads kept by a Router for running work concurrently.
+// The threads are started when first needed and kept until the pool is
+// destroyed, so batches of work don't each pay for starting threads, and
+// state kept per thread, such as the workspace for A* searches, lasts 
+// from one transaction to the next.
+class ThreadPool
+{
+    public:
+        ThreadPool();
+        ~ThreadPool();
+
+        // Calls func(i) for each index i in [0, count), distributing the 
+        // indices over up to threadCount threads (including the calling 
+        // thread).  Indices are handed out in increasing order as threads
+        // become free, so func must not depend on the order in which the
+        // calls happen.  If any call throws, the remaining indices are 
+        // skipped and the first exception is rethrown on the calling 
+        // thread once all threads have finished.  This must not be called
+        // from within func.
+        //
+        // libcola/parallel.h has a parallelFor() with the same behaviour
+        // for libcola and libdialect, which starts threads for each call.
+        // Keep the two in step.
+        //
+        template <typename Func>
+        void parallelFor(const size_t count, unsigned int threadCount, 
+                Func func);
+
+    private:
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Runs job on the calling thread and on helperCount of the pool's
+        // threads, and returns once all of them have finished it.
+        void run(const std::function<void()>& job, 
+                const unsigned int helperCount);
+        void workerLoop(const unsigned int index, unsigned int generation);
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_work_ready;
+        std::condition_variable m_work_done;
+        // The current job, and the number of threads asked to help with
+        // it and still running it.  m_generation changes for each job.
+        const std::function<void()> *m_job;
+        unsigned int m_generation;
+        unsigned int m_helpers_wanted;
+        unsigned int m_helpers_running;
+        bool m_stopping;
+};
+
+
+template <typename Func>
+void ThreadPool::parallelFor(const size_t count, unsigned int threadCount, 
+        Func func)
+{
+    if (threadCount > count)
+    {
+        threadCount = (unsigned int) count;
+    }
+    if (threadCount <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextIndex(0);
+    std::exception_ptr firstException;
+    std::mutex exceptionMutex;
+
+    std::function<void()> worker = [&]()
+    {
+        try
+        {
+            size_t i;
+            while ((i = nextIndex.fetch_add(1)) < count)
+            {
+                func(i);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(exceptionMutex);
+            if (!firstException)
+            {
+                firstException = std::current_exception();
+            }
+            // Stop other threads taking further work.
+            nextIndex.store(count);
+        }
+    };
+    run(worker, threadCount - 1);
+
+    if (firstException)
+    {
+        std::rethrow_exception(firstException);
+    }
+}
+
+}
+
+#endif
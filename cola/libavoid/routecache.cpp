@@ -0,0 +1,206 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <algorithm>
+
+#include "libavoid/routecache.h"
+#include "libavoid/router.h"
+#include "libavoid/obstacle.h"
+#include "libavoid/junction.h"
+#include "libavoid/assertions.h"
+
+namespace Avoid {
+
+
+template <typename T>
+static bool lessId(const T& lhs, const T& rhs)
+{
+    return lhs.id < rhs.id;
+}
+
+
+// Returns whether the ranges of a and b in the given dimension overlap
+// or touch.
+static bool rangesOverlap(const Box& a, const Box& b, const size_t dim)
+{
+    return (a.min[dim] <= b.max[dim]) && (b.min[dim] <= a.max[dim]);
+}
+
+
+static Box pointBox(const Point& point)
+{
+    Box box;
+    box.min = point;
+    box.max = point;
+    return box;
+}
+
+
+RouteCache::RouteCache(Router *router)
+    : m_router(router),
+      m_valid(false),
+      m_everything_changed(true)
+{
+}
+
+
+void RouteCache::invalidate(void)
+{
+    m_valid = false;
+    m_obstacles.clear();
+    m_conn_points.clear();
+}
+
+
+void RouteCache::recordInputs(std::vector<ObstacleInfo>& obstacles,
+        std::vector<ConnPointInfo>& connPoints) const
+{
+    obstacles.clear();
+    for (ObstacleList::const_iterator obstacleIt =
+                m_router->m_obstacles.begin();
+            obstacleIt != m_router->m_obstacles.end(); ++obstacleIt)
+    {
+        Obstacle *obstacle = *obstacleIt;
+        JunctionRef *junction = dynamic_cast<JunctionRef *> (obstacle);
+        if (junction && !junction->positionFixed())
+        {
+            // Free junctions aren't part of the orthogonal graph.
+            continue;
+        }
+        ObstacleInfo info;
+        info.id = obstacle->uniqueId();
+        info.box = obstacle->routingBox();
+        obstacles.push_back(info);
+    }
+    std::sort(obstacles.begin(), obstacles.end(), lessId<ObstacleInfo>);
+
+    connPoints.clear();
+    for (VertInf *curr = m_router->vertices.connsBegin();
+            curr && (curr != m_router->vertices.shapesBegin());
+            curr = curr->lstNext)
+    {
+        if (curr->visDirections == ConnDirNone)
+        {
+            continue;
+        }
+        ConnPointInfo info;
+        info.id = curr->uniqueId;
+        info.point = curr->point;
+        info.visDirections = curr->visDirections;
+        connPoints.push_back(info);
+    }
+    std::sort(connPoints.begin(), connPoints.end(), lessId<ConnPointInfo>);
+}
+
+
+void RouteCache::findChanges(void)
+{
+    std::vector<ObstacleInfo> obstacles;
+    std::vector<ConnPointInfo> connPoints;
+    recordInputs(obstacles, connPoints);
+
+    m_changes.clear();
+    m_everything_changed = !m_valid;
+    if (m_valid)
+    {
+        // Both lists are sorted by id, so merge them to find the items
+        // that have been added, removed or changed.
+        size_t i = 0, j = 0;
+        while ((i < m_obstacles.size()) || (j < obstacles.size()))
+        {
+            if ((j == obstacles.size()) || ((i < m_obstacles.size()) &&
+                    (m_obstacles[i].id < obstacles[j].id)))
+            {
+                m_changes.push_back(m_obstacles[i++].box);
+            }
+            else if ((i == m_obstacles.size()) ||
+                    (obstacles[j].id < m_obstacles[i].id))
+            {
+                m_changes.push_back(obstacles[j++].box);
+            }
+            else
+            {
+                const Box& oldBox = m_obstacles[i++].box;
+                const Box& newBox = obstacles[j++].box;
+                if ((oldBox.min != newBox.min) || (oldBox.max != newBox.max))
+                {
+                    m_changes.push_back(oldBox);
+                    m_changes.push_back(newBox);
+                }
+            }
+        }
+
+        i = 0;
+        j = 0;
+        while ((i < m_conn_points.size()) || (j < connPoints.size()))
+        {
+            if ((j == connPoints.size()) || ((i < m_conn_points.size()) &&
+                    (m_conn_points[i].id < connPoints[j].id)))
+            {
+                m_changes.push_back(pointBox(m_conn_points[i++].point));
+            }
+            else if ((i == m_conn_points.size()) ||
+                    (connPoints[j].id < m_conn_points[i].id))
+            {
+                m_changes.push_back(pointBox(connPoints[j++].point));
+            }
+            else
+            {
+                const ConnPointInfo& oldInfo = m_conn_points[i++];
+                const ConnPointInfo& newInfo = connPoints[j++];
+                if ((oldInfo.point != newInfo.point) ||
+                        (oldInfo.visDirections != newInfo.visDirections))
+                {
+                    m_changes.push_back(pointBox(oldInfo.point));
+                    m_changes.push_back(pointBox(newInfo.point));
+                }
+            }
+        }
+    }
+
+    m_obstacles.swap(obstacles);
+    m_conn_points.swap(connPoints);
+    m_valid = true;
+}
+
+
+bool RouteCache::changedWithin(const Box& region) const
+{
+    if (m_everything_changed)
+    {
+        return true;
+    }
+    for (size_t i = 0; i < m_changes.size(); ++i)
+    {
+        if (rangesOverlap(m_changes[i], region, XDIM) ||
+                rangesOverlap(m_changes[i], region, YDIM))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+}
+
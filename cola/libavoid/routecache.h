@@ -0,0 +1,94 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef AVOID_ROUTECACHE_H
+#define AVOID_ROUTECACHE_H
+
+#include <vector>
+
+#include "libavoid/geomtypes.h"
+#include "libavoid/vertices.h"
+
+namespace Avoid {
+
+class Router;
+
+
+// Records the obstacles and connection points that the orthogonal
+// visibility graph was built from, so that the regions changed between
+// one transaction and the next can be found.  A connector whose previous
+// route search only depended on parts of the graph outside these regions
+// would find the same route again, so the router can reuse that route
+// rather than searching for it.
+//
+// Each obstacle or connection point adds lines to the graph through the
+// edges of its box, extending horizontally and vertically until blocked.
+// So a change affects the part of the graph within any region that
+// shares a horizontal or vertical band with the old or new box.
+//
+class RouteCache
+{
+    public:
+        RouteCache(Router *router);
+
+        // Forgets the recorded inputs, so that the next call to
+        // findChanges() treats everything as changed.
+        void invalidate(void);
+        // Finds the boxes of obstacles and connection points that have
+        // been added, moved or removed since the last call, and records
+        // the current ones for the next call.
+        void findChanges(void);
+        // Returns whether any of the changes found by the last call to
+        // findChanges() may have affected the graph within region.
+        bool changedWithin(const Box& region) const;
+
+    private:
+        struct ObstacleInfo
+        {
+            unsigned int id;
+            Box box;
+        };
+        struct ConnPointInfo
+        {
+            unsigned int id;
+            Point point;
+            ConnDirFlags visDirections;
+        };
+
+        void recordInputs(std::vector<ObstacleInfo>& obstacles,
+                std::vector<ConnPointInfo>& connPoints) const;
+
+        Router *m_router;
+        bool m_valid;
+        bool m_everything_changed;
+        std::vector<ObstacleInfo> m_obstacles;
+        std::vector<ConnPointInfo> m_conn_points;
+        std::vector<Box> m_changes;
+};
+
+
+}
+
+#endif
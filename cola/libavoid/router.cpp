@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cfloat>
+#include <unordered_set>
 
 #include "libavoid/shape.h"
 #include "libavoid/router.h"
@@ -38,6 +39,10 @@
 #include "libavoid/orthogonal.h"
 #include "libavoid/assertions.h"
 #include "libavoid/connectionpin.h"
+#include "libavoid/makepath.h"
+#include "libavoid/parallel.h"
+#include "libavoid/spatialindex.h"
+#include "libavoid/routecache.h"
 
 
 namespace Avoid {
@@ -45,6 +50,12 @@ namespace Avoid {
 
 Router::Router(const unsigned int flags)
     : visOrthogGraph(),
+      m_orthogonal_graph_state(new OrthogonalVisGraphState()),
+      m_obstacle_index(new ObstacleIndex(this)),
+      m_route_cache(new RouteCache(this)),
+      m_thread_pool(new ThreadPool()),
+      visGraphAdjacency(false),
+      visOrthogGraphAdjacency(true),
       PartialTime(false),
       SimpleRouting(false),
       ClusteredRouting(true),
@@ -59,8 +70,11 @@ Router::Router(const unsigned int flags)
       // Instrumentation:
       st_checked_edges(0),
       m_largest_assigned_id(0),
+      m_connrefs_added(0),
       m_consolidate_actions(true),
       m_currently_calling_destructors(false),
+      m_bulk_loading(false),
+      m_bulk_load_unrouted(false),
       m_topology_addon(new TopologyAddonInterface()),
       // Mode options:
       m_allows_polyline_routing(false),
@@ -98,6 +112,9 @@ Router::Router(const unsigned int flags)
     m_routing_options[improveHyperedgeRoutesMovingAddingAndDeletingJunctions] =
             false;
     m_routing_options[nudgeSharedPathsWithCommonEndPoint] = true;
+    m_routing_options[incrementallyUpdateOrthogonalVisibilityGraph] = true;
+    m_routing_options[reuseUnaffectedOrthogonalRoutes] = true;
+    m_routing_options[warmStartOrthogonalNudging] = false;
 
     m_hyperedge_improver.setRouter(this);
     m_hyperedge_rerouter.setRouter(this);
@@ -137,6 +154,10 @@ Router::~Router()
 
     // Cleanup orphaned orthogonal graph vertices.
     destroyOrthogonalVisGraph();
+    delete m_orthogonal_graph_state;
+    delete m_obstacle_index;
+    delete m_route_cache;
+    delete m_thread_pool;
 
     COLA_ASSERT(m_obstacles.size() == 0);
     COLA_ASSERT(connRefs.size() == 0);
@@ -161,16 +182,35 @@ ShapeRef *Router::shapeContainingPoint(const Point& point)
     bool countBorder = true;
 
     // Compute enclosing shapes.
+    ShapeRef *result = nullptr;
+    std::vector<Obstacle *> candidates;
+    m_obstacle_index->obstaclesAtPoint(point, candidates);
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        ShapeRef *shape = dynamic_cast<ShapeRef *>(candidates[i]);
+        if (shape && inPoly(shape->routingPolygon(), point, countBorder))
+        {
+            result = shape;
+            break;
+        }
+    }
+
+#ifndef NDEBUG
+    // Check the index against a scan of all the obstacles.
+    ShapeRef *scanned = nullptr;
     ObstacleList::const_iterator finish = m_obstacles.end();
     for (ObstacleList::const_iterator i = m_obstacles.begin(); i != finish; ++i)
     {
         ShapeRef *shape = dynamic_cast<ShapeRef *>(*i);
         if (shape && inPoly(shape->routingPolygon(), point, countBorder))
         {
-            return shape;
+            scanned = shape;
+            break;
         }
     }
-    return nullptr;
+    COLA_ASSERT(result == scanned);
+#endif
+    return result;
 }
 
 void Router::modifyConnector(ConnRef *conn, const unsigned int type,
@@ -440,6 +480,7 @@ void Router::destroyOrthogonalVisGraph(void)
 {
     // Remove orthogonal visibility graph edges.
     visOrthogGraph.clear();
+    m_orthogonal_graph_state->clear();
 
     // Remove the now orphaned vertices.
     VertInf *curr = vertices.shapesBegin();
@@ -465,13 +506,17 @@ void Router::regenerateStaticBuiltGraph(void)
     {
         if (m_allows_orthogonal_routing)
         {
-            destroyOrthogonalVisGraph();
-
             TIMER_START(this, tmOrthogGraph);
-            // Regenerate a new visibility graph.
-            generateStaticOrthogonalVisGraph(this);
+            // Update the existing visibility graph for the changes, if
+            // possible, otherwise regenerate a new visibility graph.
+            if (!routingOption(incrementallyUpdateOrthogonalVisibilityGraph) ||
+                    !updateStaticOrthogonalVisGraph(this))
+            {
+                destroyOrthogonalVisGraph();
+                generateStaticOrthogonalVisGraph(this);
+            }
             
-            TIMER_STOP(this);
+            TIMER_STOP(this, tmOrthogGraph);
         }
         m_static_orthogonal_graph_invalidated = false;
     }
@@ -607,8 +652,6 @@ void Router::processActions(void)
         bool isMove = (actInf.type == ShapeMove) ||
                 (actInf.type == JunctionMove);
 
-        unsigned int pid = obstacle->id();
-
         // Restore this shape for visibility.
         obstacle->makeActive();
 
@@ -623,30 +666,7 @@ void Router::processActions(void)
                 junction->setPosition(actInf.newPosition);
             }
         }
-        const Polygon& shapePoly = obstacle->routingPolygon();
-
-        adjustContainsWithAdd(shapePoly, pid);
-
-        if (m_allows_polyline_routing)
-        {
-            // o  Check all visibility edges to see if this one shape
-            //    blocks them.
-            if (!isMove || notPartialTime)
-            {
-                newBlockingShape(shapePoly, pid);
-            }
-
-            // o  Calculate visibility for the new vertices.
-            if (UseLeesAlgorithm)
-            {
-                obstacle->computeVisibilitySweep();
-            }
-            else
-            {
-                obstacle->computeVisibilityNaive();
-            }
-            obstacle->updatePinPolyLineVisibility();
-        }
+        addObstacleVisibility(obstacle, !isMove || notPartialTime);
     }
 
     // Update connector endpoints.
@@ -667,21 +687,189 @@ void Router::processActions(void)
     actionList.clear();
 }
 
+// Updates the containment and poly-line visibility information for an
+// obstacle that has just been made active.  If checkBlocking is set, then
+// existing visibility edges are checked to see if the obstacle blocks them.
+void Router::addObstacleVisibility(Obstacle *obstacle, 
+        const bool checkBlocking)
+{
+    unsigned int pid = obstacle->id();
+    const Polygon& shapePoly = obstacle->routingPolygon();
+
+    adjustContainsWithAdd(shapePoly, pid);
+
+    if (m_allows_polyline_routing)
+    {
+        // o  Check all visibility edges to see if this one shape
+        //    blocks them.
+        if (checkBlocking)
+        {
+            newBlockingShape(shapePoly, pid);
+        }
+
+        // o  Calculate visibility for the new vertices.
+        if (UseLeesAlgorithm)
+        {
+            obstacle->computeVisibilitySweep();
+        }
+        else
+        {
+            obstacle->computeVisibilityNaive();
+        }
+        obstacle->updatePinPolyLineVisibility();
+    }
+}
+
+
+template <typename T>
+static bool lessObjectId(const T *lhs, const T *rhs)
+{
+    return lhs->id() < rhs->id();
+}
+
+
+BulkLoadResult Router::bulkLoad(const std::vector<BulkShape>& shapes,
+        const std::vector<BulkPin>& pins,
+        const std::vector<BulkConnector>& connectors)
+{
+    BulkLoadResult result;
+    result.shapes.reserve(shapes.size());
+    result.pins.reserve(pins.size());
+    result.connectors.reserve(connectors.size());
+
+    m_bulk_loading = true;
+
+    // Create the objects, in the same order as they would be created 
+    // individually, but without queueing actions to add them.
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        result.shapes.push_back(new ShapeRef(this, shapes[i].polygon,
+                shapes[i].id, false));
+    }
+    for (size_t i = 0; i < pins.size(); ++i)
+    {
+        const BulkPin& pin = pins[i];
+        COLA_ASSERT(pin.shapeIndex < result.shapes.size());
+        ShapeRef *shape = result.shapes[pin.shapeIndex];
+        result.pins.push_back(new ShapeConnectionPin(shape, pin.classId,
+                pin.xOffset, pin.yOffset, pin.proportional,
+                pin.insideOffset, pin.visDirs));
+    }
+    for (size_t i = 0; i < connectors.size(); ++i)
+    {
+        ConnRef *conn = new ConnRef(this, connectors[i].id);
+        conn->m_type = validConnType(connectors[i].type);
+        result.connectors.push_back(conn);
+    }
+
+    m_bulk_loading = false;
+
+#ifndef NDEBUG
+    // Check the IDs of all objects are unique.
+    std::unordered_set<unsigned int> ids;
+    for (ObstacleList::const_iterator i = m_obstacles.begin(); 
+            i != m_obstacles.end(); ++i) 
+    {
+        COLA_ASSERT(ids.insert((*i)->id()).second);
+    }
+    for (size_t i = 0; i < result.shapes.size(); ++i)
+    {
+        COLA_ASSERT(ids.insert(result.shapes[i]->id()).second);
+    }
+    for (ConnRefList::const_iterator i = connRefs.begin(); 
+            i != connRefs.end(); ++i) 
+    {
+        COLA_ASSERT(ids.insert((*i)->id()).second);
+    }
+    for (ClusterRefList::const_iterator i = clusterRefs.begin(); 
+            i != clusterRefs.end(); ++i) 
+    {
+        COLA_ASSERT(ids.insert((*i)->id()).second);
+    }
+#endif
+
+    // Add the shapes, then the connector endpoints, in order of ID, as
+    // processTransaction() would.
+    std::vector<ShapeRef *> shapesById(result.shapes);
+    std::stable_sort(shapesById.begin(), shapesById.end(), 
+            lessObjectId<ShapeRef>);
+    for (size_t i = 0; i < shapesById.size(); ++i)
+    {
+        ShapeRef *shape = shapesById[i];
+        shape->makeActive();
+        addObstacleVisibility(shape, true);
+    }
+
+    std::vector<size_t> descriptionIndex(connectors.size());
+    for (size_t i = 0; i < connectors.size(); ++i)
+    {
+        descriptionIndex[i] = i;
+    }
+    std::stable_sort(descriptionIndex.begin(), descriptionIndex.end(),
+            [&](size_t lhs, size_t rhs)
+            {
+                return result.connectors[lhs]->id() < 
+                        result.connectors[rhs]->id();
+            });
+    for (size_t i = 0; i < descriptionIndex.size(); ++i)
+    {
+        const BulkConnector& description = connectors[descriptionIndex[i]];
+        ConnRef *conn = result.connectors[descriptionIndex[i]];
+        const BulkConnEnd *ends[2] = { &description.src, &description.dst };
+        const unsigned int types[2] = { VertID::src, VertID::tar };
+        for (size_t e = 0; e < 2; ++e)
+        {
+            const BulkConnEnd& end = *ends[e];
+            if (end.isAttached())
+            {
+                COLA_ASSERT(end.shapeIndex < result.shapes.size());
+                conn->updateEndPoint(types[e], 
+                        ConnEnd(result.shapes[end.shapeIndex], 
+                            end.pinClassId));
+            }
+            else
+            {
+                conn->updateEndPoint(types[e], 
+                        ConnEnd(end.point, end.visDirs));
+            }
+        }
+    }
+
+    // The new connectors need routing in the next transaction.
+    m_bulk_load_unrouted = true;
+    if (!m_consolidate_actions)
+    {
+        processTransaction();
+    }
+
+    return result;
+}
+
+
 bool Router::processTransaction(void)
 {
     // If SimpleRouting, then don't update here.
     if ((actionList.empty() && (m_hyperedge_rerouter.count() == 0) &&
-         (m_settings_changes == false)) || SimpleRouting)
+         (m_settings_changes == false) && (m_bulk_load_unrouted == false)) ||
+            SimpleRouting)
     {
         return false;
     }
     m_settings_changes = false;
+    m_bulk_load_unrouted = false;
 
+    TIMER_START(this, tmTransaction);
     processActions();
 
     m_static_orthogonal_graph_invalidated = true;
     rerouteAndCallbackConnectors();
 
+    if (timers.isEnabled())
+    {
+        timers.setGraphSizes(visGraph.size(), visOrthogGraph.size());
+    }
+    TIMER_STOP(this, tmTransaction);
+
     return true;
 }
 
@@ -841,7 +1029,8 @@ unsigned int Router::assignId(const unsigned int suggestedId)
     unsigned int assignedId = (suggestedId == 0) ?  newObjectId() : suggestedId;
     
     // If assertions are enabled, then we check that this ID really is unique.
-    COLA_ASSERT(objectIdIsUnused(assignedId));
+    // The IDs of objects being bulk loaded are instead checked together.
+    COLA_ASSERT(m_bulk_loading || objectIdIsUnused(assignedId));
     
     // Have the router record if this ID is larger than the largest assigned ID.
     m_largest_assigned_id = std::max(m_largest_assigned_id, assignedId);
@@ -851,68 +1040,95 @@ unsigned int Router::assignId(const unsigned int suggestedId)
 
 
     // Returns whether the given ID is unique among all objects known by the
-    // router.  It is expected this is only going to be called from assertions
-    // while debugging, so efficiency is not an issue and we just iterate over
-    // all objects.
+    // router.
 bool Router::objectIdIsUnused(const unsigned int id) const 
 {
-    // Examine shapes/junctions.
-    for (ObstacleList::const_iterator i = m_obstacles.begin(); 
-            i != m_obstacles.end(); ++i) 
-    {
-        if ((*i)->id() == id)
-        {
-            return false;
-        }
-    }
+    return m_object_ids.count(id) == 0;
+}
 
-    // Examine connectors.
-    for (ConnRefList::const_iterator i = connRefs.begin(); 
-            i != connRefs.end(); ++i) 
-    {
-        if ((*i)->id() == id)
-        {
-            return false;
-        }
-    }
 
-    // Examine clusters.
-    for (ClusterRefList::const_iterator i = clusterRefs.begin(); 
-            i != clusterRefs.end(); ++i) 
-    {
-        if ((*i)->id() == id)
-        {
-            return false;
-        }
-    }
+void Router::addObjectId(const unsigned int id)
+{
+    m_object_ids.insert(id);
+}
 
-    return true;
+
+void Router::removeObjectId(const unsigned int id)
+{
+    std::unordered_multiset<unsigned int>::iterator found =
+            m_object_ids.find(id);
+    COLA_ASSERT(found != m_object_ids.end());
+    m_object_ids.erase(found);
 }
 
 
 //----------------------------------------------------------------------------
 
-    // Returns a list of connector Ids of all the connectors of type
-    // 'type' attached to the shape with the ID 'shapeId'.
-void Router::attachedConns(IntList &conns, const unsigned int shapeId,
-        const unsigned int type)
-{
-    ConnRefList::const_iterator fin = connRefs.end();
-    for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
+    // Returns the connectors in connRefs attached to the shape with the ID
+    // 'shapeId' by ends of type 'type', in the same order as in connRefs.
+    // The connectors are found from the ConnEnds anchored to the shape, so
+    // this doesn't depend on the total number of connectors.
+std::vector<ConnRef *> Router::connectorsAttachedTo(
+        const unsigned int shapeId, const unsigned int type) const
+{
+    std::vector<ConnRef *> candidates;
+    std::pair<ObstacleIdMap::const_iterator, ObstacleIdMap::const_iterator>
+            range = m_obstacles_by_id.equal_range(shapeId);
+    for (ObstacleIdMap::const_iterator obstacle = range.first; 
+            obstacle != range.second; ++obstacle)
+    {
+        const std::set<ConnEnd *>& connEnds = 
+                obstacle->second->m_following_conns;
+        for (std::set<ConnEnd *>::const_iterator curr = connEnds.begin();
+                curr != connEnds.end(); ++curr)
+        {
+            ConnRef *conn = (*curr)->m_conn_ref;
+            if (conn->m_active)
+            {
+                candidates.push_back(conn);
+            }
+        }
+    }
+    // A connector may have both ends attached to the shape.
+    std::sort(candidates.begin(), candidates.end(), 
+            [](const ConnRef *lhs, const ConnRef *rhs)
+            {
+                return lhs->m_connrefs_order > rhs->m_connrefs_order;
+            });
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+            candidates.end());
+
+    std::vector<ConnRef *> conns;
+    for (size_t i = 0; i < candidates.size(); ++i)
     {
-        std::pair<Obstacle *, Obstacle *> anchors = (*i)->endpointAnchors();
+        std::pair<Obstacle *, Obstacle *> anchors = 
+                candidates[i]->endpointAnchors();
 
         if ((type & runningTo) &&
                 (anchors.second && (anchors.second->id() == shapeId)))
         {
-            conns.push_back((*i)->id());
+            conns.push_back(candidates[i]);
         }
         else if ((type & runningFrom) &&
                 (anchors.first && (anchors.first->id() == shapeId)))
         {
-            conns.push_back((*i)->id());
+            conns.push_back(candidates[i]);
         }
     }
+    return conns;
+}
+
+
+    // Returns a list of connector Ids of all the connectors of type
+    // 'type' attached to the shape with the ID 'shapeId'.
+void Router::attachedConns(IntList &conns, const unsigned int shapeId,
+        const unsigned int type)
+{
+    std::vector<ConnRef *> attached = connectorsAttachedTo(shapeId, type);
+    for (size_t i = 0; i < attached.size(); ++i)
+    {
+        conns.push_back(attached[i]->id());
+    }
 }
 
 
@@ -921,10 +1137,11 @@ void Router::attachedConns(IntList &conns, const unsigned int shapeId,
 void Router::attachedShapes(IntList &shapes, const unsigned int shapeId,
         const unsigned int type)
 {
-    ConnRefList::const_iterator fin = connRefs.end();
-    for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
+    std::vector<ConnRef *> attached = connectorsAttachedTo(shapeId, type);
+    for (size_t i = 0; i < attached.size(); ++i)
     {
-        std::pair<Obstacle *, Obstacle *> anchors = (*i)->endpointAnchors();
+        std::pair<Obstacle *, Obstacle *> anchors = 
+                attached[i]->endpointAnchors();
 
         if ((type & runningTo) &&
                 (anchors.second && (anchors.second->id() == shapeId)))
@@ -966,6 +1183,10 @@ void Router::rerouteAndCallbackConnectors(void)
         (*i)->freeActivePins();
     }
 
+    // Bring the compact copies of the graphs used by searches up to date.
+    visGraphAdjacency.update(this);
+    visOrthogGraphAdjacency.update(this);
+
     // Calculate and return connectors that are part of hyperedges and will
     // be completely rerouted by that code and thus don't need to have routes
     // generated here.
@@ -976,6 +1197,64 @@ void Router::rerouteAndCallbackConnectors(void)
     //       smallest to largest estimated cost.  This way we likely get 
     //       better exclusive pin assignment during initial routing.
 
+    TIMER_START(this, tmRouteSearch);
+
+    // Find the orthogonal connectors whose previous routes could not have
+    // been improved on by the changes since they were found.  These keep
+    // their routes rather than being searched for again.
+    ConnRefSet reusableConns;
+    if (routingOption(reuseUnaffectedOrthogonalRoutes))
+    {
+        m_route_cache->findChanges();
+        for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
+        {
+            ConnRef *connector = *i;
+            if ((hyperedgeConns.find(connector) == hyperedgeConns.end()) &&
+                    !connector->hasFixedRoute() &&
+                    connector->hasReusableSearchRoute() &&
+                    !m_route_cache->changedWithin(
+                        connector->m_search_corridor))
+            {
+                reusableConns.insert(connector);
+            }
+        }
+    }
+    else
+    {
+        m_route_cache->invalidate();
+    }
+
+    // If multiple threads are requested, first perform the searches for 
+    // all connectors whose searches don't depend on the routing of other
+    // connectors.  These are then used when processing the connectors in
+    // order below.
+    std::vector<AStarPath *> precomputedSearches;
+    unsigned int threadCount = 
+            threadCountFromSetting(routingParameter(routingThreadCount));
+    if (threadCount > 1)
+    {
+        std::vector<ConnRef *> independentConns;
+        for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
+        {
+            ConnRef *connector = *i;
+            if ((hyperedgeConns.find(connector) == hyperedgeConns.end()) &&
+                    (reusableConns.find(connector) == reusableConns.end()) &&
+                    !connector->hasFixedRoute() &&
+                    connector->hasIndependentSearch())
+            {
+                independentConns.push_back(connector);
+                precomputedSearches.push_back(new AStarPath());
+            }
+        }
+
+        m_thread_pool->parallelFor(independentConns.size(), threadCount, 
+                [&](size_t index)
+                {
+                    independentConns[index]->precomputeSearch(
+                            precomputedSearches[index]);
+                });
+    }
+
     size_t totalConns = connRefs.size();
     size_t numOfReroutedConns = 0;
     for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
@@ -989,23 +1268,40 @@ void Router::rerouteAndCallbackConnectors(void)
         if (hyperedgeConns.find(connector) != hyperedgeConns.end())
         {
             // This will be rerouted by the hyperedge code, so do nothing.
+            connector->m_search_route.clear();
             continue;
         }
 
         if (connector->hasFixedRoute())
         {
             // We don't reroute connectors with fixed routes.
+            connector->m_search_route.clear();
             continue;
         }
 
-        TIMER_START(this, tmOrthogRoute);
         connector->m_needs_repaint = false;
+        if (reusableConns.find(connector) != reusableConns.end())
+        {
+            connector->reuseSearchRoute();
+            reroutedConns.push_back(connector);
+            continue;
+        }
         bool rerouted = connector->generatePath();
         if (rerouted)
         {
             reroutedConns.push_back(connector);
         }
-        TIMER_STOP(this);
+    }
+    TIMER_STOP(this, tmRouteSearch);
+
+    // Free precomputed searches.
+    for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
+    {
+        (*i)->m_precomputed_search = nullptr;
+    }
+    for (size_t i = 0; i < precomputedSearches.size(); ++i)
+    {
+        delete precomputedSearches[i];
     }
 
 
@@ -1104,6 +1400,84 @@ static double cheapEstimatedCost(ConnRef *lineRef)
     return length - (route.size() + 1);
 }
 
+// Indexes the segments of a list of connector routes, so that the routes
+// which might touch or cross a particular route can be found without
+// comparing it against every other route.  Routes may have points added
+// by ConnectorCrossings while the index is in use, since this doesn't
+// change the paths they follow.
+class RouteSegmentIndex
+{
+    public:
+        RouteSegmentIndex(const std::vector<const Polygon *>& routes)
+            : m_grid(1.0),
+              m_last_seen(routes.size(), 0)
+        {
+            // Segment boxes are slightly enlarged so that touching
+            // segments are found despite any rounding.
+            const double tolerance = 1e-6;
+
+            m_first_box.reserve(routes.size() + 1);
+            for (size_t i = 0; i < routes.size(); ++i)
+            {
+                m_first_box.push_back(m_boxes.size());
+                const Polygon& route = *routes[i];
+                for (size_t j = 1; j < route.size(); ++j)
+                {
+                    const Point& a = route.at(j - 1);
+                    const Point& b = route.at(j);
+                    Box box;
+                    box.min.x = std::min(a.x, b.x) - tolerance;
+                    box.min.y = std::min(a.y, b.y) - tolerance;
+                    box.max.x = std::max(a.x, b.x) + tolerance;
+                    box.max.y = std::max(a.y, b.y) + tolerance;
+                    m_boxes.push_back(box);
+                }
+            }
+            m_first_box.push_back(m_boxes.size());
+
+            m_grid = SpatialGrid(SpatialGrid::suggestedCellSize(m_boxes));
+            for (size_t i = 0; i < routes.size(); ++i)
+            {
+                for (size_t b = m_first_box[i]; b < m_first_box[i + 1]; ++b)
+                {
+                    m_grid.insert((unsigned int) i, m_boxes[b]);
+                }
+            }
+        }
+
+        // Sets candidates to the indexes, in increasing order, of the
+        // routes after the given route with a segment whose bounding box
+        // touches the bounding box of one of the given route's segments.
+        // Routes not in this list can't touch or cross the given route.
+        void laterCandidates(const size_t index, std::vector<size_t>& candidates)
+        {
+            candidates.clear();
+            for (size_t b = m_first_box[index]; b < m_first_box[index + 1]; ++b)
+            {
+                m_query_result.clear();
+                m_grid.query(m_boxes[b], m_query_result);
+                for (size_t k = 0; k < m_query_result.size(); ++k)
+                {
+                    const size_t other = m_query_result[k];
+                    if ((other > index) && (m_last_seen[other] != index + 1))
+                    {
+                        m_last_seen[other] = index + 1;
+                        candidates.push_back(other);
+                    }
+                }
+            }
+            std::sort(candidates.begin(), candidates.end());
+        }
+
+    private:
+        SpatialGrid m_grid;
+        std::vector<Box> m_boxes;
+        std::vector<size_t> m_first_box;
+        std::vector<size_t> m_last_seen;
+        std::vector<unsigned int> m_query_result;
+};
+
+
 // A map of connectors to the set of connectors that cross them.
 typedef std::map<ConnRef *, std::set<ConnRef *> > CrossingConnectorsMap;
 
@@ -1445,16 +1819,29 @@ void Router::improveCrossings(void)
         return;
     }
 
+    TIMER_START(this, tmCrossingDetection);
+
     // Information on crossing connector groups.
     CrossingConnectorsInfo crossingConnInfo;
 
     size_t numOfConns = connRefs.size();
     size_t numOfConnsChecked = 0;
 
+    // Only pairs of connectors with touching segments can cross or share
+    // paths, so use an index of the route segments to find these rather
+    // than checking every pair.
+    std::vector<ConnRef *> conns(connRefs.begin(), connRefs.end());
+    std::vector<const Polygon *> routes(conns.size());
+    for (size_t ind = 0; ind < conns.size(); ++ind)
+    {
+        routes[ind] = &(conns[ind]->routeRef());
+    }
+    RouteSegmentIndex segmentIndex(routes);
+    std::vector<size_t> candidates;
+
     // Find crossings and reroute connectors.
     m_in_crossing_rerouting_stage = true;
-    ConnRefList::iterator fin = connRefs.end();
-    for (ConnRefList::iterator i = connRefs.begin(); i != fin; ++i) 
+    for (size_t iInd = 0; iInd < conns.size(); ++iInd)
     {
         // Progress reporting and continuation check.
         ++numOfConnsChecked;
@@ -1463,28 +1850,31 @@ void Router::improveCrossings(void)
         if (m_abort_transaction)
         {
             m_in_crossing_rerouting_stage = false;
+            TIMER_STOP(this, tmCrossingDetection);
             return;
         }
     
-        Avoid::Polygon& iRoute = (*i)->routeRef();
+        ConnRef *i = conns[iInd];
+        Avoid::Polygon& iRoute = i->routeRef();
         if (iRoute.size() == 0)
         {
             // Rerouted hyperedges will have an empty route.
             // We can't reroute these.
             continue;
         }
-        ConnRefList::iterator j = i;
-        for (++j; j != fin; ++j) 
+        segmentIndex.laterCandidates(iInd, candidates);
+        for (size_t cInd = 0; cInd < candidates.size(); ++cInd)
         {
-            if (crossingConnInfo.connsKnownToCross(*i, *j))
+            ConnRef *j = conns[candidates[cInd]];
+            if (crossingConnInfo.connsKnownToCross(i, j))
             {
                 // We already know both these have crossings.
                 continue;
             }
 
             // Determine if this pair cross.
-            Avoid::Polygon& jRoute = (*j)->routeRef();
-            ConnectorCrossings cross(iRoute, true, jRoute, *i, *j);
+            Avoid::Polygon& jRoute = j->routeRef();
+            ConnectorCrossings cross(iRoute, true, jRoute, i, j);
             for (size_t jInd = 1; jInd < jRoute.size(); ++jInd)
             {
                 const bool finalSegment = ((jInd + 1) == jRoute.size());
@@ -1498,13 +1888,13 @@ void Router::improveCrossings(void)
                 {
                     // We are penalising fixedSharedPaths and there is a
                     // fixedSharedPath.
-                    crossingConnInfo.addCrossing(*i, *j);
+                    crossingConnInfo.addCrossing(i, j);
                     break;
                 }
                 else if ((crossing_penalty > 0) && (cross.crossingCount > 0))
                 {
                     // We are penalising crossings and this is a crossing.
-                    crossingConnInfo.addCrossing(*i, *j);
+                    crossingConnInfo.addCrossing(i, j);
                     break;
                 }
             }
@@ -1518,12 +1908,14 @@ void Router::improveCrossings(void)
     // be rerouted, starting with the shortest.
     ConnCostRefSetList crossingConnsGroups = 
             crossingConnInfo.crossingSetsListToRemoveCrossingsFromGroups();
+    TIMER_STOP(this, tmCrossingDetection);
 
     // At this point we have a list containing crossings for rerouting.
     // We do this rerouting via two passes, for each group of interacting
     // crossing connectors:
     //  1) clear existing routes and free pin assignments, and
     //  2) compute new routes.
+    TIMER_START(this, tmRerouteSearch);
     unsigned int numOfConnsToReroute = 1;
     unsigned int numOfConnsRerouted = 1;
     for (ConnCostRefSetList::iterator setIt = crossingConnsGroups.begin();
@@ -1563,6 +1955,7 @@ void Router::improveCrossings(void)
                     if (m_abort_transaction)
                     {
                         m_in_crossing_rerouting_stage = false;
+                        TIMER_STOP(this, tmRerouteSearch);
                         return;
                     }
                     ++numOfConnsRerouted;
@@ -1573,6 +1966,7 @@ void Router::improveCrossings(void)
             }
         }
     }
+    TIMER_STOP(this, tmRerouteSearch);
     m_in_crossing_rerouting_stage = false;
 }
 
@@ -1581,6 +1975,7 @@ void Router::newBlockingShape(const Polygon& poly, int pid)
 {
     // o  Check all visibility edges to see if this one shape
     //    blocks them.
+    const Box polyBox = poly.offsetBoundingBox(0.0);
     EdgeInf *finish = visGraph.end();
     for (EdgeInf *iter = visGraph.begin(); iter != finish ; )
     {
@@ -1595,6 +1990,15 @@ void Router::newBlockingShape(const Polygon& poly, int pid)
             std::pair<Point, Point> points(tmp->points());
             Point e1 = points.first;
             Point e2 = points.second;
+            if (((e1.x < polyBox.min.x) && (e2.x < polyBox.min.x)) ||
+                ((e1.x > polyBox.max.x) && (e2.x > polyBox.max.x)) ||
+                ((e1.y < polyBox.min.y) && (e2.y < polyBox.min.y)) ||
+                ((e1.y > polyBox.max.y) && (e2.y > polyBox.max.y)))
+            {
+                // The edge lies to one side of the shape, so can't be
+                // blocked by it.
+                continue;
+            }
             bool blocked = false;
 
             bool countBorder = false;
@@ -1700,6 +2104,15 @@ void Router::checkAllMissingEdges(void)
 }
 
 
+const ShapeSet& Router::containingShapes(const VertID& pointID) const
+{
+    static const ShapeSet noShapes;
+
+    ContainsMap::const_iterator found = contains.find(pointID);
+    return (found != contains.end()) ? found->second : noShapes;
+}
+
+
 void Router::generateContains(VertInf *pt)
 {
     contains[pt->id].clear();
@@ -1709,25 +2122,52 @@ void Router::generateContains(VertInf *pt)
     bool countBorder = false;
 
     // Compute enclosing shapes.
+    std::vector<Obstacle *> obstacles;
+    m_obstacle_index->obstaclesAtPoint(pt->point, obstacles);
+    for (size_t i = 0; i < obstacles.size(); ++i)
+    {
+        if (inPoly(obstacles[i]->routingPolygon(), pt->point, countBorder))
+        {
+            contains[pt->id].insert(obstacles[i]->id());
+        }
+    }
+
+    // Computer enclosing Clusters
+    std::vector<ClusterRef *> clusters;
+    m_obstacle_index->clustersAtPoint(pt->point, clusters);
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        if (inPolyGen(clusters[i]->polygon(), pt->point))
+        {
+            enclosingClusters[pt->id].insert(clusters[i]->id());
+        }
+    }
+
+#ifndef NDEBUG
+    // Check the index against a scan of all the obstacles and clusters.
+    ShapeSet scannedObstacles;
     ObstacleList::const_iterator finish = m_obstacles.end();
     for (ObstacleList::const_iterator i = m_obstacles.begin(); i != finish; ++i)
     {
         if (inPoly((*i)->routingPolygon(), pt->point, countBorder))
         {
-            contains[pt->id].insert((*i)->id());
+            scannedObstacles.insert((*i)->id());
         }
     }
+    COLA_ASSERT(scannedObstacles == contains[pt->id]);
 
-    // Computer enclosing Clusters
+    ShapeSet scannedClusters;
     ClusterRefList::const_iterator clFinish = clusterRefs.end();
     for (ClusterRefList::const_iterator i = clusterRefs.begin(); 
             i != clFinish; ++i)
     {
         if (inPolyGen((*i)->polygon(), pt->point))
         {
-            enclosingClusters[pt->id].insert((*i)->id());
+            scannedClusters.insert((*i)->id());
         }
     }
+    COLA_ASSERT(scannedClusters == enclosingClusters[pt->id]);
+#endif
 }
 
 
@@ -2052,6 +2492,10 @@ void Router::setRoutingParameter(const RoutingParameter parameter,
             case portDirectionPenalty:
                 m_routing_parameters[parameter] = 100;
                 break;
+            case routingThreadCount:
+                m_routing_parameters[parameter] = 
+                        std::max(std::thread::hardware_concurrency(), 1u);
+                break;
             default:
                 m_routing_parameters[parameter] = 50;
                 break;
@@ -2061,6 +2505,13 @@ void Router::setRoutingParameter(const RoutingParameter parameter,
     {
         m_routing_parameters[parameter] = value;
     }
+    if (parameter == shapeBufferDistance)
+    {
+        // The routing polygons of all obstacles change.
+        m_obstacle_index->invalidate();
+    }
+    // Previous routes may no longer be the best ones.
+    m_route_cache->invalidate();
     m_settings_changes = true;
 }
 
@@ -2076,6 +2527,7 @@ void Router::setRoutingOption(const RoutingOption option, const bool value)
 {
     COLA_ASSERT(option < lastRoutingOptionMarker);
     m_routing_options[option] = value;
+    m_route_cache->invalidate();
     m_settings_changes = true;
 }
 
@@ -2104,6 +2556,30 @@ HyperedgeRerouter *Router::hyperedgeRerouter(void)
 }
 
 
+void Router::setProfilingEnabled(const bool enabled)
+{
+    timers.setEnabled(enabled);
+}
+
+
+bool Router::profilingEnabled(void) const
+{
+    return timers.isEnabled();
+}
+
+
+RouterProfile Router::profile(void) const
+{
+    return timers.profile();
+}
+
+
+void Router::resetProfile(void)
+{
+    timers.reset();
+}
+
+
 bool Router::isInCrossingPenaltyReroutingStage(void) const
 {
     return m_in_crossing_rerouting_stage;
@@ -2181,10 +2657,11 @@ void Router::printInfo(void)
     fprintf(fp, "checkVisEdge tally: %d\n", st_checked_edges);
     fprintf(fp, "----------------------\n");
 
-#ifdef AVOID_PROFILE
-    timers.printAll(fp);
-    timers.reset();
-#endif
+    if (timers.isEnabled())
+    {
+        timers.printAll(fp);
+        timers.reset();
+    }
 }
 
 
@@ -2307,17 +2784,28 @@ bool Router::existsOrthogonalTouchingPaths(void)
 int Router::existsCrossings(const bool optimisedForConnectorType)
 {
     int count = 0;
-    ConnRefList::iterator fin = connRefs.end();
-    for (ConnRefList::iterator i = connRefs.begin(); i != fin; ++i) 
+    std::vector<ConnRef *> conns(connRefs.begin(), connRefs.end());
+    std::vector<Polygon> displayRoutes(conns.size());
+    std::vector<const Polygon *> routes(conns.size());
+    for (size_t ind = 0; ind < conns.size(); ++ind)
     {
-        Avoid::Polygon iRoute = (*i)->displayRoute();
-        ConnRefList::iterator j = i;
-        for (++j; j != fin; ++j) 
+        displayRoutes[ind] = conns[ind]->displayRoute();
+        routes[ind] = &displayRoutes[ind];
+    }
+    RouteSegmentIndex segmentIndex(routes);
+    std::vector<size_t> candidates;
+
+    for (size_t iInd = 0; iInd < conns.size(); ++iInd)
+    {
+        Avoid::Polygon iRoute = displayRoutes[iInd];
+        segmentIndex.laterCandidates(iInd, candidates);
+        for (size_t cInd = 0; cInd < candidates.size(); ++cInd)
         {
             // Determine if this pair overlap
-            Avoid::Polygon jRoute = (*j)->displayRoute();
-            ConnRef *iConn = (optimisedForConnectorType) ? *i : nullptr;
-            ConnRef *jConn = (optimisedForConnectorType) ? *j : nullptr;
+            const size_t other = candidates[cInd];
+            Avoid::Polygon jRoute = displayRoutes[other];
+            ConnRef *iConn = (optimisedForConnectorType) ? conns[iInd] : nullptr;
+            ConnRef *jConn = (optimisedForConnectorType) ? conns[other] : nullptr;
             ConnectorCrossings cross(iRoute, true, jRoute, iConn, jConn);
             cross.checkForBranchingSegments = true;
             for (size_t jInd = 1; jInd < jRoute.size(); ++jInd)
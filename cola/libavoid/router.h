@@ -33,6 +33,8 @@
 #include <list>
 #include <utility>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "libavoid/dllexport.h"
 #include "libavoid/connector.h"
@@ -42,6 +44,7 @@
 #include "libavoid/hyperedge.h"
 #include "libavoid/actioninfo.h"
 #include "libavoid/hyperedgeimprover.h"
+#include "libavoid/bulkload.h"
 
 
 namespace Avoid {
@@ -63,7 +66,12 @@ class ClusterRef;
 typedef std::list<ClusterRef *> ClusterRefList;
 class Obstacle;
 typedef std::list<Obstacle *> ObstacleList;
+typedef std::unordered_multimap<unsigned int, Obstacle *> ObstacleIdMap;
 class DebugHandler;
+class OrthogonalVisGraphState;
+class ObstacleIndex;
+class RouteCache;
+class ThreadPool;
 
 //! @brief  Flags that can be passed to the router during initialisation 
 //!         to specify options.
@@ -161,6 +169,27 @@ enum RoutingParameter
     //!         to loop around obstacles.
     reverseDirectionPenalty,
 
+    //! @brief This parameter defines the number of threads that will be
+    //!        used to search for initial connector routes.  By default
+    //!        this is set to zero, meaning all searches are performed 
+    //!        serially on the calling thread.  If a negative value is given
+    //!        then the number of hardware threads will be used.
+    //!
+    //! Searches for connectors that do not attach to connection pins or
+    //! junctions and do not have checkpoints are performed concurrently,
+    //! with the resulting routes committed in the usual connector order.
+    //! Independent regions of overlapping segments are also nudged
+    //! concurrently during orthogonal routing, and the poly-line 
+    //! visibility of the vertices of added or moved shapes is computed
+    //! concurrently.  The routes produced are identical to those from 
+    //! serial routing.  While nudging concurrently, the transaction
+    //! progress callback is called between batches of regions rather
+    //! than before each region.
+    //!
+    //! @note   This has no effect when rubber-band routing is in use or
+    //!         a debug handler is set.
+    routingThreadCount,
+
     // Used for determining the size of the routing parameter array.
     // This should always we the last value in the enum.
     lastRoutingParameterMarker
@@ -284,6 +313,56 @@ enum RoutingOption
     //!
     nudgeSharedPathsWithCommonEndPoint,
 
+    //! This option causes the orthogonal visibility graph to be updated
+    //! incrementally when shapes, junctions or connector endpoints are
+    //! added, moved or removed.  Only the parts of the graph in the 
+    //! horizontal and vertical bands spanned by the changed objects are 
+    //! recomputed, and the rest of the graph is left untouched.  The 
+    //! resulting graph is the same as one regenerated from scratch.
+    //!
+    //! Defaults to true.
+    //!
+    //! Turning this off forces the graph to be fully regenerated after 
+    //! every change, as is always done when most of the graph is affected.
+    //!
+    incrementallyUpdateOrthogonalVisibilityGraph,
+
+    //! This option causes orthogonal connectors to keep their previous
+    //! routes when nothing that could have led to a better route has
+    //! changed since they were last routed.  After each search the router
+    //! records a corridor around the connector's endpoints, sized from the
+    //! cost of the route found so that any cheaper route would have to lie
+    //! within it.  The search itself is not limited to this corridor.  In
+    //! later transactions, if the connector's endpoints haven't moved and 
+    //! no shape, junction or connection point added, moved or removed 
+    //! since then affects the visibility graph within the corridor, the 
+    //! search is skipped and the previous route is used.  Connectors 
+    //! attached to connection pins or with checkpoints are always 
+    //! rerouted.
+    //!
+    //! Defaults to true.
+    //!
+    //! Turning this off forces every connector to be rerouted in every
+    //! transaction.  Changing any routing parameter or option, or any
+    //! cluster, also causes every connector to be rerouted once.
+    //!
+    reuseUnaffectedOrthogonalRoutes,
+
+    //! This option causes the constraint solver for each region of 
+    //! overlapping segments to be kept between the attempts made while
+    //! nudging, so each attempt is warm-started from the last solution.
+    //! While unifying segments each attempt only adds or rolls back one
+    //! equality constraint, so this saves rebuilding the solver from 
+    //! scratch every time.
+    //!
+    //! Defaults to false.
+    //!
+    //! The positions found can differ slightly from those found by a new
+    //! solver, so routes may not be identical to those produced with this
+    //! option turned off.
+    //!
+    warmStartOrthogonalNudging,
+
 
     // Used for determining the size of the routing options array.
     // This should always we the last value in the enum.
@@ -404,7 +483,25 @@ class AVOID_EXPORT Router {
         EdgeList visGraph;
         EdgeList invisGraph;
         EdgeList visOrthogGraph;
+        OrthogonalVisGraphState *m_orthogonal_graph_state;
+        ObstacleIndex *m_obstacle_index;
+        RouteCache *m_route_cache;
+        // The threads used when routingThreadCount asks for more than one.
+        ThreadPool *m_thread_pool;
+        CompactAdjacency visGraphAdjacency;
+        CompactAdjacency visOrthogGraphAdjacency;
+        // Returns the compact adjacency of the orthogonal or polyline
+        // visibility graph.
+        CompactAdjacency& compactAdjacency(const bool orthogonal)
+        {
+            return (orthogonal) ? visOrthogGraphAdjacency : 
+                    visGraphAdjacency;
+        }
         ContainsMap contains;
+        // Returns the shapes containing the given connector point, without
+        // adding an entry for it to the contains map, so this can be used 
+        // from multiple threads.
+        const ShapeSet& containingShapes(const VertID& pointID) const;
         VertInfList vertices;
         ContainsMap enclosingClusters;
         
@@ -426,9 +523,7 @@ class AVOID_EXPORT Router {
         
 
         // Instrumentation:
-#ifdef AVOID_PROFILE
         Timer timers;
-#endif
         int st_checked_edges;
 
         //! @brief Allows setting of the behaviour of the router in regard
@@ -479,6 +574,34 @@ class AVOID_EXPORT Router {
         //!
         bool processTransaction(void);
 
+        //! @brief  Adds a complete set of shapes, connection pins and 
+        //!         connectors to the router scene at once.
+        //!
+        //! This gives the same scene as creating each ShapeRef, 
+        //! ShapeConnectionPin and ConnRef in turn, in the order they are 
+        //! given, and then calling processTransaction().  The objects are 
+        //! added to the router's data structures directly rather than 
+        //! queueing an action for each of them, and the uniqueness of 
+        //! their IDs is checked (if assertions are enabled) once for all
+        //! of them, so this is much faster for large diagrams.
+        //!
+        //! The objects are added immediately, though connectors are only 
+        //! routed the next time Router::processTransaction() is called, 
+        //! or immediately if the router is not using transactions.
+        //!
+        //! @param[in]  shapes      Descriptions of the shapes to create.
+        //! @param[in]  pins        Descriptions of the connection pins to 
+        //!                         create, each on one of shapes.
+        //! @param[in]  connectors  Descriptions of the connectors to 
+        //!                         create, with endpoints that are either 
+        //!                         free points or pin classes on shapes.
+        //! @return  The objects created, in the order of their 
+        //!          descriptions.  These are owned by the router.
+        //!
+        BulkLoadResult bulkLoad(const std::vector<BulkShape>& shapes,
+                const std::vector<BulkPin>& pins,
+                const std::vector<BulkConnector>& connectors);
+
         //! @brief Delete a shape from the router scene.
         //!
         //! Connectors that could have a better (usually shorter) path after
@@ -669,6 +792,37 @@ class AVOID_EXPORT Router {
         //!
         HyperedgeRerouter *hyperedgeRerouter(void);
 
+        //! @brief  Turns collection of profiling information on or off.
+        //!
+        //! When enabled, the router records the time taken by each phase 
+        //! of the transactions it processes, along with counts of the work 
+        //! done.  These can be read with profile().  Profiling is off by
+        //! default and costs very little when off.
+        //!
+        //! This should not be called while a transaction is being processed.
+        //!
+        //! @param[in] enabled  Whether profiling information is collected.
+        //!
+        void setProfilingEnabled(const bool enabled);
+
+        //! @brief  Returns whether profiling information is being collected.
+        //!
+        //! @return  A boolean denoting whether profiling is enabled.
+        //!
+        bool profilingEnabled(void) const;
+
+        //! @brief  Returns the profiling information collected since 
+        //!         profiling was enabled or last reset.
+        //!
+        //! @return  A RouterProfile with times for each transaction phase
+        //!          and counts of the work done.
+        //!
+        RouterProfile profile(void) const;
+
+        //! @brief  Discards the profiling information collected so far.
+        //!
+        void resetProfile(void);
+
         //! @brief  Generates an SVG file containing debug output and code that
         //!         can be used to regenerate the instance.
         //!
@@ -843,18 +997,36 @@ class AVOID_EXPORT Router {
         void newBlockingShape(const Polygon& poly, int pid);
         void checkAllBlockedEdges(int pid);
         void checkAllMissingEdges(void);
+        void addObstacleVisibility(Obstacle *obstacle, 
+                const bool checkBlocking);
         void adjustContainsWithAdd(const Polygon& poly, const int p_shape);
         void adjustContainsWithDel(const int p_shape);
         void adjustClustersWithAdd(const PolygonInterface& poly, 
                 const int p_cluster);
         void adjustClustersWithDel(const int p_cluster);
+        void addObjectId(const unsigned int id);
+        void removeObjectId(const unsigned int id);
+        std::vector<ConnRef *> connectorsAttachedTo(
+                const unsigned int shapeId, const unsigned int type) const;
         void rerouteAndCallbackConnectors(void);
         void improveCrossings(void);
 
         ActionInfoList actionList;
         unsigned int m_largest_assigned_id;
+        // The IDs of the shapes, junctions, connectors and clusters in the
+        // lists above, so objectIdIsUnused() needn't search them.
+        std::unordered_multiset<unsigned int> m_object_ids;
+        // Every shape and junction that exists, by ID, whether or not it
+        // has been added yet.  Their connectors are found from them.
+        ObstacleIdMap m_obstacles_by_id;
+        // The number of times connectors have been added to connRefs.
+        unsigned long m_connrefs_added;
         bool m_consolidate_actions;
         bool m_currently_calling_destructors;
+        bool m_bulk_loading;
+        // Whether bulkLoad() has added connectors that no transaction 
+        // has routed yet.
+        bool m_bulk_load_unrouted;
         double m_routing_parameters[lastRoutingParameterMarker];
         bool m_routing_options[lastRoutingOptionMarker];
         
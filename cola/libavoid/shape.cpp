@@ -43,6 +43,17 @@ ShapeRef::ShapeRef(Router *router, Polygon& ply, const unsigned int id)
 }
 
 
+ShapeRef::ShapeRef(Router *router, const Polygon& ply, const unsigned int id,
+        const bool queueAddition)
+    : Obstacle(router, ply, id)
+{
+    if (queueAddition)
+    {
+        m_router->addShape(this);
+    }
+}
+
+
 ShapeRef::~ShapeRef()
 {
     if (m_router->m_currently_calling_destructors == false)
@@ -149,6 +149,11 @@ class AVOID_EXPORT ShapeRef : public Obstacle
         friend class ShapeConnectionPin;
         friend class topology::LayoutObstacle;
 
+        // Constructs a shape that Router::bulkLoad() adds to the router 
+        // directly, rather than queueing an action to add it.
+        ShapeRef(Router *router, const Polygon& poly, const unsigned int id,
+                const bool queueAddition);
+
         void outputCode(FILE *fp) const;
         void moveAttachedConns(const Polygon& newPoly);
         void assignPinVisibilityTo(const unsigned int pinClassId,
@@ -0,0 +1,492 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "libavoid/spatialindex.h"
+#include "libavoid/router.h"
+#include "libavoid/obstacle.h"
+#include "libavoid/viscluster.h"
+#include "libavoid/assertions.h"
+
+namespace Avoid {
+
+
+SpatialGrid::SpatialGrid(const double cellSize)
+    : m_cell_size(cellSize),
+      m_entry_count(0)
+{
+    COLA_ASSERT(m_cell_size > 0);
+}
+
+
+double SpatialGrid::cellSize(void) const
+{
+    return m_cell_size;
+}
+
+
+bool SpatialGrid::empty(void) const
+{
+    return (m_entry_count == 0);
+}
+
+
+void SpatialGrid::clear(void)
+{
+    m_cells.clear();
+    m_entry_count = 0;
+}
+
+
+int SpatialGrid::cellCoord(const double value) const
+{
+    // Clamp so that huge coordinates still map to a valid cell.  Boxes
+    // beyond this range all share the outermost cells, which is slow but
+    // still correct.
+    const double cell = std::floor(value / m_cell_size);
+    if (cell <= INT_MIN / 2)
+    {
+        return INT_MIN / 2;
+    }
+    if (cell >= INT_MAX / 2)
+    {
+        return INT_MAX / 2;
+    }
+    return (int) cell;
+}
+
+
+SpatialGrid::CellKey SpatialGrid::cellKey(const int x, const int y)
+{
+    return (((CellKey) (unsigned int) x) << 32) | (CellKey) (unsigned int) y;
+}
+
+
+void SpatialGrid::insert(const unsigned int item, const Box& box)
+{
+    Entry entry;
+    entry.item = item;
+    entry.box = box;
+
+    const int minX = cellCoord(box.min.x);
+    const int maxX = cellCoord(box.max.x);
+    const int minY = cellCoord(box.min.y);
+    const int maxY = cellCoord(box.max.y);
+    for (int x = minX; x <= maxX; ++x)
+    {
+        for (int y = minY; y <= maxY; ++y)
+        {
+            m_cells[cellKey(x, y)].push_back(entry);
+        }
+    }
+    ++m_entry_count;
+}
+
+
+void SpatialGrid::remove(const unsigned int item, const Box& box)
+{
+    const int minX = cellCoord(box.min.x);
+    const int maxX = cellCoord(box.max.x);
+    const int minY = cellCoord(box.min.y);
+    const int maxY = cellCoord(box.max.y);
+    for (int x = minX; x <= maxX; ++x)
+    {
+        for (int y = minY; y <= maxY; ++y)
+        {
+            std::unordered_map<CellKey, EntryList>::iterator cell =
+                    m_cells.find(cellKey(x, y));
+            COLA_ASSERT(cell != m_cells.end());
+            EntryList& entries = cell->second;
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                const Entry& entry = entries[i];
+                if ((entry.item == item) &&
+                        (entry.box.min == box.min) && (entry.box.max == box.max))
+                {
+                    entries[i] = entries.back();
+                    entries.pop_back();
+                    break;
+                }
+            }
+            if (entries.empty())
+            {
+                m_cells.erase(cell);
+            }
+        }
+    }
+    COLA_ASSERT(m_entry_count > 0);
+    --m_entry_count;
+}
+
+
+void SpatialGrid::queryCell(const CellKey key, const EntryList& entries,
+        const Box& box, std::vector<unsigned int>& items) const
+{
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const Box& other = entries[i].box;
+        if ((other.min.x > box.max.x) || (other.max.x < box.min.x) ||
+                (other.min.y > box.max.y) || (other.max.y < box.min.y))
+        {
+            continue;
+        }
+        // The entry may be stored in several of the cells being searched.
+        // Only report it from the cell containing the top-left corner of
+        // the intersection of the two boxes, which is unique.
+        const int refX = cellCoord(std::max(other.min.x, box.min.x));
+        const int refY = cellCoord(std::max(other.min.y, box.min.y));
+        if (cellKey(refX, refY) == key)
+        {
+            items.push_back(entries[i].item);
+        }
+    }
+}
+
+
+void SpatialGrid::query(const Box& box, std::vector<unsigned int>& items) const
+{
+    if (m_entry_count == 0)
+    {
+        return;
+    }
+
+    const int minX = cellCoord(box.min.x);
+    const int maxX = cellCoord(box.max.x);
+    const int minY = cellCoord(box.min.y);
+    const int maxY = cellCoord(box.max.y);
+    const double spannedCells =
+            ((double) maxX - minX + 1) * ((double) maxY - minY + 1);
+    if (spannedCells > (double) m_cells.size())
+    {
+        // The query covers more cells than are occupied, so it is
+        // quicker to look at each of the occupied cells.
+        for (std::unordered_map<CellKey, EntryList>::const_iterator cell =
+                m_cells.begin(); cell != m_cells.end(); ++cell)
+        {
+            queryCell(cell->first, cell->second, box, items);
+        }
+        return;
+    }
+
+    for (int x = minX; x <= maxX; ++x)
+    {
+        for (int y = minY; y <= maxY; ++y)
+        {
+            const CellKey key = cellKey(x, y);
+            std::unordered_map<CellKey, EntryList>::const_iterator cell =
+                    m_cells.find(key);
+            if (cell != m_cells.end())
+            {
+                queryCell(key, cell->second, box, items);
+            }
+        }
+    }
+}
+
+
+double SpatialGrid::suggestedCellSize(const std::vector<Box>& boxes)
+{
+    if (boxes.empty())
+    {
+        return 1.0;
+    }
+
+    Box bounds = boxes[0];
+    double totalSize = 0;
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        const Box& box = boxes[i];
+        bounds.min.x = std::min(bounds.min.x, box.min.x);
+        bounds.min.y = std::min(bounds.min.y, box.min.y);
+        bounds.max.x = std::max(bounds.max.x, box.max.x);
+        bounds.max.y = std::max(bounds.max.y, box.max.y);
+        totalSize += std::max(box.width(), box.height());
+    }
+
+    // Use cells about the size of an average box, but not so small that
+    // there would be many more cells over the whole area than boxes.
+    const double averageSize = totalSize / boxes.size();
+    const double area = std::max(bounds.width(), 1.0) *
+            std::max(bounds.height(), 1.0);
+    const double sparseSize = std::sqrt(area / boxes.size());
+    const double cellSize = std::max(averageSize, sparseSize);
+    if (!(cellSize > 0) || std::isinf(cellSize))
+    {
+        return 1.0;
+    }
+    return cellSize;
+}
+
+
+ObstacleIndex::ObstacleIndex(Router *router)
+    : m_router(router),
+      m_obstacle_grid(1.0),
+      m_grid_obstacle_count(0),
+      m_next_order(0),
+      m_obstacles_valid(true),
+      m_cluster_grid(1.0),
+      m_clusters_valid(false)
+{
+}
+
+
+// The routing polygon can extend beyond the routing box at sharp corners,
+// so this uses the bounds of the polygon itself.
+Box ObstacleIndex::obstacleBox(Obstacle *obstacle) const
+{
+    return obstacle->routingPolygon().offsetBoundingBox(0.0);
+}
+
+
+void ObstacleIndex::addObstacle(Obstacle *obstacle)
+{
+    invalidateClusters();
+    if (!m_obstacles_valid)
+    {
+        return;
+    }
+    COLA_ASSERT(m_obstacle_slots.find(obstacle) == m_obstacle_slots.end());
+
+    unsigned int slot;
+    if (!m_free_slots.empty())
+    {
+        slot = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+    else
+    {
+        slot = (unsigned int) m_obstacles.size();
+        m_obstacles.push_back(nullptr);
+        m_obstacle_boxes.push_back(Box());
+        m_obstacle_order.push_back(0);
+    }
+    m_obstacles[slot] = obstacle;
+    m_obstacle_boxes[slot] = obstacleBox(obstacle);
+    m_obstacle_order[slot] = m_next_order++;
+    m_obstacle_slots[obstacle] = slot;
+
+    if (m_obstacle_slots.size() > 2 * m_grid_obstacle_count)
+    {
+        // Choose a new cell size now the number of obstacles has doubled.
+        rebuildObstacleGrid();
+    }
+    else
+    {
+        m_obstacle_grid.insert(slot, m_obstacle_boxes[slot]);
+    }
+}
+
+
+void ObstacleIndex::moveObstacle(Obstacle *obstacle)
+{
+    invalidateClusters();
+    if (!m_obstacles_valid)
+    {
+        return;
+    }
+    std::unordered_map<const Obstacle *, unsigned int>::const_iterator found =
+            m_obstacle_slots.find(obstacle);
+    if (found == m_obstacle_slots.end())
+    {
+        // The obstacle has not been added to the router yet.
+        return;
+    }
+    const unsigned int slot = found->second;
+    m_obstacle_grid.remove(slot, m_obstacle_boxes[slot]);
+    m_obstacle_boxes[slot] = obstacleBox(obstacle);
+    m_obstacle_grid.insert(slot, m_obstacle_boxes[slot]);
+}
+
+
+void ObstacleIndex::removeObstacle(Obstacle *obstacle)
+{
+    invalidateClusters();
+    if (!m_obstacles_valid)
+    {
+        return;
+    }
+    std::unordered_map<const Obstacle *, unsigned int>::iterator found =
+            m_obstacle_slots.find(obstacle);
+    COLA_ASSERT(found != m_obstacle_slots.end());
+    const unsigned int slot = found->second;
+    m_obstacle_grid.remove(slot, m_obstacle_boxes[slot]);
+    m_obstacles[slot] = nullptr;
+    m_free_slots.push_back(slot);
+    m_obstacle_slots.erase(found);
+}
+
+
+void ObstacleIndex::invalidate(void)
+{
+    m_obstacles_valid = false;
+    m_clusters_valid = false;
+}
+
+
+void ObstacleIndex::invalidateClusters(void)
+{
+    m_clusters_valid = false;
+}
+
+
+void ObstacleIndex::rebuildObstacles(void)
+{
+    m_obstacles.clear();
+    m_obstacle_boxes.clear();
+    m_obstacle_order.clear();
+    m_free_slots.clear();
+    m_obstacle_slots.clear();
+    m_next_order = 0;
+
+    // Obstacles are added to the front of the router's list, so add them
+    // from the back to give them the same order.
+    for (ObstacleList::const_reverse_iterator it = 
+            m_router->m_obstacles.rbegin(); 
+            it != m_router->m_obstacles.rend(); ++it)
+    {
+        Obstacle *obstacle = *it;
+        m_obstacle_slots[obstacle] = (unsigned int) m_obstacles.size();
+        m_obstacles.push_back(obstacle);
+        m_obstacle_boxes.push_back(obstacleBox(obstacle));
+        m_obstacle_order.push_back(m_next_order++);
+    }
+    rebuildObstacleGrid();
+    m_obstacles_valid = true;
+}
+
+
+void ObstacleIndex::rebuildObstacleGrid(void)
+{
+    std::vector<Box> boxes;
+    boxes.reserve(m_obstacle_slots.size());
+    for (size_t slot = 0; slot < m_obstacles.size(); ++slot)
+    {
+        if (m_obstacles[slot])
+        {
+            boxes.push_back(m_obstacle_boxes[slot]);
+        }
+    }
+    m_obstacle_grid = SpatialGrid(SpatialGrid::suggestedCellSize(boxes));
+    for (size_t slot = 0; slot < m_obstacles.size(); ++slot)
+    {
+        if (m_obstacles[slot])
+        {
+            m_obstacle_grid.insert((unsigned int) slot, m_obstacle_boxes[slot]);
+        }
+    }
+    m_grid_obstacle_count = boxes.size();
+}
+
+
+void ObstacleIndex::rebuildClusters(void)
+{
+    m_clusters.clear();
+    std::vector<Box> boxes;
+    for (ClusterRefList::const_iterator it = m_router->clusterRefs.begin();
+            it != m_router->clusterRefs.end(); ++it)
+    {
+        if ((*it)->polygon().empty())
+        {
+            continue;
+        }
+        m_clusters.push_back(*it);
+        boxes.push_back((*it)->polygon().offsetBoundingBox(0.0));
+    }
+    m_cluster_grid = SpatialGrid(SpatialGrid::suggestedCellSize(boxes));
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        m_cluster_grid.insert((unsigned int) i, boxes[i]);
+    }
+    m_clusters_valid = true;
+}
+
+
+// Orders obstacle slots by when their obstacles were added, latest first.
+class CmpSlotOrder
+{
+    public:
+        CmpSlotOrder(const std::vector<unsigned long long>& order)
+            : m_order(order)
+        {
+        }
+        bool operator()(const unsigned int lhs, const unsigned int rhs) const
+        {
+            return m_order[lhs] > m_order[rhs];
+        }
+    private:
+        const std::vector<unsigned long long>& m_order;
+};
+
+
+void ObstacleIndex::obstaclesAtPoint(const Point& point, 
+        std::vector<Obstacle *>& obstacles)
+{
+    if (!m_obstacles_valid)
+    {
+        rebuildObstacles();
+    }
+    Box box;
+    box.min = point;
+    box.max = point;
+    m_query_items.clear();
+    m_obstacle_grid.query(box, m_query_items);
+    std::sort(m_query_items.begin(), m_query_items.end(), 
+            CmpSlotOrder(m_obstacle_order));
+
+    obstacles.clear();
+    for (size_t i = 0; i < m_query_items.size(); ++i)
+    {
+        obstacles.push_back(m_obstacles[m_query_items[i]]);
+    }
+}
+
+
+void ObstacleIndex::clustersAtPoint(const Point& point, 
+        std::vector<ClusterRef *>& clusters)
+{
+    clusters.clear();
+    if (m_router->clusterRefs.empty())
+    {
+        return;
+    }
+    if (!m_clusters_valid)
+    {
+        rebuildClusters();
+    }
+    Box box;
+    box.min = point;
+    box.max = point;
+    m_query_items.clear();
+    m_cluster_grid.query(box, m_query_items);
+    for (size_t i = 0; i < m_query_items.size(); ++i)
+    {
+        clusters.push_back(m_clusters[m_query_items[i]]);
+    }
+}
+
+
+}
+
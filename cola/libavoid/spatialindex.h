@@ -0,0 +1,150 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2004-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef AVOID_SPATIALINDEX_H
+#define AVOID_SPATIALINDEX_H
+
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+#include "libavoid/geomtypes.h"
+
+namespace Avoid {
+
+// An index of axis-aligned boxes, based on a uniform grid of square cells.
+// Each box is stored in every cell it overlaps, so the grid works best
+// when the cell size is comparable to the size of the boxes it holds.
+// Items are identified by an unsigned integer chosen by the caller and
+// the same item may be inserted several times with different boxes.
+//
+class SpatialGrid
+{
+    public:
+        SpatialGrid(const double cellSize);
+
+        double cellSize(void) const;
+        bool empty(void) const;
+        void clear(void);
+
+        // Adds an entry for item with the given box.
+        void insert(const unsigned int item, const Box& box);
+        // Removes the entry for item that was inserted with the given box.
+        void remove(const unsigned int item, const Box& box);
+        // Appends to items the item for each entry whose box intersects
+        // or touches the query box.  Each entry is reported once, though
+        // an item inserted with several boxes may be reported several
+        // times.  The order of the results is unspecified.
+        void query(const Box& box, std::vector<unsigned int>& items) const;
+
+        // Returns a cell size suitable for indexing the given boxes.
+        static double suggestedCellSize(const std::vector<Box>& boxes);
+
+    private:
+        struct Entry
+        {
+            unsigned int item;
+            Box box;
+        };
+        typedef std::vector<Entry> EntryList;
+        typedef unsigned long long CellKey;
+
+        int cellCoord(const double value) const;
+        static CellKey cellKey(const int x, const int y);
+        void queryCell(const CellKey key, const EntryList& entries,
+                const Box& box, std::vector<unsigned int>& items) const;
+
+        double m_cell_size;
+        size_t m_entry_count;
+        std::unordered_map<CellKey, EntryList> m_cells;
+};
+
+
+class Router;
+class Obstacle;
+class ClusterRef;
+
+// An index of the obstacles and clusters in a router, by the bounding 
+// boxes of their routing polygons, for finding those that may contain a 
+// point.  Obstacle entries are updated as obstacles are added, moved and 
+// removed.  Cluster boundaries may refer to the points of obstacles, so 
+// the cluster entries are instead rebuilt when next needed after any 
+// change.  The whole index is rebuilt when next needed after it is 
+// invalidated, e.g., when the shape buffer distance changes.
+//
+class ObstacleIndex
+{
+    public:
+        ObstacleIndex(Router *router);
+
+        void addObstacle(Obstacle *obstacle);
+        void moveObstacle(Obstacle *obstacle);
+        void removeObstacle(Obstacle *obstacle);
+        void invalidate(void);
+        void invalidateClusters(void);
+
+        // Sets obstacles to the active obstacles whose routing boxes 
+        // contain or touch the point, in the order of Router::m_obstacles,
+        // i.e., most recently added first.
+        void obstaclesAtPoint(const Point& point, 
+                std::vector<Obstacle *>& obstacles);
+        // Sets clusters to the active clusters whose bounding boxes contain
+        // or touch the point, in no particular order.
+        void clustersAtPoint(const Point& point, 
+                std::vector<ClusterRef *>& clusters);
+
+    private:
+        void rebuildObstacles(void);
+        void rebuildObstacleGrid(void);
+        void rebuildClusters(void);
+        Box obstacleBox(Obstacle *obstacle) const;
+
+        Router *m_router;
+
+        // Obstacle entries are held in slots, which are the items in the 
+        // grid.  Each records the obstacle, its box and the order in 
+        // which it was added.  Free slots have a null obstacle.
+        std::vector<Obstacle *> m_obstacles;
+        std::vector<Box> m_obstacle_boxes;
+        std::vector<unsigned long long> m_obstacle_order;
+        std::vector<unsigned int> m_free_slots;
+        std::unordered_map<const Obstacle *, unsigned int> m_obstacle_slots;
+        SpatialGrid m_obstacle_grid;
+        // The number of obstacles when the grid's cell size was chosen.
+        size_t m_grid_obstacle_count;
+        unsigned long long m_next_order;
+        bool m_obstacles_valid;
+
+        std::vector<ClusterRef *> m_clusters;
+        SpatialGrid m_cluster_grid;
+        bool m_clusters_valid;
+
+        std::vector<unsigned int> m_query_items;
+};
+
+
+}
+
+#endif
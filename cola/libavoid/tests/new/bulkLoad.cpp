@@ -0,0 +1,192 @@
+#include <vector>
+#include "libavoid/libavoid.h"
+#include "gtest/gtest.h"
+
+/*
+ * Test that bulk loading shapes, connection pins and connectors gives the same objects and routes as creating each
+ * of them individually and processing a transaction, for both orthogonal and poly-line routing.
+ * */
+
+using namespace Avoid;
+
+static const int gridSize = 6;
+
+static Rectangle gridRectangle(int index) {
+    int row = index / gridSize;
+    int col = index % gridSize;
+    double x = col * 100 + (row % 3) * 7;
+    double y = row * 90 + (col % 4) * 5;
+    return Rectangle(Point(x, y), Point(x + 40, y + 30));
+}
+
+// Describes a diagram with a grid of shapes with pins on their tops and bottoms, connectors between pins on
+// neighbouring shapes and connectors between free points.  Some shapes and connectors are given IDs.
+static void describeDiagram(std::vector<BulkShape>& shapes, std::vector<BulkPin>& pins,
+        std::vector<BulkConnector>& connectors) {
+    for (int i = 0; i < gridSize * gridSize; ++i) {
+        shapes.push_back(BulkShape(gridRectangle(i), (i % 5 == 0) ? 1000 + i : 0));
+        pins.push_back(BulkPin(i, 1, ATTACH_POS_CENTRE, ATTACH_POS_TOP, true, 0.0, ConnDirUp));
+        pins.push_back(BulkPin(i, 1, ATTACH_POS_CENTRE, ATTACH_POS_BOTTOM, true, 0.0, ConnDirDown));
+        pins.push_back(BulkPin(i, 2, 5, 10, false, 0.0, ConnDirLeft));
+    }
+    for (int i = 0; i + gridSize + 1 < gridSize * gridSize; ++i) {
+        if (i % 2 == 0) {
+            connectors.push_back(BulkConnector(BulkConnEnd(i, 1), BulkConnEnd(i + gridSize + 1, 1),
+                    (i % 3 == 0) ? 2000 + i : 0));
+        } else {
+            Point src = gridRectangle(i).at(0);
+            Point dst = gridRectangle(i + 1).at(2);
+            connectors.push_back(BulkConnector(BulkConnEnd(Point(src.x + 10, src.y + 45)),
+                    BulkConnEnd(Point(dst.x - 10, dst.y - 45), ConnDirUp | ConnDirDown)));
+        }
+    }
+    connectors.push_back(BulkConnector(BulkConnEnd(3, 2), BulkConnEnd(Point(-50, -50)), 0, ConnType_PolyLine));
+}
+
+// Creates the objects described individually, in the order given.
+static BulkLoadResult createIndividually(Router *router, const std::vector<BulkShape>& shapes,
+        const std::vector<BulkPin>& pins, const std::vector<BulkConnector>& connectors) {
+    BulkLoadResult result;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        Polygon polygon = shapes[i].polygon;
+        result.shapes.push_back(new ShapeRef(router, polygon, shapes[i].id));
+    }
+    for (size_t i = 0; i < pins.size(); ++i) {
+        const BulkPin& pin = pins[i];
+        result.pins.push_back(new ShapeConnectionPin(result.shapes[pin.shapeIndex], pin.classId, pin.xOffset,
+                pin.yOffset, pin.proportional, pin.insideOffset, pin.visDirs));
+    }
+    for (size_t i = 0; i < connectors.size(); ++i) {
+        ConnEnd ends[2];
+        const BulkConnEnd *descriptions[2] = { &connectors[i].src, &connectors[i].dst };
+        for (int e = 0; e < 2; ++e) {
+            const BulkConnEnd& end = *descriptions[e];
+            ends[e] = (end.isAttached()) ? ConnEnd(result.shapes[end.shapeIndex], end.pinClassId) :
+                    ConnEnd(end.point, end.visDirs);
+        }
+        ConnRef *conn = new ConnRef(router, ends[0], ends[1], connectors[i].id);
+        if (connectors[i].type != ConnType_None) {
+            conn->setRoutingType(connectors[i].type);
+        }
+        result.connectors.push_back(conn);
+    }
+    return result;
+}
+
+static void expectSameRoutes(const BulkLoadResult& expected, const BulkLoadResult& actual) {
+    ASSERT_EQ(expected.connectors.size(), actual.connectors.size());
+    for (size_t i = 0; i < expected.connectors.size(); ++i) {
+        const PolyLine& expectedRoute = expected.connectors[i]->displayRoute();
+        const PolyLine& actualRoute = actual.connectors[i]->displayRoute();
+        EXPECT_EQ(expectedRoute.size(), actualRoute.size()) << "connector " << i;
+        if (expectedRoute.size() == actualRoute.size()) {
+            for (size_t j = 0; j < expectedRoute.size(); ++j) {
+                EXPECT_EQ(expectedRoute.ps[j], actualRoute.ps[j]) << "connector " << i;
+            }
+        }
+    }
+}
+
+class BulkLoad : public ::testing::Test {
+protected:
+    void createRouters(unsigned int flags) {
+        for (int r = 0; r < 2; ++r) {
+            routers[r] = new Router(flags);
+            routers[r]->setRoutingParameter(RoutingParameter::segmentPenalty, 50);
+            routers[r]->setRoutingParameter(RoutingParameter::shapeBufferDistance, 4);
+        }
+        describeDiagram(shapes, pins, connectors);
+    }
+
+    void TearDown() override {
+        delete routers[0];
+        delete routers[1];
+    }
+
+    // Creates the diagram in the first router individually and in the second router by bulk loading, and checks
+    // they give the same objects and routes, including after later changes.
+    void checkMatchesIndividualCreation();
+
+    Router *routers[2];
+    std::vector<BulkShape> shapes;
+    std::vector<BulkPin> pins;
+    std::vector<BulkConnector> connectors;
+};
+
+void BulkLoad::checkMatchesIndividualCreation() {
+    BulkLoadResult individual = createIndividually(routers[0], shapes, pins, connectors);
+    BulkLoadResult bulk = routers[1]->bulkLoad(shapes, pins, connectors);
+
+    ASSERT_EQ(bulk.shapes.size(), shapes.size());
+    ASSERT_EQ(bulk.pins.size(), pins.size());
+    ASSERT_EQ(bulk.connectors.size(), connectors.size());
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        EXPECT_EQ(bulk.shapes[i]->id(), individual.shapes[i]->id());
+        EXPECT_EQ(bulk.shapes[i]->polygon().at(0), individual.shapes[i]->polygon().at(0));
+    }
+    for (size_t i = 0; i < pins.size(); ++i) {
+        EXPECT_EQ(bulk.pins[i]->position(), individual.pins[i]->position());
+    }
+    for (size_t i = 0; i < connectors.size(); ++i) {
+        EXPECT_EQ(bulk.connectors[i]->id(), individual.connectors[i]->id());
+        EXPECT_EQ(bulk.connectors[i]->routingType(), individual.connectors[i]->routingType());
+    }
+
+    EXPECT_TRUE(routers[0]->processTransaction());
+    EXPECT_TRUE(routers[1]->processTransaction());
+    expectSameRoutes(individual, bulk);
+
+    // Bulk loaded objects can then be changed like any others.
+    routers[0]->moveShape(individual.shapes[14], 20, 15);
+    routers[1]->moveShape(bulk.shapes[14], 20, 15);
+    routers[0]->deleteConnector(individual.connectors[3]);
+    routers[1]->deleteConnector(bulk.connectors[3]);
+    individual.connectors.erase(individual.connectors.begin() + 3);
+    bulk.connectors.erase(bulk.connectors.begin() + 3);
+    routers[0]->processTransaction();
+    routers[1]->processTransaction();
+    expectSameRoutes(individual, bulk);
+}
+
+TEST_F(BulkLoad, OrthogonalMatchesCreatingObjectsIndividually) {
+    createRouters(OrthogonalRouting);
+    checkMatchesIndividualCreation();
+}
+
+TEST_F(BulkLoad, PolyLineMatchesCreatingObjectsIndividually) {
+    createRouters(OrthogonalRouting | PolyLineRouting);
+    checkMatchesIndividualCreation();
+}
+
+TEST_F(BulkLoad, RoutesImmediatelyWithoutTransactions) {
+    createRouters(OrthogonalRouting);
+    routers[0]->setTransactionUse(false);
+    BulkLoadResult bulk = routers[0]->bulkLoad(shapes, pins, connectors);
+    EXPECT_FALSE(routers[0]->processTransaction());
+    for (size_t i = 0; i < bulk.connectors.size(); ++i) {
+        EXPECT_GE(bulk.connectors[i]->displayRoute().size(), 2u) << "connector " << i;
+    }
+}
+
+TEST_F(BulkLoad, ManyPinsWithoutTransactionsQueueNoActions) {
+    createRouters(OrthogonalRouting);
+    // Add several more pins to every shape, each with a class of its own.
+    for (int i = 0; i < gridSize * gridSize; ++i) {
+        for (unsigned int classId = 3; classId < 13; ++classId) {
+            double offset = (classId - 3) / 10.0;
+            pins.push_back(BulkPin(i, classId, offset, ATTACH_POS_TOP, true, 0.0, ConnDirUp));
+        }
+    }
+    // The second router routes the same diagram with transactions, for comparison.
+    BulkLoadResult expected = routers[1]->bulkLoad(shapes, pins, connectors);
+    routers[1]->processTransaction();
+
+    routers[0]->setTransactionUse(false);
+    routers[0]->setProfilingEnabled(true);
+    BulkLoadResult bulk = routers[0]->bulkLoad(shapes, pins, connectors);
+    // The whole load is a single transaction, rather than one for each pin.
+    EXPECT_EQ(routers[0]->profile().transactions.count, 1u);
+    EXPECT_FALSE(routers[0]->processTransaction());
+    ASSERT_EQ(bulk.pins.size(), pins.size());
+    expectSameRoutes(expected, bulk);
+}
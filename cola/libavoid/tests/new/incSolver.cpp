@@ -0,0 +1,163 @@
+#include <cstdlib>
+#include <vector>
+#include "libavoid/vpsc.h"
+#include "gtest/gtest.h"
+
+/*
+ * Test that an IncSolver kept between solves, while desired positions are changed and constraints are added and
+ * removed, gives the same solutions as a new solver for each problem.  This is how nudging uses the solver with the
+ * warmStartOrthogonalNudging option.
+ * */
+
+using namespace Avoid;
+
+static double randomValue(const int range) {
+    return (double) range * rand() / (RAND_MAX + 1.0);
+}
+
+// The same problem held twice, once for the solver that is kept between solves and once for solving from scratch.
+class IncSolverWarmStart : public ::testing::Test {
+protected:
+    void TearDown() override {
+        clear();
+    }
+
+    void clear() {
+        for (int p = 0; p < 2; ++p) {
+            for (size_t i = 0; i < cs[p].size(); ++i) {
+                delete cs[p][i];
+            }
+            for (size_t i = 0; i < vs[p].size(); ++i) {
+                delete vs[p][i];
+            }
+            cs[p].clear();
+            vs[p].clear();
+        }
+    }
+
+    void addVariable(double desiredPosition) {
+        for (int p = 0; p < 2; ++p) {
+            vs[p].push_back(new Variable((int) vs[p].size(), desiredPosition));
+        }
+    }
+
+    // Adds a random constraint from a lower to a higher indexed variable, so the constraint graph stays acyclic.
+    void addConstraint(IncSolver *solver) {
+        size_t left = (size_t) randomValue((int) vs[0].size() - 1);
+        size_t right = left + 1 + (size_t) randomValue((int) (vs[0].size() - left - 1));
+        double gap = randomValue(4);
+        for (int p = 0; p < 2; ++p) {
+            cs[p].push_back(new Constraint(vs[p][left], vs[p][right], gap));
+        }
+        if (solver) {
+            solver->addConstraint(cs[0].back());
+        }
+    }
+
+    void removeConstraint(IncSolver *solver, size_t index) {
+        solver->removeConstraint(cs[0][index]);
+        for (int p = 0; p < 2; ++p) {
+            delete cs[p][index];
+            cs[p].erase(cs[p].begin() + index);
+        }
+    }
+
+    size_t activeConstraintIndex() const {
+        for (size_t i = 0; i < cs[0].size(); ++i) {
+            if (cs[0][i]->active) {
+                return i;
+            }
+        }
+        return cs[0].size();
+    }
+
+    void setDesiredPosition(size_t index, double desiredPosition) {
+        for (int p = 0; p < 2; ++p) {
+            vs[p][index]->desiredPosition = desiredPosition;
+        }
+    }
+
+    // Solves the problem with the kept solver and with a new one, and checks they agree.
+    void solveAndCompare(IncSolver *solver) {
+        bool keptSatisfied = solver->solve();
+        IncSolver fresh(vs[1], cs[1]);
+        bool freshSatisfied = fresh.solve();
+        EXPECT_EQ(keptSatisfied, freshSatisfied);
+        for (size_t i = 0; i < vs[0].size(); ++i) {
+            EXPECT_NEAR(vs[0][i]->finalPosition, vs[1][i]->finalPosition, 0.01) << "variable " << i;
+        }
+        for (size_t i = 0; i < cs[0].size(); ++i) {
+            const Constraint *c = cs[0][i];
+            EXPECT_GE(c->right->finalPosition - c->left->finalPosition, c->gap - 0.0001) << "constraint " << i;
+        }
+    }
+
+    Variables vs[2];
+    Constraints cs[2];
+};
+
+TEST_F(IncSolverWarmStart, MatchesSolvingFromScratch) {
+    for (unsigned int seed = 1; seed <= 10; ++seed) {
+        clear();
+        srand(seed);
+
+        const size_t n = 40;
+        for (size_t i = 0; i < n; ++i) {
+            addVariable(randomValue(50));
+        }
+        for (size_t i = 0; i < 2 * n; ++i) {
+            addConstraint(nullptr);
+        }
+        IncSolver solver(vs[0], cs[0]);
+        solveAndCompare(&solver);
+        for (int step = 0; step < 20; ++step) {
+            // Move a few variables.
+            for (int i = 0; i < 3; ++i) {
+                setDesiredPosition((size_t) randomValue((int) n), randomValue(50));
+            }
+            solveAndCompare(&solver);
+
+            // Add some constraints.
+            for (int i = 0; i < 3; ++i) {
+                addConstraint(&solver);
+            }
+            solveAndCompare(&solver);
+
+            // Remove an active constraint, splitting its block, and another at random.
+            size_t active = activeConstraintIndex();
+            if (active < cs[0].size()) {
+                removeConstraint(&solver, active);
+            }
+            removeConstraint(&solver, (size_t) randomValue((int) cs[0].size()));
+            solveAndCompare(&solver);
+        }
+    }
+}
+
+// Rolling back the constraint just added, as nudging does when unifying fails, gives the solution from before it
+// was added.
+TEST_F(IncSolverWarmStart, RollingBackAnAddedConstraint) {
+    srand(7);
+    const size_t n = 30;
+    for (size_t i = 0; i < n; ++i) {
+        addVariable(randomValue(50));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        addConstraint(nullptr);
+    }
+    IncSolver solver(vs[0], cs[0]);
+    solveAndCompare(&solver);
+    std::vector<double> before(n);
+    for (size_t i = 0; i < n; ++i) {
+        before[i] = vs[0][i]->finalPosition;
+    }
+    for (int attempt = 0; attempt < 10; ++attempt) {
+        addConstraint(&solver);
+        solveAndCompare(&solver);
+        removeConstraint(&solver, cs[0].size() - 1);
+        solveAndCompare(&solver);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(vs[0][i]->finalPosition, before[i], 0.01) << "variable " << i;
+        }
+    }
+}
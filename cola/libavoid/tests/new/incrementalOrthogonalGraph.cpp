@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <set>
+#include <vector>
+#include "libavoid/libavoid.h"
+#include "gtest/gtest.h"
+
+/*
+ * Test that incrementally updating the orthogonal visibility graph after shapes, junctions and connectors are moved,
+ * added or removed gives the same graph and routes as regenerating the whole graph after each change.
+ * */
+
+using namespace Avoid;
+
+// An edge of the visibility graph as a comparable value.
+struct GraphEdge {
+    Point a, b;
+    double dist;
+
+    bool operator<(const GraphEdge& rhs) const {
+        if (a != rhs.a) return a < rhs.a;
+        if (b != rhs.b) return b < rhs.b;
+        return dist < rhs.dist;
+    }
+    bool operator==(const GraphEdge& rhs) const {
+        return (a == rhs.a) && (b == rhs.b) && (dist == rhs.dist);
+    }
+};
+
+// A vertex of the visibility graph, with its visibility flags, as a comparable value.
+struct GraphVertex {
+    Point point;
+    unsigned int flags;
+    size_t degree;
+
+    bool operator<(const GraphVertex& rhs) const {
+        if (point != rhs.point) return point < rhs.point;
+        if (flags != rhs.flags) return flags < rhs.flags;
+        return degree < rhs.degree;
+    }
+    bool operator==(const GraphVertex& rhs) const {
+        return (point == rhs.point) && (flags == rhs.flags) && (degree == rhs.degree);
+    }
+};
+
+static std::vector<GraphEdge> graphEdges(Router *router) {
+    std::vector<GraphEdge> edges;
+    for (EdgeInf *edge = router->visOrthogGraph.begin(); edge != router->visOrthogGraph.end();
+            edge = edge->lstNext) {
+        std::pair<Point, Point> points = edge->points();
+        GraphEdge graphEdge;
+        graphEdge.a = std::min(points.first, points.second);
+        graphEdge.b = (graphEdge.a == points.first) ? points.second : points.first;
+        graphEdge.dist = edge->getDist();
+        edges.push_back(graphEdge);
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+static std::vector<GraphVertex> graphVertices(Router *router) {
+    std::vector<GraphVertex> vertices;
+    for (VertInf *vert = router->vertices.connsBegin(); vert; vert = vert->lstNext) {
+        if (vert->orthogVisList.empty()) {
+            continue;
+        }
+        GraphVertex graphVertex;
+        graphVertex.point = vert->point;
+        graphVertex.flags = vert->orthogVisPropFlags;
+        graphVertex.degree = vert->orthogVisList.size();
+        vertices.push_back(graphVertex);
+    }
+    std::sort(vertices.begin(), vertices.end());
+    return vertices;
+}
+
+static std::set<unsigned int> graphEdgeIds(Router *router) {
+    std::set<unsigned int> ids;
+    for (EdgeInf *edge = router->visOrthogGraph.begin(); edge != router->visOrthogGraph.end();
+            edge = edge->lstNext) {
+        ids.insert(edge->uniqueId());
+    }
+    return ids;
+}
+
+// Builds the same diagram in two routers, one updating its graph incrementally and the other regenerating it, and
+// applies the same changes to both.
+class IncrementalOrthogonalGraph : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int r = 0; r < 2; ++r) {
+            routers[r] = new Router(OrthogonalRouting);
+            routers[r]->setRoutingParameter(RoutingParameter::segmentPenalty, 50);
+            routers[r]->setRoutingParameter(RoutingParameter::shapeBufferDistance, 4);
+            routers[r]->setRoutingOption(RoutingOption::incrementallyUpdateOrthogonalVisibilityGraph, r == 0);
+            shapes[r].clear();
+            connectors[r].clear();
+            for (int row = 0; row < gridSize; ++row) {
+                for (int col = 0; col < gridSize; ++col) {
+                    double x = col * 100 + (row % 3) * 7;
+                    double y = row * 90 + (col % 4) * 5;
+                    Rectangle rectangle(Point(x, y), Point(x + 40, y + 30));
+                    ShapeRef *shape = new ShapeRef(routers[r], rectangle);
+                    new ShapeConnectionPin(shape, 1, ATTACH_POS_CENTRE, ATTACH_POS_TOP, true, 0.0, ConnDirUp);
+                    new ShapeConnectionPin(shape, 1, ATTACH_POS_CENTRE, ATTACH_POS_BOTTOM, true, 0.0, ConnDirDown);
+                    shapes[r].push_back(shape);
+                }
+            }
+            unsigned int seed = 11;
+            for (int i = 0; i < 60; ++i) {
+                seed = seed * 1103515245 + 12345;
+                size_t src = (seed >> 8) % shapes[r].size();
+                seed = seed * 1103515245 + 12345;
+                size_t dst = (seed >> 8) % shapes[r].size();
+                if (src == dst) {
+                    continue;
+                }
+                ConnRef *conn;
+                if (i % 3 == 0) {
+                    conn = new ConnRef(routers[r], ConnEnd(shapes[r][src], 1), ConnEnd(shapes[r][dst], 1));
+                } else {
+                    Point srcPoint = shapes[r][src]->position();
+                    Point dstPoint = shapes[r][dst]->position();
+                    conn = new ConnRef(routers[r], ConnEnd(Point(srcPoint.x + 30, srcPoint.y + 20)),
+                            ConnEnd(Point(dstPoint.x - 30, dstPoint.y - 20)));
+                }
+                connectors[r].push_back(conn);
+            }
+            routers[r]->processTransaction();
+        }
+    }
+
+    void TearDown() override {
+        delete routers[0];
+        delete routers[1];
+    }
+
+    // Processes the transaction in both routers and checks they have the same graph and routes.  Returns the
+    // proportion of the edges in the incrementally updated graph that were kept.
+    double processAndCompare() {
+        std::set<unsigned int> previousIds = graphEdgeIds(routers[0]);
+        routers[0]->processTransaction();
+        routers[1]->processTransaction();
+
+        std::vector<GraphEdge> incremental = graphEdges(routers[0]);
+        std::vector<GraphEdge> regenerated = graphEdges(routers[1]);
+        EXPECT_EQ(incremental.size(), regenerated.size());
+        EXPECT_TRUE(incremental == regenerated);
+        std::vector<GraphVertex> incrementalVertices = graphVertices(routers[0]);
+        std::vector<GraphVertex> regeneratedVertices = graphVertices(routers[1]);
+        EXPECT_EQ(incrementalVertices.size(), regeneratedVertices.size());
+        EXPECT_TRUE(incrementalVertices == regeneratedVertices);
+
+        for (size_t i = 0; i < connectors[0].size(); ++i) {
+            const PolyLine& incrementalRoute = connectors[0][i]->displayRoute();
+            const PolyLine& regeneratedRoute = connectors[1][i]->displayRoute();
+            EXPECT_EQ(incrementalRoute.size(), regeneratedRoute.size()) << "connector " << i;
+            if (incrementalRoute.size() == regeneratedRoute.size()) {
+                for (size_t j = 0; j < incrementalRoute.size(); ++j) {
+                    EXPECT_EQ(incrementalRoute.ps[j], regeneratedRoute.ps[j]) << "connector " << i;
+                }
+            }
+        }
+
+        std::set<unsigned int> ids = graphEdgeIds(routers[0]);
+        size_t kept = 0;
+        for (std::set<unsigned int>::iterator id = ids.begin(); id != ids.end(); ++id) {
+            kept += previousIds.count(*id);
+        }
+        return (double) kept / ids.size();
+    }
+
+    static const int gridSize = 10;
+    Router *routers[2];
+    std::vector<ShapeRef *> shapes[2];
+    std::vector<ConnRef *> connectors[2];
+};
+
+TEST_F(IncrementalOrthogonalGraph, MovingShapesMatchesRegeneration) {
+    const double moves[][3] = { {23, 12, 5}, {23, -40, 9}, {57, 16, -8}, {0, 3, 3}, {99, -25, -30}, {45, 200, 0} };
+    for (size_t m = 0; m < sizeof(moves) / sizeof(moves[0]); ++m) {
+        for (int r = 0; r < 2; ++r) {
+            routers[r]->moveShape(shapes[r][(size_t) moves[m][0]], moves[m][1], moves[m][2]);
+        }
+        double keptProportion = processAndCompare();
+        EXPECT_GT(keptProportion, 0.5) << "move " << m;
+    }
+}
+
+TEST_F(IncrementalOrthogonalGraph, AddingAndRemovingObjectsMatchesRegeneration) {
+    // Add a shape and a junction with connectors to them from nearby points.
+    ShapeRef *added[2];
+    JunctionRef *junctions[2];
+    for (int r = 0; r < 2; ++r) {
+        Rectangle rectangle(Point(455, 400), Point(480, 420));
+        added[r] = new ShapeRef(routers[r], rectangle);
+        junctions[r] = new JunctionRef(routers[r], Point(250, 590));
+        junctions[r]->setPositionFixed(true);
+        connectors[r].push_back(new ConnRef(routers[r], ConnEnd(Point(467, 410)), ConnEnd(Point(530, 380))));
+        connectors[r].push_back(new ConnRef(routers[r], ConnEnd(junctions[r]), ConnEnd(Point(330, 560))));
+    }
+    EXPECT_GT(processAndCompare(), 0.5);
+
+    // Move connector endpoints.
+    for (int r = 0; r < 2; ++r) {
+        connectors[r][1]->setSourceEndpoint(ConnEnd(Point(333, 333)));
+        connectors[r][5]->setDestEndpoint(ConnEnd(shapes[r][70], 1));
+    }
+    EXPECT_GT(processAndCompare(), 0.5);
+
+    // Delete a shape with its pins and a connector.
+    for (int r = 0; r < 2; ++r) {
+        routers[r]->deleteConnector(connectors[r][2]);
+        connectors[r].erase(connectors[r].begin() + 2);
+        routers[r]->deleteShape(shapes[r][44]);
+    }
+    EXPECT_GT(processAndCompare(), 0.5);
+
+    // Move the junction, then the added shape, together with a second shape.
+    for (int r = 0; r < 2; ++r) {
+        routers[r]->moveJunction(junctions[r], 12, -30);
+    }
+    processAndCompare();
+    for (int r = 0; r < 2; ++r) {
+        routers[r]->moveShape(added[r], -200, 35);
+        routers[r]->moveShape(shapes[r][91], 10, 10);
+    }
+    processAndCompare();
+}
+
+TEST_F(IncrementalOrthogonalGraph, LargeChangesRegenerateTheGraph) {
+    // Moving every shape affects all of the graph, so it is regenerated.
+    for (int r = 0; r < 2; ++r) {
+        for (size_t i = 0; i < shapes[r].size(); ++i) {
+            routers[r]->moveShape(shapes[r][i], 3, 4);
+        }
+    }
+    EXPECT_EQ(processAndCompare(), 0);
+}
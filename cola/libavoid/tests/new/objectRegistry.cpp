@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include "libavoid/libavoid.h"
+#include "gtest/gtest.h"
+
+/*
+ * Test that object IDs are found to be in use exactly while their objects are in the router, and that the connectors
+ * and shapes attached to each shape or junction are the same, and in the same order, as found by going through every
+ * connector, as connectors are added, moved between shapes and deleted and shapes are deleted.
+ * */
+
+using namespace Avoid;
+
+// The shapes or junctions at the ends of a connector, with zero for a free end.
+struct Anchors {
+    unsigned int src;
+    unsigned int dst;
+};
+
+class ObjectRegistry : public ::testing::Test {
+protected:
+    void SetUp() override {
+        srand(3);
+        router = new Router(OrthogonalRouting);
+        for (int i = 0; i < 16; ++i) {
+            double x = (i % 4) * 100, y = (i / 4) * 100;
+            Rectangle rectangle(Point(x, y), Point(x + 40, y + 30));
+            ShapeRef *shape = new ShapeRef(router, rectangle);
+            new ShapeConnectionPin(shape, 1, ATTACH_POS_CENTRE, ATTACH_POS_TOP, true, 0.0, ConnDirUp);
+            new ShapeConnectionPin(shape, 1, ATTACH_POS_CENTRE, ATTACH_POS_BOTTOM, true, 0.0, ConnDirDown);
+            shapes.push_back(shape);
+            ids.push_back(shape->id());
+        }
+        for (int i = 0; i < 4; ++i) {
+            JunctionRef *junction = new JunctionRef(router, Point(i * 100 + 70, 50));
+            junctions.push_back(junction);
+            ids.push_back(junction->id());
+        }
+        Rectangle clusterRectangle(Point(-20, -20), Point(160, 150));
+        ClusterRef *cluster = new ClusterRef(router, clusterRectangle);
+        ids.push_back(cluster->id());
+        router->processTransaction();
+    }
+
+    void TearDown() override {
+        delete router;
+    }
+
+    // Returns a random end, on a shape, a junction or a free point.
+    ConnEnd randomEnd(unsigned int& anchor) {
+        int kind = rand() % 5;
+        if (kind < 3 && !shapes.empty()) {
+            ShapeRef *shape = shapes[rand() % shapes.size()];
+            anchor = shape->id();
+            return ConnEnd(shape, 1);
+        } else if (kind < 4) {
+            JunctionRef *junction = junctions[rand() % junctions.size()];
+            anchor = junction->id();
+            return ConnEnd(junction);
+        }
+        anchor = 0;
+        return ConnEnd(Point(rand() % 400, rand() % 400 - 50));
+    }
+
+    // Returns the connectors expected from attachedConns(), going through every connector.
+    IntList expectedConns(unsigned int shapeId, unsigned int type) {
+        IntList result;
+        for (ConnRefList::const_iterator i = router->connRefs.begin(); i != router->connRefs.end(); ++i) {
+            Anchors anchors = connAnchors[*i];
+            if (((type & runningTo) && anchors.dst == shapeId) ||
+                    ((type & runningFrom) && anchors.src == shapeId)) {
+                result.push_back((*i)->id());
+            }
+        }
+        return result;
+    }
+
+    // Returns the shapes expected from attachedShapes(), going through every connector.
+    IntList expectedShapes(unsigned int shapeId, unsigned int type) {
+        IntList result;
+        for (ConnRefList::const_iterator i = router->connRefs.begin(); i != router->connRefs.end(); ++i) {
+            Anchors anchors = connAnchors[*i];
+            if ((type & runningTo) && anchors.dst == shapeId) {
+                if (anchors.src != 0) {
+                    result.push_back(anchors.src);
+                }
+            } else if ((type & runningFrom) && anchors.src == shapeId) {
+                if (anchors.dst != 0) {
+                    result.push_back(anchors.dst);
+                }
+            }
+        }
+        return result;
+    }
+
+    void checkRegistry() {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            EXPECT_FALSE(router->objectIdIsUnused(ids[i]));
+        }
+        for (size_t i = 0; i < deletedIds.size(); ++i) {
+            EXPECT_TRUE(router->objectIdIsUnused(deletedIds[i]));
+        }
+        EXPECT_TRUE(router->objectIdIsUnused(router->newObjectId()));
+
+        std::vector<unsigned int> anchorIds;
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            anchorIds.push_back(shapes[i]->id());
+        }
+        for (size_t i = 0; i < junctions.size(); ++i) {
+            anchorIds.push_back(junctions[i]->id());
+        }
+        anchorIds.insert(anchorIds.end(), deletedIds.begin(), deletedIds.end());
+        const unsigned int types[] = { runningTo, runningFrom, runningToAndFrom };
+        for (size_t i = 0; i < anchorIds.size(); ++i) {
+            for (int t = 0; t < 3; ++t) {
+                IntList conns, attached;
+                router->attachedConns(conns, anchorIds[i], types[t]);
+                EXPECT_EQ(conns, expectedConns(anchorIds[i], types[t]));
+                router->attachedShapes(attached, anchorIds[i], types[t]);
+                EXPECT_EQ(attached, expectedShapes(anchorIds[i], types[t]));
+            }
+        }
+    }
+
+    Router *router;
+    std::vector<ShapeRef *> shapes;
+    std::vector<JunctionRef *> junctions;
+    std::vector<ConnRef *> conns;
+    std::map<ConnRef *, Anchors> connAnchors;
+    std::vector<unsigned int> ids;
+    std::vector<unsigned int> deletedIds;
+};
+
+TEST_F(ObjectRegistry, MatchesSearchOfAllObjects) {
+    // Some connectors are given IDs, counting down so they're never the IDs the router would choose next.
+    unsigned int givenId = 5000;
+    checkRegistry();
+    for (int step = 0; step < 60; ++step) {
+        int changes = 1 + rand() % 4;
+        for (int c = 0; c < changes; ++c) {
+            int op = rand() % 10;
+            if (op < 4 || conns.empty()) {
+                Anchors anchors;
+                ConnEnd src = randomEnd(anchors.src);
+                ConnEnd dst = randomEnd(anchors.dst);
+                ConnRef *conn = new ConnRef(router, src, dst, (op == 0) ? givenId-- : 0);
+                conns.push_back(conn);
+                connAnchors[conn] = anchors;
+                ids.push_back(conn->id());
+            } else if (op < 7) {
+                ConnRef *conn = conns[rand() % conns.size()];
+                if (op == 5) {
+                    conn->setSourceEndpoint(randomEnd(connAnchors[conn].src));
+                } else {
+                    conn->setDestEndpoint(randomEnd(connAnchors[conn].dst));
+                }
+            } else if (op < 9) {
+                size_t i = rand() % conns.size();
+                ConnRef *conn = conns[i];
+                ids.erase(std::find(ids.begin(), ids.end(), conn->id()));
+                deletedIds.push_back(conn->id());
+                connAnchors.erase(conn);
+                conns.erase(conns.begin() + i);
+                router->deleteConnector(conn);
+            } else if (shapes.size() > 4) {
+                size_t i = rand() % shapes.size();
+                ShapeRef *shape = shapes[i];
+                unsigned int id = shape->id();
+                // Connectors attached to the shape are left with free ends.
+                for (std::map<ConnRef *, Anchors>::iterator a = connAnchors.begin(); a != connAnchors.end(); ++a) {
+                    if (a->second.src == id) {
+                        a->second.src = 0;
+                    }
+                    if (a->second.dst == id) {
+                        a->second.dst = 0;
+                    }
+                }
+                ids.erase(std::find(ids.begin(), ids.end(), id));
+                deletedIds.push_back(id);
+                shapes.erase(shapes.begin() + i);
+                router->deleteShape(shape);
+            }
+        }
+        router->processTransaction();
+        checkRegistry();
+    }
+}
@@ -0,0 +1,170 @@
+#include <vector>
+#include "libavoid/libavoid.h"
+#include "gtest/gtest.h"
+#include "helpers.h"
+
+/*
+ * Test that searching for connector routes on multiple threads produces exactly the same routes as the default
+ * serial search, both for connectors with point endpoints (searched in parallel) and connectors attached to pins
+ * (always routed serially).  Orthogonal routes are also nudged on multiple threads, and must match serial nudging
+ * with the nudging options enabled too.  Poly-line visibility is computed on multiple threads, with both the sweep
+ * and the naive visibility methods.
+ * */
+
+using namespace Avoid;
+
+class ParallelRouting : public ::testing::TestWithParam<unsigned int> {
+protected:
+    Router *createRouter(unsigned int flags, double threadCount) {
+        Router *router = new Router(flags);
+        router->setRoutingParameter(RoutingParameter::segmentPenalty, 50);
+        router->setRoutingParameter(RoutingParameter::shapeBufferDistance, 4);
+        router->setRoutingParameter(RoutingParameter::idealNudgingDistance, 4);
+        router->setRoutingParameter(RoutingParameter::routingThreadCount, threadCount);
+        return router;
+    }
+
+    // Builds a grid of shapes, with connectors between pseudo-randomly chosen pairs of shapes.
+    void buildDiagram(Router *router, ConnType connType) {
+        const int gridSize = 8;
+        std::vector<ShapeRef *> shapes;
+        for (int row = 0; row < gridSize; ++row) {
+            for (int col = 0; col < gridSize; ++col) {
+                double x = col * 100 + (row % 3) * 7;
+                double y = row * 90 + (col % 4) * 5;
+                Rectangle rectangle(Point(x, y), Point(x + 40, y + 30));
+                ShapeRef *shape = new ShapeRef(router, rectangle);
+                new ShapeConnectionPin(shape, 1, ATTACH_POS_CENTRE, ATTACH_POS_CENTRE, true, 0.0, ConnDirNone);
+                shapes.push_back(shape);
+            }
+        }
+
+        unsigned int seed = 7;
+        for (int i = 0; i < 120; ++i) {
+            seed = seed * 1103515245 + 12345;
+            ShapeRef *src = shapes[(seed >> 8) % shapes.size()];
+            seed = seed * 1103515245 + 12345;
+            ShapeRef *dst = shapes[(seed >> 8) % shapes.size()];
+            if (src == dst) {
+                continue;
+            }
+            ConnRef *conn;
+            if (i % 5 == 0) {
+                conn = new ConnRef(router, ConnEnd(src, 1), ConnEnd(dst, 1));
+            } else {
+                conn = new ConnRef(router, ConnEnd(src->position()), ConnEnd(dst->position()));
+            }
+            conn->setRoutingType(connType);
+            connectors.push_back(conn);
+        }
+        movedShape = shapes[gridSize + 3];
+        router->processTransaction();
+    }
+
+    std::vector<ConnRef *> connectors;
+    ShapeRef *movedShape;
+};
+
+static std::vector<std::vector<Point> > routesOf(const std::vector<ConnRef *>& connectors) {
+    std::vector<std::vector<Point> > routes;
+    for (size_t i = 0; i < connectors.size(); ++i) {
+        routes.push_back(connectors[i]->displayRoute().ps);
+    }
+    return routes;
+}
+
+static void expectIdenticalRoutes(const std::vector<std::vector<Point> >& serial,
+        const std::vector<std::vector<Point> >& parallel) {
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        ASSERT_EQ(serial[i].size(), parallel[i].size()) << "connector " << i;
+        for (size_t j = 0; j < serial[i].size(); ++j) {
+            EXPECT_EQ(serial[i][j].x, parallel[i][j].x) << "connector " << i << " point " << j;
+            EXPECT_EQ(serial[i][j].y, parallel[i][j].y) << "connector " << i << " point " << j;
+        }
+    }
+}
+
+TEST_P(ParallelRouting, OrthogonalRoutesMatchSerialRouting) {
+    Router *serialRouter = createRouter(OrthogonalRouting, 0);
+    buildDiagram(serialRouter, ConnType_Orthogonal);
+    std::vector<std::vector<Point> > serialRoutes = routesOf(connectors);
+    serialRouter->moveShape(movedShape, 35, 20);
+    serialRouter->processTransaction();
+    std::vector<std::vector<Point> > serialMovedRoutes = routesOf(connectors);
+
+    connectors.clear();
+    Router *parallelRouter = createRouter(OrthogonalRouting, GetParam());
+    buildDiagram(parallelRouter, ConnType_Orthogonal);
+    std::vector<std::vector<Point> > parallelRoutes = routesOf(connectors);
+    parallelRouter->moveShape(movedShape, 35, 20);
+    parallelRouter->processTransaction();
+    std::vector<std::vector<Point> > parallelMovedRoutes = routesOf(connectors);
+
+    expectIdenticalRoutes(serialRoutes, parallelRoutes);
+    expectIdenticalRoutes(serialMovedRoutes, parallelMovedRoutes);
+
+    delete serialRouter;
+    delete parallelRouter;
+}
+
+TEST_P(ParallelRouting, NudgedRoutesMatchSerialNudging) {
+    Router *routers[2];
+    std::vector<std::vector<Point> > routes[2];
+    for (int r = 0; r < 2; ++r) {
+        connectors.clear();
+        routers[r] = createRouter(OrthogonalRouting, (r == 0) ? 0 : GetParam());
+        routers[r]->setRoutingOption(RoutingOption::nudgeOrthogonalSegmentsConnectedToShapes, true);
+        routers[r]->setRoutingOption(RoutingOption::nudgeOrthogonalTouchingColinearSegments, true);
+        routers[r]->setRoutingOption(RoutingOption::nudgeSharedPathsWithCommonEndPoint, false);
+        buildDiagram(routers[r], ConnType_Orthogonal);
+        routes[r] = routesOf(connectors);
+    }
+
+    expectIdenticalRoutes(routes[0], routes[1]);
+
+    delete routers[0];
+    delete routers[1];
+}
+
+TEST_P(ParallelRouting, PolylineRoutesMatchSerialRouting) {
+    Router *serialRouter = createRouter(PolyLineRouting, 0);
+    buildDiagram(serialRouter, ConnType_PolyLine);
+    std::vector<std::vector<Point> > serialRoutes = routesOf(connectors);
+
+    connectors.clear();
+    Router *parallelRouter = createRouter(PolyLineRouting, GetParam());
+    buildDiagram(parallelRouter, ConnType_PolyLine);
+    std::vector<std::vector<Point> > parallelRoutes = routesOf(connectors);
+
+    expectIdenticalRoutes(serialRoutes, parallelRoutes);
+
+    delete serialRouter;
+    delete parallelRouter;
+}
+
+TEST_P(ParallelRouting, NaivePolylineVisibilityMatchesSerialRouting) {
+    Router *routers[2];
+    std::vector<std::vector<Point> > routes[2];
+    std::vector<std::vector<Point> > movedRoutes[2];
+    for (int r = 0; r < 2; ++r) {
+        connectors.clear();
+        routers[r] = createRouter(PolyLineRouting, (r == 0) ? 0 : GetParam());
+        routers[r]->UseLeesAlgorithm = false;
+        routers[r]->InvisibilityGrph = false;
+        buildDiagram(routers[r], ConnType_PolyLine);
+        routes[r] = routesOf(connectors);
+        routers[r]->moveShape(movedShape, 35, 20);
+        routers[r]->processTransaction();
+        movedRoutes[r] = routesOf(connectors);
+    }
+
+    expectIdenticalRoutes(routes[0], routes[1]);
+    expectIdenticalRoutes(movedRoutes[0], movedRoutes[1]);
+    EXPECT_EQ(routers[0]->visGraph.size(), routers[1]->visGraph.size());
+
+    delete routers[0];
+    delete routers[1];
+}
+
+INSTANTIATE_TEST_SUITE_P(ThreadCounts, ParallelRouting, ::testing::Values(2u, 4u, 16u));
@@ -0,0 +1,132 @@
+#include <vector>
+#include "libavoid/libavoid.h"
+#include "gtest/gtest.h"
+
+/*
+ * Test that orthogonal connectors unaffected by a change keep their previous routes without being searched for, and
+ * that every route is the same as when all connectors are rerouted after each change.
+ * */
+
+using namespace Avoid;
+
+// Builds the same diagram in two routers, one reusing unaffected routes and the other rerouting every connector, and
+// applies the same changes to both.
+class RouteReuse : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int r = 0; r < 2; ++r) {
+            routers[r] = new Router(OrthogonalRouting);
+            routers[r]->setRoutingParameter(RoutingParameter::segmentPenalty, 50);
+            routers[r]->setRoutingParameter(RoutingParameter::shapeBufferDistance, 4);
+            routers[r]->setRoutingParameter(RoutingParameter::idealNudgingDistance, 4);
+            routers[r]->setRoutingOption(RoutingOption::reuseUnaffectedOrthogonalRoutes, r == 0);
+            routers[r]->setProfilingEnabled(true);
+            shapes[r].clear();
+            connectors[r].clear();
+            for (int row = 0; row < gridSize; ++row) {
+                for (int col = 0; col < gridSize; ++col) {
+                    double x = col * 100 + (row % 3) * 7;
+                    double y = row * 90 + (col % 4) * 5;
+                    Rectangle rectangle(Point(x, y), Point(x + 40, y + 30));
+                    shapes[r].push_back(new ShapeRef(routers[r], rectangle));
+                }
+            }
+            for (size_t i = 0; i < shapes[r].size(); ++i) {
+                // Connect each shape to its right and lower right neighbours.
+                Point src = shapes[r][i]->position();
+                if ((i % gridSize) + 1 < gridSize) {
+                    Point dst = shapes[r][i + 1]->position();
+                    connectors[r].push_back(new ConnRef(routers[r], ConnEnd(Point(src.x + 10, src.y - 5)),
+                            ConnEnd(Point(dst.x - 10, dst.y + 5))));
+                }
+                if (((i % gridSize) + 1 < gridSize) && (i + gridSize + 1 < shapes[r].size())) {
+                    Point dst = shapes[r][i + gridSize + 1]->position();
+                    connectors[r].push_back(new ConnRef(routers[r], ConnEnd(Point(src.x, src.y + 10)),
+                            ConnEnd(Point(dst.x, dst.y - 10))));
+                }
+            }
+            routers[r]->processTransaction();
+        }
+    }
+
+    void TearDown() override {
+        delete routers[0];
+        delete routers[1];
+    }
+
+    // Processes the transaction in both routers and checks they give the same routes.  Returns the number of route
+    // searches performed by the router reusing routes.
+    unsigned long long processAndCompare() {
+        for (int r = 0; r < 2; ++r) {
+            routers[r]->resetProfile();
+            routers[r]->processTransaction();
+        }
+        EXPECT_EQ(connectors[0].size(), connectors[1].size());
+        for (size_t i = 0; i < connectors[0].size(); ++i) {
+            const PolyLine& reusedRoute = connectors[0][i]->displayRoute();
+            const PolyLine& reroutedRoute = connectors[1][i]->displayRoute();
+            EXPECT_EQ(reusedRoute.size(), reroutedRoute.size()) << "connector " << i;
+            if (reusedRoute.size() == reroutedRoute.size()) {
+                for (size_t j = 0; j < reusedRoute.size(); ++j) {
+                    EXPECT_EQ(reusedRoute.ps[j], reroutedRoute.ps[j]) << "connector " << i;
+                }
+            }
+        }
+        // Without reuse, every connector is searched for.
+        EXPECT_EQ(routers[1]->profile().aStarSearches, connectors[1].size());
+        return routers[0]->profile().aStarSearches;
+    }
+
+    static const int gridSize = 8;
+    Router *routers[2];
+    std::vector<ShapeRef *> shapes[2];
+    std::vector<ConnRef *> connectors[2];
+};
+
+TEST_F(RouteReuse, MovingShapesKeepsDistantRoutes) {
+    const double moves[][3] = { {0, 12, 5}, {27, -10, 9}, {63, 16, -8}, {36, 3, 3} };
+    for (size_t m = 0; m < sizeof(moves) / sizeof(moves[0]); ++m) {
+        for (int r = 0; r < 2; ++r) {
+            routers[r]->moveShape(shapes[r][(size_t) moves[m][0]], moves[m][1], moves[m][2]);
+        }
+        unsigned long long searches = processAndCompare();
+        EXPECT_GT(searches, 0u) << "move " << m;
+        EXPECT_LT(searches, connectors[0].size() / 2) << "move " << m;
+    }
+}
+
+TEST_F(RouteReuse, AddingAndRemovingObjectsReroutesAffectedConnectors) {
+    // Add a shape in the way of some connectors and a new connector.
+    for (int r = 0; r < 2; ++r) {
+        Rectangle rectangle(Point(250, 160), Point(280, 200));
+        shapes[r].push_back(new ShapeRef(routers[r], rectangle));
+        connectors[r].push_back(new ConnRef(routers[r], ConnEnd(Point(10, 600)), ConnEnd(Point(130, 530))));
+    }
+    EXPECT_LT(processAndCompare(), connectors[0].size());
+
+    // Move a connector endpoint, then remove a shape and a connector.
+    for (int r = 0; r < 2; ++r) {
+        connectors[r][5]->setDestEndpoint(ConnEnd(Point(333, 333)));
+    }
+    EXPECT_LT(processAndCompare(), connectors[0].size());
+    for (int r = 0; r < 2; ++r) {
+        routers[r]->deleteConnector(connectors[r][9]);
+        connectors[r].erase(connectors[r].begin() + 9);
+        routers[r]->deleteShape(shapes[r][44]);
+    }
+    EXPECT_LT(processAndCompare(), connectors[0].size());
+}
+
+TEST_F(RouteReuse, ChangingSettingsReroutesEverything) {
+    for (int r = 0; r < 2; ++r) {
+        routers[r]->setRoutingParameter(RoutingParameter::segmentPenalty, 40);
+    }
+    EXPECT_EQ(processAndCompare(), connectors[0].size());
+
+    // Turning reuse off forces every connector to be rerouted.
+    routers[0]->setRoutingOption(RoutingOption::reuseUnaffectedOrthogonalRoutes, false);
+    for (int r = 0; r < 2; ++r) {
+        routers[r]->moveShape(shapes[r][0], 5, 5);
+    }
+    EXPECT_EQ(processAndCompare(), connectors[0].size());
+}
@@ -0,0 +1,93 @@
+#include <vector>
+#include "libavoid/libavoid.h"
+#include "gtest/gtest.h"
+
+/*
+ * Test the profiling information collected by the router: nothing is recorded while profiling is disabled, and when
+ * enabled each transaction phase that runs is timed once per transaction, with counts of the work done.
+ * */
+
+using namespace Avoid;
+
+class RouterProfiling : public ::testing::Test {
+protected:
+    void SetUp() override {
+        router = new Router(OrthogonalRouting);
+        router->setRoutingParameter(RoutingParameter::segmentPenalty, 50);
+        router->setRoutingParameter(RoutingParameter::crossingPenalty, 100);
+        router->setRoutingParameter(RoutingParameter::idealNudgingDistance, 4);
+        const int gridSize = 5;
+        for (int row = 0; row < gridSize; ++row) {
+            for (int col = 0; col < gridSize; ++col) {
+                double x = col * 100;
+                double y = row * 90;
+                Rectangle rectangle(Point(x, y), Point(x + 40, y + 30));
+                shapes.push_back(new ShapeRef(router, rectangle));
+            }
+        }
+        for (int i = 0; i + 7 < gridSize * gridSize; ++i) {
+            Point src = shapes[i]->position();
+            Point dst = shapes[i + 7]->position();
+            new ConnRef(router, ConnEnd(Point(src.x + 25, src.y)), ConnEnd(Point(dst.x - 25, dst.y)));
+        }
+    }
+
+    void TearDown() override {
+        delete router;
+    }
+
+    Router *router;
+    std::vector<ShapeRef *> shapes;
+};
+
+TEST_F(RouterProfiling, DisabledByDefault) {
+    EXPECT_FALSE(router->profilingEnabled());
+    router->processTransaction();
+
+    RouterProfile profile = router->profile();
+    EXPECT_EQ(profile.transactions.count, 0u);
+    EXPECT_EQ(profile.routeSearch.count, 0u);
+    EXPECT_EQ(profile.aStarSearches, 0u);
+    EXPECT_EQ(profile.nudgingConstraints, 0u);
+}
+
+TEST_F(RouterProfiling, RecordsPhasesAndCounters) {
+    router->setProfilingEnabled(true);
+    router->processTransaction();
+    router->moveShape(shapes[12], 15, 10);
+    router->processTransaction();
+
+    RouterProfile profile = router->profile();
+    EXPECT_EQ(profile.transactions.count, 2u);
+    const unsigned int phases[] = {
+        TransactionPhaseOrthogonalVisibilityGraphScanX, TransactionPhaseOrthogonalVisibilityGraphScanY,
+        TransactionPhaseRouteSearch, TransactionPhaseCrossingDetection, TransactionPhaseRerouteSearch,
+        TransactionPhaseOrthogonalNudgingX, TransactionPhaseOrthogonalNudgingY, TransactionPhaseCompleted };
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); ++i) {
+        const ProfileTimes& times = profile.phase(phases[i]);
+        EXPECT_EQ(times.count, 2u) << "phase " << phases[i];
+        EXPECT_GE(times.wallTime, 0) << "phase " << phases[i];
+        EXPECT_GE(times.cpuTime, 0) << "phase " << phases[i];
+        EXPECT_LE(times.maxWallTime, times.wallTime) << "phase " << phases[i];
+        EXPECT_LE(times.wallTime, profile.transactions.wallTime) << "phase " << phases[i];
+    }
+    EXPECT_EQ(profile.hyperedgeForest.count, 0u);
+
+    EXPECT_GE(profile.aStarSearches, 2 * (shapes.size() - 7));
+    EXPECT_GT(profile.aStarExpansions, profile.aStarSearches);
+    EXPECT_LE(profile.maxAStarExpansions, profile.aStarExpansions);
+    EXPECT_GT(profile.nudgingConstraints, 0u);
+    EXPECT_LE(profile.maxNudgingConstraints, profile.nudgingConstraints);
+    EXPECT_EQ(profile.orthogonalVisibilityEdges, (unsigned int) router->visOrthogGraph.size());
+
+    router->resetProfile();
+    EXPECT_EQ(router->profile().transactions.count, 0u);
+    EXPECT_EQ(router->profile().aStarSearches, 0u);
+
+    // Nothing more is recorded once profiling is turned off.
+    router->setProfilingEnabled(false);
+    router->moveShape(shapes[12], -15, -10);
+    router->processTransaction();
+    EXPECT_EQ(router->profile().transactions.count, 0u);
+    EXPECT_EQ(router->profile().aStarSearches, 0u);
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <vector>
+#include "libavoid/geomtypes.h"
+#include "libavoid/spatialindex.h"
+#include "libavoid/libavoid.h"
+#include "gtest/gtest.h"
+
+/*
+ * Test that querying the spatial grid used for crossing detection finds exactly the same boxes as comparing the query
+ * box against every indexed box, including after boxes have been removed.  Also test that the router's index of
+ * obstacles finds the same shape containing a point as scanning every shape, as shapes are added, moved and removed.
+ * */
+
+using namespace Avoid;
+
+static Box makeBox(unsigned int& seed, double maxSize) {
+    seed = seed * 1103515245 + 12345;
+    double x = (seed >> 8) % 1000;
+    seed = seed * 1103515245 + 12345;
+    double y = (seed >> 8) % 1000;
+    seed = seed * 1103515245 + 12345;
+    double width = ((seed >> 8) % 1000) * maxSize / 1000.0;
+    seed = seed * 1103515245 + 12345;
+    double height = ((seed >> 8) % 1000) * maxSize / 1000.0;
+    // Include zero width boxes, as the segments of orthogonal routes have.
+    if (seed % 3 == 0) {
+        width = 0;
+    }
+    Box box;
+    box.min = Point(x - 500, y - 500);
+    box.max = Point(x - 500 + width, y - 500 + height);
+    return box;
+}
+
+static std::vector<unsigned int> bruteForceQuery(const std::vector<Box>& boxes, const std::vector<bool>& present,
+        const Box& query) {
+    std::vector<unsigned int> result;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (present[i] && boxes[i].min.x <= query.max.x && boxes[i].max.x >= query.min.x &&
+                boxes[i].min.y <= query.max.y && boxes[i].max.y >= query.min.y) {
+            result.push_back((unsigned int) i);
+        }
+    }
+    return result;
+}
+
+static std::vector<unsigned int> gridQuery(const SpatialGrid& grid, const Box& query) {
+    std::vector<unsigned int> result;
+    grid.query(query, result);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST(SpatialGrid, QueryMatchesBruteForce) {
+    unsigned int seed = 3;
+    std::vector<Box> boxes;
+    for (int i = 0; i < 400; ++i) {
+        boxes.push_back(makeBox(seed, 120));
+    }
+    std::vector<bool> present(boxes.size(), true);
+
+    SpatialGrid grid(SpatialGrid::suggestedCellSize(boxes));
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        grid.insert((unsigned int) i, boxes[i]);
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        // Mix small queries with some covering most of the area.
+        Box query = makeBox(seed, (i % 10 == 0) ? 2000 : 80);
+        EXPECT_EQ(bruteForceQuery(boxes, present, query), gridQuery(grid, query)) << "query " << i;
+    }
+
+    for (size_t i = 0; i < boxes.size(); i += 3) {
+        grid.remove((unsigned int) i, boxes[i]);
+        present[i] = false;
+    }
+    for (int i = 0; i < 200; ++i) {
+        Box query = makeBox(seed, 80);
+        EXPECT_EQ(bruteForceQuery(boxes, present, query), gridQuery(grid, query)) << "query " << i;
+    }
+
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (present[i]) {
+            grid.remove((unsigned int) i, boxes[i]);
+        }
+    }
+    EXPECT_TRUE(grid.empty());
+}
+
+TEST(SpatialGrid, TouchingBoxesAreFound) {
+    SpatialGrid grid(10);
+    Box box;
+    box.min = Point(0, 0);
+    box.max = Point(10, 0);
+    grid.insert(1, box);
+
+    Box query;
+    query.min = Point(10, -5);
+    query.max = Point(10, 5);
+    std::vector<unsigned int> result = gridQuery(grid, query);
+    ASSERT_EQ(1u, result.size());
+    EXPECT_EQ(1u, result[0]);
+
+    query.min = Point(10.5, -5);
+    query.max = Point(10.5, 5);
+    EXPECT_TRUE(gridQuery(grid, query).empty());
+}
+
+// The first shape in the router's obstacle list containing the point, found by scanning every obstacle.
+static ShapeRef *scanForShapeContainingPoint(Router *router, const Point& point) {
+    for (ObstacleList::const_iterator it = router->m_obstacles.begin(); it != router->m_obstacles.end(); ++it) {
+        ShapeRef *shape = dynamic_cast<ShapeRef *>(*it);
+        if (shape && inPoly(shape->routingPolygon(), point, true)) {
+            return shape;
+        }
+    }
+    return nullptr;
+}
+
+static void expectIndexMatchesScan(Router *router, unsigned int& seed) {
+    for (int i = 0; i < 300; ++i) {
+        seed = seed * 1103515245 + 12345;
+        double x = (seed >> 8) % 700;
+        seed = seed * 1103515245 + 12345;
+        double y = (seed >> 8) % 700;
+        Point point(x - 50, y - 50);
+        EXPECT_EQ(scanForShapeContainingPoint(router, point), router->shapeContainingPoint(point)) << "point " << i;
+    }
+}
+
+TEST(ObstacleIndex, ShapeContainingPointMatchesScan) {
+    Router *router = new Router(PolyLineRouting);
+    router->setRoutingParameter(RoutingParameter::shapeBufferDistance, 2);
+    unsigned int seed = 5;
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 120; ++i) {
+        Box box = makeBox(seed, 90);
+        box.min = Point(box.min.x + 600, box.min.y + 600);
+        if (i % 4 == 0) {
+            // A triangle, whose routing polygon extends beyond its routing box at the sharp corner.
+            Polygon triangle(3);
+            triangle.ps[0] = Point(box.min.x, box.min.y);
+            triangle.ps[1] = Point(box.min.x + 60, box.min.y + 4);
+            triangle.ps[2] = Point(box.min.x, box.min.y + 8);
+            shapes.push_back(new ShapeRef(router, triangle));
+        } else {
+            Rectangle rectangle(box.min, Point(box.min.x + 10 + (i % 7) * 9, box.min.y + 10 + (i % 5) * 11));
+            shapes.push_back(new ShapeRef(router, rectangle));
+        }
+    }
+    // Clusters and connectors, so the router also finds the shapes and clusters containing connector endpoints.  The
+    // cluster crossing penalty needs cluster boundaries made of shape corners, so is turned off.
+    router->setRoutingParameter(RoutingParameter::clusterCrossingPenalty, 0);
+    for (int i = 0; i < 3; ++i) {
+        Rectangle rectangle(Point(i * 200 - 40, i * 150 - 40), Point(i * 200 + 180, i * 150 + 160));
+        new ClusterRef(router, rectangle);
+    }
+    for (int i = 0; i < 20; ++i) {
+        new ConnRef(router, ConnEnd(Point(i * 31 - 40, i * 17)), ConnEnd(Point(600 - i * 23, i * 29 - 30)));
+    }
+    router->processTransaction();
+    expectIndexMatchesScan(router, seed);
+
+    // Moving shapes changes their order in the router too.
+    for (size_t i = 0; i < shapes.size(); i += 5) {
+        router->moveShape(shapes[i], (double) (i % 13) * 7 - 40, (double) (i % 11) * 5 - 25);
+    }
+    router->processTransaction();
+    expectIndexMatchesScan(router, seed);
+
+    for (size_t i = 2; i < shapes.size(); i += 6) {
+        router->deleteShape(shapes[i]);
+        shapes[i] = nullptr;
+    }
+    router->processTransaction();
+    expectIndexMatchesScan(router, seed);
+
+    // Changing the buffer distance changes every routing polygon.
+    router->setRoutingParameter(RoutingParameter::shapeBufferDistance, 12);
+    router->processTransaction();
+    expectIndexMatchesScan(router, seed);
+
+    delete router;
+}
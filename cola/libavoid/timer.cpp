@@ -24,165 +24,271 @@
 
 
 #include <cstdio>
-#include <cstdlib>
-#include <climits>
+#include <algorithm>
 
 #include "libavoid/timer.h"
-#include "libavoid/debug.h"
+#include "libavoid/router.h"
 #include "libavoid/assertions.h"
 
 namespace Avoid {
 
-#ifdef AVOID_PROFILE
+ProfileTimes::ProfileTimes()
+    : count(0),
+      wallTime(0),
+      cpuTime(0),
+      maxWallTime(0),
+      maxCpuTime(0)
+{
+}
 
-Timer::Timer()
+
+RouterProfile::RouterProfile()
+    : aStarSearches(0),
+      aStarExpansions(0),
+      maxAStarExpansions(0),
+      nudgingConstraints(0),
+      maxNudgingConstraints(0),
+      visibilityEdges(0),
+      orthogonalVisibilityEdges(0)
 {
-    reset();
 }
 
 
-void Timer::reset(void)
+const ProfileTimes& RouterProfile::phase(const unsigned int phaseNumber) const
 {
-    for (size_t i = 0; i < tmCount; ++i)
+    switch (phaseNumber)
     {
-        m_total_time[i] =  0;
-        m_tally[i] = 0;
-        m_max_time[i] = 0;
-        for (size_t j = 0; j < TIMER_VARIABLES_COUNT; ++j)
-        {
-            m_variables[i][j] = 0;
-        }
+        case TransactionPhaseOrthogonalVisibilityGraphScanX:
+            return orthogonalVisibilityGraphScanX;
+        case TransactionPhaseOrthogonalVisibilityGraphScanY:
+            return orthogonalVisibilityGraphScanY;
+        case TransactionPhaseRouteSearch:
+            return routeSearch;
+        case TransactionPhaseCrossingDetection:
+            return crossingDetection;
+        case TransactionPhaseRerouteSearch:
+            return rerouteSearch;
+        case TransactionPhaseOrthogonalNudgingX:
+            return orthogonalNudgingX;
+        case TransactionPhaseOrthogonalNudgingY:
+            return orthogonalNudgingY;
+        default:
+            COLA_ASSERT(phaseNumber == TransactionPhaseCompleted);
+            return transactions;
     }
-    m_is_running = false;
-    m_type = m_last_type = tmCount;
 }
 
 
-void Timer::initialise(const TimerIndex t)
+Timer::Timer()
+    : m_enabled(false)
 {
-    COLA_ASSERT(t != tmCount);
-    COLA_ASSERT(m_type == tmCount);
-    
-    m_type = t;
+    reset();
 }
 
-void Timer::start(void)
+
+void Timer::setEnabled(const bool enabled)
 {
-    COLA_ASSERT(!m_is_running);
-    m_start_time[m_type] = clock();  // CPU time
-    m_is_running = true;
+    m_enabled = enabled;
 }
 
 
-void Timer::stop(void)
+void Timer::reset(void)
 {
-    COLA_ASSERT(m_is_running);
-    clock_t stopTime = clock();      // CPU time
-    m_is_running = false;
-
-    bigclock_t timeDiff;
-    if (stopTime < m_start_time[m_type])
+    m_profile = RouterProfile();
+    for (size_t i = 0; i < tmCount; ++i)
     {
-        // Uh-oh, the clock value has wrapped around.
-        //
-        bigclock_t realStopTime = ((bigclock_t) stopTime) + ULONG_MAX + 1;
-        timeDiff = realStopTime - m_start_time[m_type];
+        m_is_running[i] = false;
+        m_was_run[i] = false;
+        m_wall_time[i] = 0;
+        m_cpu_time[i] = 0;
     }
-    else
+    for (size_t i = 0; i < tvCount; ++i)
     {
-        timeDiff = stopTime - m_start_time[m_type];
+        m_totals[i] = 0;
+        m_maxima[i] = 0;
     }
-    
-    COLA_ASSERT(timeDiff < LONG_MAX);
+}
 
-    m_total_time[m_type] += timeDiff;
-    m_tally[m_type]++;
-    if (((clock_t) timeDiff) > m_max_time[m_type])
-    {
-        m_max_time[m_type] = (clock_t) timeDiff;
-    }
-    m_last_type = m_type;
 
-    m_type = tmCount;
+void Timer::start(const TimerIndex t)
+{
+    COLA_ASSERT(t < tmCount);
+    COLA_ASSERT(!m_is_running[t]);
+    m_is_running[t] = true;
+    m_was_run[t] = true;
+    m_cpu_start[t] = clock();
+    m_wall_start[t] = WallClock::now();
 }
 
-static const char* timerNames[] =
+
+void Timer::stop(const TimerIndex t)
 {
-    "Adds",
-    "Dels",
-    "Movs",
-    "Pths",
-    "OrthogGraph",
-    "OrthogRoute",
-    "OrthogCentre",
-    "OrthogNudge",
-    "HyperedgeForest",
-    "HyperedgeMTST",
-    "HyperedgeImprove",
-    "HyperedgeAlt"
-};
+    COLA_ASSERT(t < tmCount);
+    if (!m_is_running[t])
+    {
+        // Profiling was enabled while this stage was running.
+        return;
+    }
+    WallClock::time_point wallStop = WallClock::now();
+    clock_t cpuStop = clock();
+    m_is_running[t] = false;
+
+    m_wall_time[t] += std::chrono::duration<double, std::milli>(
+            wallStop - m_wall_start[t]).count();
+    m_cpu_time[t] += (cpuStop - m_cpu_start[t]) * 
+            (1000.0 / CLOCKS_PER_SEC);
+
+    if (t == tmTransaction)
+    {
+        endTransaction();
+    }
+}
 
 
-void Timer::printAll(FILE *fp)
+// Adds the times accumulated by each stage during the transaction to the
+// totals and maxima.
+void Timer::endTransaction(void)
 {
-    for (unsigned int i = 0; i < tmCount; i++)
+    for (size_t i = 0; i < tmCount; ++i)
     {
-        fprintf(fp, "%s:  ", timerNames[i]);
-        print((TimerIndex) i, fp);
+        if (!m_was_run[i] || m_is_running[i])
+        {
+            continue;
+        }
+        ProfileTimes& stageTimes = times(m_profile, (TimerIndex) i);
+        ++stageTimes.count;
+        stageTimes.wallTime += m_wall_time[i];
+        stageTimes.cpuTime += m_cpu_time[i];
+        stageTimes.maxWallTime = std::max(stageTimes.maxWallTime, 
+                m_wall_time[i]);
+        stageTimes.maxCpuTime = std::max(stageTimes.maxCpuTime, 
+                m_cpu_time[i]);
+
+        m_was_run[i] = false;
+        m_wall_time[i] = 0;
+        m_cpu_time[i] = 0;
     }
-    fprintf(fp, "\n");
 }
 
-#define toMsec(tot) ((bigclock_t) ((tot) / (((double) CLOCKS_PER_SEC) / 1000)))
-#define toAvg(tot, cnt) ((((cnt) > 0) ? ((long double) (tot)) / (cnt) : 0))
 
-void Timer::printHyperedgePaper(FILE *fp)
+void Timer::varIncrement(const TimerVariableIndex i, 
+        const unsigned long long val)
 {
-    fprintf(fp, "%5lld & %5lld & %5lld & %5lld\n\n",
-        toMsec(m_total_time[tmOrthogGraph]),
-        toMsec(m_total_time[tmHyperedgeForest] + m_total_time[tmHyperedgeMTST]),
-        toMsec(m_total_time[tmHyperedgeAlt]),
-        toMsec(m_total_time[tmHyperedgeImprove]));
+    COLA_ASSERT(i < tvCount);
+    m_totals[i] += val;
 }
 
-void Timer::print(const TimerIndex t, FILE *fp)
+
+void Timer::varMax(const TimerVariableIndex i, const unsigned long long val)
 {
-    bigclock_t avg = toMsec(toAvg(m_total_time[t], m_tally[t]));
-    clock_t max = toMsec(m_max_time[t]); 
-    fprintf(fp, "%lld %d %lld %ld",
-            toMsec(m_total_time[t]), m_tally[t], avg, max);
-    
-    for (size_t j = 0; j < TIMER_VARIABLES_COUNT; ++j)
+    COLA_ASSERT(i < tvCount);
+    unsigned long long current = m_maxima[i];
+    while ((val > current) && !m_maxima[i].compare_exchange_weak(current, val))
     {
-        if (m_variables[t][j] > 0)
-        {
-            fprintf(fp, ", %lu: %u", j, m_variables[t][j]);
-        }
     }
-    fprintf(fp, "\n");
 }
 
-void Timer::varIncrement(size_t i, unsigned int val)
+
+void Timer::setGraphSizes(const unsigned int visibilityEdges, 
+        const unsigned int orthogonalVisibilityEdges)
+{
+    m_profile.visibilityEdges = visibilityEdges;
+    m_profile.orthogonalVisibilityEdges = orthogonalVisibilityEdges;
+}
+
+
+RouterProfile Timer::profile(void) const
 {
-    COLA_ASSERT(i < TIMER_VARIABLES_COUNT);
-    
-    if (m_is_running)
+    RouterProfile result = m_profile;
+    result.aStarSearches = m_totals[tvAStarSearches];
+    result.aStarExpansions = m_totals[tvAStarExpansions];
+    result.maxAStarExpansions = m_maxima[tvAStarExpansions];
+    result.nudgingConstraints = m_totals[tvNudgingConstraints];
+    result.maxNudgingConstraints = m_maxima[tvNudgingConstraints];
+    return result;
+}
+
+
+ProfileTimes& Timer::times(RouterProfile& profile, const TimerIndex t) const
+{
+    switch (t)
     {
-        m_variables[m_type][i] += val;
+        case tmTransaction:
+            return profile.transactions;
+        case tmOrthogGraphScanX:
+            return profile.orthogonalVisibilityGraphScanX;
+        case tmOrthogGraphScanY:
+            return profile.orthogonalVisibilityGraphScanY;
+        case tmOrthogGraph:
+            return profile.orthogonalVisibilityGraph;
+        case tmRouteSearch:
+            return profile.routeSearch;
+        case tmCrossingDetection:
+            return profile.crossingDetection;
+        case tmRerouteSearch:
+            return profile.rerouteSearch;
+        case tmOrthogNudgeX:
+            return profile.orthogonalNudgingX;
+        case tmOrthogNudgeY:
+            return profile.orthogonalNudgingY;
+        case tmHyperedgeForest:
+            return profile.hyperedgeForest;
+        case tmHyperedgeMTST:
+            return profile.hyperedgeMTST;
+        case tmHyperedgeAlt:
+            return profile.hyperedgeInterleaved;
+        default:
+            COLA_ASSERT(t == tmHyperedgeImprove);
+            return profile.hyperedgeImprovement;
     }
 }
 
-void Timer::varMax(size_t i, unsigned int val)
+
+static const char* timerNames[] =
 {
-    COLA_ASSERT(i < TIMER_VARIABLES_COUNT);
+    "Transactions",
+    "OrthogGraphScanX",
+    "OrthogGraphScanY",
+    "OrthogGraph",
+    "RouteSearch",
+    "CrossingDetection",
+    "RerouteSearch",
+    "OrthogNudgeX",
+    "OrthogNudgeY",
+    "HyperedgeForest",
+    "HyperedgeMTST",
+    "HyperedgeAlt",
+    "HyperedgeImprove"
+};
 
-    if (m_is_running)
+
+void Timer::printAll(FILE *fp) const
+{
+    for (unsigned int i = 0; i < tmCount; i++)
     {
-        m_variables[m_type][i] = std::max(m_variables[m_type][i], val);
+        fprintf(fp, "%s:  ", timerNames[i]);
+        print((TimerIndex) i, fp);
     }
+    RouterProfile current = profile();
+    fprintf(fp, "A* searches: %llu, expansions: %llu (max %llu)\n",
+            current.aStarSearches, current.aStarExpansions, 
+            current.maxAStarExpansions);
+    fprintf(fp, "Nudging constraints: %llu (max %llu)\n", 
+            current.nudgingConstraints, current.maxNudgingConstraints);
+    fprintf(fp, "\n");
 }
 
-#endif
 
+void Timer::print(const TimerIndex t, FILE *fp) const
+{
+    RouterProfile current = m_profile;
+    const ProfileTimes& stageTimes = times(current, t);
+    double avg = (stageTimes.count > 0) ? 
+            (stageTimes.wallTime / stageTimes.count) : 0;
+    fprintf(fp, "%.3f %u %.3f %.3f (cpu %.3f, max %.3f)\n",
+            stageTimes.wallTime, stageTimes.count, avg, 
+            stageTimes.maxWallTime, stageTimes.cpuTime, 
+            stageTimes.maxCpuTime);
 }
 
+}
@@ -26,79 +26,188 @@
 #ifndef AVOID_TIMER_H
 #define AVOID_TIMER_H
 
+#include <cstdio>
 #include <ctime>
+#include <chrono>
+#include <atomic>
 
-namespace Avoid {
+#include "libavoid/dllexport.h"
 
-//#define AVOID_PROFILE
+namespace Avoid {
 
-#ifndef AVOID_PROFILE
+// The instrumentation is always compiled in, but only does any work when
+// profiling has been enabled with Router::setProfilingEnabled().
+#define TIMER_START(r, t) \
+    do { if ((r)->timers.isEnabled()) (r)->timers.start(t); } while(0)
+#define TIMER_STOP(r, t) \
+    do { if ((r)->timers.isEnabled()) (r)->timers.stop(t); } while(0)
+#define TIMER_VAR_ADD(r, n, v) \
+    do { if ((r)->timers.isEnabled()) (r)->timers.varIncrement(n, v); } while(0)
+#define TIMER_VAR_MAX(r, n, v) \
+    do { if ((r)->timers.isEnabled()) (r)->timers.varMax(n, v); } while(0)
+
+//! @brief  Wall-clock and CPU times, in milliseconds, for one stage of 
+//!         routing.
+//!
+//! Times are accumulated over each transaction.  The maxima are the 
+//! largest times taken by the stage in a single transaction.
+//!
+struct AVOID_EXPORT ProfileTimes
+{
+    ProfileTimes();
+
+    //! The number of transactions in which the stage was performed.
+    unsigned int count;
+    //! The total wall-clock time for the stage.
+    double wallTime;
+    //! The total processor time for the stage.  This is for the whole 
+    //! process, so it includes the time of any routing threads.
+    double cpuTime;
+    //! The largest wall-clock time for the stage in one transaction.
+    double maxWallTime;
+    //! The largest processor time for the stage in one transaction.
+    double maxCpuTime;
+};
 
-  #define TIMER_START(r, t) do {} while(0)
-  #define TIMER_STOP(r) do {} while(0)
-  #define TIMER_VAR_ADD(r, n, v) do {} while(0)
-  #define TIMER_VAR_MAX(r, n, v) do {} while(0)
+//! @brief  Profiling information collected by a Router while profiling is 
+//!         enabled.
+//!
+//! This is returned by Router::profile().  It holds the times for each of 
+//! the transaction phases reported to 
+//! Router::shouldContinueTransactionWithProgress(), as well as some other
+//! stages and counts of the work done.
+//!
+struct AVOID_EXPORT RouterProfile
+{
+    RouterProfile();
+
+    //! @brief  Returns the times for the given transaction phase.
+    //!
+    //! @param  phaseNumber  A Avoid::TransactionPhases value.  For 
+    //!                      Avoid::TransactionPhaseCompleted, the times 
+    //!                      for whole transactions are returned.
+    //! @return The times for the phase.
+    const ProfileTimes& phase(const unsigned int phaseNumber) const;
+
+    //! Whole transactions, from Router::processTransaction().
+    ProfileTimes transactions;
+    //! The sweep in the x-dimension to build the orthogonal visibility graph.
+    ProfileTimes orthogonalVisibilityGraphScanX;
+    //! The sweep in the y-dimension to build the orthogonal visibility graph.
+    ProfileTimes orthogonalVisibilityGraphScanY;
+    //! Building or updating the orthogonal visibility graph, including 
+    //! both sweeps.
+    ProfileTimes orthogonalVisibilityGraph;
+    //! Initial route searches.
+    ProfileTimes routeSearch;
+    //! Detection of crossings between connectors.
+    ProfileTimes crossingDetection;
+    //! Rerouting of crossing connectors.
+    ProfileTimes rerouteSearch;
+    //! Nudging of orthogonal segments in the x-dimension.
+    ProfileTimes orthogonalNudgingX;
+    //! Nudging of orthogonal segments in the y-dimension.
+    ProfileTimes orthogonalNudgingY;
+    //! Building the shortest path terminal forest for hyperedge routing.
+    ProfileTimes hyperedgeForest;
+    //! Building the minimum terminal spanning tree for hyperedge routing.
+    ProfileTimes hyperedgeMTST;
+    //! Building the hyperedge tree with the interleaved method.
+    ProfileTimes hyperedgeInterleaved;
+    //! Improving hyperedge routes by moving junctions.
+    ProfileTimes hyperedgeImprovement;
+
+    //! The number of A* searches performed for connector routes.
+    unsigned long long aStarSearches;
+    //! The total number of nodes expanded by the A* searches.
+    unsigned long long aStarExpansions;
+    //! The largest number of nodes expanded by a single A* search.
+    unsigned long long maxAStarExpansions;
+    //! The number of separation constraints solved during nudging.  A 
+    //! region of segments solved more than once counts each time.
+    unsigned long long nudgingConstraints;
+    //! The largest number of separation constraints in a single solve.
+    unsigned long long maxNudgingConstraints;
+    //! The number of edges in the polyline visibility graph at the end of 
+    //! the last transaction.
+    unsigned int visibilityEdges;
+    //! The number of edges in the orthogonal visibility graph at the end 
+    //! of the last transaction.
+    unsigned int orthogonalVisibilityEdges;
+};
 
-#else
-   
-  #define TIMER_START(r, t) r->timers.initialise(t); r->timers.start()
-  #define TIMER_STOP(r) r->timers.stop()
-  #define TIMER_VAR_ADD(r, n, v) r->timers.varIncrement(n, v);
-  #define TIMER_VAR_MAX(r, n, v) r->timers.varMax(n, v)
 
-typedef unsigned long long int bigclock_t;
+// NOTE: The following are internal to the Router.
 
 enum TimerIndex 
 {
-    tmAdd,
-    tmDel,
-    tmMov,
-    tmPth,
+    tmTransaction,
+    tmOrthogGraphScanX,
+    tmOrthogGraphScanY,
     tmOrthogGraph,
-    tmOrthogRoute,
-    tmOrthogCentre,
-    tmOrthogNudge,
+    tmRouteSearch,
+    tmCrossingDetection,
+    tmRerouteSearch,
+    tmOrthogNudgeX,
+    tmOrthogNudgeY,
     tmHyperedgeForest,
     tmHyperedgeMTST,
-    tmHyperedgeImprove,
     tmHyperedgeAlt,
+    tmHyperedgeImprove,
     tmCount
 };
 
-static const bool timerStart = true;
-static const bool timerDelay = false;
-
-static const size_t TIMER_VARIABLES_COUNT = 2;
+enum TimerVariableIndex
+{
+    tvAStarSearches,
+    tvAStarExpansions,
+    tvNudgingConstraints,
+    tvCount
+};
 
 class Timer
 {
     public:
         Timer();
-        void initialise(const TimerIndex t);
-        void start(void);
-        void stop(void);
+        void setEnabled(const bool enabled);
+        bool isEnabled(void) const
+        {
+            return m_enabled;
+        }
+        void start(const TimerIndex t);
+        void stop(const TimerIndex t);
         void reset(void);
-        void varIncrement(size_t i, unsigned int val);
-        void varMax(size_t i, unsigned int val);
+        // These may be called from routing threads.
+        void varIncrement(const TimerVariableIndex i, 
+                const unsigned long long val);
+        void varMax(const TimerVariableIndex i, const unsigned long long val);
+        void setGraphSizes(const unsigned int visibilityEdges, 
+                const unsigned int orthogonalVisibilityEdges);
 
-        void print(TimerIndex, FILE *fp);
-        void printAll(FILE *fp);
-        void printHyperedgePaper(FILE *fp);
+        RouterProfile profile(void) const;
+        void print(const TimerIndex t, FILE *fp) const;
+        void printAll(FILE *fp) const;
 
     private:
-        clock_t m_start_time[tmCount];
-        bigclock_t m_total_time[tmCount];
-        int m_tally[tmCount];
-        clock_t m_max_time[tmCount];
-        unsigned int m_variables[tmCount][TIMER_VARIABLES_COUNT];
-
-        bool m_is_running;
-        TimerIndex m_type;
-        TimerIndex m_last_type;
+        typedef std::chrono::steady_clock WallClock;
+
+        void endTransaction(void);
+        ProfileTimes& times(RouterProfile& profile, const TimerIndex t) const;
+
+        bool m_enabled;
+        RouterProfile m_profile;
+        // Start times for the running timers, and the times accumulated 
+        // so far in the current transaction.
+        WallClock::time_point m_wall_start[tmCount];
+        clock_t m_cpu_start[tmCount];
+        bool m_is_running[tmCount];
+        bool m_was_run[tmCount];
+        double m_wall_time[tmCount];
+        double m_cpu_time[tmCount];
+        std::atomic<unsigned long long> m_totals[tvCount];
+        std::atomic<unsigned long long> m_maxima[tvCount];
 };
 
-#endif
-
 }
 
 #endif
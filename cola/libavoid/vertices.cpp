@@ -175,6 +175,8 @@ VertInf::VertInf(Router *router, const VertID& vid, const Point& vpoint,
 {
     point.id = vid.objID;
     point.vn = vid.vn;
+    adjacencyIndex[0] = CompactAdjacency::noIndex;
+    adjacencyIndex[1] = CompactAdjacency::noIndex;
 
     if (addToRouter)
     {
@@ -205,6 +207,8 @@ EdgeInf *VertInf::hasNeighbour(VertInf *target, bool orthogonal) const
 
 void VertInf::Reset(const VertID& vid, const Point& vpoint)
 {
+    _router->compactAdjacency(false).vertexMoved(this);
+    _router->compactAdjacency(true).vertexMoved(this);
     id = vid;
     point = vpoint;
     point.id = id.objID;
@@ -214,6 +218,8 @@ void VertInf::Reset(const VertID& vid, const Point& vpoint)
 
 void VertInf::Reset(const Point& vpoint)
 {
+    _router->compactAdjacency(false).vertexMoved(this);
+    _router->compactAdjacency(true).vertexMoved(this);
     point = vpoint;
     point.id = id.objID;
     point.vn = id.vn;
@@ -110,8 +110,6 @@ class VertID
 static const VertID dummyOrthogID(0, 0);
 static const VertID dummyOrthogShapeID(0, 0, VertID::PROP_OrthShapeEdge);
 
-class ANode;
-
 class VertInf
 {
     public:
@@ -165,11 +163,13 @@ class VertInf
         double sptfDist;
 
         ConnDirFlags visDirections;
-        std::list<ANode *> aStarDoneNodes;
-        std::list<ANode *> aStarPendingNodes;
         // Flags for orthogonal visibility properties, i.e., whether the 
         // line points to a shape edge, connection point or an obstacle.
         unsigned int orthogVisPropFlags;
+
+        // The rows for this vertex in the router's CompactAdjacency for 
+        // the polyline [0] and orthogonal [1] visibility graphs.
+        unsigned int adjacencyIndex[2];
 };
 
 
@@ -26,6 +26,8 @@
 
 #include "libavoid/viscluster.h"
 #include "libavoid/router.h"
+#include "libavoid/spatialindex.h"
+#include "libavoid/routecache.h"
 #include "libavoid/assertions.h"
 #include "libavoid/debug.h"
 
@@ -64,6 +66,9 @@ void ClusterRef::makeActive(void)
     // Add to clusterRefs list.
     m_clusterrefs_pos = m_router->clusterRefs.insert(
             m_router->clusterRefs.begin(), this);
+    m_router->addObjectId(m_id);
+    m_router->m_obstacle_index->invalidateClusters();
+    m_router->m_route_cache->invalidate();
 
     m_active = true;
 }
@@ -75,6 +80,9 @@ void ClusterRef::makeInactive(void)
     
     // Remove from clusterRefs list.
     m_router->clusterRefs.erase(m_clusterrefs_pos);
+    m_router->removeObjectId(m_id);
+    m_router->m_obstacle_index->invalidateClusters();
+    m_router->m_route_cache->invalidate();
 
     m_active = false;
 }
@@ -84,6 +92,8 @@ void ClusterRef::setNewPoly(Polygon& poly)
 {
     m_polygon = ReferencingPolygon(poly, m_router);
     m_rectangular_polygon = m_polygon.boundingRectPolygon();
+    m_router->m_obstacle_index->invalidateClusters();
+    m_router->m_route_cache->invalidate();
 }
 
 
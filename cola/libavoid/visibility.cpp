@@ -33,6 +33,7 @@
 
 #include <algorithm>
 #include <cfloat>
+#include <vector>
 
 #include "libavoid/shape.h"
 #include "libavoid/debug.h"
@@ -42,12 +43,60 @@
 #include "libavoid/geometry.h"
 #include "libavoid/router.h"
 #include "libavoid/assertions.h"
+#include "libavoid/parallel.h"
 
 
 namespace Avoid {
 
 
-static void vertexSweep(VertInf *vert);
+// The visibility found from a vertex to another vertex.  Visibility is
+// computed without changing the visibility graph, so the visibility of
+// many pairs of vertices can be computed concurrently.  The results are
+// then added to the graph in a fixed order, giving the same graph as when
+// each edge is added as soon as its visibility is known.
+class VisibilityResult
+{
+    public:
+        VisibilityResult(VertInf *inf, const bool visible, const int blocker,
+                const double dist)
+            : vInf(inf),
+              visible(visible),
+              blocker(blocker),
+              dist(dist)
+        {
+        }
+
+        VertInf *vInf;
+        bool     visible;
+        int      blocker;
+        double   dist;
+};
+
+typedef std::vector<VisibilityResult> VisibilityResultList;
+
+
+static void vertexSweep(VertInf *vert, VisibilityResultList& results);
+static void addSweepEdges(VertInf *centerInf,
+        const VisibilityResultList& results);
+
+
+// The work of computing the visibility of one shape's vertices grows with
+// the number of vertices in the router.  Below this many, starting threads
+// costs more than it saves, so the work is done on the calling thread.
+static const unsigned int minVerticesForConcurrentVisibility = 200;
+
+// Returns the number of threads to use to compute the visibility of the
+// vertices of one shape.
+static unsigned int visibilityThreadCount(Router *router)
+{
+    if (router->vertices.connsSize() + router->vertices.shapesSize() <
+            minVerticesForConcurrentVisibility)
+    {
+        return 1;
+    }
+    return threadCountFromSetting(
+            router->routingParameter(routingThreadCount));
+}
 
 void Obstacle::computeVisibilityNaive(void)
 {
@@ -60,15 +109,14 @@ void Obstacle::computeVisibilityNaive(void)
     VertInf *shapeBegin = firstVert();
     VertInf *shapeEnd = lastVert()->lstNext;
 
+    // Find the pairs of vertices to check, in the order their edges are
+    // to be added.
+    std::vector<VertInf *> pairCentres;
+    std::vector<VertInf *> pairOthers;
     VertInf *pointsBegin = router()->vertices.connsBegin();
+    VertInf *pointsEnd = router()->vertices.end();
     for (VertInf *curr = shapeBegin; curr != shapeEnd; curr = curr->lstNext)
     {
-        bool knownNew = true;
-
-        db_printf("-- CONSIDERING --\n");
-        curr->id.db_print();
-
-        db_printf("\tFirst Half:\n");
         for (VertInf *j = pointsBegin ; j != curr; j = j->lstNext)
         {
             if (j->id == dummyOrthogID)
@@ -76,11 +124,10 @@ void Obstacle::computeVisibilityNaive(void)
                 // Don't include orthogonal dummy vertices.
                 continue;
             }
-            EdgeInf::checkEdgeVisibility(curr, j, knownNew);
+            pairCentres.push_back(curr);
+            pairOthers.push_back(j);
         }
 
-        db_printf("\tSecond Half:\n");
-        VertInf *pointsEnd = router()->vertices.end();
         for (VertInf *k = shapeEnd; k != pointsEnd; k = k->lstNext)
         {
             if (k->id == dummyOrthogID)
@@ -88,7 +135,37 @@ void Obstacle::computeVisibilityNaive(void)
                 // Don't include orthogonal dummy vertices.
                 continue;
             }
-            EdgeInf::checkEdgeVisibility(curr, k, knownNew);
+            pairCentres.push_back(curr);
+            pairOthers.push_back(k);
+        }
+    }
+
+    // Check the visibility of each pair.
+    std::vector<int> blockers(pairOthers.size(), 0);
+    std::vector<char> visible(pairOthers.size(), false);
+    router()->m_thread_pool->parallelFor(pairOthers.size(), 
+            visibilityThreadCount(router()),
+            [&](size_t index)
+            {
+                visible[index] = EdgeInf::verticesVisible(pairCentres[index],
+                        pairOthers[index], &blockers[index]);
+            });
+
+    // Then add the edges.
+    for (size_t index = 0; index < pairOthers.size(); ++index)
+    {
+        VertInf *curr = pairCentres[index];
+        VertInf *other = pairOthers[index];
+        router()->st_checked_edges++;
+        if (visible[index])
+        {
+            EdgeInf *edge = new EdgeInf(curr, other);
+            edge->setDist(euclideanDist(curr->point, other->point));
+        }
+        else if (router()->InvisibilityGrph)
+        {
+            EdgeInf *edge = new EdgeInf(curr, other);
+            edge->addBlocker(blockers[index]);
         }
     }
 }
@@ -105,9 +182,22 @@ void Obstacle::computeVisibilitySweep(void)
     VertInf *startIter = firstVert();
     VertInf *endIter = lastVert()->lstNext;
 
+    // Sweep around each vertex, then add the edges found in vertex order.
+    std::vector<VertInf *> verts;
     for (VertInf *i = startIter; i != endIter; i = i->lstNext)
     {
-        vertexSweep(i);
+        verts.push_back(i);
+    }
+    std::vector<VisibilityResultList> results(verts.size());
+    router()->m_thread_pool->parallelFor(verts.size(), 
+            visibilityThreadCount(router()),
+            [&](size_t index)
+            {
+                vertexSweep(verts[index], results[index]);
+            });
+    for (size_t index = 0; index < verts.size(); ++index)
+    {
+        addSweepEdges(verts[index], results[index]);
     }
 }
 
@@ -133,7 +223,9 @@ void vertexVisibility(VertInf *point, VertInf *partner, bool knownNew,
 
     if (router->UseLeesAlgorithm)
     {
-        vertexSweep(point);
+        VisibilityResultList results;
+        vertexSweep(point, results);
+        addSweepEdges(point, results);
     }
     else
     {
@@ -323,7 +415,7 @@ class isBoundingShape
 {
     public:
         // Class instance remembers the ShapeSet.
-        isBoundingShape(ShapeSet& set) : 
+        isBoundingShape(const ShapeSet& set) : 
             ss(set)
         { }
         // The following is an overloading of the function call operator.
@@ -343,7 +435,7 @@ class isBoundingShape
         isBoundingShape & operator=(isBoundingShape const &);
         isBoundingShape();
 
-        ShapeSet& ss;
+        const ShapeSet& ss;
 };
 
 
@@ -382,7 +474,7 @@ static bool sweepVisible(SweepEdgeList& T, const PointPair& point,
     {
         // It's a connector endpoint, so we have to ignore 
         // edges of containing shapes for determining visibility.
-        ShapeSet& rss = router->contains[point.vInf->id];
+        const ShapeSet& rss = router->containingShapes(point.vInf->id);
         while (closestIt != end)
         {
             if (rss.find(closestIt->vInf1->id.objID) == rss.end())
@@ -433,7 +525,10 @@ static bool sweepVisible(SweepEdgeList& T, const PointPair& point,
 }
 
 
-static void vertexSweep(VertInf *vert)
+// Sweeps around the vertex vert, recording the visibility of each other
+// vertex that is to have an edge to it in results.  This only reads the
+// router's obstacles and vertices, so can be called from multiple threads.
+static void vertexSweep(VertInf *vert, VisibilityResultList& results)
 {
     Router *router = vert->_router;
     VertID& pID = vert->id;
@@ -448,7 +543,7 @@ static void vertexSweep(VertInf *vert)
     VertSet v;
 
     // Initialise the vertex list
-    ShapeSet& ss = router->contains[centerID];
+    const ShapeSet& ss = router->containingShapes(centerID);
     VertInf *beginVert = router->vertices.connsBegin();
     VertInf *endVert = router->vertices.end();
     for (VertInf *inf = beginVert; inf != endVert; inf = inf->lstNext)
@@ -571,12 +666,6 @@ static void vertexSweep(VertInf *vert)
 
         const double& currDist = (*t).distance;
 
-        EdgeInf *edge = EdgeInf::existingEdge(centerInf, currInf);
-        if (edge == nullptr)
-        {
-            edge = new EdgeInf(centerInf, currInf);
-        }
-
         for (SweepEdgeList::iterator c = e.begin(); c != e.end(); ++c)
         {
             (*c).setCurrAngle(*t);
@@ -605,32 +694,23 @@ static void vertexSweep(VertInf *vert)
         {
             if (router->InvisibilityGrph)
             {
-                db_printf("\tSetting invisibility edge... \n\t\t");
-                edge->addBlocker(0);
-                edge->db_print();
+                results.push_back(VisibilityResult(currInf, false, 0, 
+                        currDist));
             }
         }
         else
         {
             if (currVisible)
             {
-                db_printf("\tSetting visibility edge... \n\t\t");
-                edge->setDist(currDist);
-                edge->db_print();
+                results.push_back(VisibilityResult(currInf, true, 0, 
+                        currDist));
             }
             else if (router->InvisibilityGrph)
             {
-                db_printf("\tSetting invisibility edge... \n\t\t");
-                edge->addBlocker(blocker);
-                edge->db_print();
+                results.push_back(VisibilityResult(currInf, false, blocker, 
+                        currDist));
             }
         }
-        
-        if (!(edge->added()) && !(router->InvisibilityGrph))
-        {
-            delete edge;
-            edge = nullptr;
-        }
 
         if (!(currID.isConnPt()))
         {
@@ -672,5 +752,35 @@ static void vertexSweep(VertInf *vert)
 }
 
 
+// Adds the edges from centerInf found by a sweep around it to the
+// visibility graph, or to the invisibility graph.
+static void addSweepEdges(VertInf *centerInf,
+        const VisibilityResultList& results)
+{
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const VisibilityResult& result = results[i];
+        EdgeInf *edge = EdgeInf::existingEdge(centerInf, result.vInf);
+        if (edge == nullptr)
+        {
+            edge = new EdgeInf(centerInf, result.vInf);
+        }
+
+        if (result.visible)
+        {
+            db_printf("\tSetting visibility edge... \n\t\t");
+            edge->setDist(result.dist);
+            edge->db_print();
+        }
+        else
+        {
+            db_printf("\tSetting invisibility edge... \n\t\t");
+            edge->addBlocker(result.blocker);
+            edge->db_print();
+        }
+    }
+}
+
+
 }
 
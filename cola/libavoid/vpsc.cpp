@@ -41,6 +41,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include <sstream>
 #include <map>
 #include <cfloat>
@@ -103,6 +104,59 @@ void IncSolver::addConstraint(Constraint *c)
     c->needsScaling = needsScaling;
 }
 
+// eraseConstraint() and IncSolver::removeConstraint() are copies of those
+// in libvpsc/solve_VPSC.cpp.  Keep the two versions in step.
+static void eraseConstraint(Constraints &l, Constraint *c)
+{
+    Constraints::iterator it = std::find(l.begin(), l.end(), c);
+    if (it != l.end())
+    {
+        *it = l.back();
+        l.pop_back();
+    }
+}
+
+void IncSolver::removeConstraint(Constraint *c)
+{
+    COLA_ASSERT(m > 0);
+    --m;
+    if (c->active)
+    {
+        // Split the block on c, leaving the rest of the block structure
+        // as it is.  The two halves are placed at their own optimal
+        // positions, and any constraints between them that this violates
+        // are merged across again by the next satisfy().
+        Block *b = c->left->block, *l = nullptr, *r = nullptr;
+        COLA_ASSERT(b == c->right->block);
+        b->split(l, r, c);
+        bs->insert(l);
+        bs->insert(r);
+        b->deleted = true;
+        bs->cleanup();
+    }
+    else
+    {
+        eraseConstraint(inactive, c);
+    }
+    eraseConstraint(c->left->out, c);
+    eraseConstraint(c->right->in, c);
+
+    // Rebuild any constraint heaps of the blocks at each end, as these
+    // may still refer to c.
+    Block *blocks[2] = { c->left->block, c->right->block };
+    for (int i = 0; i < 2; ++i)
+    {
+        if (blocks[i]->in)
+        {
+            blocks[i]->setUpInConstraints();
+        }
+        if (blocks[i]->out)
+        {
+            blocks[i]->setUpOutConstraints();
+        }
+    }
+}
+
 // useful in debugging
 void IncSolver::printBlocks() {
 #ifdef LIBVPSC_LOGGING
@@ -306,6 +306,9 @@ public:
 
     ~IncSolver();
     void addConstraint(Constraint *constraint);
+    // Removes a constraint, splitting its block if it is active.  The
+    // caller should also remove it from the list passed to the constructor.
+    void removeConstraint(Constraint *constraint);
     Variables const & getVariables() { return vs; }
 protected:
     Blocks *bs;
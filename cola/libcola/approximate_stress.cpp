@@ -0,0 +1,315 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#include "libvpsc/assertions.h"
+#include "libcola/approximate_stress.h"
+
+using std::valarray;
+using std::vector;
+
+namespace cola {
+
+// Cells deeper than this are not subdivided further.  This only matters
+// when many nodes share (almost) the same position.
+static const unsigned maxQuadTreeDepth = 32;
+
+void QuadTree::build(const valarray<double>& X, const valarray<double>& Y,
+        const vector<unsigned>& nodes)
+{
+    m_cells.clear();
+    m_nodes = nodes;
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+    for (unsigned i = 0; i < m_nodes.size(); ++i)
+    {
+        const unsigned v = m_nodes[i];
+        minX = std::min(minX, X[v]);
+        minY = std::min(minY, Y[v]);
+        maxX = std::max(maxX, X[v]);
+        maxY = std::max(maxY, Y[v]);
+    }
+
+    Cell root;
+    root.minX = minX;
+    root.minY = minY;
+    root.size = std::max(maxX - minX, maxY - minY);
+    root.begin = 0;
+    root.end = (unsigned) m_nodes.size();
+    root.firstChild = 0;
+    root.childCount = 0;
+    m_cells.push_back(root);
+    subdivide(0, 0, X, Y);
+}
+
+void QuadTree::subdivide(const unsigned cellIndex, const unsigned depth,
+        const valarray<double>& X, const valarray<double>& Y)
+{
+    const unsigned begin = m_cells[cellIndex].begin;
+    const unsigned end = m_cells[cellIndex].end;
+
+    // Centroid, then the representative as the node nearest it.
+    double cx = 0, cy = 0;
+    for (unsigned i = begin; i < end; ++i)
+    {
+        cx += X[m_nodes[i]];
+        cy += Y[m_nodes[i]];
+    }
+    cx /= (end - begin);
+    cy /= (end - begin);
+    unsigned representative = m_nodes[begin];
+    double bestDist = DBL_MAX;
+    for (unsigned i = begin; i < end; ++i)
+    {
+        const unsigned v = m_nodes[i];
+        const double dx = X[v] - cx, dy = Y[v] - cy;
+        const double dist = dx * dx + dy * dy;
+        if (dist < bestDist)
+        {
+            bestDist = dist;
+            representative = v;
+        }
+    }
+    m_cells[cellIndex].cx = cx;
+    m_cells[cellIndex].cy = cy;
+    m_cells[cellIndex].representative = representative;
+
+    if (((end - begin) <= 1) || (depth >= maxQuadTreeDepth))
+    {
+        return;
+    }
+
+    // Partition the nodes into the four quadrants.
+    const double half = m_cells[cellIndex].size / 2;
+    const double midX = m_cells[cellIndex].minX + half;
+    const double midY = m_cells[cellIndex].minY + half;
+    vector<unsigned>::iterator first = m_nodes.begin() + begin;
+    vector<unsigned>::iterator last = m_nodes.begin() + end;
+    vector<unsigned>::iterator splitY = std::partition(first, last,
+            [&](unsigned v) { return Y[v] < midY; });
+    vector<unsigned>::iterator splitLow = std::partition(first, splitY,
+            [&](unsigned v) { return X[v] < midX; });
+    vector<unsigned>::iterator splitHigh = std::partition(splitY, last,
+            [&](unsigned v) { return X[v] < midX; });
+    const vector<unsigned>::iterator bounds[5] =
+            { first, splitLow, splitY, splitHigh, last };
+
+    const unsigned firstChild = (unsigned) m_cells.size();
+    for (unsigned q = 0; q < 4; ++q)
+    {
+        if (bounds[q] == bounds[q + 1])
+        {
+            continue;
+        }
+        Cell child;
+        child.minX = (q % 2 == 0) ? m_cells[cellIndex].minX : midX;
+        child.minY = (q < 2) ? m_cells[cellIndex].minY : midY;
+        child.size = half;
+        child.begin = (unsigned) (bounds[q] - m_nodes.begin());
+        child.end = (unsigned) (bounds[q + 1] - m_nodes.begin());
+        child.firstChild = 0;
+        child.childCount = 0;
+        m_cells.push_back(child);
+    }
+    const unsigned childCount = (unsigned) m_cells.size() - firstChild;
+    m_cells[cellIndex].firstChild = firstChild;
+    m_cells[cellIndex].childCount = childCount;
+    for (unsigned c = firstChild; c < firstChild + childCount; ++c)
+    {
+        subdivide(c, depth + 1, X, Y);
+    }
+}
+
+
+ApproximateStress::ApproximateStress(
+        const vector<vector<unsigned> >& adjacency,
+        const unsigned nearHops, const double theta)
+    : m_theta(theta),
+      m_near_hops(nearHops),
+      m_near_nodes(adjacency.size()),
+      m_component_of(adjacency.size(), 0),
+      m_near_mark(adjacency.size(), 0)
+{
+    COLA_ASSERT(nearHops >= 1);
+    COLA_ASSERT(theta >= 0);
+    const unsigned n = (unsigned) adjacency.size();
+
+    // Connected components.  There are no forces between components.
+    vector<bool> visited(n, false);
+    vector<unsigned> queue;
+    for (unsigned s = 0; s < n; ++s)
+    {
+        if (visited[s])
+        {
+            continue;
+        }
+        const unsigned component = (unsigned) m_components.size();
+        m_components.push_back(vector<unsigned>());
+        visited[s] = true;
+        queue.assign(1, s);
+        for (unsigned i = 0; i < queue.size(); ++i)
+        {
+            const unsigned u = queue[i];
+            m_component_of[u] = component;
+            m_components[component].push_back(u);
+            for (unsigned j = 0; j < adjacency[u].size(); ++j)
+            {
+                const unsigned v = adjacency[u][j];
+                if (!visited[v])
+                {
+                    visited[v] = true;
+                    queue.push_back(v);
+                }
+            }
+        }
+    }
+    m_trees.resize(m_components.size());
+
+    // Hop-limited breadth-first search from each node for its near nodes.
+    vector<unsigned> seen(n, 0);
+    vector<unsigned> frontier, next;
+    for (unsigned s = 0; s < n; ++s)
+    {
+        vector<unsigned>& nearNodes = m_near_nodes[s];
+        seen[s] = s + 1;
+        frontier.assign(1, s);
+        for (unsigned hop = 0; (hop < nearHops) && !frontier.empty(); ++hop)
+        {
+            next.clear();
+            for (unsigned i = 0; i < frontier.size(); ++i)
+            {
+                const unsigned u = frontier[i];
+                for (unsigned j = 0; j < adjacency[u].size(); ++j)
+                {
+                    const unsigned v = adjacency[u][j];
+                    if (seen[v] != s + 1)
+                    {
+                        seen[v] = s + 1;
+                        next.push_back(v);
+                        nearNodes.push_back(v);
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+        std::sort(nearNodes.begin(), nearNodes.end());
+    }
+}
+
+void ApproximateStress::update(const valarray<double>& X,
+        const valarray<double>& Y)
+{
+    for (unsigned c = 0; c < m_components.size(); ++c)
+    {
+        m_trees[c].build(X, Y, m_components[c]);
+    }
+}
+
+void ApproximateStress::addFarTerms(const unsigned u, const vpsc::Dim dim,
+        const valarray<double>& X, const valarray<double>& Y,
+        const IdealDistances& distances, double& stress, double& g,
+        double& Huu)
+{
+    const vector<unsigned>& nearNodes = m_near_nodes[u];
+    for (unsigned i = 0; i < nearNodes.size(); ++i)
+    {
+        m_near_mark[nearNodes[i]] = u + 1;
+    }
+    m_near_mark[u] = u + 1;
+
+    const QuadTree& tree = m_trees[m_component_of[u]];
+    const vector<QuadTree::Cell>& cells = tree.cells();
+    const vector<unsigned>& nodes = tree.nodes();
+    if (cells.empty())
+    {
+        return;
+    }
+
+    // The term for node u and a group of weight nodes at distance (rx, ry)
+    // from it, with ideal distance d.  As with the exact stress, distant
+    // pairs only contribute when they are closer than their ideal distance.
+    auto addTerm = [&](double rx, double ry, double d, double weight)
+    {
+        double l = sqrt(rx * rx + ry * ry);
+        if (l > d)
+        {
+            return;
+        }
+        double d2 = d * d;
+        double rl = d - l;
+        stress += weight * rl * rl / d2;
+        if (l < 1e-30)
+        {
+            l = 0.1;
+        }
+        double dx = (dim == vpsc::HORIZONTAL) ? rx : ry;
+        double dy = (dim == vpsc::HORIZONTAL) ? ry : rx;
+        g += weight * dx * (l - d) / (d2 * l);
+        Huu -= weight * (d * dy * dy / (l * l * l) - 1) / d2;
+    };
+
+    m_stack.assign(1, 0);
+    while (!m_stack.empty())
+    {
+        const QuadTree::Cell& cell = cells[m_stack.back()];
+        m_stack.pop_back();
+
+        const double rx = X[u] - cell.cx, ry = Y[u] - cell.cy;
+        const bool containsU = (X[u] >= cell.minX) &&
+                (X[u] <= cell.minX + cell.size) &&
+                (Y[u] >= cell.minY) && (Y[u] <= cell.minY + cell.size);
+        const unsigned count = cell.end - cell.begin;
+        if ((count > 1) && !containsU &&
+                (cell.size < m_theta * sqrt(rx * rx + ry * ry)))
+        {
+            // Far enough away to treat as a single node.  Near nodes
+            // inside the cell are (rarely) counted here as well.
+            addTerm(rx, ry, distances(u, cell.representative), count);
+        }
+        else if (cell.childCount == 0)
+        {
+            for (unsigned i = cell.begin; i < cell.end; ++i)
+            {
+                const unsigned v = nodes[i];
+                if (m_near_mark[v] != u + 1)
+                {
+                    addTerm(X[u] - X[v], Y[u] - Y[v], distances(u, v), 1);
+                }
+            }
+        }
+        else
+        {
+            for (unsigned c = cell.firstChild;
+                    c < cell.firstChild + cell.childCount; ++c)
+            {
+                m_stack.push_back(c);
+            }
+        }
+    }
+}
+
+} // namespace cola
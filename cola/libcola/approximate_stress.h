@@ -0,0 +1,119 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef COLA_APPROXIMATE_STRESS_H
+#define COLA_APPROXIMATE_STRESS_H
+
+#include <vector>
+#include <valarray>
+
+#include "libvpsc/rectangle.h"
+#include "libcola/pivot_distances.h"
+
+namespace cola {
+
+/*
+ * A point-region quadtree over the positions of a set of nodes.  Each cell
+ * records the number of nodes it holds, their centroid and a representative
+ * node (the one nearest the centroid), so that a group of distant nodes can
+ * be treated as a single weighted node.
+ */
+class QuadTree
+{
+public:
+    struct Cell
+    {
+        // Square bounds of the cell.
+        double minX, minY, size;
+        // Centroid of the nodes in the cell.
+        double cx, cy;
+        // The nodes in this cell are nodes()[begin..end).
+        unsigned begin, end;
+        unsigned representative;
+        // Children are cells()[firstChild..firstChild+childCount), or
+        // childCount is zero for a leaf.
+        unsigned firstChild, childCount;
+    };
+
+    // Rebuilds the tree for the given nodes at positions X, Y.
+    void build(const std::valarray<double>& X, const std::valarray<double>& Y,
+            const std::vector<unsigned>& nodes);
+
+    const std::vector<Cell>& cells() const { return m_cells; }
+    const std::vector<unsigned>& nodes() const { return m_nodes; }
+
+private:
+    void subdivide(const unsigned cellIndex, const unsigned depth,
+            const std::valarray<double>& X, const std::valarray<double>& Y);
+
+    std::vector<Cell> m_cells;
+    std::vector<unsigned> m_nodes;
+};
+
+/*
+ * Supports the approximate stress mode of ConstrainedFDLayout.  Terms for
+ * pairs of nodes within a given number of hops in the graph ("near" pairs)
+ * are computed exactly by the layout, while the terms for all other pairs
+ * are approximated Barnes-Hut style using a quadtree per connected
+ * component, rebuilt from the current positions each time they're needed.
+ */
+class ApproximateStress
+{
+public:
+    ApproximateStress(const std::vector<std::vector<unsigned> >& adjacency,
+            const unsigned nearHops, const double theta);
+
+    // Nodes within nearHops of u (excluding u), in increasing order.
+    const std::vector<unsigned>& nearNodes(const unsigned u) const
+    {
+        return m_near_nodes[u];
+    }
+
+    double theta(void) const { return m_theta; }
+    unsigned nearHops(void) const { return m_near_hops; }
+
+    // Rebuilds the quadtrees for the current positions.
+    void update(const std::valarray<double>& X, const std::valarray<double>& Y);
+
+    // Adds the (approximate) contributions of the pairs of u and the nodes
+    // that are not near it to the stress, the gradient g in dimension dim,
+    // and the diagonal Hessian entry Huu.
+    void addFarTerms(const unsigned u, const vpsc::Dim dim,
+            const std::valarray<double>& X, const std::valarray<double>& Y,
+            const IdealDistances& distances, double& stress, double& g,
+            double& Huu);
+
+private:
+    double m_theta;
+    unsigned m_near_hops;
+    std::vector<std::vector<unsigned> > m_near_nodes;
+    std::vector<unsigned> m_component_of;
+    std::vector<std::vector<unsigned> > m_components;
+    std::vector<QuadTree> m_trees;
+    // Marks the near nodes of the node currently being processed.
+    std::vector<unsigned> m_near_mark;
+    std::vector<unsigned> m_stack;
+};
+
+} // namespace cola
+
+#endif // COLA_APPROXIMATE_STRESS_H
@@ -20,6 +20,7 @@
  *
 */
 
+#include <algorithm>
 #include <sstream>
 
 #include "libcola/cola.h"
@@ -83,14 +84,36 @@ NonOverlapConstraints::NonOverlapConstraints(
     : CompoundConstraint(vpsc::HORIZONTAL, priority),
       pairInfoListSorted(false),
       initialSortCompleted(false),
-      m_exemptions(exemptions)
+      m_exemptions(exemptions),
+      m_useCandidatePairs(false),
+      m_currCandidate(0),
+      m_candidatePairsDone(false),
+      m_shapesAdded(0)
 {
     // All work is done by repeated addShape() calls.
 }
 
+void NonOverlapConstraints::setUseCandidatePairs(bool useCandidatePairs)
+{
+    COLA_ASSERT(shapeOffsets.empty());
+    m_useCandidatePairs = useCandidatePairs;
+}
+
 void NonOverlapConstraints::addShape(unsigned id, double halfW, double halfH,
         unsigned int group, std::set<unsigned> exemptions)
 {
+    if (m_useCandidatePairs)
+    {
+        // Pairs are found from the shape positions when needed.
+        if (!exemptions.empty())
+        {
+            m_shapeExemptions[id] = exemptions;
+        }
+        shapeOffsets[id] = OverlapShapeOffsets(id, halfW, halfH, group);
+        m_shapeAddOrder[id] = m_shapesAdded++;
+        return;
+    }
+
     // Setup pairInfos for all other shapes. 
     for (std::map<unsigned, OverlapShapeOffsets>::iterator curr =
             shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
@@ -132,12 +155,44 @@ void NonOverlapConstraints::removeShape(unsigned id)
             it++;
         }
     }
+
+    if (m_useCandidatePairs)
+    {
+        m_shapeExemptions.erase(id);
+        m_shapeAddOrder.erase(id);
+        size_t kept = 0;
+        size_t currCandidate = m_currCandidate;
+        for (size_t i = 0; i < m_candidatePairs.size(); ++i)
+        {
+            const ShapePairInfo& info = m_candidatePairs[i];
+            if (info.varIndex1 == id || info.varIndex2 == id)
+            {
+                if (i < m_currCandidate)
+                {
+                    --currCandidate;
+                }
+                continue;
+            }
+            m_candidatePairs[kept++] = info;
+        }
+        m_candidatePairs.erase(m_candidatePairs.begin() + kept,
+                m_candidatePairs.end());
+        m_currCandidate = currCandidate;
+    }
 }
 
 // This is expected to be called after all addNode calls.
 void NonOverlapConstraints::addCluster(Cluster *cluster, unsigned int group)
 {
     unsigned id = cluster->clusterVarId;
+    if (m_useCandidatePairs)
+    {
+        // Pairs are found from the shape positions when needed.
+        shapeOffsets[id] = OverlapShapeOffsets(id, cluster, group);
+        m_shapeAddOrder[id] = m_shapesAdded++;
+        return;
+    }
+
     // Setup pairInfos for all other shapes. 
     for (std::map<unsigned, OverlapShapeOffsets>::iterator curr =
             shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
@@ -179,54 +234,46 @@ void NonOverlapConstraints::generateVariables(const vpsc::Dim dim,
     COLA_UNUSED(vars);
 }
 
-void NonOverlapConstraints::computeOverlapForShapePairInfo(ShapePairInfo& info,
-        vpsc::Variables vs[])
+void NonOverlapConstraints::computeShapeBounds(unsigned id,
+        vpsc::Variables vs[], double& left, double& right, double& bottom,
+        double& top) const
 {
-    OverlapShapeOffsets& shape1 = shapeOffsets[info.varIndex1];
-    OverlapShapeOffsets& shape2 = shapeOffsets[info.varIndex2];
+    std::map<unsigned, OverlapShapeOffsets>::const_iterator found =
+            shapeOffsets.find(id);
+    COLA_ASSERT(found != shapeOffsets.end());
+    const OverlapShapeOffsets& shape = found->second;
 
-    double xPos1 = vs[0][info.varIndex1]->finalPosition;
-    double xPos2 = vs[0][info.varIndex2]->finalPosition;
-    double yPos1 = vs[1][info.varIndex1]->finalPosition;
-    double yPos2 = vs[1][info.varIndex2]->finalPosition;
+    double xPos = vs[0][id]->finalPosition;
+    double yPos = vs[1][id]->finalPosition;
 
-    double left1   = xPos1 - shape1.halfDim[0];
-    double right1  = xPos1 + shape1.halfDim[0];
-    double bottom1 = yPos1 - shape1.halfDim[1];
-    double top1    = yPos1 + shape1.halfDim[1];
+    left   = xPos - shape.halfDim[0];
+    right  = xPos + shape.halfDim[0];
+    bottom = yPos - shape.halfDim[1];
+    top    = yPos + shape.halfDim[1];
 
-    if (shape1.cluster)
+    if (shape.cluster)
     {
-        COLA_ASSERT(shape1.halfDim[0] == 0);
-        COLA_ASSERT(shape1.halfDim[1] == 0);
-        COLA_ASSERT(info.varIndex1 + 1U < vs[0].size());
-        right1 = vs[0][info.varIndex1 + 1]->finalPosition;
-        COLA_ASSERT(info.varIndex1 + 1U < vs[1].size());
-        top1    = vs[1][info.varIndex1 + 1]->finalPosition;
-        left1 -= shape1.rectPadding.min(XDIM);
-        bottom1 -= shape1.rectPadding.min(YDIM);
-        right1 += shape1.rectPadding.max(XDIM);
-        top1 += shape1.rectPadding.max(YDIM);
+        COLA_ASSERT(shape.halfDim[0] == 0);
+        COLA_ASSERT(shape.halfDim[1] == 0);
+        COLA_ASSERT(id + 1U < vs[0].size());
+        right = vs[0][id + 1]->finalPosition;
+        COLA_ASSERT(id + 1U < vs[1].size());
+        top    = vs[1][id + 1]->finalPosition;
+        left -= shape.rectPadding.min(XDIM);
+        bottom -= shape.rectPadding.min(YDIM);
+        right += shape.rectPadding.max(XDIM);
+        top += shape.rectPadding.max(YDIM);
     }
+}
 
-    double left2   = xPos2 - shape2.halfDim[0];
-    double right2  = xPos2 + shape2.halfDim[0];
-    double bottom2 = yPos2 - shape2.halfDim[1];
-    double top2    = yPos2 + shape2.halfDim[1];
+void NonOverlapConstraints::computeOverlapForShapePairInfo(ShapePairInfo& info,
+        vpsc::Variables vs[])
+{
+    double left1, right1, bottom1, top1;
+    computeShapeBounds(info.varIndex1, vs, left1, right1, bottom1, top1);
 
-    if (shape2.cluster)
-    {
-        COLA_ASSERT(shape2.halfDim[0] == 0);
-        COLA_ASSERT(shape2.halfDim[1] == 0);
-        COLA_ASSERT(info.varIndex2 + 1U < vs[0].size());
-        right2 = vs[0][info.varIndex2 + 1]->finalPosition;
-        COLA_ASSERT(info.varIndex2 + 1U < vs[1].size());
-        top2   = vs[1][info.varIndex2 + 1]->finalPosition;
-        left2 -= shape2.rectPadding.min(XDIM);
-        bottom2 -= shape2.rectPadding.min(YDIM);
-        right2 += shape2.rectPadding.max(XDIM);
-        top2 += shape2.rectPadding.max(YDIM);
-    }
+    double left2, right2, bottom2, top2;
+    computeShapeBounds(info.varIndex2, vs, left2, right2, bottom2, top2);
 
     // If lr < 0, then left edge of shape1 is on the left 
     // of right edge of shape2.
@@ -306,8 +353,161 @@ std::string NonOverlapConstraints::toString(void) const
     return stream.str();
 }
 
+// Returns whether a non-overlap constraint applies between the two shapes,
+// following the rules addShape() and addCluster() use to create pairs.
+bool NonOverlapConstraints::pairIsConstrained(unsigned id1,
+        unsigned id2) const
+{
+    const OverlapShapeOffsets& shape1 = shapeOffsets.find(id1)->second;
+    const OverlapShapeOffsets& shape2 = shapeOffsets.find(id2)->second;
+    if (shape1.group != shape2.group)
+    {
+        // Apply non-overlap only to objects in the same group (cluster).
+        return false;
+    }
+    if (shape1.cluster || shape2.cluster)
+    {
+        // Don't apply non-overlap between clusters and their child nodes,
+        // or if exempt due to non-strict cluster hierarchy.
+        if ((shape1.cluster && (shape1.cluster->nodes.count(id2) > 0)) ||
+                (shape2.cluster && (shape2.cluster->nodes.count(id1) > 0)))
+        {
+            return false;
+        }
+        return (m_cluster_cluster_exemptions.count(ShapePair(id1, id2)) == 0);
+    }
+    // addShape() only checks the exemptions of the shape being added 
+    // against those already added.
+    const bool id2Later = (m_shapeAddOrder.find(id1)->second <
+            m_shapeAddOrder.find(id2)->second);
+    std::map<unsigned, std::set<unsigned> >::const_iterator exemptions =
+            m_shapeExemptions.find(id2Later ? id2 : id1);
+    if ((exemptions != m_shapeExemptions.end()) &&
+            (exemptions->second.count(id2Later ? id1 : id2) > 0))
+    {
+        return false;
+    }
+    return !(m_exemptions &&
+            m_exemptions->shapePairIsExempt(ShapePair(id1, id2)));
+}
+
+// Orders pairs as ShapePairInfo::operator<, breaking ties in the order
+// addShape() would have created the pairs.
+static bool candidatePairLess(const ShapePairInfo& lhs,
+        const ShapePairInfo& rhs)
+{
+    if (lhs < rhs)
+    {
+        return true;
+    }
+    if (rhs < lhs)
+    {
+        return false;
+    }
+    if (lhs.varIndex2 != rhs.varIndex2)
+    {
+        return lhs.varIndex2 < rhs.varIndex2;
+    }
+    return lhs.varIndex1 < rhs.varIndex1;
+}
+
+// A shape's extent, for sweeping over shapes from left to right.
+struct SweepShape
+{
+    unsigned id;
+    double min;
+    double max;
+    double otherMin;
+    double otherMax;
+
+    bool operator<(const SweepShape& rhs) const
+    {
+        if (min != rhs.min)
+        {
+            return min < rhs.min;
+        }
+        return id < rhs.id;
+    }
+};
+
+// Finds the pairs of shapes which currently overlap and haven't been
+// processed this round, by sweeping across the shapes in order of their
+// left sides and testing each against those whose right sides haven't
+// yet been passed.
+void NonOverlapConstraints::computeCandidatePairs(vpsc::Variables vs[])
+{
+    std::vector<SweepShape> shapes;
+    shapes.reserve(shapeOffsets.size());
+    for (std::map<unsigned, OverlapShapeOffsets>::const_iterator curr =
+            shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
+    {
+        SweepShape shape;
+        shape.id = curr->first;
+        computeShapeBounds(shape.id, vs, shape.min, shape.max,
+                shape.otherMin, shape.otherMax);
+        shapes.push_back(shape);
+    }
+    std::sort(shapes.begin(), shapes.end());
+
+    m_candidatePairs.clear();
+    m_currCandidate = 0;
+    std::vector<size_t> active;
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        const SweepShape& shape = shapes[i];
+        size_t kept = 0;
+        for (size_t a = 0; a < active.size(); ++a)
+        {
+            const SweepShape& other = shapes[active[a]];
+            if (other.max <= shape.min)
+            {
+                // Ends before this and all later shapes start.
+                continue;
+            }
+            active[kept++] = active[a];
+
+            if ((other.otherMax <= shape.otherMin) ||
+                    (shape.otherMax <= other.otherMin))
+            {
+                continue;
+            }
+            if (!pairIsConstrained(other.id, shape.id) ||
+                    (m_processedPairs.count(ShapePair(other.id, shape.id)) > 0))
+            {
+                continue;
+            }
+            ShapePairInfo info(other.id, shape.id);
+            computeOverlapForShapePairInfo(info, vs);
+            if (info.overlapMax > 0)
+            {
+                m_candidatePairs.push_back(info);
+            }
+        }
+        active.resize(kept);
+        active.push_back(i);
+    }
+    std::sort(m_candidatePairs.begin(), m_candidatePairs.end(),
+            candidatePairLess);
+}
+
+ShapePairInfo& NonOverlapConstraints::currentPairInfo(void)
+{
+    if (m_useCandidatePairs)
+    {
+        COLA_ASSERT(m_currCandidate < m_candidatePairs.size());
+        return m_candidatePairs[m_currCandidate];
+    }
+    return pairInfoList.front();
+}
+
 void NonOverlapConstraints::computeAndSortOverlap(vpsc::Variables vs[])
 {
+    if (m_useCandidatePairs)
+    {
+        computeCandidatePairs(vs);
+        return;
+    }
+
     for (std::list<ShapePairInfo>::iterator curr = pairInfoList.begin();
             curr != pairInfoList.end(); ++curr)
     {
@@ -328,6 +528,15 @@ void NonOverlapConstraints::computeAndSortOverlap(vpsc::Variables vs[])
 
 void NonOverlapConstraints::markCurrSubConstraintAsActive(const bool satisfiable)
 {
+    if (m_useCandidatePairs)
+    {
+        const ShapePairInfo& info = currentPairInfo();
+        m_processedPairs.insert(ShapePair(info.varIndex1, info.varIndex2));
+        ++m_currCandidate;
+        pairInfoListSorted = false;
+        return;
+    }
+
     ShapePairInfo info = pairInfoList.front();
     pairInfoList.pop_front();
 
@@ -353,8 +562,21 @@ NonOverlapConstraints::getCurrSubConstraintAlternatives(vpsc::Variables vs[])
         initialSortCompleted = true;
     }
 
+    if (m_useCandidatePairs && (m_currCandidate == m_candidatePairs.size()))
+    {
+        if (pairInfoListSorted)
+        {
+            // No unprocessed pairs overlapped when last computed.
+            m_candidatePairsDone = true;
+            return alternatives;
+        }
+        computeAndSortOverlap(vs);
+        pairInfoListSorted = true;
+        return alternatives;
+    }
+
     // Take the first in the list.
-    ShapePairInfo& info = pairInfoList.front();
+    ShapePairInfo& info = currentPairInfo();
     if (pairInfoListSorted == false)
     {
         // Only need to compute if not sorted.
@@ -368,6 +590,7 @@ NonOverlapConstraints::getCurrSubConstraintAlternatives(vpsc::Variables vs[])
             // Seeing no overlap in the sorted list means we have solved
             // all non-overlap.  Nothing more to do.
             _currSubConstraintIndex = pairInfoList.size();
+            m_candidatePairsDone = true;
             return alternatives;
         }
         computeAndSortOverlap(vs);
@@ -489,6 +712,10 @@ NonOverlapConstraints::getCurrSubConstraintAlternatives(vpsc::Variables vs[])
 bool NonOverlapConstraints::subConstraintsRemaining(void) const
 {
     //printf(". %3d of %4d\n", _currSubConstraintIndex, pairInfoList.size());
+    if (m_useCandidatePairs)
+    {
+        return !m_candidatePairsDone && (shapeOffsets.size() > 1);
+    }
     return _currSubConstraintIndex < pairInfoList.size();
 }
 
@@ -504,6 +731,11 @@ void NonOverlapConstraints::markAllSubConstraintsAsInactive(void)
     }
     _currSubConstraintIndex = 0;
     initialSortCompleted = false;
+
+    m_candidatePairs.clear();
+    m_currCandidate = 0;
+    m_processedPairs.clear();
+    m_candidatePairsDone = false;
 }
 
 
@@ -511,78 +743,182 @@ void NonOverlapConstraints::generateSeparationConstraints(
         const vpsc::Dim dim, vpsc::Variables& vs, vpsc::Constraints& cs,
         std::vector<vpsc::Rectangle*>& boundingBoxes) 
 {
+    if (m_useCandidatePairs)
+    {
+        generateCandidateSeparationConstraints(dim, vs, cs, boundingBoxes);
+        return;
+    }
+
     for (std::list<ShapePairInfo>::iterator info = pairInfoList.begin();
             info != pairInfoList.end(); ++info)
     {
-        assertValidVariableIndex(vs, info->varIndex1);
-        assertValidVariableIndex(vs, info->varIndex2);
-        
-        OverlapShapeOffsets& shape1 = shapeOffsets[info->varIndex1];
-        OverlapShapeOffsets& shape2 = shapeOffsets[info->varIndex2];
-        
-        vpsc::Rectangle rect1 = (shape1.cluster) ?
-                shape1.cluster->bounds : *boundingBoxes[info->varIndex1];
-        vpsc::Rectangle rect2 = (shape2.cluster) ?
-                shape2.cluster->bounds : *boundingBoxes[info->varIndex2];
-
-        double pos1 = rect1.getCentreD(dim);
-        double pos2 = rect2.getCentreD(dim);
-
-        double below1 = shape1.halfDim[dim];
-        double above1 = shape1.halfDim[dim];
-        double below2 = shape2.halfDim[dim];
-        double above2 = shape2.halfDim[dim];
-
-        vpsc::Variable *varLeft1 = nullptr;
-        vpsc::Variable *varLeft2 = nullptr;
-        vpsc::Variable *varRight1 = nullptr;
-        vpsc::Variable *varRight2 = nullptr;
-        if (shape1.cluster)
-        {
-            // Must constraint to cluster boundary variables.
-            varLeft1 = vs[shape1.cluster->clusterVarId];
-            varRight1 = vs[shape1.cluster->clusterVarId + 1];
-            rect1 = shape1.cluster->margin().rectangleByApplyingBox(rect1);
-            below1 = shape1.cluster->margin().min(dim);
-            above1 = shape1.cluster->margin().max(dim);
-        }
-        else
-        {
-            // Must constrain to rectangle centre postion variable.
-            varLeft1 = varRight1 = vs[info->varIndex1];
-        }
+        generateSeparationConstraintForPair(dim, vs, cs, boundingBoxes,
+                *info);
+    }
+}
 
-        if (shape2.cluster)
-        {
-            // Must constraint to cluster boundary variables.
-            varLeft2 = vs[shape2.cluster->clusterVarId];
-            varRight2 = vs[shape2.cluster->clusterVarId + 1];
-            rect2 = shape2.cluster->margin().rectangleByApplyingBox(rect2);
-            below2 = shape2.cluster->margin().min(dim);
-            above2 = shape2.cluster->margin().max(dim);
-        }
-        else
+
+// A pair of shapes ordered as addShape() and addCluster() create pairs
+// in the all-pairs path: by when the later of the two was added, then by
+// the id of the earlier one.
+struct SeparationPair
+{
+    unsigned laterAddOrder;
+    unsigned earlierId;
+    unsigned laterId;
+
+    bool operator<(const SeparationPair& rhs) const
+    {
+        if (laterAddOrder != rhs.laterAddOrder)
         {
-            // Must constrain to rectangle centre postion variable.
-            varLeft2 = varRight2 = vs[info->varIndex2];
+            return laterAddOrder < rhs.laterAddOrder;
         }
+        return earlierId < rhs.earlierId;
+    }
+};
+
+// Generates the same constraints as for all pairs, only for those pairs
+// of shapes whose rectangles overlap in the dimension opposite to dim, as
+// found by sweeping across them.  They are generated in the order of the
+// all-pairs path's pair list as created, so the two give the same 
+// results.  That list is re-sorted by overlap once the layout starts 
+// processing pairs; this order doesn't follow it.
+void NonOverlapConstraints::generateCandidateSeparationConstraints(
+        const vpsc::Dim dim, vpsc::Variables& vs, vpsc::Constraints& cs,
+        std::vector<vpsc::Rectangle*>& boundingBoxes)
+{
+    const unsigned otherDim = !dim;
+    std::vector<SweepShape> shapes;
+    shapes.reserve(shapeOffsets.size());
+    for (std::map<unsigned, OverlapShapeOffsets>::const_iterator curr =
+            shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
+    {
+        const OverlapShapeOffsets& offsets = curr->second;
+        vpsc::Rectangle rect = (offsets.cluster) ?
+                offsets.cluster->margin().rectangleByApplyingBox(
+                        offsets.cluster->bounds) :
+                *boundingBoxes[curr->first];
+        SweepShape shape;
+        shape.id = curr->first;
+        shape.min = rect.getMinD(otherDim);
+        shape.max = rect.getMaxD(otherDim);
+        shapes.push_back(shape);
+    }
+    std::sort(shapes.begin(), shapes.end());
 
-        if (rect1.overlapD(!dim, &rect2) > 0.0005)
+    std::vector<SeparationPair> pairs;
+    std::vector<size_t> active;
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        const SweepShape& shape = shapes[i];
+        size_t kept = 0;
+        for (size_t a = 0; a < active.size(); ++a)
         {
-            vpsc::Constraint *constraint = nullptr;
-            if (pos1 < pos2)
+            const SweepShape& other = shapes[active[a]];
+            if (other.max <= shape.min)
             {
-                constraint = new vpsc::Constraint(varRight1, varLeft2,
-                             above1 + below2);
+                continue;
             }
-            else
+            active[kept++] = active[a];
+            if (pairIsConstrained(other.id, shape.id))
             {
-                constraint = new vpsc::Constraint(varRight2, varLeft1,
-                        below1 + above2);
+                const unsigned otherOrder = m_shapeAddOrder[other.id];
+                const unsigned shapeOrder = m_shapeAddOrder[shape.id];
+                SeparationPair pair;
+                pair.laterAddOrder = std::max(otherOrder, shapeOrder);
+                pair.earlierId = (otherOrder < shapeOrder) ?
+                        other.id : shape.id;
+                pair.laterId = (otherOrder < shapeOrder) ?
+                        shape.id : other.id;
+                pairs.push_back(pair);
             }
-            constraint->creator = this;
-            cs.push_back(constraint);
         }
+        active.resize(kept);
+        active.push_back(i);
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        generateSeparationConstraintForPair(dim, vs, cs, boundingBoxes,
+                ShapePairInfo(pairs[i].earlierId, pairs[i].laterId));
+    }
+}
+
+
+void NonOverlapConstraints::generateSeparationConstraintForPair(
+        const vpsc::Dim dim, vpsc::Variables& vs, vpsc::Constraints& cs,
+        std::vector<vpsc::Rectangle*>& boundingBoxes,
+        const ShapePairInfo& info)
+{
+    assertValidVariableIndex(vs, info.varIndex1);
+    assertValidVariableIndex(vs, info.varIndex2);
+    
+    OverlapShapeOffsets& shape1 = shapeOffsets[info.varIndex1];
+    OverlapShapeOffsets& shape2 = shapeOffsets[info.varIndex2];
+    
+    vpsc::Rectangle rect1 = (shape1.cluster) ?
+            shape1.cluster->bounds : *boundingBoxes[info.varIndex1];
+    vpsc::Rectangle rect2 = (shape2.cluster) ?
+            shape2.cluster->bounds : *boundingBoxes[info.varIndex2];
+
+    double pos1 = rect1.getCentreD(dim);
+    double pos2 = rect2.getCentreD(dim);
+
+    double below1 = shape1.halfDim[dim];
+    double above1 = shape1.halfDim[dim];
+    double below2 = shape2.halfDim[dim];
+    double above2 = shape2.halfDim[dim];
+
+    vpsc::Variable *varLeft1 = nullptr;
+    vpsc::Variable *varLeft2 = nullptr;
+    vpsc::Variable *varRight1 = nullptr;
+    vpsc::Variable *varRight2 = nullptr;
+    if (shape1.cluster)
+    {
+        // Must constraint to cluster boundary variables.
+        varLeft1 = vs[shape1.cluster->clusterVarId];
+        varRight1 = vs[shape1.cluster->clusterVarId + 1];
+        rect1 = shape1.cluster->margin().rectangleByApplyingBox(rect1);
+        below1 = shape1.cluster->margin().min(dim);
+        above1 = shape1.cluster->margin().max(dim);
+    }
+    else
+    {
+        // Must constrain to rectangle centre postion variable.
+        varLeft1 = varRight1 = vs[info.varIndex1];
+    }
+
+    if (shape2.cluster)
+    {
+        // Must constraint to cluster boundary variables.
+        varLeft2 = vs[shape2.cluster->clusterVarId];
+        varRight2 = vs[shape2.cluster->clusterVarId + 1];
+        rect2 = shape2.cluster->margin().rectangleByApplyingBox(rect2);
+        below2 = shape2.cluster->margin().min(dim);
+        above2 = shape2.cluster->margin().max(dim);
+    }
+    else
+    {
+        // Must constrain to rectangle centre postion variable.
+        varLeft2 = varRight2 = vs[info.varIndex2];
+    }
+
+    if (rect1.overlapD(!dim, &rect2) > 0.0005)
+    {
+        vpsc::Constraint *constraint = nullptr;
+        if (pos1 < pos2)
+        {
+            constraint = new vpsc::Constraint(varRight1, varLeft2,
+                         above1 + below2);
+        }
+        else
+        {
+            constraint = new vpsc::Constraint(varRight2, varLeft1,
+                    below1 + above2);
+        }
+        constraint->creator = this;
+        cs.push_back(constraint);
     }
 }
 
@@ -112,8 +112,8 @@ class ShapePairInfo
             return overlapMax > rhs.overlapMax;
         }
         unsigned short order;
-        unsigned short varIndex1;
-        unsigned short varIndex2;
+        unsigned varIndex1;
+        unsigned varIndex2;
         bool satisfied;
         bool processed;
         double overlapMax;
@@ -137,6 +137,21 @@ class NonOverlapConstraints : public CompoundConstraint {
     public:
         NonOverlapConstraints(NonOverlapConstraintExemptions *exemptions,
                 unsigned int priority = PRIORITY_NONOVERLAP);
+        //! @brief Use this method to only consider pairs of shapes found to
+        //!        overlap by a sweep-line over their current positions,
+        //!        rather than storing and checking every pair of shapes.
+        //!
+        //! The candidate pairs are found again each time the overlaps are
+        //! recomputed, and kept in a vector.  This takes memory and time
+        //! proportional to the number of overlapping pairs rather than
+        //! the square of the number of shapes, so should be used for large
+        //! numbers of shapes.  Pairs of shapes with equal overlap may be
+        //! resolved in a different order than by default.
+        //!
+        //! This must be called before any shapes or clusters are added.
+        //!
+        //! @param useCandidatePairs  Whether to use sweep-line candidates.
+        void setUseCandidatePairs(bool useCandidatePairs);
         //! @brief Use this method to add all the shapes between which you want
         //!        to prevent overlaps.
         //! @param id     This will be used as index into both the vars and
@@ -191,6 +206,19 @@ class NonOverlapConstraints : public CompoundConstraint {
     private:
         void computeOverlapForShapePairInfo(ShapePairInfo& info,
                 vpsc::Variables vs[]);
+        void computeShapeBounds(unsigned id, vpsc::Variables vs[],
+                double& left, double& right, double& bottom,
+                double& top) const;
+        bool pairIsConstrained(unsigned id1, unsigned id2) const;
+        void computeCandidatePairs(vpsc::Variables vs[]);
+        void generateCandidateSeparationConstraints(const vpsc::Dim dim,
+                vpsc::Variables& vs, vpsc::Constraints& cs,
+                std::vector<vpsc::Rectangle*>& boundingBoxes);
+        void generateSeparationConstraintForPair(const vpsc::Dim dim,
+                vpsc::Variables& vs, vpsc::Constraints& cs,
+                std::vector<vpsc::Rectangle*>& boundingBoxes,
+                const ShapePairInfo& info);
+        ShapePairInfo& currentPairInfo(void);
         
         std::list<ShapePairInfo> pairInfoList;
         std::map<unsigned, OverlapShapeOffsets> shapeOffsets;
@@ -204,6 +232,22 @@ class NonOverlapConstraints : public CompoundConstraint {
 
         NonOverlapConstraintExemptions *m_exemptions;
         std::set<ShapePair> m_cluster_cluster_exemptions;
+
+        // Candidate pairs mode.  The unprocessed pairs that overlapped when
+        // last computed are held sorted in m_candidatePairs, from
+        // m_currCandidate on.  Pairs processed this round aren't
+        // candidates again until markAllSubConstraintsAsInactive().
+        bool m_useCandidatePairs;
+        std::vector<ShapePairInfo> m_candidatePairs;
+        size_t m_currCandidate;
+        std::set<ShapePair> m_processedPairs;
+        bool m_candidatePairsDone;
+        std::map<unsigned, std::set<unsigned> > m_shapeExemptions;
+        // The order in which each shape or cluster was added, so the
+        // candidate pairs' separation constraints can be generated in the
+        // order the all-pairs path would have created the pairs.
+        std::map<unsigned, unsigned> m_shapeAddOrder;
+        unsigned m_shapesAdded;
 };
 
 } // namespace cola
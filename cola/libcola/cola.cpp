@@ -67,6 +67,7 @@ ConstrainedMajorizationLayout
       xSkipping(true),
       scaling(true),
       externalSolver(false),
+      warmStartProjections(false),
       majorization(true)
 {
     if (done == nullptr)
@@ -330,6 +331,8 @@ void ConstrainedMajorizationLayout::run(bool x, bool y) {
         gpY=new GradientProjection(
             VERTICAL,&lap2,tol,100,ccs,unsatisfiableY,
             avoidOverlaps,clusterHierarchy,pbb,scaling,mosek);
+        gpX->setWarmStart(warmStartProjections);
+        gpY->setWarmStart(warmStartProjections);
     }
     if(n>0) do {
         // to enforce clusters with non-intersecting, convex boundaries we
@@ -408,6 +411,8 @@ void ConstrainedMajorizationLayout::runOnce(bool x, bool y) {
         gpY=new GradientProjection(
             VERTICAL,&lap2,tol,100,ccs,unsatisfiableY,
             avoidOverlaps,clusterHierarchy,pbb,scaling,mosek);
+        gpX->setWarmStart(warmStartProjections);
+        gpY->setWarmStart(warmStartProjections);
     }
     if(n>0) {
         // to enforce clusters with non-intersecting, convex boundaries we
@@ -30,6 +30,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <memory>
 
 #include "libcola/gradient_projection.h"
 #include "libcola/cluster.h"
@@ -57,6 +58,9 @@ namespace cola {
 
 class NonOverlapConstraints;
 class NonOverlapConstraintExemptions;
+class ApproximateStress;
+class PivotDistances;
+class DynamicShortestPaths;
 
 //! @brief A vector of node Indexes.
 typedef std::vector<unsigned> NodeIndexes;
@@ -359,6 +363,16 @@ public:
     void setExternalSolver(bool externalSolver) {
         this->externalSolver=externalSolver;
     }
+    /**
+     * Says that the VPSC solver for each dimension should be kept between
+     * projections, so each one starts from the last one's block structure.
+     * This only has an effect while the constraints are the same for every
+     * projection, that is, without overlap avoidance, straightening or an
+     * external solver.  Default value is false.
+     */
+    void setWarmStartProjections(bool warmStartProjections) {
+        this->warmStartProjections=warmStartProjections;
+    }
     /**
      * At each iteration of layout, generate constraints to avoid overlaps.
      * If bool horizontal is true, all overlaps will be resolved horizontally, 
@@ -517,6 +531,7 @@ private:
      * for testing 
      */
     bool externalSolver;
+    bool warmStartProjections;
     bool majorization;
 };
 
@@ -733,6 +748,7 @@ public:
     void setClusterHierarchy(RootCluster *hierarchy)
     {
         clusterHierarchy = hierarchy;
+        m_multilevelPending = m_multilevel;
     }
     /**
      * @brief Register to receive information about unsatisfiable constraints.
@@ -819,12 +835,186 @@ public:
      */
     void setUseNeighbourStress(bool useNeighbourStress);
 
+    /**
+     * @brief  Specifies whether an approximation of the stress function
+     *         should be used, to make layout of large graphs feasible.
+     *
+     * Under approximate stress, the terms for pairs of nodes within
+     * nearHops edges of each other are computed exactly.  The terms for
+     * other pairs of nodes are approximated by grouping distant nodes
+     * using a quadtree (the Barnes-Hut method), reducing the cost of each
+     * iteration from O(n^2) to roughly O(n log n).
+     *
+     * A group of nodes is treated as a single node when the size of its
+     * quadtree cell is less than theta times its distance from the node
+     * being considered.  Smaller values are more accurate and slower, and
+     * zero gives the exact stress function.
+     *
+     * If neighbour stress is also used, only the neighbour terms are
+     * computed, without the O(n^2) loop over all pairs.
+     *
+     * Default value is false.
+     *
+     * @param[in] useApproximateStress  New boolean value for this option.
+     * @param[in] theta      The accuracy of the approximation (default: 0.5).
+     * @param[in] nearHops   The number of hops within which pairs of nodes
+     *                       are treated exactly (default: 2, minimum: 1).
+     */
+    void setUseApproximateStress(bool useApproximateStress,
+            double theta = 0.5, unsigned nearHops = 2);
+
+    /**
+     * @brief  Specifies that ideal distances between nodes should be
+     *         estimated from a number of pivot nodes, rather than stored
+     *         for every pair of nodes.
+     *
+     * By default the ideal distances are held in dense n x n matrices,
+     * which needs about 10n^2 bytes of memory.  With pivot distances,
+     * shortest path lengths are only stored from each pivot to every node
+     * and between nodes within nearHops edges of each other.  Other
+     * distances are estimated via the pivots.  This is best combined with
+     * setUseApproximateStress() for large graphs.
+     *
+     * The dense matrices are only computed when first needed, so to
+     * avoid allocating them this should be called before run(),
+     * computeStress(), readLinearD() or similar.
+     *
+     * @param[in] pivotCount  The number of pivots to use, or zero to use
+     *                        the dense matrices (the default).
+     * @param[in] nearHops    The number of hops within which distances
+     *                        are stored exactly (default: 2).
+     */
+    void setUsePivotDistances(unsigned pivotCount, unsigned nearHops = 2);
+
+    /**
+     * @brief  Adds a node to the graph of this layout, for the next run.
+     *
+     * The methods addNode(), removeNode(), addEdge() and removeEdge()
+     * change the graph of an existing layout, for applications that lay
+     * out a series of slightly different graphs.  The shortest path
+     * lengths between nodes are then kept up to date with the changes by
+     * a DynamicShortestPaths, so only the paths affected by the changes
+     * are recomputed, rather than taking O(n^2 log n) time to compute all
+     * of them again.
+     *
+     * Constraints, cluster hierarchies, non-overlap exemptions and
+     * topology addons refer to nodes by index, so are not updated by
+     * these methods; callers should set any they use again.
+     *
+     * @param[in] r  The bounding box of the new node, giving its initial
+     *               position.  As with those given to the constructor,
+     *               this is not owned by the layout.
+     * @return  The index of the new node, which is the number of nodes
+     *          the layout had before.
+     */
+    unsigned addNode(vpsc::Rectangle *r);
+
+    /**
+     * @brief  Removes a node, and all of its edges, from the graph of this
+     *         layout.
+     *
+     * The indexes of nodes after it, and of their edges, go down by one.
+     * See addNode().
+     *
+     * @param[in] i  The index of the node.
+     */
+    void removeNode(unsigned i);
+
+    /**
+     * @brief  Adds an edge to the graph of this layout.  See addNode().
+     *
+     * @param[in] e       The edge, between existing nodes.
+     * @param[in] length  The length of the edge, as a multiple of the
+     *                    ideal edge length (default: 1).
+     */
+    void addEdge(const Edge& e, double length = 1);
+
+    /**
+     * @brief  Removes an edge with the given ends and length from the graph
+     *         of this layout.  See addNode().
+     *
+     * @return  Whether there was such an edge.
+     */
+    bool removeEdge(const Edge& e, double length = 1);
+
+    /**
+     * @brief  Uses the shortest path lengths kept by another layout of the
+     *         same graph, rather than computing them.
+     *
+     * The other layout must have the same nodes, in the same order, and
+     * the same edges and edge lengths as this one.  Its shortest paths
+     * are shared with this layout until either of them is changed with
+     * addNode() and the like, so an application can keep one layout up
+     * to date with its changes and create others from it with different
+     * options.  This replaces any pivot distances, and should be called
+     * after setTopology().
+     *
+     * @param[in] other  The layout to share the shortest paths of.
+     */
+    void sharePathLengths(ConstrainedFDLayout& other);
+
+    /**
+     * @brief  Specifies that non-overlap constraints should only consider
+     *         pairs of nodes found to overlap by a sweep-line, rather than
+     *         every pair of nodes.
+     *
+     * By default a record is kept for every pair of nodes, and the overlap
+     * of every pair is computed and sorted in each projection, which
+     * takes O(n^2) memory and O(n^2 log n) time.  With this option, the
+     * overlapping pairs are found from the current node positions each
+     * time they are needed.  See
+     * NonOverlapConstraints::setUseCandidatePairs().
+     *
+     * This only has an effect if node overlaps are being avoided.
+     *
+     * Default value is false.
+     *
+     * @param[in] useCandidatePairs  New boolean value for this option.
+     */
+    void setUseNonOverlapCandidatePairs(bool useCandidatePairs);
+
+    /**
+     * @brief  Specifies whether run() should first lay out a hierarchy of
+     *         coarsened versions of the graph, to give good starting
+     *         positions for large graphs.
+     *
+     * Coarser graphs are built by repeatedly merging pairs of adjacent
+     * nodes and collapsing leaves into their neighbours.  The coarsest
+     * graph is laid out starting from the centroids of the current node
+     * positions, then each finer graph is given a few iterations starting
+     * from the positions of the graph above it, down to the full graph,
+     * which is then laid out as usual.
+     *
+     * Nodes referenced by compound constraints are never merged, so the
+     * constraints are applied to each coarser graph.  Nodes are only
+     * merged with others in the same cluster, but clusters, non-overlap,
+     * topology and desired positions are only applied to the full graph.
+     * Neighbour stress, approximate stress and pivot distances are used
+     * for the coarser graphs if they are in use.
+     *
+     * The coarser graphs are laid out by the next call of run() on both
+     * axes.  Later calls just lay out the full graph, until this, 
+     * setConstraints() or setClusterHierarchy() is called again.
+     *
+     * Default value is false.
+     *
+     * @param[in] useMultilevel   New boolean value for this option.
+     * @param[in] refinementIterations  The number of iterations for each
+     *                            level between the coarsest graph and the
+     *                            full graph (default: 10).
+     * @param[in] coarsestSize    Graphs are coarsened until they have at
+     *                            most this many nodes (default: 100).
+     */
+    void setUseMultilevel(bool useMultilevel,
+            unsigned refinementIterations = 10, unsigned coarsestSize = 100);
+
     /**
      * @brief  Retrieve a copy of the "D matrix" computed by the computePathLengths
      * method, linearised as a vector.
      *
      * This is especially useful for projects in SWIG target languages that want to
-     * do their own computations with stress.
+     * do their own computations with stress.  If pivot distances are in use
+     * this is built from the (estimated) distances on demand.
      *
      * D is the required euclidean distances between pairs of nodes
      * based on the shortest paths between them (using
@@ -856,6 +1046,13 @@ public:
      */
     std::vector<unsigned> readLinearG(void);
 
+    /**
+     * @brief  Returns the number of entries stored for the Hessian of the
+     *         stress function, which is at most n^2 and is O(kn) when
+     *         k pivot distances are used.
+     */
+    size_t hessianNonZeroCount(void);
+
     double computeStress() const;
 
 private:
@@ -875,8 +1072,18 @@ private:
             const double oldStress, 
             double stepsize
             /*,topology::TopologyConstraints *s=nullptr*/);
-    void computePathLengths(
-            const std::vector<Edge>& es, std::valarray<double> eLengths);
+    void computePathLengths(const std::vector<Edge>& es,
+            const std::valarray<double>& edgeLengths) const;
+    static std::valarray<double> positiveEdgeLengths(
+            const std::valarray<double>& eLengths);
+    void allocatePathLengths(void) const;
+    void finishPathLengths(void) const;
+    void ensurePathLengths() const;
+    void freePathLengths();
+    void ensureShortestPaths(void);
+    void beginGraphChange(void);
+    void endGraphChange(void);
+    double edgeLength(size_t i) const;
     void generateNonOverlapAndClusterCompoundConstraints(
             vpsc::Variables (&vs)[2]);
     void handleResizes(const Resizes&);
@@ -885,22 +1092,28 @@ private:
     bool noForces(double, double, unsigned) const;
     void computeForces(const vpsc::Dim dim, SparseMap &H, 
             std::valarray<double> &g);
+    void computeForces(const vpsc::Dim dim, SparseMatrix &H,
+            std::valarray<double> &g);
+    void ensureHessianPattern();
     void recGenerateClusterVariablesAndConstraints(
             vpsc::Variables (&vars)[2], unsigned int& priority, 
             cola::NonOverlapConstraints *noc, Cluster *cluster, 
             cola::CompoundConstraints& idleConstraints);
     std::vector<double> offsetDir(double minD);
+    void layoutCoarsenedGraphs(void);
 
     void computeNeighbours(std::vector<Edge> es);
-    std::vector<std::vector<unsigned> > neighbours;
+    bool areNeighbours(unsigned u, unsigned v) const;
+    std::vector<std::vector<unsigned> > adjacentNodes;
     std::vector<std::vector<double> > neighbourLengths;
     TestConvergence *done;
     bool using_default_done; // Whether we allocated a default TestConvergence object.
     PreIteration* preIteration;
     cola::CompoundConstraints ccs;
-    double** D;
-    unsigned short** G;
-    double minD;
+    // D, G and minD are computed on demand, see ensurePathLengths().
+    mutable double** D;
+    mutable unsigned short** G;
+    mutable double minD;
     PseudoRandom random;
 
     TopologyAddonInterface *topologyAddon;
@@ -913,8 +1126,29 @@ private:
     double rectClusterBuffer;
     double m_idealEdgeLength;
     bool m_generateNonOverlapConstraints;
+    bool m_useNonOverlapCandidatePairs;
+    bool m_multilevel;
+    // Whether the next run() should lay out the coarsened graphs first.
+    bool m_multilevelPending;
+    unsigned m_multilevelIterations;
+    unsigned m_multilevelCoarsestSize;
     bool m_useNeighbourStress;
-    const std::valarray<double> m_edge_lengths;
+    ApproximateStress *m_approximateStress;
+    PivotDistances *m_pivotDistances;
+    // The Hessian, whose sparsity pattern is computed once by
+    // ensureHessianPattern() and whose entries are refilled in place on
+    // each iteration.
+    SparseMatrix m_hessian;
+    bool m_hessianPatternValid;
+    // Scratch space for computeStepSize().
+    mutable std::valarray<double> m_hessianProduct;
+    std::vector<Edge> m_edges;
+    std::valarray<double> m_edge_lengths;
+    // The shortest paths between nodes, kept once the graph has been
+    // changed, or shared with another layout, and the index in them of
+    // each node.  They are copied before being changed if shared.
+    std::shared_ptr<DynamicShortestPaths> m_shortestPaths;
+    std::vector<unsigned> m_shortestPathIndexes;
 
     NonOverlapConstraintExemptions *m_nonoverlap_exemptions;
 
@@ -27,6 +27,7 @@
 #include <vector>
 #include <cmath>
 #include <limits>
+#include <mutex>
 
 #include "libvpsc/solve_VPSC.h"
 #include "libvpsc/variable.h"
@@ -40,6 +41,10 @@
 #include "libcola/straightener.h"
 #include "libcola/cc_clustercontainmentconstraints.h"
 #include "libcola/cc_nonoverlapconstraints.h"
+#include "libcola/approximate_stress.h"
+#include "libcola/pivot_distances.h"
+#include "libcola/multilevel.h"
+#include "libcola/dynamic_shortest_paths.h"
 
 #ifdef MAKEFEASIBLE_DEBUG
   #include "libcola/output_svg.h"
@@ -110,7 +115,16 @@ ConstrainedFDLayout::ConstrainedFDLayout(const vpsc::Rectangles& rs,
       rectClusterBuffer(0),
       m_idealEdgeLength(idealLength),
       m_generateNonOverlapConstraints(false),
+      m_useNonOverlapCandidatePairs(false),
+      m_multilevel(false),
+      m_multilevelPending(false),
+      m_multilevelIterations(10),
+      m_multilevelCoarsestSize(100),
       m_useNeighbourStress(false),
+      m_approximateStress(nullptr),
+      m_pivotDistances(nullptr),
+      m_hessianPatternValid(false),
+      m_edges(es),
       m_edge_lengths(eLengths.data(), eLengths.size()),
       m_nonoverlap_exemptions(new NonOverlapConstraintExemptions())
 {
@@ -125,7 +139,12 @@ ConstrainedFDLayout::ConstrainedFDLayout(const vpsc::Rectangles& rs,
     computeNeighbours(es);
 
     //FILELog::ReportingLevel() = logDEBUG1;
-    FILELog::ReportingLevel() = logERROR;
+    // Set the level once only, since layouts may be built on several
+    // threads at once.
+    static std::once_flag reportingLevelSet;
+    std::call_once(reportingLevelSet, []() {
+        FILELog::ReportingLevel() = logERROR;
+    });
     boundingBoxes = rs;
     done->reset();
     unsigned i=0;
@@ -134,23 +153,21 @@ ConstrainedFDLayout::ConstrainedFDLayout(const vpsc::Rectangles& rs,
         Y[i]=(*ri)->getCentreY();
         FILE_LOG(logDEBUG) << *ri;
     }
-    D=new double*[n];
-    G=new unsigned short*[n];
-    for(unsigned i=0;i<n;i++) {
-        D[i]=new double[n];
-        G[i]=new unsigned short[n];
-    }
-
-    computePathLengths(es,m_edge_lengths);
+    // The D and G matrices are computed when first needed, so that
+    // setUsePivotDistances() can be used to avoid allocating them.
+    D=nullptr;
+    G=nullptr;
 }
 
 std::vector<double> ConstrainedFDLayout::readLinearD(void)
 {
+    ensurePathLengths();
+    IdealDistances pathLengths(D,G,m_pivotDistances);
     std::vector<double> d;
     d.resize(n*n);
     for (unsigned i = 0; i < n; ++i) {
         for (unsigned j = 0; j < n; ++j) {
-            d[n*i + j] = D[i][j];
+            d[n*i + j] = pathLengths(i,j);
         }
     }
     return d;
@@ -158,28 +175,40 @@ std::vector<double> ConstrainedFDLayout::readLinearD(void)
 
 std::vector<unsigned> ConstrainedFDLayout::readLinearG(void)
 {
+    ensurePathLengths();
+    IdealDistances pathLengths(D,G,m_pivotDistances);
     std::vector<unsigned> g;
     g.resize(n*n);
     for (unsigned i = 0; i < n; ++i) {
         for (unsigned j = 0; j < n; ++j) {
-            g[n*i + j] = G[i][j];
+            g[n*i + j] = pathLengths.forceType(i,j);
         }
     }
     return g;
 }
 
 void ConstrainedFDLayout::computeNeighbours(vector<Edge> es) {
-    for (unsigned i = 0; i < n; ++i) {
-        neighbours.push_back(vector<unsigned>(n));
-    }
+    adjacentNodes.resize(n);
     for (vector<Edge>::iterator it = es.begin(); it!=es.end(); ++it) {
         Edge e = *it;
         unsigned s = e.first, t = e.second;
-        neighbours[s][t] = 1;
-        neighbours[t][s] = 1;
+        adjacentNodes[s].push_back(t);
+        if (s != t) {
+            adjacentNodes[t].push_back(s);
+        }
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        vector<unsigned>& adjacent = adjacentNodes[i];
+        sort(adjacent.begin(), adjacent.end());
+        adjacent.erase(unique(adjacent.begin(), adjacent.end()),
+                adjacent.end());
     }
 }
 
+bool ConstrainedFDLayout::areNeighbours(unsigned u, unsigned v) const {
+    return binary_search(adjacentNodes[u].begin(), adjacentNodes[u].end(), v);
+}
+
 void dijkstra(const unsigned s, const unsigned n, double* d,
         const vector<Edge>& es, const std::valarray<double> & eLengths)
 {
@@ -189,6 +218,7 @@ void dijkstra(const unsigned s, const unsigned n, double* d,
 void ConstrainedFDLayout::setConstraints(const cola::CompoundConstraints& ccs)
 {
     this->ccs = ccs;
+    m_multilevelPending = m_multilevel;
 }
 
 void ConstrainedFDLayout::setAvoidNodeOverlaps(bool avoidOverlaps,
@@ -198,9 +228,49 @@ void ConstrainedFDLayout::setAvoidNodeOverlaps(bool avoidOverlaps,
     m_nonoverlap_exemptions->addExemptGroupOfNodes(listOfNodeGroups);
 }
 
+void ConstrainedFDLayout::setUseNonOverlapCandidatePairs(
+        bool useCandidatePairs)
+{
+    m_useNonOverlapCandidatePairs = useCandidatePairs;
+}
+
 void ConstrainedFDLayout::setUseNeighbourStress(bool useNeighbourStress)
 {
     m_useNeighbourStress = useNeighbourStress;
+    m_hessianPatternValid = false;
+}
+
+void ConstrainedFDLayout::setUseApproximateStress(bool useApproximateStress,
+        double theta, unsigned nearHops)
+{
+    delete m_approximateStress;
+    m_approximateStress = nullptr;
+    m_hessianPatternValid = false;
+    if (useApproximateStress) {
+        m_approximateStress = new ApproximateStress(adjacentNodes,
+                max(nearHops, 1u), max(theta, 0.));
+    }
+}
+
+void ConstrainedFDLayout::setUsePivotDistances(unsigned pivotCount,
+        unsigned nearHops)
+{
+    freePathLengths();
+    if (pivotCount > 0) {
+        m_pivotDistances = new PivotDistances(n, m_edges,
+                positiveEdgeLengths(m_edge_lengths), m_idealEdgeLength,
+                pivotCount, nearHops);
+        minD = m_pivotDistances->minDistance();
+    }
+}
+
+void ConstrainedFDLayout::setUseMultilevel(bool useMultilevel,
+        unsigned refinementIterations, unsigned coarsestSize)
+{
+    m_multilevel = useMultilevel;
+    m_multilevelPending = useMultilevel;
+    m_multilevelIterations = refinementIterations;
+    m_multilevelCoarsestSize = max(coarsestSize, 2u);
 }
 
 void ConstrainedFDLayout::setDesiredPositions(DesiredPositions *desiredPositions)
@@ -225,21 +295,221 @@ void ConstrainedFDLayout::setDesiredPositions(DesiredPositions *desiredPositions
  *     a connected path between them.
  */
 void ConstrainedFDLayout::computePathLengths(
-        const vector<Edge>& es, std::valarray<double> eLengths)
+        const vector<Edge>& es, const std::valarray<double>& edgeLengths) const
 {
-    // Correct zero or negative entries in eLengths array.
-    for (size_t i = 0; i < eLengths.size(); ++i)
+    std::valarray<double> eLengths = positiveEdgeLengths(edgeLengths);
+
+    allocatePathLengths();
+    shortest_paths::johnsons(n,D,es,eLengths);
+    //dumpSquareMatrix<double>(n,D);
+    finishPathLengths();
+}
+
+// The length of edge i, as used for shortest paths.
+double ConstrainedFDLayout::edgeLength(size_t i) const
+{
+    return ((i < m_edge_lengths.size()) && (m_edge_lengths[i] > 0)) ?
+            m_edge_lengths[i] : 1;
+}
+
+// Makes sure this layout has shortest paths of its own to change, built
+// from the current graph if it had none and copied if they are shared.
+void ConstrainedFDLayout::ensureShortestPaths(void)
+{
+    if (!m_shortestPaths)
     {
-        if (eLengths[i] <= 0)
+        m_shortestPaths = std::make_shared<DynamicShortestPaths>();
+        m_shortestPathIndexes.resize(n);
+        for (unsigned i = 0; i < n; ++i)
         {
-            fprintf(stderr, "Warning: ignoring non-positive length at index %d "
-                    "in ideal edge length array.\n", (int) i);
-            eLengths[i] = 1;
+            m_shortestPathIndexes[i] = m_shortestPaths->addNode();
         }
+        for (size_t i = 0; i < m_edges.size(); ++i)
+        {
+            m_shortestPaths->addEdge(m_shortestPathIndexes[m_edges[i].first],
+                    m_shortestPathIndexes[m_edges[i].second], edgeLength(i));
+        }
+    }
+    else if (m_shortestPaths.use_count() > 1)
+    {
+        m_shortestPaths = std::make_shared<DynamicShortestPaths>(
+                *m_shortestPaths);
     }
+}
 
-    shortest_paths::johnsons(n,D,es,eLengths);
-    //dumpSquareMatrix<double>(n,D);
+// Called before the graph is changed, while n is still the old number of
+// nodes.  Pivot distances are kept, to be recomputed by endGraphChange().
+void ConstrainedFDLayout::beginGraphChange(void)
+{
+    ensureShortestPaths();
+    PivotDistances *pivotDistances = m_pivotDistances;
+    m_pivotDistances = nullptr;
+    freePathLengths();
+    m_pivotDistances = pivotDistances;
+}
+
+// Called after the graph is changed, to rebuild what depends on it.
+void ConstrainedFDLayout::endGraphChange(void)
+{
+    adjacentNodes.clear();
+    computeNeighbours(m_edges);
+    if (m_pivotDistances)
+    {
+        unsigned pivotCount = m_pivotDistances->pivots().size();
+        unsigned nearHops = m_pivotDistances->nearHops();
+        delete m_pivotDistances;
+        m_pivotDistances = nullptr;
+        setUsePivotDistances(pivotCount, nearHops);
+    }
+    if (m_approximateStress)
+    {
+        setUseApproximateStress(true, m_approximateStress->theta(),
+                m_approximateStress->nearHops());
+    }
+    m_hessianPatternValid = false;
+    m_multilevelPending = m_multilevel;
+}
+
+unsigned ConstrainedFDLayout::addNode(vpsc::Rectangle *r)
+{
+    beginGraphChange();
+    unsigned i = n++;
+    m_shortestPathIndexes.push_back(m_shortestPaths->addNode());
+    boundingBoxes.push_back(r);
+    valarray<double> x(n), y(n);
+    x[std::slice(0, i, 1)] = X;
+    y[std::slice(0, i, 1)] = Y;
+    x[i] = r->getCentreX();
+    y[i] = r->getCentreY();
+    X = x;
+    Y = y;
+    endGraphChange();
+    return i;
+}
+
+void ConstrainedFDLayout::removeNode(unsigned i)
+{
+    COLA_ASSERT(i < n);
+    beginGraphChange();
+    m_shortestPaths->removeNode(m_shortestPathIndexes[i]);
+    m_shortestPathIndexes.erase(m_shortestPathIndexes.begin() + i);
+    // Drop the node's edges, and renumber those of the nodes after it.
+    vector<Edge> edges;
+    vector<double> lengths;
+    for (size_t k = 0; k < m_edges.size(); ++k)
+    {
+        Edge e = m_edges[k];
+        if ((e.first == i) || (e.second == i))
+        {
+            continue;
+        }
+        edges.push_back(Edge((e.first > i) ? e.first - 1 : e.first,
+                (e.second > i) ? e.second - 1 : e.second));
+        if (m_edge_lengths.size() > 0)
+        {
+            lengths.push_back(m_edge_lengths[k]);
+        }
+    }
+    m_edges.swap(edges);
+    if (m_edge_lengths.size() > 0)
+    {
+        m_edge_lengths = valarray<double>(lengths.data(), lengths.size());
+    }
+    boundingBoxes.erase(boundingBoxes.begin() + i);
+    --n;
+    valarray<double> x(n), y(n);
+    for (unsigned j = 0; j < n; ++j)
+    {
+        x[j] = X[(j < i) ? j : j + 1];
+        y[j] = Y[(j < i) ? j : j + 1];
+    }
+    X = x;
+    Y = y;
+    endGraphChange();
+}
+
+void ConstrainedFDLayout::addEdge(const Edge& e, double length)
+{
+    COLA_ASSERT((e.first < n) && (e.second < n));
+    beginGraphChange();
+    if ((m_edge_lengths.size() > 0) || (length != 1))
+    {
+        // Give every edge a length, since there must be none or one each.
+        valarray<double> lengths(1.0, m_edges.size() + 1);
+        for (size_t k = 0; k < m_edge_lengths.size(); ++k)
+        {
+            lengths[k] = m_edge_lengths[k];
+        }
+        lengths[m_edges.size()] = length;
+        m_edge_lengths = lengths;
+    }
+    m_edges.push_back(e);
+    m_shortestPaths->addEdge(m_shortestPathIndexes[e.first],
+            m_shortestPathIndexes[e.second], edgeLength(m_edges.size() - 1));
+    endGraphChange();
+}
+
+bool ConstrainedFDLayout::removeEdge(const Edge& e, double length)
+{
+    if (length <= 0)
+    {
+        length = 1;
+    }
+    for (size_t k = 0; k < m_edges.size(); ++k)
+    {
+        const Edge& f = m_edges[k];
+        bool sameEnds = ((f.first == e.first) && (f.second == e.second)) ||
+                ((f.first == e.second) && (f.second == e.first));
+        if (!sameEnds || (edgeLength(k) != length))
+        {
+            continue;
+        }
+        beginGraphChange();
+        m_shortestPaths->removeEdge(m_shortestPathIndexes[f.first],
+                m_shortestPathIndexes[f.second], length);
+        m_edges.erase(m_edges.begin() + k);
+        if (m_edge_lengths.size() > 0)
+        {
+            valarray<double> lengths(m_edges.size());
+            for (size_t j = 0; j < m_edges.size(); ++j)
+            {
+                lengths[j] = m_edge_lengths[(j < k) ? j : j + 1];
+            }
+            m_edge_lengths = lengths;
+        }
+        endGraphChange();
+        return true;
+    }
+    return false;
+}
+
+void ConstrainedFDLayout::sharePathLengths(ConstrainedFDLayout& other)
+{
+    COLA_ASSERT((other.n == n) && (other.m_edges.size() == m_edges.size()));
+    if (!other.m_shortestPaths)
+    {
+        other.ensureShortestPaths();
+    }
+    freePathLengths();
+    m_shortestPaths = other.m_shortestPaths;
+    m_shortestPathIndexes = other.m_shortestPathIndexes;
+}
+
+void ConstrainedFDLayout::allocatePathLengths(void) const
+{
+    D=new double*[n];
+    G=new unsigned short*[n];
+    for(unsigned i=0;i<n;i++) {
+        D[i]=new double[n];
+        G[i]=new unsigned short[n];
+    }
+}
+
+// Given the shortest path lengths in D, in units of the edge lengths,
+// scales them by the ideal edge length and fills in G and minD.
+void ConstrainedFDLayout::finishPathLengths(void) const
+{
+    minD = DBL_MAX;
     for(unsigned i=0;i<n;i++) {
         for(unsigned j=0;j<n;j++) {
             if(i==j) continue;
@@ -260,7 +530,7 @@ void ConstrainedFDLayout::computePathLengths(
     }
     if (minD == DBL_MAX) minD = 1;
 
-    for(vector<Edge>::const_iterator e=es.begin();e!=es.end();++e) {
+    for(vector<Edge>::const_iterator e=m_edges.begin();e!=m_edges.end();++e) {
         unsigned u=e->first, v=e->second;
         G[u][v]=G[v][u]=1;
     }
@@ -268,6 +538,62 @@ void ConstrainedFDLayout::computePathLengths(
     //dumpSquareMatrix<short>(n,G);
 }
 
+// Returns a copy of eLengths with zero or negative entries corrected.
+std::valarray<double> ConstrainedFDLayout::positiveEdgeLengths(
+        const std::valarray<double>& eLengths)
+{
+    std::valarray<double> lengths = eLengths;
+    for (size_t i = 0; i < lengths.size(); ++i)
+    {
+        if (lengths[i] <= 0)
+        {
+            fprintf(stderr, "Warning: ignoring non-positive length at index %d "
+                    "in ideal edge length array.\n", (int) i);
+            lengths[i] = 1;
+        }
+    }
+    return lengths;
+}
+
+// Computes the D and G matrices if they are needed and haven't been yet.
+void ConstrainedFDLayout::ensurePathLengths() const
+{
+    if (!D && !m_pivotDistances) {
+        if (m_shortestPaths) {
+            // Only the paths changed since they were last read are
+            // recomputed.
+            allocatePathLengths();
+            for (unsigned i = 0; i < n; ++i) {
+                for (unsigned j = 0; j < n; ++j) {
+                    D[i][j] = m_shortestPaths->distance(
+                            m_shortestPathIndexes[i], m_shortestPathIndexes[j]);
+                }
+            }
+            finishPathLengths();
+        } else {
+            computePathLengths(m_edges,m_edge_lengths);
+        }
+    }
+}
+
+void ConstrainedFDLayout::freePathLengths()
+{
+    if (D) {
+        for (unsigned i = 0; i < n; ++i)
+        {
+            delete [] G[i];
+            delete [] D[i];
+        }
+        delete [] G;
+        delete [] D;
+        D = nullptr;
+        G = nullptr;
+    }
+    delete m_pivotDistances;
+    m_pivotDistances = nullptr;
+    m_hessianPatternValid = false;
+}
+
 typedef valarray<double> Position;
 void getPosition(Position& X, Position& Y, Position& pos) {
     unsigned n=X.size();
@@ -307,6 +633,200 @@ void ConstrainedFDLayout::computeDescentVectorOnBothAxes(
     getPosition(X,Y,x1);
 }
 
+// Each node is given the group of the cluster that directly contains it.
+// Nodes directly in more than one cluster are pinned.
+static void assignClusterGroups(Cluster *cluster, vector<unsigned>& groups,
+        vector<bool>& assigned, vector<bool>& pinned, unsigned& nextGroup)
+{
+    const unsigned group = nextGroup++;
+    for (set<unsigned>::const_iterator i = cluster->nodes.begin();
+            i != cluster->nodes.end(); ++i)
+    {
+        if (*i >= groups.size())
+        {
+            continue;
+        }
+        if (assigned[*i])
+        {
+            pinned[*i] = true;
+        }
+        groups[*i] = group;
+        assigned[*i] = true;
+    }
+    for (unsigned i = 0; i < cluster->clusters.size(); ++i)
+    {
+        assignClusterGroups(cluster->clusters[i], groups, assigned, pinned,
+                nextGroup);
+    }
+}
+
+/*
+ * Used by run() in multilevel mode to find starting positions, by laying
+ * out successively finer versions of the graph, starting from the coarsest.
+ */
+void ConstrainedFDLayout::layoutCoarsenedGraphs(void)
+{
+    // Nodes referenced by the compound constraints are pinned, so each
+    // has a node of its own at every level and the constraints can be
+    // applied by renumbering their variables.
+    vector<bool> pinned(n, false);
+    for (unsigned i = 0; i < ccs.size(); ++i)
+    {
+        list<unsigned> ids = ccs[i]->subConstraintObjIndexes();
+        for (list<unsigned>::const_iterator id = ids.begin();
+                id != ids.end(); ++id)
+        {
+            if (*id < n)
+            {
+                pinned[*id] = true;
+            }
+        }
+    }
+    for (unsigned dim = 0; dim < 2; ++dim)
+    {
+        vpsc::Variables vs;
+        for (unsigned i = 0; i < n; ++i)
+        {
+            vs.push_back(new vpsc::Variable(i, 0));
+        }
+        vpsc::Constraints cs;
+        generateVariablesAndConstraints(ccs, (vpsc::Dim) dim, vs, cs,
+                boundingBoxes);
+        for (unsigned i = 0; i < cs.size(); ++i)
+        {
+            if ((unsigned) cs[i]->left->id < n)
+            {
+                pinned[cs[i]->left->id] = true;
+            }
+            if ((unsigned) cs[i]->right->id < n)
+            {
+                pinned[cs[i]->right->id] = true;
+            }
+        }
+        for_each(cs.begin(), cs.end(), delete_object());
+        for_each(vs.begin(), vs.end(), delete_object());
+    }
+
+    vector<unsigned> groups(n, 0);
+    if (clusterHierarchy)
+    {
+        vector<bool> assigned(n, false);
+        unsigned nextGroup = 0;
+        assignClusterGroups(clusterHierarchy, groups, assigned, pinned,
+                nextGroup);
+    }
+
+    MultilevelHierarchy hierarchy(m_edges,
+            positiveEdgeLengths(m_edge_lengths), boundingBoxes, groups,
+            pinned, m_multilevelCoarsestSize);
+    const vector<MultilevelHierarchy::Level>& levels = hierarchy.levels();
+    if (levels.size() < 2)
+    {
+        return;
+    }
+
+    // Start the coarsest level from the centroids of the current positions,
+    // and find the node standing for each pinned node at every level.
+    valarray<double> x = X, y = Y;
+    vector<unsigned> pinnedNodes;
+    for (unsigned i = 0; i < n; ++i)
+    {
+        if (pinned[i])
+        {
+            pinnedNodes.push_back(i);
+        }
+    }
+    vector<vector<unsigned> > pinnedIndexes(levels.size(), pinnedNodes);
+    for (unsigned l = 1; l < levels.size(); ++l)
+    {
+        valarray<double> coarseX, coarseY;
+        hierarchy.restrict(l, x, y, coarseX, coarseY);
+        x.resize(coarseX.size());
+        y.resize(coarseY.size());
+        x = coarseX;
+        y = coarseY;
+        for (unsigned i = 0; i < pinnedNodes.size(); ++i)
+        {
+            pinnedIndexes[l][i] = levels[l].parent[pinnedIndexes[l - 1][i]];
+        }
+    }
+
+    for (unsigned l = levels.size() - 1; l > 0; --l)
+    {
+        const MultilevelHierarchy::Level& level = levels[l];
+        vpsc::Rectangles rs;
+        for (unsigned i = 0; i < level.size(); ++i)
+        {
+            rs.push_back(new vpsc::Rectangle(
+                    x[i] - level.width[i] / 2, x[i] + level.width[i] / 2,
+                    y[i] - level.height[i] / 2, y[i] + level.height[i] / 2));
+        }
+        EdgeLengths eLengths(level.eLengths.begin(), level.eLengths.end());
+        TestConvergence test(done->tolerance, (l == levels.size() - 1) ?
+                done->maxiterations : m_multilevelIterations);
+        ConstrainedFDLayout alg(rs, level.es, m_idealEdgeLength, eLengths,
+                &test);
+        alg.setUseNeighbourStress(m_useNeighbourStress);
+        if (m_approximateStress)
+        {
+            alg.setUseApproximateStress(true, m_approximateStress->theta(),
+                    m_approximateStress->nearHops());
+        }
+        if (m_pivotDistances)
+        {
+            alg.setUsePivotDistances(min((unsigned)
+                    m_pivotDistances->pivots().size(), level.size()),
+                    m_pivotDistances->nearHops());
+        }
+
+        VariableIDMap idMap;
+        for (unsigned i = 0; i < pinnedNodes.size(); ++i)
+        {
+            idMap.addMappingForVariable(pinnedNodes[i], pinnedIndexes[l][i]);
+        }
+        for (unsigned i = 0; i < ccs.size(); ++i)
+        {
+            ccs[i]->updateVarIDsWithMapping(idMap);
+        }
+        alg.setConstraints(ccs);
+        try
+        {
+            alg.run();
+        }
+        catch (...)
+        {
+            for (unsigned i = 0; i < ccs.size(); ++i)
+            {
+                ccs[i]->updateVarIDsWithMapping(idMap, false);
+            }
+            for_each(rs.begin(), rs.end(), delete_object());
+            throw;
+        }
+        for (unsigned i = 0; i < ccs.size(); ++i)
+        {
+            ccs[i]->updateVarIDsWithMapping(idMap, false);
+        }
+
+        for (unsigned i = 0; i < level.size(); ++i)
+        {
+            x[i] = rs[i]->getCentreX();
+            y[i] = rs[i]->getCentreY();
+        }
+        for_each(rs.begin(), rs.end(), delete_object());
+
+        valarray<double> fineX, fineY;
+        hierarchy.prolong(l, x, y, m_idealEdgeLength, fineX, fineY);
+        x.resize(fineX.size());
+        y.resize(fineY.size());
+        x = fineX;
+        y = fineY;
+    }
+
+    X = x;
+    Y = y;
+    moveBoundingBoxes();
+}
+
 /*
  * run() implements the main layout loop, taking descent steps until
  * stress is no-longer significantly reduced.
@@ -315,6 +835,12 @@ void ConstrainedFDLayout::computeDescentVectorOnBothAxes(
  */
 void ConstrainedFDLayout::run(const bool xAxis, const bool yAxis)
 {
+    if (m_multilevelPending && xAxis && yAxis)
+    {
+        m_multilevelPending = false;
+        layoutCoarsenedGraphs();
+    }
+
     // This generates constraints for non-overlap inside and outside
     // of clusters.  To assign correct variable indexes it requires
     // that vs[] contains elements equal to the number of rectangles.
@@ -579,6 +1105,7 @@ void ConstrainedFDLayout::generateNonOverlapAndClusterCompoundConstraints(
             cola::NonOverlapConstraints *noc =
                     new cola::NonOverlapConstraints(m_nonoverlap_exemptions,
                             priority);
+            noc->setUseCandidatePairs(m_useNonOverlapCandidatePairs);
             noc->setClusterClusterExemptions(
                     clusterHierarchy->m_cluster_cluster_overlap_exceptions);
             recGenerateClusterVariablesAndConstraints(vs, priority,
@@ -592,6 +1119,7 @@ void ConstrainedFDLayout::generateNonOverlapAndClusterCompoundConstraints(
         // nodes.
         cola::NonOverlapConstraints *noc =
                 new cola::NonOverlapConstraints(m_nonoverlap_exemptions);
+        noc->setUseCandidatePairs(m_useNonOverlapCandidatePairs);
         for (unsigned int i = 0; i < boundingBoxes.size(); ++i)
         {
             noc->addShape(i, boundingBoxes[i]->width() / 2,
@@ -902,15 +1430,10 @@ ConstrainedFDLayout::~ConstrainedFDLayout()
         delete done;
     }
 
-    for (unsigned i = 0; i < n; ++i)
-    {
-        delete [] G[i];
-        delete [] D[i];
-    }
-    delete [] G;
-    delete [] D;
+    freePathLengths();
     delete topologyAddon;
     delete m_nonoverlap_exemptions;
+    delete m_approximateStress;
 }
 
 void ConstrainedFDLayout::freeAssociatedObjects(void)
@@ -944,6 +1467,9 @@ void ConstrainedFDLayout::freeAssociatedObjects(void)
 void ConstrainedFDLayout::setTopology(TopologyAddonInterface *newTopology)
 {
     COLA_ASSERT(topologyAddon);
+    // The G matrix has always been computed with the topology addon given
+    // at construction, so compute it before replacing that.
+    ensurePathLengths();
     delete topologyAddon;
     topologyAddon = newTopology->clone();
 }
@@ -1129,9 +1655,9 @@ double ConstrainedFDLayout::applyForcesAndConstraints(const vpsc::Dim dim, const
         // Add non-overlap constraints, but not variables again.
         setupExtraConstraints(extraConstraints, dim, vs, cs, boundingBoxes);
         // Projection.
-        SparseMap HMap(n);
-        computeForces(dim,HMap,g);
-        SparseMatrix H(HMap);
+        ensureHessianPattern();
+        SparseMatrix& H = m_hessian;
+        computeForces(dim,H,g);
         valarray<double> oldCoords=coords;
         applyDescentVector(g,oldCoords,coords,oldStress,computeStepSize(H,g,g));
         setVariableDesiredPositions(vs,cs,des,coords);
@@ -1216,25 +1742,107 @@ std::vector<double> ConstrainedFDLayout::offsetDir(double minD)
 }
 
 
+/*
+ * Computes the sparsity pattern of the Hessian, if not already known.  The
+ * row of each node u has an entry for u and for each node v that
+ * computeForces() can find a force between u and v for, i.e., those
+ * connected to it (by G) and, if used, neighbouring it or near it under
+ * approximate stress.  With pivot distances but not approximate stress, only
+ * the pairs whose distances are exact are kept (see
+ * PivotDistances::exactPartners()), so that the pattern needs O(kn) rather
+ * than O(n^2) space, and computeForces() adds the other pairs to the
+ * diagonal only.
+ */
+void ConstrainedFDLayout::ensureHessianPattern() {
+    if(m_hessianPatternValid) return;
+    ensurePathLengths();
+    IdealDistances pathLengths(D,G,m_pivotDistances);
+    vector<unsigned> columns;
+    vector<unsigned> partners;
+    valarray<unsigned> IA(n+1);
+    for(unsigned u=0;u<n;u++) {
+        IA[u]=columns.size();
+        columns.push_back(u);
+        const vector<unsigned> *nearNodes = nullptr;
+        if (m_approximateStress) {
+            nearNodes = &m_approximateStress->nearNodes(u);
+        } else if (m_pivotDistances) {
+            partners.clear();
+            m_pivotDistances->exactPartners(u,partners);
+            sort(partners.begin(),partners.end());
+            partners.erase(unique(partners.begin(),partners.end()),partners.end());
+            nearNodes = &partners;
+        }
+        const unsigned count = (nearNodes) ? nearNodes->size() : n;
+        for(unsigned i=0;i<count;i++) {
+            unsigned v = (nearNodes) ? (*nearNodes)[i] : i;
+            if(u==v) continue;
+            if (m_useNeighbourStress && !areNeighbours(u,v)) continue;
+            if(pathLengths.forceType(u,v)==0) continue;
+            columns.push_back(v);
+        }
+        sort(columns.begin()+IA[u],columns.end());
+    }
+    IA[n]=columns.size();
+    valarray<unsigned> JA(columns.data(),columns.size());
+    m_hessian=SparseMatrix(n,IA,JA);
+    m_hessianPatternValid=true;
+}
+size_t ConstrainedFDLayout::hessianNonZeroCount() {
+    ensureHessianPattern();
+    return m_hessian.nonZeroCount();
+}
+/*
+ * As below, but with H as a SparseMap, for callers that add further terms
+ * to the Hessian outside of its usual sparsity pattern.
+ */
+void ConstrainedFDLayout::computeForces(
+        const vpsc::Dim dim,
+        SparseMap &H,
+        valarray<double> &g) {
+    ensureHessianPattern();
+    computeForces(dim,m_hessian,g);
+    for(unsigned u=0;u<n;u++) {
+        for(unsigned k=m_hessian.rowBegin(u);k<m_hessian.rowEnd(u);k++) {
+            H(u,m_hessian.columnAt(k))=m_hessian.valueAt(k);
+        }
+    }
+}
 /*
  * Computes:
  *  - the matrix of second derivatives (the Hessian) H, used in
  *    calculating stepsize; and
  *  - the vector g, the negative gradient (steepest-descent) direction.
+ * H must have the sparsity pattern set up by ensureHessianPattern().
  */
 void ConstrainedFDLayout::computeForces(
         const vpsc::Dim dim,
-        SparseMap &H,
+        SparseMatrix &H,
         valarray<double> &g) {
+    COLA_ASSERT(m_hessianPatternValid);
+    H.clear();
     if(n==1) return;
     g=0;
+    ensurePathLengths();
+    IdealDistances pathLengths(D,G,m_pivotDistances);
+    if (m_approximateStress) {
+        m_approximateStress->update(X,Y);
+    }
     // for each node:
     for(unsigned u=0;u<n;u++) {
         // Stress model
         double Huu=0;
-        for(unsigned v=0;v<n;v++) {
+        // The columns of the row increase, as v does below.
+        unsigned k=H.rowBegin(u);
+        // Under approximate stress only the near pairs are considered
+        // here, and the rest are approximated below.
+        const vector<unsigned> *nearNodes = (m_approximateStress) ?
+                &m_approximateStress->nearNodes(u) : nullptr;
+        const unsigned count = (nearNodes) ? nearNodes->size() : n;
+        for(unsigned i=0;i<count;i++) {
+            unsigned v = (nearNodes) ? (*nearNodes)[i] : i;
             if(u==v) continue;
-            if (m_useNeighbourStress && neighbours[u][v]!=1) continue;
+            if (m_useNeighbourStress && !areNeighbours(u,v)) continue;
 
             // The following loop randomly displaces nodes that are at identical positions
             double rx=X[u]-X[v], ry=Y[u]-Y[v];
@@ -1255,11 +1863,11 @@ void ConstrainedFDLayout::computeForces(
                 sd2 = rx*rx+ry*ry;
             }
 
-            unsigned short p = G[u][v];
+            unsigned short p = pathLengths.forceType(u,v);
             // no forces between disconnected parts of the graph
             if(p==0) continue;
             double l=sqrt(sd2);
-            double d=D[u][v];
+            double d=pathLengths(u,v);
             if(l>d && p>1) continue; // attractive forces not required
             double d2=d*d;
             /* force apart zero distances */
@@ -1269,9 +1877,23 @@ void ConstrainedFDLayout::computeForces(
             double dx=dim==vpsc::HORIZONTAL?rx:ry;
             double dy=dim==vpsc::HORIZONTAL?ry:rx;
             g[u]+=dx*(l-d)/(d2*l);
-            Huu-=H(u,v)=(d*dy*dy/(l*l*l)-1)/d2;
+            double Huv=(d*dy*dy/(l*l*l)-1)/d2;
+            while(k<H.rowEnd(u) && H.columnAt(k)<v) k++;
+            if(k<H.rowEnd(u) && H.columnAt(k)==v) {
+                H.valueAt(k)=Huv;
+            } else {
+                // Pairs left out of the pattern for pivot distances only
+                // contribute to the diagonal.
+                COLA_ASSERT(m_pivotDistances && !m_approximateStress);
+            }
+            Huu-=Huv;
+        }
+        if (m_approximateStress && !m_useNeighbourStress) {
+            // Far pairs only contribute to the diagonal of the Hessian.
+            double stress=0;
+            m_approximateStress->addFarTerms(u,dim,X,Y,pathLengths,stress,g[u],Huu);
         }
-        H(u,u)=Huu;
+        H.valueAt(H.find(u,u))=Huu;
     }
     if(desiredPositions) {
         for(DesiredPositions::const_iterator p=desiredPositions->begin();
@@ -1281,7 +1903,7 @@ void ConstrainedFDLayout::computeForces(
                 ?p->x-X[i]:p->y-Y[i];
             d*=p->weight;
             g[i]-=d;
-            H(i,i)+=p->weight;
+            H.valueAt(H.find(i,i))+=p->weight;
         }
     }
 }
@@ -1298,7 +1920,8 @@ double ConstrainedFDLayout::computeStepSize(
     COLA_ASSERT(g.size()==H.rowSize());
     // stepsize = g'd / (d' H d)
     double numerator = dotProd(g,d);
-    valarray<double> Hd(d.size());
+    valarray<double>& Hd = m_hessianProduct;
+    if(Hd.size()!=d.size()) Hd.resize(d.size());
     H.rightMultiply(d,Hd);
     double denominator = dotProd(d,Hd);
     //COLA_ASSERT(numerator>=0);
@@ -1314,15 +1937,27 @@ double ConstrainedFDLayout::computeStepSize(
 double ConstrainedFDLayout::computeStress() const {
     FILE_LOG(logDEBUG)<<"ConstrainedFDLayout::computeStress()";
     double stress=0;
-    for(unsigned u=0;(u + 1)<n;u++) {
-        for(unsigned v=u+1;v<n;v++) {
-            if (m_useNeighbourStress && neighbours[u][v]!=1) continue;
-            unsigned short p=G[u][v];
+    ensurePathLengths();
+    IdealDistances pathLengths(D,G,m_pivotDistances);
+    if (m_approximateStress) {
+        m_approximateStress->update(X,Y);
+    }
+    for(unsigned u=0;u<n;u++) {
+        // Under approximate stress only the near pairs are considered
+        // here, and the rest are approximated below.
+        const vector<unsigned> *nearNodes = (m_approximateStress) ?
+                &m_approximateStress->nearNodes(u) : nullptr;
+        const unsigned count = (nearNodes) ? nearNodes->size() : n;
+        for(unsigned i=(nearNodes) ? 0 : u+1;i<count;i++) {
+            unsigned v = (nearNodes) ? (*nearNodes)[i] : i;
+            if (v<=u) continue;
+            if (m_useNeighbourStress && !areNeighbours(u,v)) continue;
+            unsigned short p=pathLengths.forceType(u,v);
             // no forces between disconnected parts of the graph
             if(p==0) continue;
             double rx=X[u]-X[v], ry=Y[u]-Y[v];
             double l=sqrt(rx*rx+ry*ry);
-            double d=D[u][v];
+            double d=pathLengths(u,v);
             if(l>d && p>1) continue; // no attractive forces required
             double d2=d*d;
             double rl=d-l;
@@ -1330,6 +1965,13 @@ double ConstrainedFDLayout::computeStress() const {
             stress+=s;
             FILE_LOG(logDEBUG2)<<"s("<<u<<","<<v<<")="<<s;
         }
+        if (m_approximateStress && !m_useNeighbourStress) {
+            // Each far pair is seen from both ends, so count half of it.
+            double farStress=0, g=0, Huu=0;
+            m_approximateStress->addFarTerms(u,vpsc::HORIZONTAL,X,Y,
+                    pathLengths,farStress,g,Huu);
+            stress+=farStress/2;
+        }
     }
     if(preIteration) {
         if ((*preIteration)()) {
@@ -1385,6 +2027,8 @@ void ConstrainedFDLayout::outputInstanceToSVG(std::string instanceName)
         return;
     }
 
+    ensurePathLengths();
+    IdealDistances pathLengths(D,G,m_pivotDistances);
 
     double minX = LIMIT;
     double minY = LIMIT;
@@ -1455,7 +2099,7 @@ void ConstrainedFDLayout::outputInstanceToSVG(std::string instanceName)
     {
         for (size_t j =  i + 1; j < n; ++j)
         {
-            if (G[i][j] == 1)
+            if (pathLengths.forceType(i,j) == 1)
             {
                 fprintf(fp, "    es.push_back(std::make_pair(%lu, %lu));\n", i, j);
             }
@@ -1527,7 +2171,7 @@ void ConstrainedFDLayout::outputInstanceToSVG(std::string instanceName)
     {
         for (size_t j =  i + 1; j < n; ++j)
         {
-            if (G[i][j] == 1)
+            if (pathLengths.forceType(i,j) == 1)
             {
                 fprintf(fp, "<path d=\"M %g %g L %g %g\" "
                         "style=\"stroke-width: 1px; stroke: black;\" />\n",
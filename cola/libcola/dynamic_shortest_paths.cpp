@@ -0,0 +1,409 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+#include "libvpsc/assertions.h"
+#include "libcola/dynamic_shortest_paths.h"
+
+using std::vector;
+
+namespace cola {
+
+// Removes one entry for v with the given length from a list of neighbours.
+static bool removeNeighbour(vector<std::pair<unsigned, double> >& neighbours,
+        unsigned v, double length)
+{
+    for (size_t i = 0; i < neighbours.size(); ++i)
+    {
+        if ((neighbours[i].first == v) && (neighbours[i].second == length))
+        {
+            neighbours[i] = neighbours.back();
+            neighbours.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether the path lengths a and b are equal, allowing for rounding.
+static bool samePathLength(double a, double b)
+{
+    return fabs(a - b) <= 1e-9 * std::max(a, b);
+}
+
+DynamicShortestPaths::DynamicShortestPaths()
+    : m_edgeCount(0),
+      m_pathsComputed(0)
+{
+}
+
+unsigned DynamicShortestPaths::addNode(void)
+{
+    unsigned u;
+    if (!m_free.empty())
+    {
+        u = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        u = size();
+        m_adjacent.push_back(vector<Neighbour>());
+        m_used.push_back(false);
+        for (unsigned i = 0; i < u; ++i)
+        {
+            m_distances[i].push_back(DBL_MAX);
+        }
+        m_distances.push_back(vector<double>(u + 1, DBL_MAX));
+    }
+    m_used[u] = true;
+    m_addedNodes.push_back(u);
+    return u;
+}
+
+void DynamicShortestPaths::removeNode(unsigned u)
+{
+    COLA_ASSERT(hasNode(u));
+    while (!m_adjacent[u].empty())
+    {
+        Neighbour e = m_adjacent[u].back();
+        removeEdge(u, e.first, e.second);
+    }
+    m_used[u] = false;
+    m_removedNodes.push_back(u);
+}
+
+void DynamicShortestPaths::addEdge(unsigned u, unsigned v, double length)
+{
+    COLA_ASSERT(hasNode(u) && hasNode(v));
+    COLA_ASSERT(length > 0);
+    m_adjacent[u].push_back(Neighbour(v, length));
+    m_adjacent[v].push_back(Neighbour(u, length));
+    ++m_edgeCount;
+    ChangedEdge e = { u, v, length };
+    m_addedEdges.push_back(e);
+}
+
+bool DynamicShortestPaths::removeEdge(unsigned u, unsigned v, double length)
+{
+    if (!hasNode(u) || !hasNode(v) ||
+            !removeNeighbour(m_adjacent[u], v, length))
+    {
+        return false;
+    }
+    removeNeighbour(m_adjacent[v], u, length);
+    --m_edgeCount;
+
+    // An edge added since the last update just needs to be forgotten.
+    for (size_t i = 0; i < m_addedEdges.size(); ++i)
+    {
+        const ChangedEdge& e = m_addedEdges[i];
+        if ((e.length == length) && (((e.u == u) && (e.v == v)) ||
+                    ((e.u == v) && (e.v == u))))
+        {
+            m_addedEdges.erase(m_addedEdges.begin() + i);
+            return true;
+        }
+    }
+    ChangedEdge e = { u, v, length };
+    m_removedEdges.push_back(e);
+    return true;
+}
+
+bool DynamicShortestPaths::hasNode(unsigned u) const
+{
+    return (u < size()) && m_used[u];
+}
+
+double DynamicShortestPaths::distance(unsigned u, unsigned v) const
+{
+    COLA_ASSERT((u < size()) && (v < size()));
+    update();
+    return m_distances[u][v];
+}
+
+// Applies the changes made since the last update to m_distances.
+void DynamicShortestPaths::update(void) const
+{
+    if (m_addedEdges.empty() && m_removedEdges.empty() &&
+            m_addedNodes.empty() && m_removedNodes.empty())
+    {
+        return;
+    }
+    const unsigned n = size();
+
+    vector<bool> added(n, false);
+    for (size_t i = 0; i < m_addedNodes.size(); ++i)
+    {
+        added[m_addedNodes[i]] = true;
+    }
+    unsigned nodeCount = 0;
+    for (unsigned s = 0; s < n; ++s)
+    {
+        nodeCount += m_used[s] ? 1 : 0;
+    }
+
+    // Recompute everything if the additions would cost more than that.
+    // Repairing the rows after removals costs at most about the same.
+    const double rowCost = (m_edgeCount + nodeCount) * log2(nodeCount + 2.0);
+    const double additionCost = m_addedNodes.size() * rowCost +
+            m_addedEdges.size() * (double) nodeCount * nodeCount;
+    const bool recomputeAll = (additionCost >= nodeCount * rowCost);
+
+    if (!recomputeAll)
+    {
+        // Rows for the existing nodes are made correct for the graph
+        // without the added edges, or shorter where paths through them
+        // were found along the way, so the added edges can then be
+        // applied one at a time.
+        for (unsigned s = 0; s < n; ++s)
+        {
+            if (m_used[s] && !added[s])
+            {
+                repairRow(s);
+            }
+        }
+    }
+    for (size_t i = 0; i < m_removedNodes.size(); ++i)
+    {
+        const unsigned u = m_removedNodes[i];
+        std::fill(m_distances[u].begin(), m_distances[u].end(), DBL_MAX);
+        for (unsigned j = 0; j < n; ++j)
+        {
+            m_distances[j][u] = DBL_MAX;
+        }
+    }
+    for (unsigned s = 0; s < n; ++s)
+    {
+        if (m_used[s] && (recomputeAll || added[s]))
+        {
+            computeRow(s);
+        }
+    }
+    if (!recomputeAll)
+    {
+        for (size_t i = 0; i < m_addedEdges.size(); ++i)
+        {
+            addToMatrix(m_addedEdges[i]);
+        }
+    }
+
+    m_free.insert(m_free.end(), m_removedNodes.begin(), m_removedNodes.end());
+    m_addedEdges.clear();
+    m_removedEdges.clear();
+    m_addedNodes.clear();
+    m_removedNodes.clear();
+}
+
+// Lengthens the paths from s that used the removed edges, following
+// Ramalingam and Reps: the nodes whose every shortest path from s used a
+// removed edge are found in order of distance, then Dijkstra's algorithm
+// is run over just those nodes, starting from their other neighbours.
+void DynamicShortestPaths::repairRow(unsigned s) const
+{
+    typedef std::pair<double, unsigned> QueueEntry;
+    typedef std::priority_queue<QueueEntry, vector<QueueEntry>,
+            std::greater<QueueEntry> > Queue;
+    vector<double>& d = m_distances[s];
+    Queue queue;
+    for (size_t i = 0; i < m_removedEdges.size(); ++i)
+    {
+        const ChangedEdge& e = m_removedEdges[i];
+        if (d[e.u] == DBL_MAX)
+        {
+            continue;
+        }
+        if (samePathLength(d[e.u] + e.length, d[e.v]))
+        {
+            queue.push(QueueEntry(d[e.v], e.v));
+        }
+        if (samePathLength(d[e.v] + e.length, d[e.u]))
+        {
+            queue.push(QueueEntry(d[e.u], e.u));
+        }
+    }
+    if (queue.empty())
+    {
+        return;
+    }
+
+    const unsigned n = size();
+    vector<bool> seen(n, false), affected(n, false);
+    vector<unsigned> affectedNodes;
+    while (!queue.empty())
+    {
+        const unsigned x = queue.top().second;
+        queue.pop();
+        if (seen[x] || (x == s))
+        {
+            continue;
+        }
+        seen[x] = true;
+        const vector<Neighbour>& neighbours = m_adjacent[x];
+        bool supported = false;
+        for (size_t i = 0; (i < neighbours.size()) && !supported; ++i)
+        {
+            const unsigned y = neighbours[i].first;
+            supported = !affected[y] && (d[y] != DBL_MAX) &&
+                    samePathLength(d[y] + neighbours[i].second, d[x]);
+        }
+        if (supported)
+        {
+            continue;
+        }
+        affected[x] = true;
+        affectedNodes.push_back(x);
+        for (size_t i = 0; i < neighbours.size(); ++i)
+        {
+            const unsigned z = neighbours[i].first;
+            if (!seen[z] && (d[z] != DBL_MAX) &&
+                    samePathLength(d[x] + neighbours[i].second, d[z]))
+            {
+                queue.push(QueueEntry(d[z], z));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < affectedNodes.size(); ++i)
+    {
+        d[affectedNodes[i]] = DBL_MAX;
+    }
+    for (size_t i = 0; i < affectedNodes.size(); ++i)
+    {
+        const unsigned x = affectedNodes[i];
+        const vector<Neighbour>& neighbours = m_adjacent[x];
+        for (size_t j = 0; j < neighbours.size(); ++j)
+        {
+            const unsigned y = neighbours[j].first;
+            if (!affected[y] && (d[y] != DBL_MAX) &&
+                    (d[y] + neighbours[j].second < d[x]))
+            {
+                d[x] = d[y] + neighbours[j].second;
+            }
+        }
+        if (d[x] != DBL_MAX)
+        {
+            queue.push(QueueEntry(d[x], x));
+        }
+    }
+    while (!queue.empty())
+    {
+        QueueEntry top = queue.top();
+        queue.pop();
+        const unsigned u = top.second;
+        if (top.first > d[u])
+        {
+            continue;
+        }
+        const vector<Neighbour>& neighbours = m_adjacent[u];
+        for (size_t i = 0; i < neighbours.size(); ++i)
+        {
+            const unsigned v = neighbours[i].first;
+            const double dv = d[u] + neighbours[i].second;
+            if (affected[v] && (dv < d[v]))
+            {
+                d[v] = dv;
+                queue.push(QueueEntry(dv, v));
+            }
+        }
+    }
+    // Column s is left alone, since the other rows are repaired from
+    // their own old values, and will get the same path lengths.
+    m_pathsComputed += affectedNodes.size();
+}
+
+// Dijkstra's algorithm from s, setting both row and column s.
+void DynamicShortestPaths::computeRow(unsigned s) const
+{
+    typedef std::pair<double, unsigned> QueueEntry;
+    vector<double>& d = m_distances[s];
+    std::fill(d.begin(), d.end(), DBL_MAX);
+    std::priority_queue<QueueEntry, vector<QueueEntry>,
+            std::greater<QueueEntry> > queue;
+    d[s] = 0;
+    queue.push(QueueEntry(0, s));
+    while (!queue.empty())
+    {
+        QueueEntry top = queue.top();
+        queue.pop();
+        const unsigned u = top.second;
+        if (top.first > d[u])
+        {
+            continue;
+        }
+        const vector<Neighbour>& neighbours = m_adjacent[u];
+        for (size_t i = 0; i < neighbours.size(); ++i)
+        {
+            const unsigned v = neighbours[i].first;
+            const double dv = d[u] + neighbours[i].second;
+            if (dv < d[v])
+            {
+                d[v] = dv;
+                queue.push(QueueEntry(dv, v));
+            }
+        }
+    }
+    for (unsigned j = 0; j < size(); ++j)
+    {
+        m_distances[j][s] = d[j];
+    }
+    m_pathsComputed += size();
+}
+
+// Shortens any paths that are shorter through the edge e.
+void DynamicShortestPaths::addToMatrix(const ChangedEdge& e) const
+{
+    const unsigned n = size();
+    const vector<double> du = m_distances[e.u];
+    const vector<double> dv = m_distances[e.v];
+    for (unsigned i = 0; i < n; ++i)
+    {
+        vector<double>& d = m_distances[i];
+        if (du[i] != DBL_MAX)
+        {
+            const double toEdge = du[i] + e.length;
+            for (unsigned j = 0; j < n; ++j)
+            {
+                if ((dv[j] != DBL_MAX) && (toEdge + dv[j] < d[j]))
+                {
+                    d[j] = toEdge + dv[j];
+                }
+            }
+        }
+        if (dv[i] != DBL_MAX)
+        {
+            const double toEdge = dv[i] + e.length;
+            for (unsigned j = 0; j < n; ++j)
+            {
+                if ((du[j] != DBL_MAX) && (toEdge + du[j] < d[j]))
+                {
+                    d[j] = toEdge + du[j];
+                }
+            }
+        }
+    }
+}
+
+} // namespace cola
@@ -0,0 +1,143 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#ifndef COLA_DYNAMIC_SHORTEST_PATHS_H
+#define COLA_DYNAMIC_SHORTEST_PATHS_H
+
+#include <vector>
+#include <utility>
+
+namespace cola {
+
+/**
+ * @brief  Shortest path lengths between all pairs of nodes of a graph,
+ *         kept up to date as nodes and edges are added and removed.
+ *
+ * This is intended for applications that lay out a series of slightly
+ * different graphs, where recomputing all shortest paths for each layout
+ * would dominate the cost of setting it up.  A ConstrainedFDLayout keeps
+ * one of these up to date when its graph is changed with
+ * ConstrainedFDLayout::addNode() and the like.
+ *
+ * Nodes are identified by the index returned by addNode().  Changes are
+ * collected until the path lengths are next read, and then applied
+ * together: from each source, only the paths to nodes whose shortest
+ * paths all used a removed edge are recomputed, then each added edge is
+ * applied to the whole matrix in O(n^2) time.  If so many edges were added
+ * that this would cost more than recomputing every path, that is done
+ * instead.
+ *
+ * The graph is undirected, may have several edges between the same pair
+ * of nodes, and edge lengths must be positive.  Path lengths are in the
+ * units of the edge lengths, with DBL_MAX for nodes that are not
+ * connected.
+ */
+class DynamicShortestPaths
+{
+public:
+    DynamicShortestPaths();
+
+    /**
+     * @brief  Adds a node with no edges.
+     *
+     * @return  The index of the new node.  Indexes of removed nodes are
+     *          reused once the path lengths have been read since their
+     *          removal.
+     */
+    unsigned addNode(void);
+
+    /**
+     * @brief  Removes a node and all of its edges.
+     *
+     * @param[in] u  The index of the node.
+     */
+    void removeNode(unsigned u);
+
+    /**
+     * @brief  Adds an edge between two nodes.
+     *
+     * @param[in] u       The index of one end.
+     * @param[in] v       The index of the other end.
+     * @param[in] length  The length of the edge, which must be positive.
+     */
+    void addEdge(unsigned u, unsigned v, double length = 1);
+
+    /**
+     * @brief  Removes one edge between two nodes with the given length.
+     *
+     * @return  Whether there was such an edge.
+     */
+    bool removeEdge(unsigned u, unsigned v, double length = 1);
+
+    /**
+     * @brief  Returns whether u is the index of a node of the graph.
+     */
+    bool hasNode(unsigned u) const;
+
+    /**
+     * @brief  Returns one more than the largest node index in use, so the
+     *         size of a matrix indexed by node.
+     */
+    unsigned size(void) const { return (unsigned) m_adjacent.size(); }
+
+    /**
+     * @brief  Returns the length of the shortest path between two nodes,
+     *         or DBL_MAX if they are not connected.
+     */
+    double distance(unsigned u, unsigned v) const;
+
+    /**
+     * @brief  Returns the number of path lengths computed so far, as a
+     *         measure of the work done applying changes.
+     */
+    unsigned long pathsComputed(void) const { return m_pathsComputed; }
+
+private:
+    typedef std::pair<unsigned, double> Neighbour;
+    struct ChangedEdge
+    {
+        unsigned u, v;
+        double length;
+    };
+
+    void update(void) const;
+    void computeRow(unsigned s) const;
+    void repairRow(unsigned s) const;
+    void addToMatrix(const ChangedEdge& e) const;
+
+    std::vector<std::vector<Neighbour> > m_adjacent;
+    std::vector<bool> m_used;
+    unsigned m_edgeCount;
+
+    // The path lengths, which are brought up to date with the changes
+    // below the next time they are read.
+    mutable std::vector<std::vector<double> > m_distances;
+    mutable std::vector<ChangedEdge> m_addedEdges;
+    mutable std::vector<ChangedEdge> m_removedEdges;
+    mutable std::vector<unsigned> m_addedNodes;
+    mutable std::vector<unsigned> m_removedNodes;
+    // Indexes that can be reused by addNode().
+    mutable std::vector<unsigned> m_free;
+    mutable unsigned long m_pathsComputed;
+};
+
+} // namespace cola
+
+#endif // COLA_DYNAMIC_SHORTEST_PATHS_H
@@ -67,8 +67,10 @@ GradientProjection::GradientProjection(
           tolerance(tol), 
           max_iterations(max_iterations),
           sparseQ(nullptr),
+          solver(nullptr),
           solveWithMosek(solveWithMosek),
-          scaling(scaling)
+          scaling(scaling),
+          warmStart(false)
 {
     //printf("GP Instance: scaling=%d, mosek=%d\n",scaling,solveWithMosek);
     for(unsigned i=0;i<denseSize;i++) {
@@ -248,7 +250,9 @@ unsigned GradientProjection::solve(
 
     bool converged=false;
 
-    solver = setupVPSC();
+    if(solver==nullptr || !canKeepVPSC()) {
+        solver = setupVPSC();
+    }
 #ifdef MOSEK_AVAILABLE
     if(solveWithMosek==Outer) {
         float* ba=new float[vars.size()];
@@ -425,6 +429,7 @@ IncSolver* GradientProjection::setupVPSC() {
     return new IncSolver(vars,cs);
 }
 void GradientProjection::destroyVPSC(IncSolver *vpsc) {
+    const bool keep=canKeepVPSC();
     if(ccs) {
         for(CompoundConstraints::const_iterator c=ccs->begin(); 
                 c!=ccs->end();++c) {
@@ -456,11 +461,23 @@ void GradientProjection::destroyVPSC(IncSolver *vpsc) {
         delete *i;
     }
     lcs.clear();
+    if(keep) {
+        return;
+    }
     delete vpsc;
+    solver=nullptr;
 #ifdef MOSEK_AVAILABLE
     if(solveWithMosek!=Off) mosek_delete(menv);
 #endif
 }
+// With warmStart, the solver can be kept for the next solve() if it will be
+// given the same variables and constraints, with only new desired
+// positions.  This is not so when local constraints are generated for each
+// solve, or when straighten() adds dummy variables.
+bool GradientProjection::canKeepVPSC() const {
+    return warmStart && nonOverlapConstraints==None && solveWithMosek==Off &&
+            sparseQ==nullptr;
+}
 void GradientProjection::straighten(
     cola::SparseMatrix const * Q, 
     vector<SeparationConstraint*> const & cs,
@@ -468,6 +485,9 @@ void GradientProjection::straighten(
 {
     COLA_ASSERT(Q->rowSize()==snodes.size());
     COLA_ASSERT(vars.size()==numStaticVars);
+    // The dummy variables and their constraints need a new solver.
+    delete solver;
+    solver=nullptr;
     sparseQ = Q;
     for(unsigned i=numStaticVars;i<snodes.size();i++) {
         Variable* v=new vpsc::Variable(i,snodes[i]->pos[k],1);
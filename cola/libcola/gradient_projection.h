@@ -87,7 +87,7 @@ public:
         return numStaticVars;
     }
     ~GradientProjection() {
-        //destroyVPSC(solver);
+        delete solver;
         for(vpsc::Constraints::iterator i(gcs.begin()); i!=gcs.end(); i++) {
             delete *i;
         }
@@ -111,6 +111,18 @@ public:
     vpsc::Dim getDimension() const {
         return k;
     }
+    /**
+     * If warmStart is true, the VPSC solver is kept between calls to
+     * solve() while all the constraints are global, so each projection
+     * starts from the last one's block structure.  Default value is false.
+     */
+    void setWarmStart(bool warmStart) {
+        this->warmStart=warmStart;
+        if(!warmStart) {
+            delete solver;
+            solver=nullptr;
+        }
+    }
     void straighten(
         cola::SparseMatrix const * Q, 
         std::vector<SeparationConstraint*> const & ccs,
@@ -131,6 +143,7 @@ private:
     double computeStepSize(
         std::valarray<double> const & g, std::valarray<double> const & d) const;
     bool runSolver(std::valarray<double> & result);
+    bool canKeepVPSC() const;
     void destroyVPSC(vpsc::IncSolver *vpsc);
     vpsc::Dim k;
     unsigned numStaticVars; // number of variables that persist
@@ -156,9 +169,11 @@ private:
 #ifdef MOSEK_AVAILABLE
     MosekEnv* menv;
 #endif
+    // Kept between calls to solve() if warmStart is set.
     vpsc::IncSolver* solver;
     SolveWithMosek solveWithMosek;
     const bool scaling;
+    bool warmStart;
     std::vector<OrthogonalEdgeConstraint*> orthogonalEdges;
 };
 } // namespace cola
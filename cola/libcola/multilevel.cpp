@@ -0,0 +1,292 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "libvpsc/assertions.h"
+#include "libvpsc/rectangle.h"
+#include "libcola/multilevel.h"
+#include "libcola/pseudorandom.h"
+
+using std::valarray;
+using std::vector;
+
+namespace cola {
+
+typedef std::pair<unsigned, double> Neighbour;
+
+static const unsigned UNMERGED = UINT_MAX;
+
+MultilevelHierarchy::MultilevelHierarchy(
+        const vector<std::pair<unsigned, unsigned> >& es,
+        const valarray<double>& eLengths, const vector<vpsc::Rectangle*>& rs,
+        const vector<unsigned>& groups, const vector<bool>& pinned,
+        const unsigned coarsestSize)
+    : m_levels(1)
+{
+    const unsigned n = rs.size();
+    Level& original = m_levels[0];
+    original.es = es;
+    original.eLengths.assign(es.size(), 1);
+    for (unsigned i = 0; i < es.size() && i < eLengths.size(); ++i)
+    {
+        original.eLengths[i] = eLengths[i];
+    }
+    original.weight.assign(n, 1);
+    original.radius.assign(n, 0);
+    original.width.resize(n);
+    original.height.resize(n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        original.width[i] = rs[i]->width();
+        original.height[i] = rs[i]->height();
+    }
+    original.group = groups;
+    original.pinned = pinned;
+
+    while (m_levels.back().size() > coarsestSize)
+    {
+        Level coarse;
+        if (!coarsen(m_levels.back(), coarse))
+        {
+            break;
+        }
+        m_levels.push_back(coarse);
+    }
+}
+
+bool MultilevelHierarchy::coarsen(const Level& fine, Level& coarse) const
+{
+    const unsigned n = fine.size();
+    vector<vector<Neighbour> > adjacent(n);
+    for (unsigned i = 0; i < fine.es.size(); ++i)
+    {
+        unsigned u = fine.es[i].first, v = fine.es[i].second;
+        if (u == v)
+        {
+            continue;
+        }
+        adjacent[u].push_back(Neighbour(v, fine.eLengths[i]));
+        adjacent[v].push_back(Neighbour(u, fine.eLengths[i]));
+    }
+
+    // Visit nodes from the lowest degree, so leaves are matched first.
+    vector<unsigned> order(n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+            [&adjacent](unsigned a, unsigned b) {
+                return adjacent[a].size() < adjacent[b].size();
+            });
+
+    vector<unsigned>& parent = coarse.parent;
+    parent.assign(n, UNMERGED);
+    unsigned count = 0;
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const unsigned u = order[i];
+        if ((parent[u] != UNMERGED) || fine.pinned[u])
+        {
+            continue;
+        }
+        // Match with the lightest unmatched neighbour, then the nearest.
+        unsigned best = UNMERGED;
+        double bestLength = 0;
+        for (unsigned j = 0; j < adjacent[u].size(); ++j)
+        {
+            const unsigned v = adjacent[u][j].first;
+            const double length = adjacent[u][j].second;
+            if ((parent[v] != UNMERGED) || fine.pinned[v] ||
+                    (fine.group[v] != fine.group[u]))
+            {
+                continue;
+            }
+            if ((best == UNMERGED) || (fine.weight[v] < fine.weight[best]) ||
+                    ((fine.weight[v] == fine.weight[best]) &&
+                     ((length < bestLength) ||
+                      ((length == bestLength) && (v < best)))))
+            {
+                best = v;
+                bestLength = length;
+            }
+        }
+        if (best == UNMERGED)
+        {
+            continue;
+        }
+        parent[u] = parent[best] = count++;
+        coarse.weight.push_back(fine.weight[u] + fine.weight[best]);
+        coarse.radius.push_back(
+                (fine.radius[u] + bestLength + fine.radius[best]) / 2);
+        coarse.width.push_back(std::max(fine.width[u], fine.width[best]));
+        coarse.height.push_back(std::max(fine.height[u], fine.height[best]));
+        coarse.group.push_back(fine.group[u]);
+        coarse.pinned.push_back(false);
+    }
+
+    // Collapse leaves left unmatched, such as those around the centre of a
+    // star, into the node their neighbour was merged into.
+    for (unsigned u = 0; u < n; ++u)
+    {
+        if ((parent[u] != UNMERGED) || fine.pinned[u] ||
+                (adjacent[u].size() != 1))
+        {
+            continue;
+        }
+        const unsigned v = adjacent[u][0].first;
+        const double length = adjacent[u][0].second;
+        const unsigned p = parent[v];
+        if ((p == UNMERGED) || (fine.group[v] != fine.group[u]))
+        {
+            continue;
+        }
+        parent[u] = p;
+        coarse.weight[p] += fine.weight[u];
+        coarse.radius[p] = std::max(coarse.radius[p],
+                (coarse.radius[p] + length + fine.radius[u]) / 2);
+        coarse.width[p] = std::max(coarse.width[p], fine.width[u]);
+        coarse.height[p] = std::max(coarse.height[p], fine.height[u]);
+    }
+
+    // Everything else is carried over as it is.
+    for (unsigned u = 0; u < n; ++u)
+    {
+        if (parent[u] != UNMERGED)
+        {
+            continue;
+        }
+        parent[u] = count++;
+        coarse.weight.push_back(fine.weight[u]);
+        coarse.radius.push_back(fine.radius[u]);
+        coarse.width.push_back(fine.width[u]);
+        coarse.height.push_back(fine.height[u]);
+        coarse.group.push_back(fine.group[u]);
+        coarse.pinned.push_back(fine.pinned[u]);
+    }
+
+    if ((count <= 1) || (count > 0.8 * n))
+    {
+        // Not worth another level.
+        return false;
+    }
+
+    // Edges between the merged nodes, with the mean length of the edges
+    // they stand for, extended by the radii of their ends.
+    typedef std::pair<std::pair<unsigned, unsigned>, double> CoarseEdge;
+    vector<CoarseEdge> edges;
+    edges.reserve(fine.es.size());
+    for (unsigned i = 0; i < fine.es.size(); ++i)
+    {
+        unsigned u = parent[fine.es[i].first];
+        unsigned v = parent[fine.es[i].second];
+        if (u == v)
+        {
+            continue;
+        }
+        if (u > v)
+        {
+            std::swap(u, v);
+        }
+        edges.push_back(CoarseEdge(std::make_pair(u, v),
+                fine.eLengths[i] + coarse.radius[u] + coarse.radius[v]));
+    }
+    std::sort(edges.begin(), edges.end());
+    for (unsigned i = 0; i < edges.size(); )
+    {
+        unsigned j = i;
+        double total = 0;
+        while ((j < edges.size()) && (edges[j].first == edges[i].first))
+        {
+            total += edges[j].second;
+            ++j;
+        }
+        coarse.es.push_back(edges[i].first);
+        coarse.eLengths.push_back(total / (j - i));
+        i = j;
+    }
+    return true;
+}
+
+void MultilevelHierarchy::restrict(const unsigned l,
+        const valarray<double>& fineX, const valarray<double>& fineY,
+        valarray<double>& X, valarray<double>& Y) const
+{
+    COLA_ASSERT((l > 0) && (l < m_levels.size()));
+    const Level& level = m_levels[l];
+    X.resize(level.size());
+    Y.resize(level.size());
+    X = 0;
+    Y = 0;
+    valarray<double> count((double) 0, level.size());
+    for (unsigned i = 0; i < level.parent.size(); ++i)
+    {
+        X[level.parent[i]] += fineX[i];
+        Y[level.parent[i]] += fineY[i];
+        count[level.parent[i]] += 1;
+    }
+    X /= count;
+    Y /= count;
+}
+
+void MultilevelHierarchy::prolong(const unsigned l,
+        const valarray<double>& X, const valarray<double>& Y,
+        const double idealLength, valarray<double>& fineX,
+        valarray<double>& fineY) const
+{
+    COLA_ASSERT((l > 0) && (l < m_levels.size()));
+    const Level& level = m_levels[l];
+    const unsigned n = level.parent.size();
+
+    vector<unsigned> members(level.size(), 0);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        ++members[level.parent[i]];
+    }
+    vector<double> angle(level.size());
+    PseudoRandom random(l);
+    for (unsigned i = 0; i < level.size(); ++i)
+    {
+        angle[i] = random.getNextBetween(0, 2 * M_PI);
+    }
+
+    fineX.resize(n);
+    fineY.resize(n);
+    vector<unsigned> placed(level.size(), 0);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const unsigned p = level.parent[i];
+        fineX[i] = X[p];
+        fineY[i] = Y[p];
+        if (members[p] > 1)
+        {
+            // Spread the members evenly around a circle.
+            double a = angle[p] + 2 * M_PI * placed[p]++ / members[p];
+            double r = std::max(level.radius[p], 0.5) * idealLength;
+            fineX[i] += r * cos(a);
+            fineY[i] += r * sin(a);
+        }
+    }
+}
+
+} // namespace cola
@@ -0,0 +1,102 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef COLA_MULTILEVEL_H
+#define COLA_MULTILEVEL_H
+
+#include <vector>
+#include <valarray>
+#include <utility>
+
+namespace vpsc {
+class Rectangle;
+}
+
+namespace cola {
+
+/*
+ * A hierarchy of successively coarser versions of a graph, used by the
+ * multilevel mode of ConstrainedFDLayout.  Each level is built from the one
+ * below by matching adjacent pairs of nodes, preferring the lightest
+ * neighbour, and then collapsing unmatched leaves into their neighbour's
+ * node.  Pinned nodes are never merged with others, and nodes are only
+ * merged with nodes in the same group.
+ */
+class MultilevelHierarchy
+{
+public:
+    struct Level
+    {
+        // For each node of the level below, the node of this level it was
+        // merged into.  Empty for the original graph.
+        std::vector<unsigned> parent;
+        std::vector<std::pair<unsigned, unsigned> > es;
+        std::vector<double> eLengths;
+        // The number of original nodes merged into each node.
+        std::vector<unsigned> weight;
+        // Roughly how far the original nodes merged into each node spread
+        // from it, in units of the ideal edge length.
+        std::vector<double> radius;
+        // The largest width and height of the original nodes merged into
+        // each node.
+        std::vector<double> width;
+        std::vector<double> height;
+        std::vector<unsigned> group;
+        std::vector<bool> pinned;
+
+        unsigned size(void) const { return (unsigned) weight.size(); }
+    };
+
+    // es and eLengths as for ConstrainedFDLayout, with eLengths already
+    // corrected to be positive.  Coarsening stops once a level has at most
+    // coarsestSize nodes, or stops shrinking.
+    MultilevelHierarchy(const std::vector<std::pair<unsigned, unsigned> >& es,
+            const std::valarray<double>& eLengths,
+            const std::vector<vpsc::Rectangle*>& rs,
+            const std::vector<unsigned>& groups,
+            const std::vector<bool>& pinned, const unsigned coarsestSize);
+
+    // The original graph is level zero, followed by the coarser levels.
+    const std::vector<Level>& levels(void) const { return m_levels; }
+
+    // Sets the positions of the nodes of level l to the centroids of the
+    // nodes of level l-1 merged into them.
+    void restrict(const unsigned l, const std::valarray<double>& fineX,
+            const std::valarray<double>& fineY, std::valarray<double>& X,
+            std::valarray<double>& Y) const;
+
+    // Sets the positions of the nodes of level l-1 from those of level l.
+    // Nodes that were merged are spread around the position of the node
+    // they were merged into, in proportion to its radius.
+    void prolong(const unsigned l, const std::valarray<double>& X,
+            const std::valarray<double>& Y, const double idealLength,
+            std::valarray<double>& fineX, std::valarray<double>& fineY) const;
+
+private:
+    bool coarsen(const Level& fine, Level& coarse) const;
+
+    std::vector<Level> m_levels;
+};
+
+} // namespace cola
+
+#endif // COLA_MULTILEVEL_H
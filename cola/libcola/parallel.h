@@ -0,0 +1,97 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the 
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2014  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef COLA_PARALLEL_H
+#define COLA_PARALLEL_H
+
+#include <cstddef>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cola {
+
+/**
+ * Calls func(i) for each index i in [0, count), distributing the indices
+ * over up to threadCount threads (including the calling thread).  Indices
+ * are handed out in increasing order as threads become free, so func must
+ * not depend on the order in which the calls happen.  If any call throws,
+ * the remaining indices are skipped and the first exception is rethrown
+ * on the calling thread once all threads have finished.
+ *
+ * This is shared by libcola and libdialect.  libavoid, which does not
+ * depend on libcola, has its own version that keeps its threads between
+ * calls, ThreadPool::parallelFor() in libavoid/parallel.h.
+ */
+template <typename Func>
+void parallelFor(const size_t count, unsigned threadCount, Func func)
+{
+    if (threadCount > count) {
+        threadCount = (unsigned) count;
+    }
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextIndex(0);
+    std::exception_ptr firstException;
+    std::mutex exceptionMutex;
+
+    auto worker = [&]() {
+        try {
+            size_t i;
+            while ((i = nextIndex.fetch_add(1)) < count) {
+                func(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(exceptionMutex);
+            if (!firstException) {
+                firstException = std::current_exception();
+            }
+            // Stop other threads taking further work.
+            nextIndex.store(count);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned t = 1; t < threadCount; ++t) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+
+    if (firstException) {
+        std::rethrow_exception(firstException);
+    }
+}
+
+} // namespace cola
+
+#endif // COLA_PARALLEL_H
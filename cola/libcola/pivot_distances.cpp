@@ -0,0 +1,336 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+#include "libvpsc/assertions.h"
+#include "libcola/pivot_distances.h"
+
+using std::valarray;
+using std::vector;
+
+namespace cola {
+
+typedef std::pair<double, unsigned> QueueEntry;
+typedef std::priority_queue<QueueEntry, vector<QueueEntry>,
+        std::greater<QueueEntry> > DistanceQueue;
+
+PivotDistances::PivotDistances(const unsigned n,
+        const vector<std::pair<unsigned, unsigned> >& es,
+        const valarray<double>& eLengths, const double idealLength,
+        const unsigned pivotCount, const unsigned nearHops)
+    : m_near_hops(nearHops),
+      m_nearest_pivot(n, 0),
+      m_near_distances(n),
+      m_adjacent(n),
+      m_component_of(n, 0),
+      m_index_in_component(n, 0),
+      m_min_distance(DBL_MAX)
+{
+    COLA_ASSERT((eLengths.size() == 0) || (eLengths.size() == es.size()));
+    for (unsigned i = 0; i < es.size(); ++i)
+    {
+        const unsigned u = es[i].first, v = es[i].second;
+        COLA_ASSERT((u < n) && (v < n));
+        if (u == v)
+        {
+            continue;
+        }
+        const double d = idealLength * ((eLengths.size() > 0) ? eLengths[i] : 1);
+        m_adjacent[u].push_back(std::make_pair(v, d));
+        m_adjacent[v].push_back(std::make_pair(u, d));
+        m_min_distance = std::min(m_min_distance, d);
+    }
+    if (m_min_distance == DBL_MAX)
+    {
+        m_min_distance = 1;
+    }
+    for (unsigned u = 0; u < n; ++u)
+    {
+        std::sort(m_adjacent[u].begin(), m_adjacent[u].end());
+    }
+
+    // Connected components.
+    vector<vector<unsigned> >& components = m_components;
+    vector<bool> visited(n, false);
+    for (unsigned s = 0; s < n; ++s)
+    {
+        if (visited[s])
+        {
+            continue;
+        }
+        const unsigned component = (unsigned) components.size();
+        components.push_back(vector<unsigned>(1, s));
+        vector<unsigned>& members = components.back();
+        visited[s] = true;
+        for (unsigned i = 0; i < members.size(); ++i)
+        {
+            const unsigned u = members[i];
+            m_component_of[u] = component;
+            m_index_in_component[u] = i;
+            for (unsigned j = 0; j < m_adjacent[u].size(); ++j)
+            {
+                const unsigned v = m_adjacent[u][j].first;
+                if (!visited[v])
+                {
+                    visited[v] = true;
+                    members.push_back(v);
+                }
+            }
+        }
+    }
+
+    // Choose pivots in each component in proportion to its size, each as
+    // far as possible from the pivots already chosen there.
+    vector<double> pivotDistance(n, DBL_MAX);
+    m_component_pivots.resize(components.size());
+    for (unsigned c = 0; c < components.size(); ++c)
+    {
+        const vector<unsigned>& members = components[c];
+        if (members.size() == 1)
+        {
+            // An isolated node has no distances to estimate.
+            continue;
+        }
+        const unsigned count = std::min((unsigned) members.size(),
+                std::max(1u, (unsigned) std::ceil((double) pivotCount *
+                        members.size() / n)));
+        unsigned pivot = members[0];
+        for (unsigned k = 0; k < count; ++k)
+        {
+            const unsigned pivotIndex = (unsigned) m_pivots.size();
+            m_pivots.push_back(pivot);
+            m_component_pivots[c].push_back(pivotIndex);
+            m_pivot_rows.push_back(vector<double>());
+            vector<double>& row = m_pivot_rows.back();
+            shortestPaths(pivot, members, row);
+            for (unsigned i = 0; i < members.size(); ++i)
+            {
+                const unsigned v = members[i];
+                if (row[i] < pivotDistance[v])
+                {
+                    pivotDistance[v] = row[i];
+                    m_nearest_pivot[v] = pivotIndex;
+                }
+            }
+            for (unsigned i = 0; i < members.size(); ++i)
+            {
+                if (pivotDistance[members[i]] > pivotDistance[pivot])
+                {
+                    pivot = members[i];
+                }
+            }
+        }
+    }
+
+    // Exact distances to the nodes within nearHops of each node.  These
+    // are found by a search that stops once all of those nodes are reached.
+    vector<double> distances(n, DBL_MAX);
+    vector<unsigned> hopMark(n, 0);
+    vector<unsigned> frontier, next;
+    for (unsigned s = 0; s < n; ++s)
+    {
+        hopMark[s] = s + 1;
+        frontier.assign(1, s);
+        unsigned remaining = 0;
+        for (unsigned hop = 0; (hop < nearHops) && !frontier.empty(); ++hop)
+        {
+            next.clear();
+            for (unsigned i = 0; i < frontier.size(); ++i)
+            {
+                const vector<NodeDistance>& adjacent = m_adjacent[frontier[i]];
+                for (unsigned j = 0; j < adjacent.size(); ++j)
+                {
+                    const unsigned v = adjacent[j].first;
+                    if (hopMark[v] != s + 1)
+                    {
+                        hopMark[v] = s + 1;
+                        next.push_back(v);
+                        ++remaining;
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+
+        vector<NodeDistance>& nearDistances = m_near_distances[s];
+        vector<unsigned> touched;
+        DistanceQueue queue;
+        distances[s] = 0;
+        queue.push(QueueEntry(0, s));
+        while (!queue.empty() && (remaining > 0))
+        {
+            const QueueEntry entry = queue.top();
+            queue.pop();
+            const unsigned u = entry.second;
+            if (entry.first > distances[u])
+            {
+                continue;
+            }
+            if ((u != s) && (hopMark[u] == s + 1))
+            {
+                nearDistances.push_back(NodeDistance(u, entry.first));
+                --remaining;
+            }
+            const vector<NodeDistance>& adjacent = m_adjacent[u];
+            for (unsigned j = 0; j < adjacent.size(); ++j)
+            {
+                const unsigned v = adjacent[j].first;
+                const double d = entry.first + adjacent[j].second;
+                if (d < distances[v])
+                {
+                    if (distances[v] == DBL_MAX)
+                    {
+                        touched.push_back(v);
+                    }
+                    distances[v] = d;
+                    queue.push(QueueEntry(d, v));
+                }
+            }
+        }
+        // Reset the distances touched by this search.
+        distances[s] = DBL_MAX;
+        for (unsigned i = 0; i < touched.size(); ++i)
+        {
+            distances[touched[i]] = DBL_MAX;
+        }
+        std::sort(nearDistances.begin(), nearDistances.end());
+    }
+}
+
+// Dijkstra's algorithm from source, setting row to the distances to each
+// of the members of its connected component.
+void PivotDistances::shortestPaths(const unsigned source,
+        const vector<unsigned>& members, vector<double>& row) const
+{
+    row.assign(members.size(), DBL_MAX);
+    vector<bool> done(members.size(), false);
+    row[m_index_in_component[source]] = 0;
+    DistanceQueue queue;
+    queue.push(QueueEntry(0, source));
+    while (!queue.empty())
+    {
+        const QueueEntry entry = queue.top();
+        queue.pop();
+        const unsigned u = entry.second;
+        if (done[m_index_in_component[u]])
+        {
+            continue;
+        }
+        done[m_index_in_component[u]] = true;
+        const vector<NodeDistance>& adjacent = m_adjacent[u];
+        for (unsigned j = 0; j < adjacent.size(); ++j)
+        {
+            const unsigned vi = m_index_in_component[adjacent[j].first];
+            const double d = entry.first + adjacent[j].second;
+            if (d < row[vi])
+            {
+                row[vi] = d;
+                queue.push(QueueEntry(d, adjacent[j].first));
+            }
+        }
+    }
+}
+
+double PivotDistances::distance(const unsigned u, const unsigned v) const
+{
+    if (u == v)
+    {
+        return 0;
+    }
+    if (m_component_of[u] != m_component_of[v])
+    {
+        return DBL_MAX;
+    }
+
+    const vector<NodeDistance>& nearDistances = m_near_distances[u];
+    vector<NodeDistance>::const_iterator it = std::lower_bound(
+            nearDistances.begin(), nearDistances.end(),
+            NodeDistance(v, -DBL_MAX));
+    if ((it != nearDistances.end()) && (it->first == v))
+    {
+        return it->second;
+    }
+
+    const vector<double>& uRow = m_pivot_rows[m_nearest_pivot[u]];
+    const vector<double>& vRow = m_pivot_rows[m_nearest_pivot[v]];
+    const unsigned ui = m_index_in_component[u];
+    const unsigned vi = m_index_in_component[v];
+    if (uRow[ui] == 0)
+    {
+        // u is a pivot, so the distance is known exactly.
+        return uRow[vi];
+    }
+    if (vRow[vi] == 0)
+    {
+        return vRow[ui];
+    }
+    // Paths via either pivot give upper bounds and the triangle inequality
+    // gives lower bounds.  Take the mean of the distances from each node to
+    // the other's pivot, kept within those bounds.
+    const double lower = std::max(std::fabs(uRow[ui] - uRow[vi]),
+            std::fabs(vRow[ui] - vRow[vi]));
+    const double upper = std::min(uRow[ui] + uRow[vi], vRow[ui] + vRow[vi]);
+    return std::min(upper, std::max(lower, (uRow[vi] + vRow[ui]) / 2));
+}
+
+void PivotDistances::exactPartners(const unsigned u,
+        vector<unsigned>& partners) const
+{
+    const vector<NodeDistance>& nearDistances = m_near_distances[u];
+    for (unsigned i = 0; i < nearDistances.size(); ++i)
+    {
+        partners.push_back(nearDistances[i].first);
+    }
+    const unsigned component = m_component_of[u];
+    const vector<unsigned>& componentPivots = m_component_pivots[component];
+    for (unsigned i = 0; i < componentPivots.size(); ++i)
+    {
+        const unsigned pivot = m_pivots[componentPivots[i]];
+        if (pivot == u)
+        {
+            const vector<unsigned>& members = m_components[component];
+            partners.insert(partners.end(), members.begin(), members.end());
+        }
+        else
+        {
+            partners.push_back(pivot);
+        }
+    }
+}
+
+unsigned short PivotDistances::forceType(const unsigned u,
+        const unsigned v) const
+{
+    if ((u == v) || (m_component_of[u] != m_component_of[v]))
+    {
+        return 0;
+    }
+    const vector<NodeDistance>& adjacent = m_adjacent[u];
+    vector<NodeDistance>::const_iterator it = std::lower_bound(
+            adjacent.begin(), adjacent.end(), NodeDistance(v, -DBL_MAX));
+    return ((it != adjacent.end()) && (it->first == v)) ? 1 : 2;
+}
+
+} // namespace cola
@@ -0,0 +1,132 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef COLA_PIVOT_DISTANCES_H
+#define COLA_PIVOT_DISTANCES_H
+
+#include <vector>
+#include <valarray>
+#include <utility>
+
+namespace cola {
+
+/*
+ * A compact store of the ideal distances between nodes, used instead of
+ * the dense D and G matrices of ConstrainedFDLayout for large graphs.
+ *
+ * Shortest path lengths are kept from a number of pivot nodes to every
+ * node in the same connected component, along with the exact path lengths
+ * between each node and the nodes within a given number of hops of it.
+ * Pivots are shared between components in proportion to their size and
+ * chosen greedily, each as far as possible from the previous ones.  Other
+ * distances are estimated by going via the pivot nearest either node, so
+ * the memory used is O(k n) rather than O(n^2) for k pivots.
+ */
+class PivotDistances
+{
+public:
+    // es and eLengths as for ConstrainedFDLayout, with eLengths already
+    // corrected to be positive.  Distances are scaled by idealLength.
+    PivotDistances(const unsigned n,
+            const std::vector<std::pair<unsigned, unsigned> >& es,
+            const std::valarray<double>& eLengths, const double idealLength,
+            const unsigned pivotCount, const unsigned nearHops);
+
+    // The (estimated) ideal distance between u and v, or DBL_MAX if they
+    // are in different connected components.
+    double distance(const unsigned u, const unsigned v) const;
+
+    // The value of G[u][v], as described for ConstrainedFDLayout.
+    unsigned short forceType(const unsigned u, const unsigned v) const;
+
+    // The smallest positive distance between any pair of nodes.
+    double minDistance(void) const { return m_min_distance; }
+
+    const std::vector<unsigned>& pivots(void) const { return m_pivots; }
+
+    unsigned nearHops(void) const { return m_near_hops; }
+
+    // Appends to partners the nodes whose distance from u is known exactly:
+    // those near u, the pivots of u's component and, if u is a pivot, the
+    // rest of its component.  There are O(n) such pairs for each pivot, so
+    // O(kn) in all.  Some nodes may be appended more than once.
+    void exactPartners(const unsigned u, std::vector<unsigned>& partners) const;
+
+private:
+    typedef std::pair<unsigned, double> NodeDistance;
+
+    void shortestPaths(const unsigned source,
+            const std::vector<unsigned>& members,
+            std::vector<double>& row) const;
+
+    std::vector<unsigned> m_pivots;
+    unsigned m_near_hops;
+    // Row i holds the distances from m_pivots[i] to every node in its
+    // connected component, indexed by m_index_in_component.
+    std::vector<std::vector<double> > m_pivot_rows;
+    // For each node, the index of its nearest pivot in m_pivots.
+    std::vector<unsigned> m_nearest_pivot;
+    // For each node, exact distances to nearby nodes, sorted by node.
+    std::vector<std::vector<NodeDistance> > m_near_distances;
+    // For each node, its neighbours and the edge lengths to them.
+    std::vector<std::vector<NodeDistance> > m_adjacent;
+    std::vector<unsigned> m_component_of;
+    // The members of each connected component, in the order of
+    // m_index_in_component, and the indexes in m_pivots of its pivots.
+    std::vector<std::vector<unsigned> > m_components;
+    std::vector<std::vector<unsigned> > m_component_pivots;
+    std::vector<unsigned> m_index_in_component;
+    double m_min_distance;
+};
+
+/*
+ * Provides the entries of the D and G matrices of ConstrainedFDLayout from
+ * whichever of the dense matrices or a PivotDistances store is in use.
+ */
+struct IdealDistances
+{
+    IdealDistances(double **D, unsigned short **G,
+            const PivotDistances *pivots)
+        : D(D),
+          G(G),
+          pivots(pivots)
+    {
+    }
+
+    double operator()(const unsigned u, const unsigned v) const
+    {
+        return (D) ? D[u][v] : pivots->distance(u, v);
+    }
+
+    unsigned short forceType(const unsigned u, const unsigned v) const
+    {
+        return (G) ? G[u][v] : pivots->forceType(u, v);
+    }
+
+    double **D;
+    unsigned short **G;
+    const PivotDistances *pivots;
+};
+
+} // namespace cola
+
+#endif // COLA_PIVOT_DISTANCES_H
@@ -29,8 +29,12 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <queue>
+#include <functional>
+#include <thread>
 
 #include "libcola/commondefs.h"
+#include "libcola/parallel.h"
 #include <libvpsc/pairing_heap.h>
 #include <libvpsc/assertions.h>
 
@@ -84,15 +88,21 @@ void floyd_warshall(unsigned const n, T** D, std::vector<Edge> const & es,
         std::valarray<T> const & eweights = std::valarray<T>()); 
 
 /**
- * find all pairs shortest paths, faster, uses dijkstra
+ * find all pairs shortest paths, faster, uses dijkstra from each node.
+ * The searches from different sources are independent, so they are
+ * shared between a number of threads, each writing whole rows of D.
+ * The result doesn't depend on the number of threads used.
  * @param n total number of nodes
  * @param D n*n matrix of shortest paths
  * @param es edge pairs
  * @param eweights edge weights, if empty then all weights will be taken as 1
+ * @param threadCount number of threads to use (including the calling
+ *        thread), or 0 to choose based on the hardware and graph size
  */
 template <typename T>
 void johnsons(unsigned const n, T** D, std::vector<Edge> const & es,
-        std::valarray<T> const & eweights = std::valarray<T>());
+        std::valarray<T> const & eweights = std::valarray<T>(),
+        unsigned threadCount = 0);
 /**
  * find shortest path lengths from node s to all other nodes
  * @param s starting node
@@ -227,18 +237,109 @@ void dijkstra(
     dijkstra(s,vs,d);
 }
 
+// Adjacency lists of an undirected graph in compressed sparse row form:
+// the neighbours of node u are targets[offsets[u]..offsets[u+1]), with
+// the corresponding edge weights in weights.
+template <typename T>
+struct CSRGraph {
+    CSRGraph(unsigned const n, std::vector<Edge> const & es,
+            std::valarray<T> const & eweights)
+        : offsets(n+1,0), targets(2*es.size()), weights(2*es.size())
+    {
+        COLA_ASSERT((eweights.size() == 0) || (eweights.size() == es.size()));
+        for(unsigned i=0;i<es.size();i++) {
+            unsigned u=es[i].first, v=es[i].second;
+            COLA_ASSERT(u<n);
+            COLA_ASSERT(v<n);
+            offsets[u+1]++;
+            offsets[v+1]++;
+        }
+        for(unsigned i=0;i<n;i++) {
+            offsets[i+1]+=offsets[i];
+        }
+        // Fill in edge order, as dijkstra_init() does.
+        std::vector<unsigned> next(offsets.begin(),offsets.end()-1);
+        for(unsigned i=0;i<es.size();i++) {
+            unsigned u=es[i].first, v=es[i].second;
+            T w = (eweights.size() > 0) ? eweights[i] : 1;
+            targets[next[u]]=v;
+            weights[next[u]++]=w;
+            targets[next[v]]=u;
+            weights[next[v]++]=w;
+        }
+    }
+    std::vector<unsigned> offsets;
+    std::vector<unsigned> targets;
+    std::vector<T> weights;
+};
+
+// Dijkstra's algorithm from s over g, writing the path lengths to d.  Uses
+// a binary heap with lazy deletion, queue is scratch space.  Each d[v] is
+// the minimum of d[u]+w over neighbours u with d[u] <= d[v], whatever the
+// order of ties in the heap, so the results are bit-identical to those of
+// the pairing heap version above.
+template <typename T>
+void dijkstra(
+        unsigned const s,
+        CSRGraph<T> const & g,
+        T* d,
+        std::vector<std::pair<T,unsigned> > & queue)
+{
+    typedef std::pair<T,unsigned> Entry;
+    const unsigned n=g.offsets.size()-1;
+    for(unsigned i=0;i<n;i++) {
+        d[i]=std::numeric_limits<T>::max();
+    }
+    d[s]=0;
+    queue.clear();
+    queue.push_back(Entry(0,s));
+    std::greater<Entry> compare;
+    while(!queue.empty()) {
+        std::pop_heap(queue.begin(),queue.end(),compare);
+        const Entry top=queue.back();
+        queue.pop_back();
+        const unsigned u=top.second;
+        if(top.first>d[u]) {
+            // Stale entry, u was already reached by a shorter path.
+            continue;
+        }
+        for(unsigned i=g.offsets[u];i<g.offsets[u+1];i++) {
+            const unsigned v=g.targets[i];
+            const T dv=d[u]+g.weights[i];
+            if(d[v] > dv) {
+                d[v]=dv;
+                queue.push_back(Entry(dv,v));
+                std::push_heap(queue.begin(),queue.end(),compare);
+            }
+        }
+    }
+}
+
 template <typename T>
 void johnsons(
         unsigned const n,
         T** D, 
         std::vector<Edge> const & es,
-        std::valarray<T> const & eweights) 
+        std::valarray<T> const & eweights,
+        unsigned threadCount) 
 {
-    std::vector<Node<T> > vs(n);
-    dijkstra_init(vs,es,eweights);
-    for(unsigned k=0;k<n;k++) {
-        dijkstra(k,vs,D[k]);
+    const CSRGraph<T> g(n,es,eweights);
+    if(threadCount==0) {
+        // Only use extra threads when there is enough work to share.
+        threadCount=std::max(std::thread::hardware_concurrency(),1u);
+        threadCount=std::min(threadCount,std::max(n/64,1u));
     }
+
+    // Sources are handed out in small batches as threads become free.
+    const unsigned batchSize=8;
+    cola::parallelFor((n+batchSize-1)/batchSize,threadCount,
+            [&](const size_t batch) {
+        std::vector<std::pair<T,unsigned> > queue;
+        const unsigned end=std::min((unsigned)batch*batchSize+batchSize,n);
+        for(unsigned k=batch*batchSize;k<end;k++) {
+            dijkstra(k,g,D[k],queue);
+        }
+    });
 }
 
 } //namespace shortest_paths
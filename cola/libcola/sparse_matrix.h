@@ -83,8 +83,11 @@ struct SparseMap {
  */
 class SparseMatrix {
 public:
+    SparseMatrix() : n(0), NZ(0), IA(std::valarray<unsigned>(1)) {
+        IA[0]=0;
+    }
     SparseMatrix(SparseMap const & m)
-            : n(m.n), NZ((unsigned)m.nonZeroCount()), sparseMap(m), 
+            : n(m.n), NZ((unsigned)m.nonZeroCount()),
               A(std::valarray<double>(NZ)), IA(std::valarray<unsigned>(n+1)), JA(std::valarray<unsigned>(NZ)) {
         unsigned cnt=0;
         int lastrow=-1;
@@ -106,6 +109,19 @@ public:
             IA[r]=NZ;
         }
     }
+    /*
+     * Creates a matrix with a fixed sparsity pattern, given by IA and JA as
+     * above with the columns of each row in increasing order, and all
+     * entries zero.  The entries can then be refilled in place, through
+     * clear() and valueAt(), without any allocation.
+     */
+    SparseMatrix(const unsigned n, std::valarray<unsigned> const & IA,
+            std::valarray<unsigned> const & JA)
+            : n(n), NZ((unsigned)JA.size()),
+              A(0.0, NZ), IA(IA), JA(JA) {
+        COLA_ASSERT(IA.size()==n+1);
+        COLA_ASSERT(IA[n]==NZ);
+    }
     void rightMultiply(std::valarray<double> const & v, std::valarray<double> & r) const {
         COLA_ASSERT(v.size()>=n);
         COLA_ASSERT(r.size()>=n);
@@ -116,8 +132,43 @@ public:
             }
         }
     }
+    // Returns the index into the entries of (i,j), or nonZeroCount() if it
+    // isn't in the sparsity pattern.
+    unsigned find(const unsigned i, const unsigned j) const {
+        COLA_ASSERT(i<n);
+        unsigned lower=IA[i], upper=IA[i+1];
+        while(lower<upper) {
+            unsigned mid=(lower+upper)/2;
+            if(JA[mid]<j) {
+                lower=mid+1;
+            } else {
+                upper=mid;
+            }
+        }
+        return (lower<IA[i+1] && JA[lower]==j)?lower:NZ;
+    }
     double getIJ(const unsigned i, const unsigned j) const {
-        return sparseMap.getIJ(i,j);
+        COLA_ASSERT(i<n);
+        COLA_ASSERT(j<n);
+        unsigned k=find(i,j);
+        return (k<NZ)?A[k]:0;
+    }
+    // Entries of row i are at indices rowBegin(i) to rowEnd(i)-1.
+    unsigned rowBegin(const unsigned i) const {
+        return IA[i];
+    }
+    unsigned rowEnd(const unsigned i) const {
+        return IA[i+1];
+    }
+    unsigned columnAt(const unsigned k) const {
+        return JA[k];
+    }
+    double& valueAt(const unsigned k) {
+        return A[k];
+    }
+    // Sets all entries to zero, keeping the sparsity pattern.
+    void clear() {
+        A=0;
     }
     void print() const {
         for(unsigned i=0;i<n;i++) {
@@ -130,9 +181,11 @@ public:
     unsigned rowSize() const {
         return n;
     }
+    unsigned nonZeroCount() const {
+        return NZ;
+    }
 private:
-    const unsigned n,NZ;
-    SparseMap const & sparseMap;
+    unsigned n,NZ;
     std::valarray<double> A;
     std::valarray<unsigned> IA, JA;
 };
@@ -0,0 +1,90 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+/** \file approximate_stress.cpp
+ *
+ * Approximate (Barnes-Hut) stress test.  A grid graph plus a separate
+ * path, starting from random positions.  With theta=0 the approximate
+ * stress must equal the exact stress, and a layout using the default
+ * approximation must reach an exact stress close to that of the exact
+ * layout.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+#include "graphlayouttest.h"
+using namespace std;
+using namespace cola;
+
+static const unsigned gridSize = 12;
+static const unsigned pathLength = 20;
+
+int main() {
+    vector<Edge> es;
+    vector<vpsc::Rectangle*> rs;
+    srand(11);
+    makeGridWithPath(es, rs, gridSize, pathLength, false, 1000);
+
+    // theta=0 approximates nothing, so the stress must match.
+    {
+        ConstrainedFDLayout approx(rs, es, 40);
+        approx.setUseApproximateStress(true, 0);
+        double exact = exactStress(rs, es, 40);
+        double approximate = approx.computeStress();
+        cout << "exact=" << exact << " approximate(theta=0)="
+             << approximate << endl;
+        assert(fabs(exact - approximate) <= 1e-9 * exact);
+    }
+
+    // The default theta groups distant nodes, but laying out from the same
+    // positions must still reach nearly the exact layout's stress.
+    vector<vpsc::Rectangle*> exactRs, approxRs;
+    copyRectangles(rs, exactRs);
+    copyRectangles(rs, approxRs);
+    {
+        TestConvergence test(1e-4, 200);
+        ConstrainedFDLayout alg(exactRs, es, 40, StandardEdgeLengths, &test);
+        alg.run();
+    }
+    {
+        TestConvergence test(1e-4, 200);
+        ConstrainedFDLayout alg(approxRs, es, 40, StandardEdgeLengths, &test);
+        alg.setUseApproximateStress(true);
+        alg.run();
+    }
+    double exactLayoutStress = exactStress(exactRs, es, 40);
+    double approxLayoutStress = exactStress(approxRs, es, 40);
+    cout << "exact layout stress=" << exactLayoutStress
+         << " approximate layout stress=" << approxLayoutStress << endl;
+    assert(approxLayoutStress < 1.5 * exactLayoutStress);
+
+    OutputFile output(approxRs, es, nullptr, "approximate_stress.svg");
+    output.generate();
+
+    for (unsigned i = 0; i < rs.size(); ++i) {
+        delete rs[i];
+        delete exactRs[i];
+        delete approxRs[i];
+    }
+    return 0;
+}
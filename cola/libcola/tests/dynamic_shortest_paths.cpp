@@ -0,0 +1,220 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+/** \file dynamic_shortest_paths.cpp
+ *
+ * Dynamic shortest path lengths.  After each of a random series of small
+ * changes to a graph, adding and removing edges and nodes, the path
+ * lengths must match those computed from scratch, with less work than
+ * recomputing them all.  A layout whose graph is changed the same way
+ * must have the same D and G matrices as one computing them itself.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cassert>
+
+#include "graphlayouttest.h"
+#include "libcola/shortest_paths.h"
+#include "libcola/dynamic_shortest_paths.h"
+using namespace std;
+using namespace cola;
+
+struct TestEdge {
+    unsigned u, v;
+    double length;
+};
+
+static void checkDistances(const DynamicShortestPaths& paths,
+        const vector<unsigned>& nodes, const vector<TestEdge>& edges)
+{
+    // Number the nodes from zero, as shortest_paths needs.
+    const unsigned n = nodes.size();
+    vector<unsigned> index(paths.size(), n);
+    for (unsigned i = 0; i < n; ++i) {
+        index[nodes[i]] = i;
+    }
+    vector<Edge> es;
+    valarray<double> eLengths(edges.size());
+    for (unsigned i = 0; i < edges.size(); ++i) {
+        es.push_back(Edge(index[edges[i].u], index[edges[i].v]));
+        eLengths[i] = edges[i].length;
+    }
+    double **D = new double*[n];
+    for (unsigned i = 0; i < n; ++i) {
+        D[i] = new double[n];
+    }
+    shortest_paths::johnsons(n, D, es, eLengths);
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < n; ++j) {
+            double d = paths.distance(nodes[i], nodes[j]);
+            if (D[i][j] == DBL_MAX) {
+                assert(d == DBL_MAX);
+            } else {
+                assert(fabs(d - D[i][j]) < 1e-9 * D[i][j] + 1e-12);
+            }
+        }
+        delete [] D[i];
+    }
+    delete [] D;
+}
+
+// Whether two layouts have the same D and G matrices and stress.
+static void checkSamePathLengths(ConstrainedFDLayout& computed,
+        ConstrainedFDLayout& given, unsigned V)
+{
+    vector<double> D1 = computed.readLinearD(), D2 = given.readLinearD();
+    vector<unsigned> G1 = computed.readLinearG(), G2 = given.readLinearG();
+    assert(D1.size() == V * V && D2.size() == V * V);
+    for (unsigned i = 0; i < V; ++i) {
+        for (unsigned j = 0; j < V; ++j) {
+            // The diagonal of G is not used.
+            unsigned k = i * V + j;
+            assert(fabs(D1[k] - D2[k]) <= 1e-9 * fabs(D1[k]));
+            assert(i == j || G1[k] == G2[k]);
+        }
+    }
+    assert(fabs(computed.computeStress() - given.computeStress()) <
+            1e-6 * computed.computeStress());
+}
+
+static void checkLayoutChanges()
+{
+    const unsigned V = 50;
+    vector<Edge> es;
+    EdgeLengths eLengths;
+    vector<vpsc::Rectangle*> rs;
+    for (unsigned i = 0; i < V; ++i) {
+        double x = getRand(500), y = getRand(500);
+        rs.push_back(new vpsc::Rectangle(x, x + 10, y, y + 10));
+    }
+    for (unsigned i = 0; i + 5 < V; ++i) {
+        unsigned u = i, v = (i * 13 + 7) % (V - 5);
+        if (u == v) continue;
+        es.push_back(Edge(u, v));
+        eLengths.push_back(1 + (i % 3) * 0.5);
+    }
+    ConstrainedFDLayout changed(rs, es, 30, eLengths);
+    changed.computeStress();
+
+    // Remove a node and an edge, then add a node joined to the rest.
+    vpsc::Rectangle *removed = rs[3];
+    rs.erase(rs.begin() + 3);
+    changed.removeNode(3);
+    vector<Edge> es2;
+    EdgeLengths eLengths2;
+    for (unsigned i = 0; i < es.size(); ++i) {
+        Edge e = es[i];
+        if (e.first == 3 || e.second == 3) continue;
+        es2.push_back(Edge(e.first - (e.first > 3), e.second - (e.second > 3)));
+        eLengths2.push_back(eLengths[i]);
+    }
+    assert(changed.removeEdge(Edge(es2[4].second, es2[4].first), eLengths2[4]));
+    assert(!changed.removeEdge(es2[5], 0.25));
+    es2.erase(es2.begin() + 4);
+    eLengths2.erase(eLengths2.begin() + 4);
+    rs.push_back(new vpsc::Rectangle(250, 260, 250, 260));
+    assert(changed.addNode(rs.back()) == V - 1);
+    es2.push_back(Edge(V - 1, 0));
+    eLengths2.push_back(2);
+    changed.addEdge(es2.back(), 2);
+    es2.push_back(Edge(V - 1, V - 3));
+    eLengths2.push_back(1);
+    changed.addEdge(es2.back());
+
+    ConstrainedFDLayout computed(rs, es2, 30, eLengths2);
+    checkSamePathLengths(computed, changed, V);
+
+    // Another layout of the same graph can share the paths.
+    ConstrainedFDLayout shared(rs, es2, 30, eLengths2);
+    shared.sharePathLengths(changed);
+    checkSamePathLengths(computed, shared, V);
+    for_each(rs.begin(), rs.end(), delete_object());
+    delete removed;
+}
+
+int main() {
+    srand(5);
+    DynamicShortestPaths paths;
+    vector<unsigned> nodes;
+    vector<TestEdge> edges;
+    const unsigned V = 80;
+    for (unsigned i = 0; i < V; ++i) {
+        nodes.push_back(paths.addNode());
+    }
+    for (unsigned i = 0; i < 200; ++i) {
+        TestEdge e = { nodes[rand() % V], nodes[rand() % V],
+                (double) (1 + rand() % 3) };
+        edges.push_back(e);
+        paths.addEdge(e.u, e.v, e.length);
+    }
+    checkDistances(paths, nodes, edges);
+    unsigned long initial = paths.pathsComputed();
+
+    const unsigned steps = 150;
+    for (unsigned step = 0; step < steps; ++step) {
+        unsigned changes = 1 + rand() % 3;
+        for (unsigned c = 0; c < changes; ++c) {
+            int op = rand() % 10;
+            if (op < 4 && !edges.empty()) {
+                unsigned i = rand() % edges.size();
+                bool removed = paths.removeEdge(edges[i].v, edges[i].u,
+                        edges[i].length);
+                assert(removed);
+                edges.erase(edges.begin() + i);
+            } else if (op < 8) {
+                TestEdge e = { nodes[rand() % nodes.size()],
+                        nodes[rand() % nodes.size()],
+                        (double) (1 + rand() % 3) };
+                edges.push_back(e);
+                paths.addEdge(e.u, e.v, e.length);
+            } else if (op == 8) {
+                unsigned u = paths.addNode();
+                TestEdge e = { u, nodes[rand() % nodes.size()], 1.5 };
+                nodes.push_back(u);
+                edges.push_back(e);
+                paths.addEdge(e.u, e.v, e.length);
+            } else {
+                unsigned i = rand() % nodes.size();
+                unsigned u = nodes[i];
+                paths.removeNode(u);
+                nodes.erase(nodes.begin() + i);
+                for (unsigned j = 0; j < edges.size(); ) {
+                    if (edges[j].u == u || edges[j].v == u) {
+                        edges.erase(edges.begin() + j);
+                    } else {
+                        ++j;
+                    }
+                }
+            }
+        }
+        assert(!paths.removeEdge(nodes[0], nodes[0], 0.25));
+        checkDistances(paths, nodes, edges);
+    }
+    unsigned long incremental = paths.pathsComputed() - initial;
+    cout << "paths computed: " << incremental << " incrementally, " <<
+            steps * V * V << " from scratch" << endl;
+    assert(incremental * 4 < steps * V * V);
+
+    checkLayoutChanges();
+    return 0;
+}
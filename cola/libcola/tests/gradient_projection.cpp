@@ -0,0 +1,87 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+/** \file gradient_projection.cpp
+ *
+ * With warm start, gradient projection keeps its VPSC solver between solves
+ * when all its constraints are global.  A series of solves with changing
+ * linear terms must give the same results as solving each with a new
+ * instance, and satisfy the constraints.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+#include "graphlayouttest.h"
+#include "libcola/gradient_projection.h"
+using namespace std;
+using namespace cola;
+
+static const unsigned n = 30;
+
+int main() {
+    srand(5);
+    // The Laplacian of a path, with a little weight on the diagonal so the
+    // problem has a unique solution.
+    valarray<double> Q(0.0, n * n);
+    for (unsigned i = 0; i + 1 < n; ++i) {
+        Q[i * n + i] += 1;
+        Q[(i + 1) * n + i + 1] += 1;
+        Q[i * n + i + 1] -= 1;
+        Q[(i + 1) * n + i] -= 1;
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        Q[i * n + i] += 0.01;
+    }
+
+    CompoundConstraints ccs;
+    for (unsigned i = 0; i + 3 < n; i += 3) {
+        ccs.push_back(new SeparationConstraint(vpsc::XDIM, i, i + 3, 20));
+    }
+    ccs.push_back(new SeparationConstraint(vpsc::XDIM, 1, 2, 5, true));
+
+    GradientProjection warm(vpsc::XDIM, &Q, 1e-8, 200, &ccs, nullptr);
+    warm.setWarmStart(true);
+    valarray<double> warmX(0.0, n), freshX(0.0, n), b(n);
+    for (unsigned round = 0; round < 5; ++round) {
+        for (unsigned i = 0; i < n; ++i) {
+            b[i] = getRand(200) - 100;
+        }
+        freshX = warmX;
+        warm.solve(b, warmX);
+        GradientProjection fresh(vpsc::XDIM, &Q, 1e-8, 200, &ccs, nullptr);
+        fresh.solve(b, freshX);
+
+        double difference = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            difference = max(difference, fabs(warmX[i] - freshX[i]));
+        }
+        cout << "round " << round << ": difference=" << difference << endl;
+        assert(difference < 0.01);
+        for (unsigned i = 0; i + 3 < n; i += 3) {
+            assert(warmX[i + 3] - warmX[i] >= 20 - 1e-6);
+        }
+        assert(fabs(warmX[2] - warmX[1] - 5) < 1e-6);
+    }
+    for_each(ccs.begin(), ccs.end(), delete_object());
+    return 0;
+}
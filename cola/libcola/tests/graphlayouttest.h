@@ -35,6 +35,75 @@ inline double getRand(double range) {
 	return range*rand()/RAND_MAX;
 }
 
+/*
+ * Appends the edges of a size x size grid of nodes, numbered row by row
+ * from first.
+ */
+inline void addGridEdges(std::vector<cola::Edge>& es, const unsigned size,
+        const unsigned first = 0) {
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            unsigned u = first + i * size + j;
+            if (j + 1 < size) es.push_back(cola::Edge(u, u + 1));
+            if (i + 1 < size) es.push_back(cola::Edge(u, u + size));
+        }
+    }
+}
+
+/*
+ * Appends count square rectangles of the given size, at random positions
+ * within range of the origin.
+ */
+inline void addRandomRectangles(std::vector<vpsc::Rectangle*>& rs,
+        const unsigned count, const double range, const double size = 5) {
+    for (unsigned i = 0; i < count; ++i) {
+        double x = getRand(range), y = getRand(range);
+        rs.push_back(new vpsc::Rectangle(x, x + size, y, y + size));
+    }
+}
+
+/*
+ * Appends the edges of a size x size grid of nodes and of a path of
+ * pathLength further nodes, then random rectangles for all of them.  If
+ * joined, the path leads from the first corner of the grid, otherwise it
+ * is a separate component.  Returns the number of nodes.
+ */
+inline unsigned makeGridWithPath(std::vector<cola::Edge>& es,
+        std::vector<vpsc::Rectangle*>& rs, const unsigned size,
+        const unsigned pathLength, const bool joined, const double range,
+        const double rectSize = 5) {
+    addGridEdges(es, size);
+    unsigned V = size * size;
+    for (unsigned i = 0; i < pathLength; ++i, ++V) {
+        if (i > 0 || joined) {
+            es.push_back(cola::Edge(i == 0 ? 0 : V - 1, V));
+        }
+    }
+    addRandomRectangles(rs, V, range, rectSize);
+    return V;
+}
+
+/*
+ * Appends copies of the rectangles in from to to.
+ */
+inline void copyRectangles(const std::vector<vpsc::Rectangle*>& from,
+        std::vector<vpsc::Rectangle*>& to) {
+    for (unsigned i = 0; i < from.size(); ++i) {
+        to.push_back(new vpsc::Rectangle(*from[i]));
+    }
+}
+
+/*
+ * Returns the stress of the layout in rs computed exactly, for comparing
+ * layouts made with approximations.
+ */
+inline double exactStress(std::vector<vpsc::Rectangle*>& rs,
+        std::vector<cola::Edge>& es, const double idealLength,
+        const cola::EdgeLengths& eLengths = cola::StandardEdgeLengths) {
+    cola::ConstrainedFDLayout alg(rs, es, idealLength, eLengths);
+    return alg.computeStress();
+}
+
 namespace DFS {
 using namespace std;
 using namespace cola;
@@ -0,0 +1,189 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+/** \file multilevel.cpp
+ *
+ * Multilevel layout test.  A grid graph with a tail and a star, starting
+ * from random positions, must reach a stress close to that of the usual
+ * layout in fewer full-graph iterations.  The coarsened graphs must only
+ * be laid out by the first run() on both axes.  With compound constraints on
+ * some nodes and a cluster, the constraints must still be satisfied and
+ * refer to the same nodes afterwards.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+#include "graphlayouttest.h"
+using namespace std;
+using namespace cola;
+
+static const unsigned gridSize = 24;
+
+// A grid with a tail from the corner, ending in a star, so there are
+// leaves as well as pairs of nodes to merge.
+static void makeGraph(vector<Edge>& es, vector<vpsc::Rectangle*>& rs)
+{
+    srand(3);
+    const unsigned centre = makeGridWithPath(es, rs, gridSize, 20, true, 1000, 10) - 1;
+    for (unsigned i = 0; i < 15; ++i) {
+        es.push_back(Edge(centre, rs.size()));
+        addRandomRectangles(rs, 1, 1000, 10);
+    }
+}
+
+// Stops after a given number of iterations.
+struct IterationLimit : TestConvergence {
+    IterationLimit(const unsigned limit)
+        : TestConvergence(1e-4, limit),
+          limit(limit)
+    {
+    }
+    bool operator()(const double new_stress, valarray<double>& X,
+            valarray<double>& Y) {
+        TestConvergence::operator()(new_stress, X, Y);
+        return iterations >= limit;
+    }
+    unsigned limit;
+};
+
+static double maxDifference(const vector<vpsc::Rectangle*>& from,
+        const vector<vpsc::Rectangle*>& to)
+{
+    double movement = 0;
+    for (unsigned i = 0; i < from.size(); ++i) {
+        movement = max(movement, max(
+                fabs(from[i]->getCentreX() - to[i]->getCentreX()),
+                fabs(from[i]->getCentreY() - to[i]->getCentreY())));
+    }
+    return movement;
+}
+
+int main() {
+    vector<Edge> es;
+    vector<vpsc::Rectangle*> rs;
+    makeGraph(es, rs);
+
+    // The usual layout and a multilevel layout from the same positions.
+    double stress[2];
+    unsigned iterations[2];
+    for (unsigned multilevel = 0; multilevel < 2; ++multilevel) {
+        vector<vpsc::Rectangle*> layoutRs;
+        copyRectangles(rs, layoutRs);
+        TestConvergence test(1e-4, 300);
+        ConstrainedFDLayout alg(layoutRs, es, 30, StandardEdgeLengths, &test);
+        alg.setUseMultilevel(multilevel == 1, 10, 50);
+        alg.run();
+        stress[multilevel] = alg.computeStress();
+        iterations[multilevel] = test.iterations;
+        cout << (multilevel ? "multilevel" : "usual") << ": iterations=" <<
+                iterations[multilevel] << " stress=" << stress[multilevel] <<
+                endl;
+        for_each(layoutRs.begin(), layoutRs.end(), delete_object());
+    }
+    assert(iterations[1] * 2 < iterations[0]);
+    assert(stress[1] < 1.05 * stress[0]);
+
+    // A layout in x alone leaves y alone.
+    {
+        vector<vpsc::Rectangle*> layoutRs;
+        copyRectangles(rs, layoutRs);
+        TestConvergence test(1e-4, 5);
+        ConstrainedFDLayout alg(layoutRs, es, 30, StandardEdgeLengths, &test);
+        alg.setUseMultilevel(true, 10, 50);
+        alg.run(true, false);
+        for (unsigned i = 0; i < rs.size(); ++i) {
+            assert(layoutRs[i]->getCentreY() == rs[i]->getCentreY());
+        }
+        for_each(layoutRs.begin(), layoutRs.end(), delete_object());
+    }
+
+    // A second run continues from the first rather than laying out the
+    // coarsened graphs again, so takes the same step as a layout without
+    // multilevel from the same positions.
+    {
+        vector<vpsc::Rectangle*> layoutRs, usualRs;
+        copyRectangles(rs, layoutRs);
+        IterationLimit test(20);
+        ConstrainedFDLayout alg(layoutRs, es, 30, StandardEdgeLengths, &test);
+        alg.setUseMultilevel(true, 10, 50);
+        alg.run();
+        copyRectangles(layoutRs, usualRs);
+        test.limit = 1;
+        test.reset();
+        alg.run();
+
+        IterationLimit usualTest(1);
+        ConstrainedFDLayout usual(usualRs, es, 30, StandardEdgeLengths,
+                &usualTest);
+        usual.run();
+        cout << "second run: difference from usual=" <<
+                maxDifference(layoutRs, usualRs) << endl;
+        assert(maxDifference(layoutRs, usualRs) < 1e-6);
+        for_each(usualRs.begin(), usualRs.end(), delete_object());
+        for_each(layoutRs.begin(), layoutRs.end(), delete_object());
+    }
+
+    // Constraints on some nodes, and a cluster.
+    {
+        vector<vpsc::Rectangle*> layoutRs;
+        copyRectangles(rs, layoutRs);
+        CompoundConstraints ccs;
+        AlignmentConstraint *alignment = new AlignmentConstraint(vpsc::XDIM);
+        for (unsigned i = 0; i < 5; ++i) {
+            alignment->addShape(i * 37, 0);
+        }
+        ccs.push_back(alignment);
+        ccs.push_back(new SeparationConstraint(vpsc::YDIM, 100, 200, 60, true));
+        ccs.push_back(new SeparationConstraint(vpsc::XDIM, 300, 301, 40));
+
+        RootCluster *root = new RootCluster();
+        RectangularCluster *cluster = new RectangularCluster();
+        for (unsigned i = 0; i < 8; ++i) {
+            cluster->addChildNode(gridSize * gridSize - 1 - i);
+        }
+        root->addChildCluster(cluster);
+
+        TestConvergence test(1e-4, 30);
+        ConstrainedFDLayout alg(layoutRs, es, 30, StandardEdgeLengths, &test);
+        alg.setConstraints(ccs);
+        alg.setClusterHierarchy(root);
+        alg.setUseMultilevel(true, 10, 50);
+        alg.run();
+        cout << "constrained multilevel: iterations=" << test.iterations <<
+                " stress=" << alg.computeStress() << endl;
+
+        for (unsigned i = 1; i < 5; ++i) {
+            assert(fabs(layoutRs[i * 37]->getCentreX() -
+                        layoutRs[0]->getCentreX()) < 0.01);
+        }
+        assert(fabs(layoutRs[200]->getCentreY() -
+                    layoutRs[100]->getCentreY() - 60) < 0.01);
+        assert(layoutRs[301]->getCentreX() -
+                layoutRs[300]->getCentreX() >= 40 - 0.01);
+
+        // Frees the rectangles, constraints and clusters.
+        alg.freeAssociatedObjects();
+    }
+    for_each(rs.begin(), rs.end(), delete_object());
+    return 0;
+}
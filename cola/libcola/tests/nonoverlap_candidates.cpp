@@ -0,0 +1,183 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+/** \file nonoverlap_candidates.cpp
+ *
+ * Non-overlap constraints using sweep-line candidate pairs.  Separation
+ * constraints generated from candidate pairs must be the same as those
+ * generated from all pairs, in the same order and respecting exemptions,
+ * so that solving them gives the same positions, and layouts with
+ * overlapping nodes must end up with no overlaps, both with and without
+ * clusters.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+#include "graphlayouttest.h"
+#include "libcola/cc_nonoverlapconstraints.h"
+#include "libvpsc/solve_VPSC.h"
+using namespace std;
+using namespace cola;
+
+static void makeRectangles(vector<vpsc::Rectangle*>& rs, unsigned V,
+        double range)
+{
+    for (unsigned i = 0; i < V; ++i) {
+        double x = getRand(range), y = getRand(range);
+        rs.push_back(new vpsc::Rectangle(x, x + 5 + getRand(30),
+                    y, y + 5 + getRand(20)));
+    }
+}
+
+static void generateSeparationConstraints(bool useCandidatePairs,
+        vector<vpsc::Rectangle*>& rs, NonOverlapConstraintExemptions *exempt,
+        vpsc::Dim dim, vpsc::Variables& vs, vpsc::Constraints& cs)
+{
+    NonOverlapConstraints noc(exempt);
+    noc.setUseCandidatePairs(useCandidatePairs);
+    // Add the shapes out of index order, which the pairs must follow.
+    for (unsigned k = 0; k < rs.size(); ++k) {
+        unsigned i = (k * 7) % rs.size();
+        set<unsigned> exemptions;
+        if (i % 7 == 0 && i > 0) {
+            exemptions.insert(i - 1);
+        }
+        noc.addShape(i, rs[i]->width() / 2, rs[i]->height() / 2,
+                (i % 11 == 0) ? 2 : 1, exemptions);
+    }
+    noc.generateSeparationConstraints(dim, vs, cs, rs);
+}
+
+static void checkSameSeparationConstraints(vector<vpsc::Rectangle*>& rs)
+{
+    NonOverlapConstraintExemptions exempt;
+    ListOfNodeIndexes groups(1);
+    groups[0].push_back(3);
+    groups[0].push_back(4);
+    groups[0].push_back(5);
+    exempt.addExemptGroupOfNodes(groups);
+
+    vpsc::Variables vs;
+    for (unsigned i = 0; i < rs.size(); ++i) {
+        vs.push_back(new vpsc::Variable(i, 0));
+    }
+    for (unsigned dim = 0; dim < 2; ++dim) {
+        vpsc::Constraints all, candidates;
+        generateSeparationConstraints(false, rs, &exempt, (vpsc::Dim) dim,
+                vs, all);
+        generateSeparationConstraints(true, rs, &exempt, (vpsc::Dim) dim,
+                vs, candidates);
+        cout << "dim " << dim << ": " << all.size() << " constraints" << endl;
+        assert(!all.empty());
+        assert(all.size() == candidates.size());
+        for (unsigned i = 0; i < all.size(); ++i) {
+            assert(all[i]->left == candidates[i]->left);
+            assert(all[i]->right == candidates[i]->right);
+            assert(all[i]->gap == candidates[i]->gap);
+        }
+        vector<double> allPositions;
+        for (unsigned pass = 0; pass < 2; ++pass) {
+            for (unsigned i = 0; i < vs.size(); ++i) {
+                vs[i]->desiredPosition = rs[i]->getCentreD(dim);
+            }
+            vpsc::IncSolver solver(vs, (pass == 0) ? all : candidates);
+            solver.solve();
+            for (unsigned i = 0; i < vs.size(); ++i) {
+                if (pass == 0) {
+                    allPositions.push_back(vs[i]->finalPosition);
+                } else {
+                    assert(allPositions[i] == vs[i]->finalPosition);
+                }
+            }
+        }
+        for_each(all.begin(), all.end(), delete_object());
+        for_each(candidates.begin(), candidates.end(), delete_object());
+    }
+    for_each(vs.begin(), vs.end(), delete_object());
+}
+
+static unsigned countOverlaps(const vector<vpsc::Rectangle*>& rs)
+{
+    unsigned overlaps = 0;
+    for (unsigned i = 0; i < rs.size(); ++i) {
+        for (unsigned j = i + 1; j < rs.size(); ++j) {
+            if (rs[i]->overlapX(rs[j]) > 0.001 &&
+                    rs[i]->overlapY(rs[j]) > 0.001) {
+                ++overlaps;
+            }
+        }
+    }
+    return overlaps;
+}
+
+static void layout(vector<vpsc::Rectangle*>& rs, bool useCandidatePairs,
+        bool withCluster)
+{
+    vector<Edge> es;
+    for (unsigned i = 0; i + 1 < rs.size(); ++i) {
+        es.push_back(Edge(i, (i * 7 + 3) % rs.size()));
+    }
+    TestConvergence test(1e-4, 50);
+    ConstrainedFDLayout alg(rs, es, 40, StandardEdgeLengths, &test);
+    alg.setAvoidNodeOverlaps(true);
+    alg.setUseNonOverlapCandidatePairs(useCandidatePairs);
+    if (withCluster) {
+        RootCluster *root = new RootCluster();
+        RectangularCluster *cluster = new RectangularCluster();
+        for (unsigned i = 0; i < 6; ++i) {
+            cluster->addChildNode(i);
+        }
+        root->addChildCluster(cluster);
+        alg.setClusterHierarchy(root);
+    }
+    alg.run();
+}
+
+int main() {
+    srand(11);
+    {
+        vector<vpsc::Rectangle*> rs;
+        makeRectangles(rs, 300, 600);
+        checkSameSeparationConstraints(rs);
+        for_each(rs.begin(), rs.end(), delete_object());
+    }
+
+    for (unsigned withCluster = 0; withCluster < 2; ++withCluster) {
+        vector<vpsc::Rectangle*> all, candidates;
+        makeRectangles(all, 120, 150);
+        for (unsigned i = 0; i < all.size(); ++i) {
+            candidates.push_back(new vpsc::Rectangle(*all[i]));
+        }
+        assert(countOverlaps(all) > 0);
+
+        layout(all, false, withCluster);
+        layout(candidates, true, withCluster);
+        cout << "overlaps: all pairs " << countOverlaps(all) <<
+                ", candidate pairs " << countOverlaps(candidates) << endl;
+        assert(countOverlaps(all) == 0);
+        assert(countOverlaps(candidates) == 0);
+        for_each(all.begin(), all.end(), delete_object());
+        for_each(candidates.begin(), candidates.end(), delete_object());
+    }
+    return 0;
+}
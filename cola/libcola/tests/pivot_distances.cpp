@@ -0,0 +1,138 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+/** \file pivot_distances.cpp
+ *
+ * Pivot distance storage test.  A grid graph with a diagonal edge of a
+ * different length, a separate path and an isolated node.  With every
+ * node as a pivot the D and G matrices must match the dense ones, and
+ * with a few pivots distances must be exact for nearby nodes and close on
+ * average elsewhere.  Finally, a layout using pivot distances and
+ * approximate stress must reach an exact stress close to the exact layout.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+#include "graphlayouttest.h"
+using namespace std;
+using namespace cola;
+
+static const unsigned gridSize = 10;
+static const unsigned pathLength = 15;
+
+// The grid and path, then a diagonal edge across the first square of the
+// grid, one and a half times as long as the others, and an isolated node.
+static void makeGraph(vector<Edge>& es, EdgeLengths& eLengths,
+        vector<vpsc::Rectangle*>& rs)
+{
+    srand(5);
+    makeGridWithPath(es, rs, gridSize, pathLength, false, 800);
+    eLengths.assign(es.size(), 1);
+    es.push_back(Edge(0, gridSize + 1));
+    eLengths.push_back(1.5);
+    addRandomRectangles(rs, 1, 800);
+}
+
+int main() {
+    vector<Edge> es;
+    EdgeLengths eLengths;
+    vector<vpsc::Rectangle*> rs;
+    makeGraph(es, eLengths, rs);
+    const unsigned V = rs.size();
+
+    ConstrainedFDLayout dense(rs, es, 30, eLengths);
+    vector<double> denseD = dense.readLinearD();
+    vector<unsigned> denseG = dense.readLinearG();
+
+    // Every node a pivot: all distances are exact.
+    {
+        ConstrainedFDLayout alg(rs, es, 30, eLengths);
+        alg.setUsePivotDistances(V);
+        vector<double> D = alg.readLinearD();
+        vector<unsigned> G = alg.readLinearG();
+        for (unsigned i = 0; i < V; ++i) {
+            for (unsigned j = 0; j < V; ++j) {
+                if (i == j) continue;
+                assert(fabs(D[i * V + j] - denseD[i * V + j]) <=
+                        1e-9 * denseD[i * V + j]);
+                assert(G[i * V + j] == denseG[i * V + j]);
+            }
+        }
+        assert(fabs(alg.computeStress() - dense.computeStress()) <= 1e-9 * dense.computeStress());
+    }
+
+    // A few pivots: nearby distances exact, others close on average.
+    {
+        ConstrainedFDLayout alg(rs, es, 30, eLengths);
+        alg.setUsePivotDistances(6, 2);
+        vector<double> D = alg.readLinearD();
+        double totalError = 0;
+        unsigned pairs = 0;
+        for (unsigned i = 0; i < V; ++i) {
+            for (unsigned j = 0; j < V; ++j) {
+                double exact = denseD[i * V + j];
+                if (i == j || exact == DBL_MAX) {
+                    assert(D[i * V + j] == exact);
+                    continue;
+                }
+                if (exact <= 2 * 30) {
+                    assert(fabs(D[i * V + j] - exact) <= 1e-9 * exact);
+                }
+                totalError += fabs(D[i * V + j] - exact) / exact;
+                ++pairs;
+            }
+        }
+        cout << "mean relative distance error=" << totalError / pairs << endl;
+        assert(totalError / pairs < 0.25);
+    }
+
+    // Laying out with 20 pivots and approximate stress, which never builds
+    // the dense matrices, must reach nearly the stress of the dense layout.
+    vector<vpsc::Rectangle*> exactRs, pivotRs;
+    copyRectangles(rs, exactRs);
+    copyRectangles(rs, pivotRs);
+    {
+        TestConvergence test(1e-4, 200);
+        ConstrainedFDLayout alg(exactRs, es, 30, eLengths, &test);
+        alg.run();
+    }
+    {
+        TestConvergence test(1e-4, 200);
+        ConstrainedFDLayout alg(pivotRs, es, 30, eLengths, &test);
+        alg.setUsePivotDistances(20);
+        alg.setUseApproximateStress(true);
+        alg.run();
+    }
+    double exactLayoutStress = exactStress(exactRs, es, 30, eLengths);
+    double pivotLayoutStress = exactStress(pivotRs, es, 30, eLengths);
+    cout << "exact layout stress=" << exactLayoutStress
+         << " pivot layout stress=" << pivotLayoutStress << endl;
+    assert(pivotLayoutStress < 1.5 * exactLayoutStress);
+
+    for (unsigned i = 0; i < V; ++i) {
+        delete rs[i];
+        delete exactRs[i];
+        delete pivotRs[i];
+    }
+    return 0;
+}
@@ -123,6 +123,27 @@ main(void)
         }
         if(dump) cout << endl;
     }
+
+    // The per-source pairing heap search and the multithreaded CSR search
+    // must give bit-identical rows, for any number of threads.  Use
+    // non-integral weights so that differently ordered sums could differ.
+    valarray<double> fweights(E);
+    for(unsigned i=0;i<E;i++) {
+        fweights[i]=(static_cast<double>(rand())/static_cast<double>(RAND_MAX))*10;
+    }
+    double* d=new double[V];
+    for(unsigned threads=1;threads<=4;threads++) {
+        cout<<"Running shortest_paths::johnsons with "<<threads<<" threads..."<<endl;
+        shortest_paths::johnsons(V,D1,es,fweights,threads);
+        for (unsigned int i = 0; i < V; ++i) {
+            shortest_paths::dijkstra(i,V,d,es,fweights);
+            for (unsigned int j = 0; j < V; ++j) {
+                assert(D1[i][j]==d[j]);
+            }
+        }
+    }
+    delete [] d;
+
 #ifdef TEST_AGAINST_BOOST
     if(dump) {
         ofstream fout("figs/johnson-eg.dot");
@@ -136,5 +157,11 @@ main(void)
         fout << "}\n";
     }
 #endif
+    for(unsigned i=0;i<V;i++) {
+        delete [] D1[i];
+        delete [] D2[i];
+    }
+    delete [] D1;
+    delete [] D2;
     return 0;
 }
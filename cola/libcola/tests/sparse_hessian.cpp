@@ -0,0 +1,154 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2006-2015  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+/** \file sparse_hessian.cpp
+ *
+ * Sparse Hessian test.  A matrix with a fixed sparsity pattern, refilled in
+ * place, must give the same entries and products as one built from a
+ * SparseMap with the same values.  Then layouts with dense stress and with
+ * neighbour stress, which use such a matrix for the Hessian, must converge.
+ * Finally, with pivot distances the Hessian must hold only the pairs whose
+ * distances are exact, O(kn) entries rather than n^2, and still converge.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+#include "graphlayouttest.h"
+using namespace std;
+using namespace cola;
+
+static void testPattern()
+{
+    const unsigned n = 30;
+    srand(3);
+    SparseMap map(n);
+    vector<unsigned> columns;
+    valarray<unsigned> IA(n + 1);
+    for (unsigned i = 0; i < n; ++i) {
+        IA[i] = columns.size();
+        for (unsigned j = 0; j < n; ++j) {
+            if ((i == j) || (rand() % 5 == 0)) {
+                columns.push_back(j);
+            }
+        }
+    }
+    IA[n] = columns.size();
+    valarray<unsigned> JA(columns.data(), columns.size());
+    SparseMatrix pattern(n, IA, JA);
+    assert(pattern.nonZeroCount() == columns.size());
+
+    valarray<double> v(n), expected(n), result(n);
+    for (unsigned round = 0; round < 3; ++round) {
+        map.clear();
+        pattern.clear();
+        for (unsigned i = 0; i < n; ++i) {
+            for (unsigned k = pattern.rowBegin(i); k < pattern.rowEnd(i); ++k) {
+                double value = getRand(10) - 5;
+                map(i, pattern.columnAt(k)) = value;
+                pattern.valueAt(pattern.find(i, pattern.columnAt(k))) += value;
+            }
+        }
+        SparseMatrix fromMap(map);
+        for (unsigned i = 0; i < n; ++i) {
+            v[i] = getRand(10);
+            for (unsigned j = 0; j < n; ++j) {
+                assert(pattern.getIJ(i, j) == fromMap.getIJ(i, j));
+            }
+        }
+        fromMap.rightMultiply(v, expected);
+        pattern.rightMultiply(v, result);
+        for (unsigned i = 0; i < n; ++i) {
+            assert(result[i] == expected[i]);
+        }
+    }
+    assert(pattern.find(0, n) == pattern.nonZeroCount());
+}
+
+static void testLayout(const bool neighbourStress)
+{
+    const unsigned gridSize = 8;
+    const unsigned V = gridSize * gridSize + 1;
+    vector<Edge> es;
+    addGridEdges(es, gridSize);
+    srand(7);
+    vector<vpsc::Rectangle*> rs;
+    addRandomRectangles(rs, V, 400);
+    DesiredPositions des;
+    DesiredPosition corner = { 0, 0, 0, 0.5 };
+    des.push_back(corner);
+
+    TestConvergence test(1e-4, 200);
+    ConstrainedFDLayout alg(rs, es, 30, EdgeLengths(), &test);
+    alg.setUseNeighbourStress(neighbourStress);
+    alg.setDesiredPositions(&des);
+    alg.run();
+    double stress = alg.computeStress();
+    cout << "neighbourStress=" << neighbourStress << " stress=" << stress
+         << endl;
+    assert(std::isfinite(stress));
+    for (unsigned i = 0; i < V; ++i) {
+        assert(std::isfinite(rs[i]->getCentreX()));
+        assert(std::isfinite(rs[i]->getCentreY()));
+        delete rs[i];
+    }
+}
+
+static void testPivotPattern()
+{
+    const unsigned gridSize = 15;
+    const unsigned V = gridSize * gridSize;
+    const unsigned pivotCount = 4;
+    vector<Edge> es;
+    addGridEdges(es, gridSize);
+    srand(11);
+    vector<vpsc::Rectangle*> rs;
+    addRandomRectangles(rs, V, 600);
+
+    TestConvergence test(1e-4, 20);
+    ConstrainedFDLayout alg(rs, es, 30, EdgeLengths(), &test);
+    alg.setUsePivotDistances(pivotCount, 2);
+    // Each row has the diagonal, at most 12 nodes within two hops in a grid
+    // and the pivots, and each pivot's row has every node.
+    size_t nonZeros = alg.hessianNonZeroCount();
+    cout << "pivot Hessian entries=" << nonZeros << " of " << V * V << endl;
+    assert(nonZeros <= (1 + 12 + 2 * pivotCount) * V);
+    assert(nonZeros < V * V / 10);
+
+    alg.run();
+    double stress = alg.computeStress();
+    cout << "pivot distances stress=" << stress << endl;
+    assert(std::isfinite(stress));
+    for (unsigned i = 0; i < V; ++i) {
+        assert(std::isfinite(rs[i]->getCentreX()));
+        assert(std::isfinite(rs[i]->getCentreY()));
+        delete rs[i];
+    }
+}
+
+int main() {
+    testPattern();
+    testLayout(false);
+    testLayout(true);
+    testPivotPattern();
+    return 0;
+}
@@ -40,6 +40,7 @@
 
 #include "libcola/cola.h"
 #include "libcola/cc_nonoverlapconstraints.h"
+#include "libcola/parallel.h"
 
 #include "libdialect/util.h"
 #include "libdialect/constraints.h"
@@ -345,6 +346,16 @@ void ACALayout::aggressiveOrdering(bool b)
     m_aggressiveOrdering = b;
 }
 
+void ACALayout::concurrentFeasibilityChecks(unsigned k)
+{
+    m_concurrentFeasibilityChecks = std::max(k, 1u);
+}
+
+void ACALayout::warmStartChecks(bool b)
+{
+    m_warmStartChecks = b;
+}
+
 void ACALayout::setAvoidNodeOverlaps(bool avoidOverlaps)
 {
     m_preventOverlaps = avoidOverlaps;
@@ -1055,12 +1066,17 @@ vpsc::Rectangle *ACALayout::makeRectForEdge(int j, vpsc::Dim dim)
 }
 
 void ACALayout::updateRectForEdge(Rectangle *R, int j, Dim dim)
+{
+    updateRectForEdge(R, j, dim, m_rs);
+}
+
+void ACALayout::updateRectForEdge(Rectangle *R, int j, Dim dim, const Rectangles &nodeRects) const
 {
     // Here dim should be HORIZONTAL when edge j has been horizontally
     // aligned and R is supposed to be a wide box with a narrow height.
     // Vice versa for VERTICAL.
     cola::Edge e = m_es[j];
-    vpsc::Rectangle *srcR = m_rs[e.first], *tgtR = m_rs[e.second];
+    vpsc::Rectangle *srcR = nodeRects[e.first], *tgtR = nodeRects[e.second];
     double srcZ = srcR->getCentreD(dim), tgtZ = tgtR->getCentreD(dim);
     vpsc::Rectangle *lowR  = srcZ < tgtZ ? srcR : tgtR;
     vpsc::Rectangle *highR = srcZ < tgtZ ? tgtR : srcR;
@@ -1101,39 +1117,55 @@ void ACALayout::recomputeEdgeShapes(Dim dim)
     // Conversely, if the dimension passed is YDIM, then we want to
     // update the horizontal edge shapes and prepare for generation of
     // non-overlap constraints on the y variables.
+    bool horiz = dim == YDIM;
+    recomputeEdgeShapes(dim, m_rs, horiz ? m_yvs : m_xvs,
+            horiz ? m_yGuidelineIndexToEdgeIndex : m_xGuidelineIndexToEdgeIndex,
+            horiz ? m_yrs : m_xrs, horiz ? m_ynocs : m_xnocs);
+}
+
+void ACALayout::recomputeEdgeShapes(Dim dim, const Rectangles &nodeRects, Variables &vs,
+        std::map<int,int> &gi2ei, Rectangles &rs, cola::NonOverlapConstraints *nocs)
+{
     bool horiz = dim == YDIM;
     int e = horiz ? m_numExtraYVars : m_numExtraXVars;
     int b = m_n + e;
-    vpsc::Variables &vs = horiz ? m_yvs : m_xvs;
     int N = vs.size();
-    std::map<int,int> &gi2ei = horiz ? m_yGuidelineIndexToEdgeIndex :
-                                       m_xGuidelineIndexToEdgeIndex;
-    vpsc::Rectangles &rs = horiz ? m_yrs : m_xrs;
-    cola::NonOverlapConstraints *nocs = horiz ? m_ynocs : m_xnocs;
     for (int gi = b; gi < N; ++gi) {
         int ei = gi2ei[gi];
         Rectangle *R = rs[gi];
         Dim perpDim = dim == YDIM ? XDIM : YDIM;
-        updateRectForEdge(R,ei,perpDim);
+        updateRectForEdge(R,ei,perpDim,nodeRects);
         nocs->resizeShape(gi,R->width()/2.0,R->height()/2.0);
     }
 }
 
 void ACALayout::updateNodeRectsFromVars(void)
+{
+    updateNodeRectsFromVars(m_rs, m_xvs, m_yvs);
+}
+
+void ACALayout::updateNodeRectsFromVars(Rectangles &rs, const Variables &xvs,
+        const Variables &yvs) const
 {
     for (int i=0; i<m_n; ++i) {
-        m_rs[i]->moveCentreX(m_xvs[i]->finalPosition);
-        m_rs[i]->moveCentreY(m_yvs[i]->finalPosition);
+        rs[i]->moveCentreX(xvs[i]->finalPosition);
+        rs[i]->moveCentreY(yvs[i]->finalPosition);
     }
 }
 
 void ACALayout::updateVarsFromNodeRects(void)
+{
+    updateVarsFromNodeRects(m_rs, m_xvs, m_yvs);
+}
+
+void ACALayout::updateVarsFromNodeRects(const Rectangles &rs, Variables &xvs,
+        Variables &yvs) const
 {
     for (int i=0; i<m_n; ++i) {
-        Rectangle *r = m_rs[i];
+        Rectangle *r = rs[i];
         double x=r->getCentreX(), y=r->getCentreY();
-        m_xvs[i]->desiredPosition=x;
-        m_yvs[i]->desiredPosition=y;
+        xvs[i]->desiredPosition=x;
+        yvs[i]->desiredPosition=y;
     }
 }
 
@@ -1164,8 +1196,26 @@ OrderedAlignment *ACALayout::chooseOA(void)
     std::sort(oas.begin(),oas.end(),sortOrdAlignsByPenalty);
     // Now, starting with the lowest-penalty alignments, look for a feasible one.
     OrderedAlignment *nextOA = nullptr;
-    for (std::vector<OrderedAlignment*>::iterator it=oas.begin(); it!=oas.end(); ++it) {
-        OrderedAlignment *oa = *it;
+    size_t k = m_concurrentFeasibilityChecks;
+    std::vector<char> infeasible;
+    size_t batchBegin = 0, batchEnd = 0;
+    for (size_t i = 0; i < oas.size(); ++i) {
+        if (k > 1) {
+            // Test the next k candidates concurrently on copies of the
+            // state, and skip those found to be infeasible. A candidate
+            // that is rejected leaves nothing behind that the next check
+            // reads (rectangles and vector lengths are restored, desired
+            // positions and unsatisfiable flags are reset by each check,
+            // and edge shapes are recomputed before they are used), so
+            // skipping it doesn't change the outcome of later checks.
+            if (i >= batchEnd) {
+                batchBegin = i;
+                batchEnd = std::min(i + k, oas.size());
+                findInfeasible(oas, batchBegin, batchEnd, infeasible);
+            }
+            if (infeasible[i - batchBegin]) continue;
+        }
+        OrderedAlignment *oa = oas[i];
         bool applied = applyIfFeasible(oa);
         if (applied) {
             nextOA = oa; //needn't call completeOrdAlign, since already done by applyIfFeasible
@@ -1392,7 +1442,6 @@ bool ACALayout::applyIfFeasible(OrderedAlignment *oa)
     // and of non-overlap constraints in both dimensions.
     bool feasible = true;
     IncSolver *seps = nullptr, *alns = nullptr;
-    IncSolver *sepnocsolv = nullptr, *alnnocsolv = nullptr;
     // On previous calls to this function, some constraint(s) may have been
     // marked as unsatisfiable. Here we clear any such flags before beginning
     // the new satisfiability tests.
@@ -1416,16 +1465,18 @@ bool ACALayout::applyIfFeasible(OrderedAlignment *oa)
     if (feasible) {
         updateNodeRectsFromVars();
         recomputeEdgeShapes(alnd);
+        size_t firstNew = alnc.size();
         alnnocs->generateSeparationConstraints(alnd,alnv,alnc,alnr);
-        alnnocsolv = satisfy(alnv,alnc,feasible);
+        feasible = satisfy(alns,alnv,alnc,firstNew);
     }
 
     // 4. Non-Overlap in the dimension of the separation constraint:
     if (feasible) {
         updateNodeRectsFromVars();
         recomputeEdgeShapes(sepd);
+        size_t firstNew = sepc.size();
         sepnocs->generateSeparationConstraints(sepd,sepv,sepc,sepr);
-        sepnocsolv = satisfy(sepv,sepc,feasible);
+        feasible = satisfy(seps,sepv,sepc,firstNew);
     }
 
     if (!feasible) {
@@ -1443,8 +1494,8 @@ bool ACALayout::applyIfFeasible(OrderedAlignment *oa)
 #ifndef ACA_FULLSOLVE_ON_EACH_CHECK
         // So far we have only tried to satisfy the constraints.
         // Now we should actually find an optimal solution.
-        alnnocsolv->solve();
-        sepnocsolv->solve();
+        alns->solve();
+        seps->solve();
 #endif
         // Accept the new node positions.
         updateNodeRectsFromVars();
@@ -1456,17 +1507,14 @@ bool ACALayout::applyIfFeasible(OrderedAlignment *oa)
     }
     delete seps;
     delete alns;
-    delete sepnocsolv;
-    delete alnnocsolv;
     return feasible;
 }
 
-// Constructs a solver and attempts to satisfy the passed constraints on the
-// passed vars. Sets the bool passed by reference according to whether it was
-// possible to satisfy the constraints.
-vpsc::IncSolver *ACALayout::satisfy(Variables &vs, Constraints &cs, bool &sat)
+// Attempts to satisfy the constraints on an existing solver for them.
+// Returns whether it was possible to satisfy the constraints.
+static bool trySatisfy(IncSolver *solv, Constraints &cs)
 {
-    IncSolver *solv = new IncSolver(vs,cs);
+    bool sat;
     try {
 #ifdef ACA_FULLSOLVE_ON_EACH_CHECK
         solv->solve();
@@ -1484,9 +1532,178 @@ vpsc::IncSolver *ACALayout::satisfy(Variables &vs, Constraints &cs, bool &sat)
             break;
         }
     }
+    return sat;
+}
+
+// Constructs a solver and attempts to satisfy the passed constraints on the
+// passed vars. Sets the bool passed by reference according to whether it was
+// possible to satisfy the constraints.
+vpsc::IncSolver *ACALayout::satisfy(Variables &vs, Constraints &cs, bool &sat)
+{
+    IncSolver *solv = new IncSolver(vs,cs);
+    sat = trySatisfy(solv,cs);
     return solv;
 }
 
+// Attempts to satisfy the constraints cs on the vars vs, where solv is a
+// solver for cs[0..firstNew). With warm-started checks the new constraints
+// are added to solv, which starts from its last solution. Otherwise solv is
+// replaced by a new solver for all of cs. Returns whether it was possible to
+// satisfy the constraints.
+bool ACALayout::satisfy(IncSolver *&solv, Variables &vs, Constraints &cs,
+        size_t firstNew)
+{
+    if (!m_warmStartChecks) {
+        delete solv;
+        bool sat;
+        solv = satisfy(vs,cs,sat);
+        return sat;
+    }
+    for (size_t i = firstNew; i < cs.size(); ++i) {
+        solv->addConstraint(cs[i]);
+    }
+    return trySatisfy(solv,cs);
+}
+
+class ACALayout::StateCopy {
+public:
+    StateCopy(const ACALayout &aca);
+    ~StateCopy();
+    // Copies of the node rectangles.
+    Rectangles rs;
+    // Copies of the variables, constraints, rectangles, guideline-to-edge
+    // maps and non-overlap constraints in each dimension.
+    Variables vs[2];
+    Constraints cs[2];
+    Rectangles dimRs[2];
+    std::map<int,int> gi2ei[2];
+    cola::NonOverlapConstraints *nocs[2];
+};
+
+ACALayout::StateCopy::StateCopy(const ACALayout &aca)
+{
+    std::map<Variable*,Variable*> varCopies;
+    for (int i = 0; i < aca.m_n; ++i) rs.push_back(new Rectangle(*aca.m_rs[i]));
+    const Variables *srcVs[2] = {&aca.m_xvs, &aca.m_yvs};
+    const Constraints *srcCs[2] = {&aca.m_xcs, &aca.m_ycs};
+    const Rectangles *srcRs[2] = {&aca.m_xrs, &aca.m_yrs};
+    const cola::NonOverlapConstraints *srcNocs[2] = {aca.m_xnocs, aca.m_ynocs};
+    const std::map<int,int> *srcGi2ei[2] = {&aca.m_xGuidelineIndexToEdgeIndex,
+                                           &aca.m_yGuidelineIndexToEdgeIndex};
+    for (int d = 0; d < 2; ++d) {
+        for (Variable *v : *srcVs[d]) {
+            Variable *copy = new Variable(*v);
+            copy->in.clear();
+            copy->out.clear();
+            copy->block = nullptr;
+            varCopies[v] = copy;
+            vs[d].push_back(copy);
+        }
+        for (Constraint *c : *srcCs[d]) {
+            Constraint *copy = new Constraint(*c);
+            copy->left = varCopies.at(c->left);
+            copy->right = varCopies.at(c->right);
+            copy->unsatisfiable = false;
+            cs[d].push_back(copy);
+        }
+        // The first m_n rectangles in each dimension are the node rectangles,
+        // followed by null entries for any extra variables, and then the
+        // rectangles for aligned edges.
+        const Rectangles &src = *srcRs[d];
+        for (size_t i = 0; i < src.size(); ++i) {
+            if (i < (size_t) aca.m_n) {
+                dimRs[d].push_back(rs[i]);
+            } else {
+                dimRs[d].push_back(src[i] ? new Rectangle(*src[i]) : nullptr);
+            }
+        }
+        // NonOverlapConstraints keeps its state in containers of values, so
+        // the copy is independent of the original.
+        nocs[d] = new cola::NonOverlapConstraints(*srcNocs[d]);
+        gi2ei[d] = *srcGi2ei[d];
+    }
+}
+
+ACALayout::StateCopy::~StateCopy()
+{
+    for (int d = 0; d < 2; ++d) {
+        for (Variable *v : vs[d]) delete v;
+        for (Constraint *c : cs[d]) delete c;
+        for (size_t i = rs.size(); i < dimRs[d].size(); ++i) delete dimRs[d][i];
+        delete nocs[d];
+    }
+    for (Rectangle *r : rs) delete r;
+}
+
+/**
+ * Run the same checks as applyIfFeasible, but on a copy of the state, so that
+ * this object is left unchanged. Several of these may run concurrently.
+ */
+bool ACALayout::feasibleOnCopy(const OrderedAlignment *candidate)
+{
+    if (badSeparation(candidate->src, candidate->tgt, candidate->sf)) return false;
+    StateCopy copy(*this);
+    OrderedAlignment oa(*candidate);
+    bool horiz = oa.dim==HORIZONTAL;
+    Dim sepd = horiz ? XDIM : YDIM;
+    Dim alnd = horiz ? YDIM : XDIM;
+    Variables   &sepv = copy.vs[sepd];
+    Constraints &sepc = copy.cs[sepd];
+    Rectangles  &sepr = copy.dimRs[sepd];
+    Variables   &alnv = copy.vs[alnd];
+    Constraints &alnc = copy.cs[alnd];
+    Rectangles  &alnr = copy.dimRs[alnd];
+    completeOrdAlign(&oa);
+    oa.separation->generateSeparationConstraints(sepd,sepv,sepc,sepr);
+    oa.alignment->generateVariables(alnd,alnv);
+    oa.alignment->generateSeparationConstraints(alnd,alnv,alnc,alnr);
+    Rectangle *newRect = makeRectForOA(&oa);
+    alnr.push_back(newRect);
+    int newRectIndex = alnv.size()-1;
+    copy.gi2ei[alnd].insert(std::pair<int,int>(newRectIndex,oa.edgeIndex));
+    copy.nocs[alnd]->addShape(newRectIndex, newRect->width()/2.0, newRect->height()/2.0, 1, exemptionSetForEdge(oa.edgeIndex));
+    updateVarsFromNodeRects(copy.rs, copy.vs[XDIM], copy.vs[YDIM]);
+    bool feasible = true;
+    IncSolver *seps = satisfy(sepv,sepc,feasible);
+    IncSolver *alns = nullptr;
+    if (feasible) alns = satisfy(alnv,alnc,feasible);
+    if (feasible) {
+        updateNodeRectsFromVars(copy.rs, copy.vs[XDIM], copy.vs[YDIM]);
+        recomputeEdgeShapes(alnd, copy.rs, alnv, copy.gi2ei[alnd], alnr, copy.nocs[alnd]);
+        size_t firstNew = alnc.size();
+        copy.nocs[alnd]->generateSeparationConstraints(alnd,alnv,alnc,alnr);
+        feasible = satisfy(alns,alnv,alnc,firstNew);
+    }
+    if (feasible) {
+        updateNodeRectsFromVars(copy.rs, copy.vs[XDIM], copy.vs[YDIM]);
+        recomputeEdgeShapes(sepd, copy.rs, sepv, copy.gi2ei[sepd], sepr, copy.nocs[sepd]);
+        size_t firstNew = sepc.size();
+        copy.nocs[sepd]->generateSeparationConstraints(sepd,sepv,sepc,sepr);
+        feasible = satisfy(seps,sepv,sepc,firstNew);
+    }
+    delete seps;
+    delete alns;
+    delete oa.separation;
+    delete oa.alignment;
+    return feasible;
+}
+
+// Test the candidates oas[begin..end) concurrently, setting infeasible[i - begin]
+// for each that applyIfFeasible would reject.
+void ACALayout::findInfeasible(const std::vector<OrderedAlignment*> &oas, size_t begin,
+        size_t end, std::vector<char> &infeasible)
+{
+    infeasible.assign(end - begin, 0);
+    cola::parallelFor(end - begin, m_concurrentFeasibilityChecks, [&](size_t i) {
+        try {
+            infeasible[i] = !feasibleOnCopy(oas[begin + i]);
+        } catch (...) {
+            // Leave it to applyIfFeasible to report the problem.
+            infeasible[i] = 0;
+        }
+    });
+}
+
 // Say whether the proposed separation is a bad one.
 bool ACALayout::badSeparation(int j, ACASepFlag sf)
 {
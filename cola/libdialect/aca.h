@@ -323,6 +323,39 @@ public:
      * to false. (But it will consider west only with it set to true.)
      */
     void aggressiveOrdering(bool b);
+    /**
+     * @brief Say how many candidate alignments to test for feasibility at once.
+     *
+     * The default value is 1. In this case each time an alignment is to be
+     * chosen, the candidates are tested for feasibility one at a time, in
+     * order of increasing penalty, until a feasible one is found.
+     *
+     * If you set this to k > 1, then the next k candidates are tested
+     * concurrently, on up to k threads, and the lowest-penalty candidate
+     * found to be feasible is applied. The alignments chosen are the same
+     * as when testing them one at a time.
+     *
+     * Each candidate is tested on its own deep copy of the node rectangles,
+     * variables, constraints and non-overlap constraints. The non-overlap
+     * constraints keep a record for each pair of nodes, so each copy takes
+     * O(n^2) time and memory for n nodes, which is only repaid when the
+     * solves for each candidate take longer than that.
+     */
+    void concurrentFeasibilityChecks(unsigned k);
+    /**
+     * @brief Say whether feasibility checks should reuse their solvers.
+     *
+     * The default value is false. In this case each feasibility check
+     * builds a new solver for the non-overlap constraints in each dimension,
+     * which solves the separation and alignment constraints again from
+     * scratch.
+     *
+     * If you set this to true, then the non-overlap constraints are instead
+     * added to the solvers that have just satisfied the separation and
+     * alignment constraints, and these are satisfied again starting from
+     * their last solution.
+     */
+    void warmStartChecks(bool b);
     /**
      * @brief  Specifies whether non-overlap constraints should be
      *         automatically generated between all nodes.
@@ -459,9 +492,18 @@ private:
     vpsc::Rectangle *makeRectForOA(OrderedAlignment *oa);
     vpsc::Rectangle *makeRectForEdge(int j, vpsc::Dim dim);
     void updateRectForEdge(vpsc::Rectangle *R, int j, vpsc::Dim dim);
+    void updateRectForEdge(vpsc::Rectangle *R, int j, vpsc::Dim dim,
+            const vpsc::Rectangles &nodeRects) const;
     void recomputeEdgeShapes(vpsc::Dim dim);
+    void recomputeEdgeShapes(vpsc::Dim dim, const vpsc::Rectangles &nodeRects,
+            vpsc::Variables &vs, std::map<int,int> &gi2ei, vpsc::Rectangles &rs,
+            cola::NonOverlapConstraints *nocs);
     void updateNodeRectsFromVars(void);
+    void updateNodeRectsFromVars(vpsc::Rectangles &rs, const vpsc::Variables &xvs,
+            const vpsc::Variables &yvs) const;
     void updateVarsFromNodeRects(void);
+    void updateVarsFromNodeRects(const vpsc::Rectangles &rs, vpsc::Variables &xvs,
+            vpsc::Variables &yvs) const;
     void pushState(void);
     void popState(void);
     void dropState(void);
@@ -474,7 +516,18 @@ private:
     bool createsOverlap(OrderedAlignment *oa);
     bool allOrNothing(OrderedAlignments oas);
     bool applyIfFeasible(OrderedAlignment *oa);
+    /**
+     * Copies of the variables, constraints, rectangles and non-overlap
+     * constraints, on which applyIfFeasible's checks can be run without
+     * changing this object.
+     */
+    class StateCopy;
+    bool feasibleOnCopy(const OrderedAlignment *candidate);
+    void findInfeasible(const std::vector<OrderedAlignment*> &oas, size_t begin,
+            size_t end, std::vector<char> &infeasible);
     vpsc::IncSolver *satisfy(vpsc::Variables &vs, vpsc::Constraints &cs, bool &sat);
+    bool satisfy(vpsc::IncSolver *&solv, vpsc::Variables &vs, vpsc::Constraints &cs,
+            size_t firstNew);
 
     // In the following methods, the separation flag always means the direction from src to tgt.
     void completeOrdAlign(OrderedAlignment *oa);
@@ -554,6 +607,8 @@ private:
     bool m_useNonLeafDegree;
     bool m_allAtOnce;
     bool m_aggressiveOrdering;
+    unsigned m_concurrentFeasibilityChecks = 1;
+    bool m_warmStartChecks = false;
 
     std::multimap<int,int> m_incidentEdges; // map node index to indices of incident edges
     std::multimap<int,int> m_nlincidentEdges; // map node index to indices of incident edges
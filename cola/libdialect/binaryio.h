@@ -0,0 +1,57 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libdialect - A library for computing DiAlEcT layouts:
+ *                 D = Decompose/Distribute
+ *                 A = Arrange
+ *                 E = Expand/Emend
+ *                 T = Transform
+ *
+ * Copyright (C) 2018  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef DIALECT_BINARYIO_H
+#define DIALECT_BINARYIO_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace dialect {
+
+// Appends an unsigned integer to a string, as written in the binary graph
+// format: four bytes, least significant first.
+static inline void appendBinaryUnsigned(std::string &out, uint32_t u)
+{
+    for (unsigned i = 0; i < 4; ++i) {
+        out.push_back((char) ((u >> (8*i)) & 0xff));
+    }
+}
+
+// Appends a double to a string, as written in the binary graph format: the
+// eight bytes of its IEEE 754 representation, least significant first.
+static inline void appendBinaryDouble(std::string &out, double d)
+{
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    for (unsigned i = 0; i < 8; ++i) {
+        out.push_back((char) ((bits >> (8*i)) & 0xff));
+    }
+}
+
+} // namespace dialect
+
+#endif // DIALECT_BINARYIO_H
@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <utility>
 #include <cmath>
+#include <cstdint>
 
 #include "libvpsc/assertions.h"
 #include "libvpsc/constraint.h"
@@ -44,6 +45,9 @@
 #include "libdialect/constraints.h"
 #include "libdialect/util.h"
 #include "libdialect/ortho.h"
+#include "libdialect/io.h"
+#include "libdialect/binaryio.h"
+#include "libdialect/textio.h"
 
 using namespace dialect;
 
@@ -306,17 +310,17 @@ CardinalDir SepPair::getCardinalDir(void) const {
     }
 }
 
-string SepPair::writeTglf(std::map<id_type, unsigned> id2ext, const SepMatrix &m) const {
+string SepPair::writeTglf(const std::map<id_type, unsigned> &id2ext, const SepMatrix &m) const {
     // If no constraints, return empty string.
     if (xst == SepType::NONE && yst == SepType::NONE) return "";
     // Prepare strings.
     double xExtraGap = xgt == GapType::BDRY ? m.getExtraBdryGap() : 0.0,
            yExtraGap = ygt == GapType::BDRY ? m.getExtraBdryGap() : 0.0;
     string fmtStr = string_format("%%.%df", tglfPrecision),
-           xgapStr = string_format(fmtStr, xgap + xExtraGap),
-           ygapStr = string_format(fmtStr, ygap + yExtraGap),
-           nxgapStr = string_format(fmtStr, -xgap + xExtraGap),
-           nygapStr = string_format(fmtStr, -ygap + yExtraGap),
+           xgapStr = formatTglfNumber(fmtStr.c_str(), xgap + xExtraGap),
+           ygapStr = formatTglfNumber(fmtStr.c_str(), ygap + yExtraGap),
+           nxgapStr = formatTglfNumber(fmtStr.c_str(), -xgap + xExtraGap),
+           nygapStr = formatTglfNumber(fmtStr.c_str(), -ygap + yExtraGap),
            xgtStr = xgt == GapType::BDRY ? "B" : "C",
            ygtStr = ygt == GapType::BDRY ? "B" : "C";
     // Prepare indices.
@@ -516,12 +520,24 @@ void SepMatrix::roundGapsUpward(void) {
     }
 }
 
+void SepMatrix::copySepPairs(void) {
+    // The subconstraint infos belong to the original, and will be rebuilt
+    // from our own SepPairs when they are next needed.
+    _subConstraintInfo.clear();
+    _currSubConstraintIndex = 0;
+    for (auto &p : m_sparseLookup) {
+        for (auto &q : p.second) {
+            q.second = std::make_shared<SepPair>(*q.second);
+        }
+    }
+}
+
 CardinalDir SepMatrix::getCardinalDir(id_type id1, id_type id2) const {
     SepPair_SP sp = checkSepPair(id1, id2);
     if (sp == nullptr) throw std::runtime_error("No constraint.");
     CardinalDir d = sp->getCardinalDir();
     // Flip if necessary.
-    if (sp->flippedRetrieval) d = Compass::cardFlip(d);
+    if (sp->src != id1) d = Compass::cardFlip(d);
     return d;
 }
 
@@ -852,11 +868,11 @@ void SepMatrix::setCorrespondingConstraints(SepMatrix &matrix) const {
     }
 }
 
-string SepMatrix::writeTglf(std::map<id_type, unsigned> id2ext) const {
+string SepMatrix::writeTglf(const std::map<id_type, unsigned> &id2ext) const {
     std::ostringstream ss;
-    for (auto p : m_sparseLookup) {
-        for (auto q : p.second) {
-            SepPair_SP &sp = q.second;
+    for (const auto &p : m_sparseLookup) {
+        for (const auto &q : p.second) {
+            const SepPair_SP &sp = q.second;
             string s = sp->writeTglf(id2ext, *this);
             if (!s.empty()) ss << s;
         }
@@ -864,6 +880,33 @@ string SepMatrix::writeTglf(std::map<id_type, unsigned> id2ext) const {
     return ss.str();
 }
 
+// Appends the constraint in one dimension of a SepPair in the binary graph format.
+static void appendBinarySep(string &out, GapType gt, SepType st, double gap) {
+    out.push_back(gt == GapType::BDRY ? 'B' : 'C');
+    out.push_back(st == SepType::EQ ? '=' : st == SepType::INEQ ? '>' : '-');
+    appendBinaryDouble(out, gap);
+}
+
+void SepMatrix::writeBinary(string &out, const std::map<id_type, unsigned> &id2ext) const {
+    string pairs;
+    uint32_t count = 0;
+    for (const auto &p : m_sparseLookup) {
+        for (const auto &q : p.second) {
+            const SepPair_SP &sp = q.second;
+            if (sp->xst == SepType::NONE && sp->yst == SepType::NONE) continue;
+            auto src = id2ext.find(sp->src), tgt = id2ext.find(sp->tgt);
+            appendBinaryUnsigned(pairs, src == id2ext.end() ? sp->src : src->second);
+            appendBinaryUnsigned(pairs, tgt == id2ext.end() ? sp->tgt : tgt->second);
+            appendBinarySep(pairs, sp->xgt, sp->xst, sp->xgap);
+            appendBinarySep(pairs, sp->ygt, sp->yst, sp->ygap);
+            ++count;
+        }
+    }
+    appendBinaryDouble(out, m_extraBdryGap);
+    appendBinaryUnsigned(out, count);
+    out += pairs;
+}
+
 SepPair_SP &SepMatrix::getSepPair(id_type id1, id_type id2) {
     if (id1 == id2) {
         throw std::runtime_error("Cannot set a constraint between a node and itself.");
@@ -904,9 +947,7 @@ SepPair_SP SepMatrix::checkSepPair(id_type id1, id_type id2) const {
             if (jt == m.end()) {
                 return nullptr;
             } else {
-                SepPair_SP sp = (*jt).second;
-                sp->flippedRetrieval = flipped;
-                return sp;
+                return (*jt).second;
             }
         }
     }
@@ -956,6 +997,18 @@ string SepMatrix::toString(void) const {
     return ss.str();
 }
 
+size_t SepMatrix::numConstraints(void) const {
+    size_t n = 0;
+    for (const auto &p : m_sparseLookup) {
+        for (const auto &q : p.second) {
+            const SepPair_SP &sp = q.second;
+            if (sp->hasConstraintInDim(vpsc::XDIM)) ++n;
+            if (sp->hasConstraintInDim(vpsc::YDIM)) ++n;
+        }
+    }
+    return n;
+}
+
 void SepMatrix::markAllSubConstraintsAsInactive(void) {
     // We take advantage of this opportunity to refresh our list of subconstraint infos, since
     // new SepPairs may have been added to the SepMatrix.
@@ -132,8 +132,8 @@ struct SepPair {
     //! storage matrix itself. Above this deepest layer is the layer of getter/setter methods, which are public and
     //! for use by clients.
     //!
-    //! As an aid to this design, the SepPair struct stores a 'flippedRetrieval' field. The field is set by the deep
-    //! layer methods, to report whether the SepPair is flipped relative to the given IDs. It is used by the public
+    //! As an aid to this design, the SepPair struct stores a 'flippedRetrieval' field. The field is set by getSepPair,
+    //! to report whether the SepPair is flipped relative to the given IDs. It is used by the public
     //! layer methods when getting and setting, in order to know when the constraint needs to be flipped.
     //! Clients must understand that, outside of this context, this field is meaningless!
     bool flippedRetrieval = false;
@@ -164,7 +164,7 @@ struct SepPair {
     //! @brief  Write a representation of this constraint in the format of
     //!         the SEPCO'S section of the TGLF file format.
     //! @param[in] id2ext  Mapping from internal Node IDs to external IDs for the TGLF output.
-    std::string writeTglf(std::map<id_type, unsigned> id2ext, const SepMatrix &m) const;
+    std::string writeTglf(const std::map<id_type, unsigned> &id2ext, const SepMatrix &m) const;
     //! @brief  Check whether there is a constraint in a given dimension.
     bool hasConstraintInDim(vpsc::Dim dim) const;
     //! @brief  Write the VPSC constraint in one dimension.
@@ -262,6 +262,13 @@ public:
     //! @note We do not destroy the SepPairs; we merely erase our pointers to them.
     void clear(void) { m_sparseLookup.clear(); }
 
+    //! @brief  Replace each SepPair with a copy of it.
+    //!
+    //! A copied SepMatrix shares its SepPairs with the original, as well as the
+    //! infos for its subconstraints, which it drops here. After this, the two
+    //! can be changed independently, and used on different threads.
+    void copySepPairs(void);
+
     //! @brief  Set corresponding constraints in another SepMatrix.
     //!
     //!         This means that for each constraint between nodes of IDs id1 and id2 in this
@@ -309,6 +316,9 @@ public:
     //! @param[out] vSets  Like hSets, only for vertical alignment.
     void getAlignedSets(std::map<id_type, std::set<id_type>> &hSets,
                         std::map<id_type, std::set<id_type>> &vSets) const;
+    //! @brief  Count the constraints, counting each dimension of each SepPair
+    //!         separately.
+    size_t numConstraints(void) const;
     //! @brief  Check whether two nodes are horizontally aligned.
     bool areHAligned(id_type id1, id_type id2) const;
     //! @brief  Check whether two nodes are vertically aligned.
@@ -316,7 +326,12 @@ public:
     //! @brief  Write a representation of all constraints in the format of
     //!         the SEPCO'S section of the TGLF file format.
     //! @param[in] id2ext  Mapping from internal Node IDs to external IDs for the TGLF output.
-    std::string writeTglf(std::map<id_type, unsigned> id2ext) const;
+    std::string writeTglf(const std::map<id_type, unsigned> &id2ext) const;
+    //! @brief  Append all constraints to a string, as the SEPCOS section of the
+    //!         binary graph format.
+    //! @param[in,out] out  The string to which to append.
+    //! @param[in] id2ext  Mapping from internal Node IDs to external IDs for the output.
+    void writeBinary(std::string &out, const std::map<id_type, unsigned> &id2ext) const;
     //! @brief  Set the related Graph.
     void setGraph(Graph *G) { m_graph = G; }
     //! @brief  Get the Graph.
@@ -366,6 +381,10 @@ private:
     //! intention is to in any way modify an existing constraint then you should NOT be using
     //! this method.
     //! This method will NOT allocate a new SepPair in the matrix under any circumstance.
+    //! Nor does it set the 'flippedRetrieval' field, since it may be called on several
+    //! threads at once, as when tree placements are compared. Clients can check whether
+    //! the IDs had to be flipped by checking whether id1 equals the src ID in the
+    //! returned SepPair.
     SepPair_SP checkSepPair(id_type id1, id_type id2) const;
 
     //! We don't mind using a raw pointer since (a) it is quite clear that a SepMatrix
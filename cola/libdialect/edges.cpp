@@ -33,6 +33,7 @@
 #include "libavoid/libavoid.h"
 #include "libdialect/util.h"
 #include "libdialect/graphs.h"
+#include "libdialect/textio.h"
 
 using namespace dialect;
 
@@ -103,11 +104,14 @@ void Edge::addRoutePoint(double x, double y) {
 }
 
 string Edge::writeRouteTglf(void) const {
-    ostringstream tglf;
-    for (auto pt : m_route) {
-        tglf << " " << pt.x << " " << pt.y;
+    string tglf;
+    for (const Point &pt : m_route) {
+        tglf += ' ';
+        appendTglfNumber(tglf, pt.x);
+        tglf += ' ';
+        appendTglfNumber(tglf, pt.y);
     }
-    return tglf.str();
+    return tglf;
 }
 
 std::pair<ConnEnd, ConnEnd> Edge::makeLibavoidConnEnds(Avoid::ConnDirFlags srcDirs, Avoid::ConnDirFlags tgtDirs) {
@@ -56,6 +56,20 @@ id_type Face::nextID = 0;
 FaceSet::FaceSet(Graph_SP &G)
     : m_graph(G)
 {
+    buildFaces();
+    // Compute aligned sets.
+    m_graph->getSepMatrix().getAlignedSets(m_hSets, m_vSets);
+}
+
+FaceSet::FaceSet(Graph_SP &G, const FaceSet &original)
+    : m_graph(G),
+      m_hSets(original.m_hSets),
+      m_vSets(original.m_vSets)
+{
+    buildFaces();
+}
+
+void FaceSet::buildFaces(void) {
     // Compute the faces and identify the external one.
     computeFaces();
     identifyExternalFace();
@@ -65,8 +79,34 @@ FaceSet::FaceSet(Graph_SP &G)
             m_facesByMemberNodeId[node->id()].insert(face);
         }
     }
-    // Compute aligned sets.
-    m_graph->getSepMatrix().getAlignedSets(m_hSets, m_vSets);
+}
+
+FaceSet_SP FaceSet::isolatedCopy(void) const {
+    Graph_SP H = m_graph->isolatedCopy();
+    // The aligned sets were computed before any tree boxes were inserted, so the
+    // copy takes them from here rather than computing them again.
+    FaceSet_SP copy(new FaceSet(H, *this));
+    COLA_ASSERT(copy->m_faces.size() == m_faces.size());
+    // Record the tree boxes inserted so far, by placements like those that inserted them.
+    for (size_t i = 0; i < m_faces.size(); ++i) {
+        for (auto p : m_faces[i]->m_treePlacementsByNodeIds) {
+            TreePlacement_SP tp = p.second;
+            if (tp == nullptr) continue;
+            copy->m_faces[i]->recordTreeNode(copy->copyPlacement(*tp, *this),
+                                             H->getNode(tp->getBoxNode()->id()));
+        }
+    }
+    return copy;
+}
+
+TreePlacement_SP FaceSet::copyPlacement(TreePlacement &tp, const FaceSet &original) const {
+    Face *face = &tp.getFace();
+    auto it = std::find_if(original.m_faces.begin(), original.m_faces.end(), [face](const Face_SP &F)->bool{
+        return F.get() == face;
+    });
+    COLA_ASSERT(it != original.m_faces.end());
+    Face_SP F = m_faces.at(it - original.m_faces.begin());
+    return std::make_shared<TreePlacement>(tp, *F, m_graph->getNode(tp.getRootNode()->id()));
 }
 
 //! Face traversal code adapted from
@@ -176,6 +216,8 @@ void FaceSet::identifyExternalFace(void) {
     double max_x = std::numeric_limits<double>::min();
     for (auto pair : m_graph->getNodeLookup()) {
         Node_SP &v = pair.second;
+        // Tree boxes have no Edges, and belong to no Face.
+        if (v->getDegree() == 0) continue;
         Point p = v->getCentre();
         if (p.x > max_x) {
             u = v;
@@ -456,9 +498,7 @@ Sides Face::getRelevantSidesForPlacement(TreePlacement_SP tp) const {
 }
 
 void Face::insertTreeNode(TreePlacement_SP tp, double padding) {
-    // First ask the relevant Side object(s) to note the placement.
-    for (Side_SP S : getRelevantSidesForPlacement(tp)) S->addTreePlacement(tp);
-    // Now insert the tree node.
+    // Build the tree node.
     Node_SP treeNode = tp->buildTreeBox(padding),
             rootNode = tp->getRootNode();
     // The dimensions of the treeNode are already as we want them.
@@ -470,14 +510,18 @@ void Face::insertTreeNode(TreePlacement_SP tp, double padding) {
     treeNode->setCentre(ct.x + cr.x, ct.y + cr.y);
     // Now add the tree node to the graph.
     m_graph->addNode(treeNode);
+    recordTreeNode(tp, treeNode);
+    // Constrain the tree node to sit beside the root node.
+    m_graph->getSepMatrix().addFixedRelativeSep(rootNode->id(), treeNode->id(), ct.x, ct.y);
+}
+
+void Face::recordTreeNode(TreePlacement_SP tp, Node_SP treeNode) {
+    // Ask the relevant Side object(s) to note the placement.
+    for (Side_SP S : getRelevantSidesForPlacement(tp)) S->addTreePlacement(tp);
     // Keep records.
-    id_type tid = treeNode->id(),
-            rid = rootNode->id();
-    m_treeNodes.insert({tid, treeNode});
-    m_treePlacementsByNodeIds[rid] = tp;
+    m_treeNodes.insert({treeNode->id(), treeNode});
+    m_treePlacementsByNodeIds[tp->getRootNode()->id()] = tp;
     tp->recordBoxNode(treeNode);
-    // Constrain the tree node to sit beside the root node.
-    m_graph->getSepMatrix().addFixedRelativeSep(rid, tid, ct.x, ct.y);
 }
 
 ProjSeq_SP Face::computeCollateralProjSeq(TreePlacement_SP tp, double padding) {
@@ -551,7 +595,10 @@ void Face::buildBdrySegsFacingOneDir(CardinalDir facingDir,
             openSegs.push_back(b.buildSideSegment(facingDir));
             // If a tree box has been placed here, build an open interval for its facing side
             // (unless we're supposed to ignore this one).
-            TreePlacement_SP tp = m_treePlacementsByNodeIds[uid];
+            // (We look the placement up without inserting, since this may run on several
+            // threads at once, as when tree placements are compared.)
+            auto jt = m_treePlacementsByNodeIds.find(uid);
+            TreePlacement_SP tp = jt == m_treePlacementsByNodeIds.end() ? nullptr : jt->second;
             if (tp != nullptr && ignoreTreeBoxNodeIds.find(uid) == ignoreTreeBoxNodeIds.end()) {
                 // We use *unpadded* tree boxes when considering where the boundary lies.
                 double padding = 0;
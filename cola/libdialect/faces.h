@@ -279,8 +279,28 @@ public:
     //!                         the number of nodes in trees that grow in the given directions.
     std::map<CardinalDir, size_t> getNumTreesByGrowthDir(bool scaleBySize=false) const;
 
+    //! @brief  Build a copy of this FaceSet, over an isolated copy of its Graph,
+    //!         with the tree boxes inserted so far.
+    //!
+    //! Expansions can then be tried in the copy, even on another thread, without
+    //! moving the Nodes of this FaceSet's Graph.
+    //! @sa Graph::isolatedCopy.
+    FaceSet_SP isolatedCopy(void) const;
+
+    //! @brief  Make a TreePlacement into this FaceSet like a given one into
+    //!         another FaceSet, of which this one is an isolated copy.
+    //! @param[in] tp  The TreePlacement to be copied.
+    //! @param[in] original  The FaceSet into which tp places its Tree.
+    TreePlacement_SP copyPlacement(TreePlacement &tp, const FaceSet &original) const;
+
 private:
 
+    //! Construct over an isolated copy of the Graph of an original FaceSet,
+    //! taking the aligned sets from the original.
+    FaceSet(Graph_SP &G, const FaceSet &original);
+
+    //! Part of construction; compute the Faces, and index them by their Nodes.
+    void buildFaces(void);
     //! Part of construction; compute and store all the Faces of the given Graph.
     void computeFaces(void);
     //! Part of construction; determine which is the external Face.
@@ -368,6 +388,12 @@ public:
     //! @sa TreePlacement::getTreeBox for interpretation of the padding.
     void insertTreeNode(TreePlacement_SP tp, double padding=0);
 
+    //! @brief  Record a tree node that is already in the graph, as placed by the
+    //!         given TreePlacement. This is part of insertTreeNode.
+    //! @param[in] tp  The TreePlacement by which the Tree was placed.
+    //! @param[in] treeNode  The tree node.
+    void recordTreeNode(TreePlacement_SP tp, Node_SP treeNode);
+
     //! @brief  Compute a projection sequence to remove/prevent overlaps between the given
     //!         TreePlacement's tree box, and any existing tree boxes or ordinary perimeter
     //!         Nodes on relevant Sides of this Face.
@@ -31,6 +31,7 @@
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <set>
 #include <stdexcept>
 #include <cmath>
 #include <iterator>
@@ -43,6 +44,8 @@
 
 #include "libdialect/constraints.h"
 #include "libdialect/io.h"
+#include "libdialect/binaryio.h"
+#include "libdialect/textio.h"
 #include "libdialect/util.h"
 #include "libdialect/ortho.h"
 #include "libdialect/logging.h"
@@ -70,7 +73,7 @@ using cola::CompoundConstraints;
 
 using Avoid::Point;
 
-id_type Node::nextID = 0;
+std::atomic<id_type> Node::nextID(0);
 id_type Edge::nextID = 0;
 
 //! @brief  Adding two bounding boxes returns the bounding box of their union.
@@ -128,6 +131,8 @@ Graph::Graph(const Graph &G)
 {
     // We deliberately do not copy any of the "cola stuff",
     // namely m_cgr, m_needNewRectangles, and m_cfdl.
+    // In particular the shortest paths kept by m_cfdl are not copied, but
+    // computed again if the copy needs them.
 
     // As for the SepMatrix, we are happy to have a copy of that from
     // the existing Graph, except our copy must point back to this Graph.
@@ -145,6 +150,28 @@ Graph &Graph::operator=(Graph other) {
     return *this;
 }
 
+Graph_SP Graph::isolatedCopy(void) const {
+    Graph_SP H = std::make_shared<Graph>();
+    H->m_debugOutputPath = m_debugOutputPath;
+    H->m_projectionDebugLevel = m_projectionDebugLevel;
+    H->m_iel = m_iel;
+    H->m_edge_thickness = m_edge_thickness;
+    for (auto p : m_nodes) {
+        GhostNode_SP g = p.second->makeGhost();
+        g->setMasquerade(true);
+        H->addNode(g);
+    }
+    // Edges are added in order of ID, so that the copy's Edges are in the same order.
+    for (auto p : m_edges) {
+        Edge_SP &e = p.second;
+        H->addEdge(e->getSourceEnd()->id(), e->getTargetEnd()->id());
+    }
+    H->m_sepMatrix = m_sepMatrix;
+    H->m_sepMatrix.setGraph(H.get());
+    H->m_sepMatrix.copySepPairs();
+    return H;
+}
+
 unsigned Graph::getMaxDegree(void) const {
     return m_maxDeg;
 }
@@ -510,67 +537,111 @@ void Graph::getChainsAndCycles(std::vector<std::deque<Node_SP> > &chains, std::v
     }
 }
 
+map<id_type, unsigned> Graph::makeExternalIdMap(void) const {
+    /* We will write external IDs for all Nodes for which they have been set.
+     * However, in case there are some nodes that do not have external IDs (which happens,
+     * for example, when new nodes, such as bend nodes, have been generated), we first
+     * determine the maximum external ID, and then generate new IDs based on that.
+    */
+    map<id_type, unsigned> id2ext;
+    int max_ext_id = -1;
+    int first_int_id_lacking_ext = -1;
+    for (const auto &pair : m_nodes) {
+        id_type id = pair.first;
+        const Node_SP &u = pair.second;
+        int ext_id = u->getExternalId();
+        max_ext_id = max(max_ext_id, ext_id);
+        if (ext_id == -1 && first_int_id_lacking_ext == -1) first_int_id_lacking_ext = id;
+    }
+    int base_id = max_ext_id + 1;
+    // However, to make debugging easier, we also want to avoid shifting any internal IDs
+    // unless necessary in order to avoid collisions.
+    if (first_int_id_lacking_ext > max_ext_id) base_id = 0;
+    for (const auto &pair : m_nodes) {
+        int ext_id = pair.second->getExternalId();
+        if (ext_id < 0) ext_id = base_id + pair.first;
+        id2ext.insert(id2ext.end(), {pair.first, ext_id});
+    }
+    return id2ext;
+}
+
 string Graph::writeTglf(bool useExternalIds) const {
     map<id_type, unsigned> id2ext;
-    int base_id = 0;
-    ostringstream ss, edges_ss;
+    if (useExternalIds) id2ext = makeExternalIdMap();
+    string tglf, edges_tglf;
     // Nodes
-    if (useExternalIds) {
-        /* We will write external IDs for all Nodes for which they have been set.
-         * However, in case there are some nodes that do not have external IDs (which happens,
-         * for example, when new nodes, such as bend nodes, have been generated), we first
-         * determine the maximum external ID, and then generate new IDs based on that.
-        */
-        int max_ext_id = -1;
-        int first_int_id_lacking_ext = -1;
-        for (auto pair : m_nodes) {
-            id_type id = pair.first;
-            Node_SP &u = pair.second;
-            int ext_id = u->getExternalId();
-            max_ext_id = max(max_ext_id, ext_id);
-            if (ext_id == -1 && first_int_id_lacking_ext == -1) first_int_id_lacking_ext = id;
-        }
-        base_id = max_ext_id + 1;
-        // However, to make debugging easier, we also want to avoid shifting any internal IDs
-        // unless necessary in order to avoid collisions.
-        if (first_int_id_lacking_ext > max_ext_id) base_id = 0;
-    }
-    for (auto pair : m_nodes) {
-        id_type id = pair.first;
-        Node_SP node = pair.second;
-        Point c = node->getCentre();
-        dimensions d = node->getDimensions();
-        if (useExternalIds) {
-            int ext_id = node->getExternalId();
-            if (ext_id < 0) ext_id = base_id + id;
-            id2ext.insert({id, ext_id});
-            id = (id_type) ext_id;
+    for (const auto &pair : m_nodes) {
+        id_type id = useExternalIds ? id2ext.at(pair.first) : pair.first;
+        Point c = pair.second->getCentre();
+        dimensions d = pair.second->getDimensions();
+        tglf += std::to_string(id);
+        for (double x : {c.x, c.y, d.first, d.second}) {
+            tglf += ' ';
+            appendTglfNumber(tglf, x);
         }
-        ss << id << " " << c.x << " " << c.y << " " << d.first << " " << d.second << "\n";
+        tglf += '\n';
     }
     // Edges
-    for (auto p : m_edges) {
+    for (const auto &p : m_edges) {
         id_type sid = p.second->getSourceEnd()->id(),
                 tid = p.second->getTargetEnd()->id();
         if (useExternalIds) {
             sid = id2ext.at(sid);
             tid = id2ext.at(tid);
         }
-        edges_ss << sid << " " << tid << p.second->writeRouteTglf() << "\n";
+        edges_tglf += std::to_string(sid) + ' ' + std::to_string(tid) + p.second->writeRouteTglf() + '\n';
     }
-    string edges_tglf = edges_ss.str();
     // SepCos
     string sepcos_tglf = m_sepMatrix.writeTglf(id2ext);
     // Put it all together.
     bool have_edges  = !edges_tglf.empty(),
          have_sepcos = !sepcos_tglf.empty();
     if (have_edges || have_sepcos) {
-        ss << "#\n" << edges_tglf;
+        tglf += "#\n" + edges_tglf;
         if (have_sepcos) {
-            ss << "#\n" << sepcos_tglf;
+            tglf += "#\n" + sepcos_tglf;
         }
     }
-    return ss.str();
+    return tglf;
+}
+
+string Graph::writeBinary(bool useExternalIds) const {
+    map<id_type, unsigned> id2ext;
+    if (useExternalIds) id2ext = makeExternalIdMap();
+    string out("DLGB");
+    appendBinaryUnsigned(out, binaryGraphFormatVersion);
+    // Nodes
+    appendBinaryUnsigned(out, (uint32_t) m_nodes.size());
+    for (const auto &pair : m_nodes) {
+        Point c = pair.second->getCentre();
+        dimensions d = pair.second->getDimensions();
+        appendBinaryUnsigned(out, useExternalIds ? id2ext.at(pair.first) : pair.first);
+        appendBinaryDouble(out, c.x);
+        appendBinaryDouble(out, c.y);
+        appendBinaryDouble(out, d.first);
+        appendBinaryDouble(out, d.second);
+    }
+    // Edges
+    appendBinaryUnsigned(out, (uint32_t) m_edges.size());
+    for (const auto &p : m_edges) {
+        id_type sid = p.second->getSourceEnd()->id(),
+                tid = p.second->getTargetEnd()->id();
+        if (useExternalIds) {
+            sid = id2ext.at(sid);
+            tid = id2ext.at(tid);
+        }
+        appendBinaryUnsigned(out, sid);
+        appendBinaryUnsigned(out, tid);
+        const vector<Point> &route = p.second->getRoute();
+        appendBinaryUnsigned(out, (uint32_t) route.size());
+        for (const Point &pt : route) {
+            appendBinaryDouble(out, pt.x);
+            appendBinaryDouble(out, pt.y);
+        }
+    }
+    // SepCos
+    m_sepMatrix.writeBinary(out, id2ext);
+    return out;
 }
 
 string Graph::writeSvg(bool useExternalIds) const {
@@ -632,20 +703,41 @@ double Graph::computeStress(void) {
 }
 
 ColaGraphRep &Graph::updateColaGraphRep(void) {
+    // Indices of Rectangles whose Nodes are gone, and whether any new
+    // Nodes come after all the old ones.
+    std::vector<size_t> removedIxs;
+    bool newNodesLast = true;
+    vpsc::Rectangles oldRs;
     // Only redo the Rectangles and index maps if necessary.
     if (m_needNewRectangles) {
-        for (auto r : m_cgr.rs) delete r;
-        m_cgr.rs.clear();
-        m_cgr.id2ix.clear();
+        // The Rectangles of Nodes we already had are kept, since our CFDL
+        // refers to them.
+        std::map<id_type, size_t> oldIxs;
+        oldIxs.swap(m_cgr.id2ix);
+        oldRs.swap(m_cgr.rs);
         m_cgr.ix2id.clear();
         size_t i = 0;
+        bool sawNewNode = false;
         for (auto p : m_nodes) {
             BoundingBox b = p.second->getBoundingBox();
-            m_cgr.rs.push_back(new Rectangle(b.x, b.X, b.y, b.Y));
+            Rectangle r(b.x, b.X, b.y, b.Y);
+            auto it = oldIxs.find(p.first);
+            if (it != oldIxs.end()) {
+                *oldRs[it->second] = r;
+                m_cgr.rs.push_back(oldRs[it->second]);
+                oldRs[it->second] = nullptr;
+                if (sawNewNode) newNodesLast = false;
+            } else {
+                m_cgr.rs.push_back(new Rectangle(r));
+                sawNewNode = true;
+            }
             m_cgr.id2ix.emplace(p.first, i);
             m_cgr.ix2id.emplace(i, p.first);
             ++i;
         }
+        for (size_t j = 0; j < oldRs.size(); ++j) {
+            if (oldRs[j] != nullptr) removedIxs.push_back(j);
+        }
         // Note that it is now unnecessary to recompute Rectangles.
         m_needNewRectangles = false;
     }
@@ -659,14 +751,44 @@ ColaGraphRep &Graph::updateColaGraphRep(void) {
         );
     }
     // Update the CFDL too.
-    delete m_cfdl;
-    m_cfdl = new cola::ConstrainedFDLayout(
-        m_cgr.rs, m_cgr.es, m_iel
-    );
+    updateStressLayout(removedIxs, newNodesLast);
+    for (Rectangle *r : oldRs) delete r;
     // Return
     return m_cgr;
 }
 
+void Graph::updateStressLayout(const std::vector<size_t> &removedIxs, bool newNodesLast) {
+    // The changes can be applied only if the CFDL's Nodes are still in the same order.
+    if (m_cfdl == nullptr || !newNodesLast || m_cfdl->m_idealEdgeLength != m_iel) {
+        delete m_cfdl;
+        m_cfdl = new cola::ConstrainedFDLayout(
+            m_cgr.rs, m_cgr.es, m_iel
+        );
+        return;
+    }
+    // Remove Nodes from the back, so that the indices of the rest stay valid.
+    for (auto it = removedIxs.rbegin(); it != removedIxs.rend(); ++it) {
+        m_cfdl->removeNode((unsigned) *it);
+    }
+    for (size_t i = m_cfdl->n; i < m_cgr.rs.size(); ++i) {
+        m_cfdl->addNode(m_cgr.rs[i]);
+    }
+    // Compare the edges it has with those we need.
+    auto ends = [](const cola::Edge &e)->cola::Edge{
+        return cola::Edge(std::min(e.first, e.second), std::max(e.first, e.second));
+    };
+    std::multiset<cola::Edge> have, need;
+    for (const cola::Edge &e : m_cfdl->m_edges) have.insert(ends(e));
+    for (const cola::Edge &e : m_cgr.es) need.insert(ends(e));
+    std::vector<cola::Edge> added, dropped;
+    std::set_difference(need.begin(), need.end(), have.begin(), have.end(),
+                        std::back_inserter(added));
+    std::set_difference(have.begin(), have.end(), need.begin(), need.end(),
+                        std::back_inserter(dropped));
+    for (const cola::Edge &e : dropped) m_cfdl->removeEdge(e);
+    for (const cola::Edge &e : added) m_cfdl->addEdge(e);
+}
+
 cola::RootCluster *Graph::buildRootCluster(const ColaOptions &opts) {
     // Delete the old cluster, if any.
     delete m_cgr.rc;
@@ -929,6 +1051,9 @@ void Graph::destress(const ColaOptions &opts) {
             cola::ConstrainedFDLayout alg(
                         m_cgr.rs, m_cgr.es, iel, opts.eLengths, opts.doneTest, opts.preIteration
             );
+            // Our CFDL keeps the shortest paths up to date with changes to the Graph,
+            // so unless other edge lengths are wanted they need not be recomputed.
+            if (opts.eLengths.empty()) alg.sharePathLengths(*m_cfdl);
             alg.setAvoidNodeOverlaps(opts.preventOverlaps);
             alg.setUseNeighbourStress(opts.useNeighbourStress);
             alg.setConstraints(ccs);
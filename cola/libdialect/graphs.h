@@ -26,6 +26,7 @@
 #define DIALECT_GRAPHS_H
 
 #include <vector>
+#include <atomic>
 #include <cfloat>
 #include <string>
 #include <map>
@@ -207,6 +208,16 @@ public:
     //! @note  Pass-by-value is deliberate. See https://stackoverflow.com/a/3279550
     Graph &operator=(const Graph other);
 
+    //! @brief  Make a copy of this Graph that shares none of its Nodes, Edges or
+    //!         constraints, so that the copy can be laid out, even on another
+    //!         thread, without moving the Nodes of this Graph.
+    //!
+    //! Each Node is represented by a GhostNode masquerading as it, so the copy
+    //! has the same Node IDs, and a copy of our SepMatrix applies to it.
+    //!
+    //! @return  The copy.
+    Graph_SP isolatedCopy(void) const;
+
     //! @brief  Reports the maximum degree of any Node in this Graph.
     //!
     //! The value is automatically maintained as you add or remove Nodes
@@ -424,6 +435,12 @@ public:
     //! @return  A string containing the TGLF.
     std::string writeTglf(bool useExternalIds = false) const;
 
+    //! @brief  Write this Graph in the binary graph format.
+    //! @param[in] useExternalIds  As for writeTglf().
+    //! @return  A string containing the binary data.
+    //! @sa buildGraphFromBinary
+    std::string writeBinary(bool useExternalIds = false) const;
+
     //! @brief  Write SVG to represent this Graph.
     //! @param[in] useExternalIds  When a Graph is built from TGLF its Nodes store the IDs that
     //!                            were used there. Set true if you want these same IDs to be
@@ -560,9 +577,10 @@ public:
     //! @brief  Refresh, as needed, the data structures necessary for applying the
     //!         methods of libcola to this Graph.
     //!
-    //! @warning  If Nodes have been added to or removed from the Graph since the
-    //!           last time this method was called, the old Rectangles will be
-    //!           deleted.
+    //! @warning  If Nodes have been removed from the Graph since the last time
+    //!           this method was called, their Rectangles will be deleted. If
+    //!           any have been added or removed, the Rectangles of the rest are
+    //!           reset to the Nodes' bounding boxes.
     //!
     //!           Clients are therefore advised to utilise methods like Graph::destress
     //!           instead of creating their own instances of ConstrainedFDLayout. At the
@@ -701,6 +719,10 @@ private:
     //! @return  The chosen ideal edge length.
     double autoInferIEL(void);
 
+    //! @brief  Map the ID of each Node to the ID written for it when external IDs
+    //!         are requested: its external ID, or a new ID if it has none.
+    std::map<id_type, unsigned> makeExternalIdMap(void) const;
+
     //! Sometimes we need to recompute the max degree, as when a Graph is
     //! modified or constructed programmatically in certain ways.
     void recomputeMaxDegree(void);
@@ -711,12 +733,24 @@ private:
     //! Common implementation for the two directional 90-degree rotation methods.
     void rotate90(PlaneMap nodeMap, std::function<void(Edge_SP)> edgeMap, SepTransform st, ColaOptions *opts=nullptr);
 
+    //! @brief  Bring our ConstrainedFDLayout up to date with the ColaGraphRep.
+    //!
+    //! Where possible the changes are applied to the existing layout, which
+    //! then only has to recompute the shortest paths they affect.
+    //!
+    //! @param[in] removedIxs  The former indices, in increasing order, of
+    //!                        Rectangles whose Nodes have been removed.
+    //! @param[in] newNodesLast  Whether all new Nodes come after the others.
+    void updateStressLayout(const std::vector<size_t> &removedIxs, bool newNodesLast);
+
     //! For building ConstrainedFDLayout objects we keep a ColaGraphRep.
     ColaGraphRep m_cgr;
     //! Keep track of whether the set of Nodes has changed since last time we
     //! computed Rectangles for the CGR.
     bool m_needNewRectangles = true;
-    //! We also keep a ConstrainedFDLayout, for use in computing stress.
+    //! We also keep a ConstrainedFDLayout, for use in computing stress. It is
+    //! kept up to date with changes to the Graph, along with its shortest paths,
+    //! which are shared with the layouts used by destress.
     cola::ConstrainedFDLayout *m_cfdl = nullptr;
 
     //! Lookup table for Nodes by ID:
@@ -921,8 +955,10 @@ protected:
     EdgesById m_edges;
 
 private:
-    //! For class-specific generation of unique IDs:
-    static id_type nextID;
+    //! For class-specific generation of unique IDs.
+    //! This is atomic since temporary Nodes may be built on several threads at once,
+    //! as when estimating the costs of TreePlacements.
+    static std::atomic<id_type> nextID;
 
     //! A Node can exist outside of any Graph; when it does belong to a Graph,
     //! we keep a pointer to it here:
@@ -27,9 +27,13 @@
 #include <string>
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <valarray>
 
 #include "libvpsc/rectangle.h"
 #include "libavoid/libavoid.h"
+#include "libcola/cola.h"
 
 #include "libdialect/commontypes.h"
 #include "libdialect/graphs.h"
@@ -51,12 +55,97 @@ using namespace dialect;
 
 using std::string;
 
+namespace {
+
+// The default convergence test, which also counts the iterations of the layouts
+// to which it is passed.
+class IterationCounter : public cola::TestConvergence {
+public:
+    bool operator()(const double new_stress, std::valarray<double> &X,
+                    std::valarray<double> &Y) override {
+        ++count;
+        return cola::TestConvergence::operator()(new_stress, X, Y);
+    }
+    unsigned count = 0;
+};
+
+// Records the stages of a layout into a HolaStats object, or does nothing if not
+// given one.
+class StageRecorder {
+public:
+    StageRecorder(HolaStats *stats) : m_stats(stats) {
+        if (m_stats != nullptr) {
+            m_stats->stages.clear();
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    // The convergence test to be set in the ColaOptions of layouts belonging to a
+    // stage, so that their iterations are counted.
+    cola::TestConvergence *counter(void) {
+        return m_stats != nullptr ? &m_counter : nullptr;
+    }
+
+    // End the current stage, taking the graph sizes from H, and begin the next.
+    // Any given iterations are counted besides those of layouts using the counter.
+    void endStage(const string &name, Graph &H, size_t iterations = 0) {
+        if (m_stats == nullptr) return;
+        auto end = std::chrono::steady_clock::now();
+        HolaStageStats stage;
+        stage.name = name;
+        stage.wallTimeMs = std::chrono::duration<double, std::milli>(end - m_start).count();
+        stage.iterations = m_counter.count + (unsigned) iterations;
+        stage.numNodes = H.getNumNodes();
+        stage.numEdges = H.getNumEdges();
+        stage.numConstraints = H.getSepMatrix().numConstraints();
+        m_stats->stages.push_back(stage);
+        m_counter.count = 0;
+        // Counting the constraints is not part of the next stage.
+        m_start = std::chrono::steady_clock::now();
+    }
+
+private:
+    HolaStats *m_stats;
+    IterationCounter m_counter;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace
+
+double HolaStats::totalWallTimeMs(void) const {
+    double t = 0;
+    for (const HolaStageStats &stage : stages) t += stage.wallTimeMs;
+    return t;
+}
+
+const HolaStageStats *HolaStats::getStage(const string &name) const {
+    for (const HolaStageStats &stage : stages) {
+        if (stage.name == name) return &stage;
+    }
+    return nullptr;
+}
+
+string HolaStats::writeTable(void) const {
+    string table = "stage\tms\titerations\tnodes\tedges\tconstraints\n";
+    char buffer[128];
+    for (const HolaStageStats &stage : stages) {
+        snprintf(buffer, sizeof buffer, "\t%.3f\t%u\t%zu\t%zu\t%zu\n", stage.wallTimeMs,
+                 stage.iterations, stage.numNodes, stage.numEdges, stage.numConstraints);
+        table += stage.name;
+        table += buffer;
+    }
+    return table;
+}
+
 void dialect::doHOLA(Graph &G) {
     HolaOpts opts;
     doHOLA(G, opts);
 }
 
-void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
+void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger, HolaStats *stats) {
+
+    // Prepare to record the stages in case a stats object is given.
+    StageRecorder rec(stats);
 
     // If there's no edges, there's nothing to do.
     if (G.getNumEdges() == 0) return;
@@ -88,6 +177,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
     // After peeling, the input graph is peeled down to its own core.
     // Ac-cor-dingly : ) we rename it...
     Graph_SP &core = Gcopy;
+    rec.endStage("peel", *core);
 
     log(*core, string_format("%02d_core", ln++));
 
@@ -103,6 +193,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
             holaOpts.treeLayoutScalar_rankSep*IEL,
             holaOpts.preferConvexTrees
         );
+        rec.endStage("tree_layout", *tree->underlyingGraph());
         // Route the edges.
         RoutingAdapter ra(Avoid::OrthogonalRouting);
         ra.router.setRoutingOption(Avoid::nudgeOrthogonalSegmentsConnectedToShapes, true);
@@ -116,6 +207,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
         tree->underlyingGraph()->setPosesInCorrespNodes(G);
         tree->underlyingGraph()->setRoutesInCorrespEdges(G);
         tree->addConstraints(G, true);
+        rec.endStage("routing", G);
         // Done.
         return;
     }
@@ -124,14 +216,19 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
 
     // Start with a plain destress -- no constraints, no overlap prevention -- in order to begin
     // giving the nodes a reasonable distribution in the plane.
-    core->destress();
+    ColaOptions freeOpts;
+    freeOpts.doneTest = rec.counter();
+    core->destress(freeOpts);
+    rec.endStage("free_destress", *core);
 
     log(*core, string_format("%02d_free_destress_core", ln++));
 
     // Now destress again, this time removing any node overlaps.
     ColaOptions colaOpts;
     colaOpts.preventOverlaps = true;
+    colaOpts.doneTest = rec.counter();
     core->destress(colaOpts);
+    rec.endStage("OP_destress", *core);
 
     log(*core, string_format("%02d_OP_destress_core", ln++));
 
@@ -141,6 +238,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
     ohlOpts.avoidFlatTriangles = holaOpts.orthoHubAvoidFlatTriangles;
     OrthoHubLayout ohl(core, ohlOpts);
     ohl.layout(logger);
+    rec.endStage("ortho_hub", *core);
 
     log(*core, string_format("%02d_core_ortho_hub", ln++));
 
@@ -155,6 +253,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
     colaOpts.logger = logger;
     nli(ln);
     core->destress(colaOpts);
+    rec.endStage("EOP_destress", *core);
 
     log(*core, string_format("%02d_EOP_destress_core", ln++));
 
@@ -185,6 +284,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
         core->project(colaOpts, vpsc::XDIM);
         core->project(colaOpts, vpsc::YDIM);
     }
+    rec.endStage("link_config", *core);
 
     // Destress with overlap prevention including aligned edges.
     // At this time we also prepare for the next step, which involves connector routing.
@@ -198,6 +298,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
     core->padAllNodes(preRoutingGap, preRoutingGap);
     core->destress(colaOpts);
     core->padAllNodes(-preRoutingGap, -preRoutingGap);
+    rec.endStage("pre_routing_destress", *core);
     if (holaOpts.useACAforLinks) {
         log(*core, string_format("%02d_core_link_config_ACA", ln++));
     } else {
@@ -212,12 +313,14 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
     LeaflessOrthoRouter lor(core, holaOpts);
     nli(ln);
     lor.route(logger);
+    rec.endStage("leafless_routing", *core, lor.numRoutingsDone);
     ++ln;
 
     log(*core, string_format("%02d_core_leafless_ortho_route", ln++));
 
     OrthoPlanariser op(core);
     Graph_SP P = op.planarise();
+    rec.endStage("planarise", *P);
 
     log(*P, string_format("%02d_planar_graph_P", ln++));
 
@@ -230,6 +333,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
     colaOpts.solidifyAlignedEdges = true;
     nli(ln);
     P->destress(colaOpts);
+    rec.endStage("P_EOP_destress", *P);
 
     log(*P, string_format("%02d_P_EOP_destress", ln++));
 
@@ -246,11 +350,13 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
         );
         log(*(tree->underlyingGraph()), string_format("%02d_%02d_symm_tree", ln, lns++));
     }
+    rec.endStage("tree_layout", *P);
 
     ++ln;
     nli(ln);
     // Now we can choose faces and reattach them.
     FaceSet_SP faceSet = reattachTrees(P, trees, holaOpts, logger);
+    rec.endStage("tree_placement", *P);
     ++ln;
     // We will need the vector of chosen tree placements.
     TreePlacements tps = faceSet->getAllTreePlacements();
@@ -271,6 +377,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
         bufferNodes.insert(buffNodes.begin(), buffNodes.end());
         colaOpts.nodeClusters.push_back(treeNodes);
     }
+    rec.endStage("tree_insertion", *P);
 
     log(*P, string_format("%02d_P_with_trees", ln++));
 
@@ -287,6 +394,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
 
     nli(ln);
     P->destress(colaOpts);
+    rec.endStage("nbr_destress", *P);
 
     log(*P, string_format("%02d_P_nbr_destress", ln++));
 
@@ -301,6 +409,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
             P->destress(colaOpts);
             log(*P, string_format("%02d_P_near_alignments", ln++));
         }
+        rec.endStage("near_alignment", *P);
     }
 
     // Delete buffer nodes.
@@ -388,6 +497,7 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
     P->setCorrespondingConstraints(G);
     // Set extra gap for boundary constraints.
     G.getSepMatrix().setExtraBdryGap(IEL/2.0);
+    rec.endStage("finishing", G);
 
     // Final connector routing.
     G.clearAllRoutes();
@@ -436,4 +546,5 @@ void dialect::doHOLA(Graph &G, const HolaOpts &holaOpts, Logger *logger) {
 
     // Remove remaining node padding.
     G.padAllNodes(-nodePaddingLayer2, -nodePaddingLayer2);
+    rec.endStage("final_routing", G);
 }
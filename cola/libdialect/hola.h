@@ -25,6 +25,7 @@
 #ifndef DIALECT_HOLA_H
 #define DIALECT_HOLA_H
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,42 @@
 
 namespace dialect {
 
+//! @brief  Measurements taken for one stage of the HOLA layout process.
+struct HolaStageStats {
+    //! The name of the stage, e.g. "peel" or "OP_destress".
+    std::string name;
+    //! Wall time spent in the stage, in milliseconds.
+    double wallTimeMs = 0;
+    //! Iterations of the stage's main loop: stress-descent iterations for the
+    //! destress stages, and routing passes for the leafless routing stage. Zero
+    //! for stages with no such loop.
+    unsigned iterations = 0;
+    //! Size of the Graph being worked on, at the end of the stage.
+    size_t numNodes = 0;
+    size_t numEdges = 0;
+    //! Number of separation constraints in that Graph's SepMatrix, at the end of
+    //! the stage, counting each dimension of each constrained pair of Nodes.
+    size_t numConstraints = 0;
+};
+
+//! @brief  A lightweight record of the HOLA layout process, giving timings and
+//!         counts for each stage, as a cheap alternative to a Logger.
+struct HolaStats {
+    //! The stages, in the order in which they were performed.
+    std::vector<HolaStageStats> stages;
+
+    //! @brief  Get the total wall time of all stages, in milliseconds.
+    double totalWallTimeMs(void) const;
+
+    //! @brief  Look up a stage by name.
+    //! @return  Pointer to the first stage of the given name, or nullptr if there is none.
+    const HolaStageStats *getStage(const std::string &name) const;
+
+    //! @brief  Write a table of all stages, one per line, with tab-separated columns
+    //!         and a header line.
+    std::string writeTable(void) const;
+};
+
 //! @brief  Apply the HOLA layout algorithm to the given Graph.
 //!         See Steve Kieffer, Tim Dwyer, Kim Marriott, and Michael Wybrow.
 //!         HOLA: Human-like Orthogonal Network Layout.
@@ -43,7 +80,10 @@ namespace dialect {
 //! @param[in] opts  Options controlling the layout.
 //! @param[out] logger  Optional pointer to a Logger in which to record TGLF for various stages
 //!                     of the layout process. Useful for debugging.
-void doHOLA(dialect::Graph &G, const dialect::HolaOpts &holaOpts, dialect::Logger *logger = nullptr);
+//! @param[out] stats  Optional pointer to a HolaStats object, which will be cleared and then
+//!                    populated with timings and counts for each stage of the layout process.
+void doHOLA(dialect::Graph &G, const dialect::HolaOpts &holaOpts, dialect::Logger *logger = nullptr,
+            dialect::HolaStats *stats = nullptr);
 
 //! @brief  Convenience function to do HOLA layout with default options.
 //! @param[in, out] G  The Graph to be laid out. Node positions are updated in-place. Constraints
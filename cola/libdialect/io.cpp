@@ -29,12 +29,29 @@
 #include <memory>
 #include <sys/stat.h>
 #include <stdexcept>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+#include <unordered_map>
+#include <clocale>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <locale.h>
+#endif
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
 
-#include "libvpsc/assertions.h"
 #include "libdialect/commontypes.h"
 #include "libdialect/graphs.h"
 #include "libdialect/io.h"
 #include "libdialect/constraints.h"
+#include "libdialect/textio.h"
 
 using namespace dialect;
 
@@ -42,81 +59,319 @@ using std::istream;
 using std::ifstream;
 using std::ofstream;
 using std::string;
-using std::getline;
-using std::istringstream;
 using std::vector;
 using std::endl;
 
-Graph_SP dialect::buildGraphFromTglf(std::string &s) {
-    istringstream in(s);
-    return buildGraphFromTglf(in);
+namespace {
+
+// Numbers in TGLF are written and read in the "C" locale, rather than the
+// one the C library has been set to, as streams in the default C++ locale
+// would do.
+#if defined(_WIN32)
+typedef _locale_t NumericLocale;
+
+NumericLocale numericLocale(void) {
+    static const NumericLocale locale = _create_locale(LC_NUMERIC, "C");
+    return locale;
 }
+#else
+typedef locale_t NumericLocale;
 
-// Simple line-based parsing:
-//   https://stackoverflow.com/questions/7868936/read-file-line-by-line
-//   https://stackoverflow.com/a/7868998
-Graph_SP dialect::buildGraphFromTglf(istream &in) {
+NumericLocale numericLocale(void) {
+    static const NumericLocale locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t) 0);
+    return locale;
+}
+#endif
+
+typedef std::unordered_map<unsigned, Node_SP> NodesByExternalId;
+
+// Reads TGLF a line at a time, in place, from a buffer.
+class TglfScanner {
+public:
+    TglfScanner(const char *begin, const char *end)
+        : m_pos(begin), m_lineEnd(begin), m_next(begin), m_end(end), m_lineNumber(0) {}
+
+    // Move to the next line, returning false if there are none left.
+    bool nextLine(void) {
+        if (m_next == m_end) return false;
+        m_pos = m_next;
+        const char *newline = static_cast<const char *>(memchr(m_pos, '\n', m_end - m_pos));
+        m_lineEnd = newline ? newline : m_end;
+        m_next = newline ? newline + 1 : m_end;
+        ++m_lineNumber;
+        return true;
+    }
+
+    // Skip whitespace, returning whether anything is left on the line.
+    bool skipSpace(void) {
+        while (m_pos != m_lineEnd && isspace((unsigned char) *m_pos)) ++m_pos;
+        return m_pos != m_lineEnd;
+    }
+
+    // Comment lines begin with "//".
+    bool atComment(void) const {
+        return m_lineEnd - m_pos >= 2 && m_pos[0] == '/' && m_pos[1] == '/';
+    }
+
+    // Sections are separated by lines holding just "#".  Any other line
+    // beginning with "#" is malformed.
+    bool atSeparator(void) {
+        if (*m_pos != '#') return false;
+        const char *rest = m_pos + 1;
+        while (rest != m_lineEnd && isspace((unsigned char) *rest)) ++rest;
+        if (rest != m_lineEnd) fail("section separator");
+        m_pos = rest;
+        return true;
+    }
+
+    bool readUnsigned(unsigned &u) {
+        if (!skipSpace() || !isdigit((unsigned char) *m_pos)) return false;
+        unsigned long long value = 0;
+        while (m_pos != m_lineEnd && isdigit((unsigned char) *m_pos)) {
+            value = 10*value + (*m_pos++ - '0');
+            if (value > UINT_MAX) return false;
+        }
+        u = (unsigned) value;
+        return true;
+    }
+
+    // Numbers are parsed from a copy of just their own characters, since the
+    // buffer need not be null-terminated.
+    bool readDouble(double &d) {
+        if (!skipSpace()) return false;
+        char token[64];
+        size_t n = 0;
+        while (m_pos + n != m_lineEnd && n + 1 < sizeof(token) && !isspace((unsigned char) m_pos[n])) {
+            token[n] = m_pos[n];
+            ++n;
+        }
+        token[n] = '\0';
+        size_t length = parseTglfNumber(token, d);
+        if (length == 0) return false;
+        m_pos += length;
+        return true;
+    }
+
+    bool readChar(char &c) {
+        if (!skipSpace()) return false;
+        c = *m_pos++;
+        return true;
+    }
+
+    [[noreturn]] void fail(const string &what) const {
+        throw std::runtime_error("Could not read TGLF " + what + " on line " + std::to_string(m_lineNumber));
+    }
+
+private:
+    const char *m_pos;
+    const char *m_lineEnd;
+    const char *m_next;
+    const char *m_end;
+    unsigned m_lineNumber;
+};
+
+// The contents of a file, memory-mapped where possible, or else read into memory.
+class FileContents {
+public:
+    explicit FileContents(const string &filepath) : m_data(nullptr), m_size(0), m_mapping(nullptr) {
+        struct stat buf;
+        if (stat(filepath.c_str(), &buf) == -1) {
+            const std::string msg = "File does not exist: " + filepath;
+            throw std::runtime_error(msg);
+        }
+#if !defined(_WIN32)
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd != -1 && fstat(fd, &buf) == 0 && buf.st_size > 0) {
+            void *mapping = mmap(nullptr, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                madvise(mapping, buf.st_size, MADV_SEQUENTIAL);
+                m_mapping = mapping;
+                m_data = static_cast<const char *>(mapping);
+                m_size = buf.st_size;
+            }
+        }
+        if (fd != -1) close(fd);
+        if (m_mapping) return;
+#endif
+        ifstream infile(filepath, std::ios::binary);
+        if (!infile) {
+            const std::string msg = "Could not read file: " + filepath;
+            throw std::runtime_error(msg);
+        }
+        m_copy.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+        m_data = m_copy.data();
+        m_size = m_copy.size();
+    }
+
+    ~FileContents(void) {
+#if !defined(_WIN32)
+        if (m_mapping) munmap(m_mapping, m_size);
+#endif
+    }
+
+    FileContents(const FileContents &) = delete;
+    FileContents &operator=(const FileContents &) = delete;
+
+    const char *begin(void) const { return m_data; }
+    const char *end(void) const { return m_data + m_size; }
+
+private:
+    const char *m_data;
+    size_t m_size;
+    void *m_mapping;
+    string m_copy;
+};
+
+// Reads the binary graph format from a buffer.
+class BinaryReader {
+public:
+    BinaryReader(const char *begin, const char *end) : m_pos(begin), m_end(end) {}
+
+    bool readMagic(void) {
+        if (m_end - m_pos < 4 || memcmp(m_pos, "DLGB", 4) != 0) return false;
+        m_pos += 4;
+        return true;
+    }
+
+    uint32_t readUnsigned(void) {
+        require(4);
+        uint32_t u = 0;
+        for (unsigned i = 0; i < 4; ++i) {
+            u |= (uint32_t) (unsigned char) m_pos[i] << (8*i);
+        }
+        m_pos += 4;
+        return u;
+    }
+
+    double readDouble(void) {
+        require(8);
+        uint64_t bits = 0;
+        for (unsigned i = 0; i < 8; ++i) {
+            bits |= (uint64_t) (unsigned char) m_pos[i] << (8*i);
+        }
+        m_pos += 8;
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    char readChar(void) {
+        require(1);
+        return *m_pos++;
+    }
+
+    // Checks that there is room left for count records of the given size,
+    // before any space is reserved for them.
+    void requireRecords(uint32_t count, size_t recordSize) const {
+        if (count > (size_t) (m_end - m_pos) / recordSize) {
+            throw std::runtime_error("Binary graph data is truncated");
+        }
+    }
+
+private:
+    void require(size_t n) const {
+        if ((size_t) (m_end - m_pos) < n) {
+            throw std::runtime_error("Binary graph data is truncated");
+        }
+    }
+
+    const char *m_pos;
+    const char *m_end;
+};
+
+void addNode(Graph &graph, NodesByExternalId &nodesByExternalId, unsigned extId,
+             double cx, double cy, double w, double h) {
+    if (!(w > 0 && h > 0)) {
+        throw std::runtime_error("Node " + std::to_string(extId) + " does not have a positive width and height");
+    }
+    Node_SP node = Node::allocate();
+    node->setExternalId(extId);
+    node->setCentre(cx, cy);
+    node->setDims(w, h);
+    graph.addNode(node);
+    nodesByExternalId.insert({extId, node});
+}
+
+const Node_SP *lookUpNode(const NodesByExternalId &nodesByExternalId, unsigned extId) {
+    NodesByExternalId::const_iterator it = nodesByExternalId.find(extId);
+    return it == nodesByExternalId.end() ? nullptr : &it->second;
+}
+
+bool readGapType(char c, GapType &gt) {
+    switch(c) {
+        case 'B': gt=GapType::BDRY; return true;
+        case 'C': gt=GapType::CENTRE; return true;
+        default: return false;
+    }
+}
+
+bool readSepType(char c, SepType &st) {
+    switch(c) {
+        case '=': st=SepType::EQ; return true;
+        case '>': st=SepType::INEQ; return true;
+        case '-': st=SepType::NONE; return true;
+        default: return false;
+    }
+}
+
+// Builds a Graph from TGLF held in a buffer, without copying its lines.
+Graph_SP buildGraphFromTglfBuffer(const char *begin, const char *end) {
     Graph_SP graph = std::make_shared<Graph>();
-    NodesById nodesByExternalId;
-    unsigned extId;
-    string line;
+    NodesByExternalId nodesByExternalId;
+    TglfScanner in(begin, end);
     unsigned state = 0;
+    unsigned extId;
     double cx, cy, w, h;
     unsigned i1, i2;
     char gtc, dir, rel1, rel2;
     double gap;
-    Node_SP node;
+    const Node_SP *n1, *n2;
     Edge_SP edge;
-    while (getline(in, line)) {
-        // Skip empty lines.
-        if (line.empty()) continue;
-        // Comment lines begin with "//". (See https://stackoverflow.com/a/40441240)
-        if (line.rfind("//", 0) == 0) continue;
+    while (in.nextLine()) {
+        // Skip empty lines and comments.
+        if (!in.skipSpace() || in.atComment()) continue;
         // Check for "#" lines.
-        if (line == "#") {
+        if (in.atSeparator()) {
             // Time to change state.
-            COLA_ASSERT(++state < 3);
+            if (++state > 2) in.fail("section separator");
             // And continue to the next line.
             continue;
         }
         // Otherwise it should be a data line.
-        istringstream iss(line);
         switch (state) {
         case 0:
             // NODES
-            COLA_ASSERT(iss >> extId >> cx >> cy >> w >> h);
-            COLA_ASSERT(w > 0);
-            COLA_ASSERT(h > 0);
-            node = Node::allocate();
-            node->setExternalId(extId);
-            node->setCentre(cx, cy);
-            node->setDims(w, h);
-            graph->addNode(node);
-            nodesByExternalId.insert({extId, node});
+            if (!(in.readUnsigned(extId) && in.readDouble(cx) && in.readDouble(cy) &&
+                  in.readDouble(w) && in.readDouble(h))) {
+                in.fail("node");
+            }
+            addNode(*graph, nodesByExternalId, extId, cx, cy, w, h);
             break;
         case 1:
             // LINKS
-            COLA_ASSERT(iss >> i1 >> i2);
-            edge = Edge::allocate(nodesByExternalId[i1], nodesByExternalId[i2]);
-            while (iss >> cx >> cy) {
+            if (!(in.readUnsigned(i1) && in.readUnsigned(i2))) in.fail("link");
+            n1 = lookUpNode(nodesByExternalId, i1);
+            n2 = lookUpNode(nodesByExternalId, i2);
+            if (!n1 || !n2) in.fail("link end");
+            edge = Edge::allocate(*n1, *n2);
+            while (in.readDouble(cx) && in.readDouble(cy)) {
                 edge->addRoutePoint(cx, cy);
             }
             graph->addEdge(edge);
             break;
         case 2:
             // SEPCOS
-            COLA_ASSERT(iss >> i1 >> i2 >> gtc >> dir >> rel1 >> rel2 >> gap);
-            id_type j1 = nodesByExternalId[i1]->id(),
-                    j2 = nodesByExternalId[i2]->id();
+            if (!(in.readUnsigned(i1) && in.readUnsigned(i2) && in.readChar(gtc) && in.readChar(dir) &&
+                  in.readChar(rel1) && in.readChar(rel2) && in.readDouble(gap))) {
+                in.fail("separation constraint");
+            }
+            n1 = lookUpNode(nodesByExternalId, i1);
+            n2 = lookUpNode(nodesByExternalId, i2);
+            if (!n1 || !n2) in.fail("separation constraint node");
             GapType gt{};
             SepDir sd{};
             SepType st{};
-            switch(gtc) {
-                case 'B': gt=GapType::BDRY; break;
-                case 'C': gt=GapType::CENTRE; break;
-                default:
-                    COLA_ASSERT(false);
-            }
+            if (!readGapType(gtc, gt)) in.fail("gap type");
             switch(dir) {
                 case 'E': sd=SepDir::EAST; break;
                 case 'S': sd=SepDir::SOUTH; break;
@@ -129,33 +384,144 @@ Graph_SP dialect::buildGraphFromTglf(istream &in) {
                 case 'X': sd=SepDir::RIGHT; break;
                 case 'Y': sd=SepDir::DOWN; break;
                 default:
-                    COLA_ASSERT(false);
+                    in.fail("separation direction");
             }
-            switch(rel1) {
-                case '=': st=SepType::EQ; break;
-                case '>': st=SepType::INEQ; break;
-                default:
-                    COLA_ASSERT(false);
-            }
-            graph->getSepMatrix().addSep(j1, j2, gt, sd, st, gap);
+            if (rel1 == '-' || !readSepType(rel1, st)) in.fail("separation relation");
+            graph->getSepMatrix().addSep((*n1)->id(), (*n2)->id(), gt, sd, st, gap);
             break;
         }
     }
     return graph;
 }
 
-Graph_SP dialect::buildGraphFromTglfFile(const string &filepath) {
-    struct stat buf;
-    if (stat(filepath.c_str(), &buf) == -1) {
-        const std::string msg = "File does not exist: " + filepath;
-        throw std::runtime_error(msg);
+Graph_SP buildGraphFromBinaryBuffer(const char *begin, const char *end) {
+    BinaryReader in(begin, end);
+    if (!in.readMagic()) {
+        throw std::runtime_error("Not in the binary graph format");
+    }
+    uint32_t version = in.readUnsigned();
+    if (version == 0 || version > binaryGraphFormatVersion) {
+        throw std::runtime_error("Unsupported binary graph format version " + std::to_string(version));
     }
-    ifstream infile(filepath);
-    return buildGraphFromTglf(infile);
+    Graph_SP graph = std::make_shared<Graph>();
+    NodesByExternalId nodesByExternalId;
+    // NODES
+    uint32_t count = in.readUnsigned();
+    // Each node is an ID and four doubles.
+    in.requireRecords(count, 4 + 4*8);
+    nodesByExternalId.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        unsigned extId = in.readUnsigned();
+        double cx = in.readDouble(), cy = in.readDouble(), w = in.readDouble(), h = in.readDouble();
+        addNode(*graph, nodesByExternalId, extId, cx, cy, w, h);
+    }
+    // LINKS
+    count = in.readUnsigned();
+    for (uint32_t i = 0; i < count; ++i) {
+        const Node_SP *n1 = lookUpNode(nodesByExternalId, in.readUnsigned()),
+                      *n2 = lookUpNode(nodesByExternalId, in.readUnsigned());
+        if (!n1 || !n2) throw std::runtime_error("Binary graph link has an unknown end");
+        Edge_SP edge = Edge::allocate(*n1, *n2);
+        uint32_t numPoints = in.readUnsigned();
+        for (uint32_t j = 0; j < numPoints; ++j) {
+            double x = in.readDouble(), y = in.readDouble();
+            edge->addRoutePoint(x, y);
+        }
+        graph->addEdge(edge);
+    }
+    // SEPCOS
+    SepMatrix &matrix = graph->getSepMatrix();
+    matrix.setExtraBdryGap(in.readDouble());
+    count = in.readUnsigned();
+    for (uint32_t i = 0; i < count; ++i) {
+        const Node_SP *n1 = lookUpNode(nodesByExternalId, in.readUnsigned()),
+                      *n2 = lookUpNode(nodesByExternalId, in.readUnsigned());
+        if (!n1 || !n2) throw std::runtime_error("Binary graph constraint has an unknown node");
+        const SepDir dirs[2] = {SepDir::RIGHT, SepDir::DOWN};
+        for (SepDir sd : dirs) {
+            GapType gt{};
+            SepType st{};
+            char gtc = in.readChar(), stc = in.readChar();
+            double gap = in.readDouble();
+            if (!readGapType(gtc, gt) || !readSepType(stc, st)) {
+                throw std::runtime_error("Binary graph constraint has an unknown type");
+            }
+            matrix.addSep((*n1)->id(), (*n2)->id(), gt, sd, st, gap);
+        }
+    }
+    return graph;
+}
+
+} // namespace
+
+namespace {
+
+int formatNumber(char *buf, size_t size, const char *format, double x) {
+#if defined(_WIN32)
+    return _snprintf_l(buf, size, format, numericLocale(), x);
+#else
+    locale_t previous = uselocale(numericLocale());
+    int n = snprintf(buf, size, format, x);
+    uselocale(previous);
+    return n;
+#endif
+}
+
+} // namespace
+
+string dialect::formatTglfNumber(const char *format, double x) {
+    char buf[64];
+    int n = formatNumber(buf, sizeof(buf), format, x);
+    if (n < 0) throw std::runtime_error("Could not format number for TGLF");
+    if ((size_t) n < sizeof(buf)) return string(buf, n);
+    // Fixed-point formats of large numbers need more room.
+    vector<char> big(n + 1);
+    formatNumber(big.data(), big.size(), format, x);
+    return string(big.data(), n);
+}
+
+void dialect::appendTglfNumber(string &out, double x) {
+    // Doubles written with "%g" need at most 13 characters.
+    char buf[32];
+    int n = formatNumber(buf, sizeof(buf), "%g", x);
+    out.append(buf, n);
+}
+
+size_t dialect::parseTglfNumber(const char *token, double &d) {
+    char *end;
+#if defined(_WIN32)
+    d = _strtod_l(token, &end, numericLocale());
+#else
+    d = strtod_l(token, &end, numericLocale());
+#endif
+    return end - token;
+}
+
+Graph_SP dialect::buildGraphFromTglf(std::string &s) {
+    return buildGraphFromTglfBuffer(s.data(), s.data() + s.size());
+}
+
+Graph_SP dialect::buildGraphFromTglf(istream &in) {
+    string s(std::istreambuf_iterator<char>(in), (std::istreambuf_iterator<char>()));
+    return buildGraphFromTglf(s);
+}
+
+Graph_SP dialect::buildGraphFromTglfFile(const string &filepath) {
+    FileContents contents(filepath);
+    return buildGraphFromTglfBuffer(contents.begin(), contents.end());
+}
+
+Graph_SP dialect::buildGraphFromBinary(const std::string &s) {
+    return buildGraphFromBinaryBuffer(s.data(), s.data() + s.size());
+}
+
+Graph_SP dialect::buildGraphFromBinaryFile(const string &filepath) {
+    FileContents contents(filepath);
+    return buildGraphFromBinaryBuffer(contents.begin(), contents.end());
 }
 
 void dialect::writeStringToFile(const std::string &s, const std::string &filepath) {
-    ofstream outfile(filepath);
+    ofstream outfile(filepath, std::ios::binary);
     outfile << s;
     outfile.close();
 }
@@ -30,6 +30,7 @@
 #include <memory>
 #include <iostream>
 #include <cstdio>
+#include <cstdint>
 
 namespace dialect {
 
@@ -99,6 +100,43 @@ class Graph;
  *
 */
 
+/*
+ * The binary graph format holds the same information as TGLF, for graphs
+ * too large to be read quickly as text. All numbers are little-endian:
+ * "unsigned" means a 32-bit unsigned integer, and "double" an IEEE 754
+ * double. It is of the form:
+ *
+ * HEADER NODES LINKS SEPCOS
+ *
+ * where
+ *
+ * HEADER is the four characters "DLGB" followed by the format version as an
+ * unsigned. This is binaryGraphFormatVersion for files written by this
+ * version of libdialect.
+ *
+ * NODES is the number of nodes as an unsigned, followed for each node by its
+ * ID as an unsigned, and then four doubles: the x and y coordinates of its
+ * centre, and its width and height.
+ *
+ * LINKS is the number of links as an unsigned, followed for each link by the
+ * IDs of its source and target nodes and its number of route points, as
+ * unsigneds, and then two doubles for the (x, y)-coordinates of each route
+ * point. As in TGLF, the centres of the end nodes are not listed.
+ *
+ * SEPCOS is a double giving the extra gap added to every boundary gap (see
+ * SepMatrix::setExtraBdryGap()), then the number of constrained pairs of
+ * nodes as an unsigned, followed for each pair by the IDs of the two nodes
+ * as unsigneds, and then the constraint in the x-dimension and then that in
+ * the y-dimension. Each of these is a *gap type* character (B or C, as in
+ * TGLF), a *relation* character ('=' for an exact gap, '>' for a minimum
+ * gap, or '-' for no constraint), and a double: the gap from the first node
+ * to the second, not including the extra boundary gap.
+ *
+*/
+
+//! The version of the binary graph format written by Graph::writeBinary().
+const uint32_t binaryGraphFormatVersion = 1;
+
 //! @brief  Build a Graph object from TGLF.
 //!
 //! @param[in]  in  An istream containing TGLF.
@@ -115,11 +153,34 @@ std::shared_ptr<Graph> buildGraphFromTglf(std::string &s);
 
 //! @brief  Build a Graph object from a file containing TGLF.
 //!
+//! The file is memory-mapped and parsed where it lies, without copying it,
+//! on platforms that support mmap().
+//!
 //! @param[in]  filepath  Full filesystem path to a file containing TGLF.
 //!
 //! @return  A Graph built on the given TGLF.
+//!
+//! @throws  std::runtime_error if the file cannot be read, or a line of it
+//!          cannot be parsed.
 std::shared_ptr<Graph> buildGraphFromTglfFile(const std::string &filepath);
 
+//! @brief  Build a Graph object from the binary graph format.
+//!
+//! @param[in]  s  A string containing a graph in the binary format.
+//!
+//! @return  A Graph built on the given data.
+//!
+//! @throws  std::runtime_error if the data is not in a version of the binary
+//!          format that can be read.
+std::shared_ptr<Graph> buildGraphFromBinary(const std::string &s);
+
+//! @brief  Build a Graph object from a file containing the binary graph format.
+//!
+//! @param[in]  filepath  Full filesystem path to a file in the binary format.
+//!
+//! @return  A Graph built on the given data.
+std::shared_ptr<Graph> buildGraphFromBinaryFile(const std::string &filepath);
+
 //! @brief  Write a string to a file.
 //!
 //! @param[in]  s  the string to be written
@@ -126,6 +126,15 @@ struct HolaOpts {
     //! Prefer trees to be placed where there are the fewest other trees considering
     //! using that same space:
     bool treePlacement_favourIsolation = true;
+    //! When the remaining candidate placements must be compared by estimated cost,
+    //! the estimates can be computed on this many threads at once. The choice of
+    //! placement is the same for any value:
+    unsigned treePlacement_concurrentEstimates = 1;
+    //! When the best placement has no feasible expansion, the next best is tried, and
+    //! so on. If the best of this many placements is infeasible, the others are tried
+    //! at once, each on its own copy of the layout, on up to one thread per hardware
+    //! thread. The choice of placement is the same as when trying them one at a time:
+    unsigned treePlacement_concurrentExpansions = 1;
 
 
     //! Expansion
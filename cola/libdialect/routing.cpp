@@ -282,6 +282,7 @@ void LeaflessOrthoRouter::route(Logger *logger) {
     size_t maxRoutings = 4*m_n + 1;
     for (size_t numRoutings = 0; numRoutings <= maxRoutings; numRoutings++) {
         m_ra.router.processTransaction();
+        numRoutingsDone = numRoutings + 1;
         log(numRoutings + 1);
         COLA_ASSERT(numRoutings < maxRoutings);
         // For testing purposes, we may want to record the results of
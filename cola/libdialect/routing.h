@@ -143,6 +143,9 @@ public:
     bool recordEachAttempt = false;
     std::vector<std::string> routingAttemptTglf;
 
+    //! After routing, the number of times the connectors were routed.
+    size_t numRoutingsDone = 0;
+
 private:
 
     //! @brief  Determine the compass direction in which the routed connector
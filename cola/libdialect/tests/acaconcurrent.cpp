@@ -0,0 +1,84 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libdialect - A library for computing DiAlEcT layouts:
+ *                 D = Decompose/Distribute
+ *                 A = Arrange
+ *                 E = Expand/Emend
+ *                 T = Transform
+ *
+ * Copyright (C) 2018  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Check that testing candidate alignments concurrently chooses the same
+// alignments, and so gives the same layout, as testing them one at a time,
+// both with and without warm-started feasibility checks.
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+#include "libvpsc/assertions.h"
+#include "libdialect/commontypes.h"
+#include "libdialect/io.h"
+#include "libdialect/graphs.h"
+#include "libdialect/aca.h"
+
+using namespace dialect;
+
+using std::string;
+using std::vector;
+using std::pair;
+using std::cout;
+using std::endl;
+
+vector< pair<string, string> > names {
+    {"special", "X_4"},
+    {"random", "v40e44"}
+};
+
+// Returns the node positions after running ACA, in the order of the nodes'
+// IDs, which differ between graphs loaded from the same file.
+vector<Avoid::Point> layoutWithChecks(const string &path, unsigned k,
+        bool warmStart = false) {
+    Graph_SP graph = buildGraphFromTglfFile(path);
+    graph->getIEL();
+    ACALayout aca(graph);
+    aca.concurrentFeasibilityChecks(k);
+    aca.warmStartChecks(warmStart);
+    aca.layout();
+    graph->updateNodesFromRects();
+    vector<Avoid::Point> positions;
+    for (auto p : graph->getNodeLookup()) {
+        positions.push_back(p.second->getCentre());
+    }
+    return positions;
+}
+
+int main(void) {
+    cout << "ACA concurrent feasibility checks" << endl;
+    for (auto p : names) {
+        string dir = p.first, file = p.second;
+        string path = TEST_DATA_PATH "graphs/"+dir+"/"+file+".tglf";
+        cout << dir << "/" << file << "..." << std::flush;
+        vector<Avoid::Point> expected = layoutWithChecks(path, 1);
+        for (unsigned k : {2, 8}) {
+            COLA_ASSERT(layoutWithChecks(path, k) == expected);
+        }
+        expected = layoutWithChecks(path, 1, true);
+        COLA_ASSERT(layoutWithChecks(path, 8, true) == expected);
+        cout << "done" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libdialect - A library for computing DiAlEcT layouts:
+ *                 D = Decompose/Distribute
+ *                 A = Arrange
+ *                 E = Expand/Emend
+ *                 T = Transform
+ *
+ * Copyright (C) 2018  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+
+// Check that graphs written as TGLF and in the binary graph format are read
+// back the same, and that malformed input is reported.
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <cstdio>
+#include <clocale>
+
+#include "libvpsc/assertions.h"
+#include "libdialect/commontypes.h"
+#include "libdialect/io.h"
+#include "libdialect/graphs.h"
+#include "libdialect/constraints.h"
+
+using namespace dialect;
+
+using std::string;
+using std::vector;
+
+// Returns whether building a Graph from the given data throws a runtime_error.
+template <typename Build>
+bool throwsRuntimeError(Build build) {
+    try {
+        build();
+    } catch (std::runtime_error const&) {
+        return true;
+    }
+    return false;
+}
+
+// Checks that the Graph reads back the same from TGLF and from the binary format.
+void checkRoundTrips(const Graph &graph, const string &name) {
+    string tglf = graph.writeTglf(true),
+           binary = graph.writeBinary(true);
+    COLA_ASSERT(buildGraphFromTglf(tglf)->writeTglf(true) == tglf);
+    std::istringstream in(tglf);
+    COLA_ASSERT(buildGraphFromTglf(in)->writeTglf(true) == tglf);
+
+    Graph_SP fromBinary = buildGraphFromBinary(binary);
+    COLA_ASSERT(fromBinary->writeTglf(true) == tglf);
+    COLA_ASSERT(fromBinary->writeBinary(true) == binary);
+
+    string path = IMAGE_OUTPUT_PATH "output/" "graphformats_" + name + ".dlgb";
+    writeStringToFile(binary, path);
+    COLA_ASSERT(buildGraphFromBinaryFile(path)->writeBinary(true) == binary);
+    std::remove(path.c_str());
+}
+
+int main(void) {
+    vector<string> files = {
+        "special/core_with_trees",
+        "special/readconstraints",
+        "special/SepMatrixIter",
+        "sbgn/glyco"
+    };
+    for (const string &file : files) {
+        Graph_SP graph = buildGraphFromTglfFile(TEST_DATA_PATH "graphs/" + file + ".tglf");
+        checkRoundTrips(*graph, file.substr(file.find('/') + 1));
+
+        // Give the edges routes, and the boundary gaps an extra gap.
+        unsigned k = 0;
+        for (auto p : graph->getEdgeLookup()) {
+            for (unsigned i = 0; i < k % 4; ++i) {
+                p.second->addRoutePoint(10.5*k + i, -3.25*i);
+            }
+            ++k;
+        }
+        graph->getSepMatrix().setExtraBdryGap(7);
+        checkRoundTrips(*graph, file.substr(file.find('/') + 1) + "_routed");
+    }
+
+    // The binary format keeps coordinates exactly, where TGLF rounds them.
+    Graph graph;
+    Node_SP u = Node::allocate(1.0/3, 2.0/3, 10, 20),
+            v = Node::allocate(1e6 + 0.125, -1e-7, 30, 40);
+    graph.addNode(u);
+    graph.addNode(v);
+    graph.addEdge(Edge::allocate(u, v));
+    graph.getSepMatrix().addSep(u->id(), v->id(), GapType::BDRY, SepDir::RIGHT, SepType::INEQ, 1.0/7);
+    Graph_SP copy = buildGraphFromBinary(graph.writeBinary());
+    COLA_ASSERT(copy->getNumNodes() == 2 && copy->getNumEdges() == 1);
+    for (auto p : copy->getNodeLookup()) {
+        Node_SP original = p.second->getExternalId() == (int) u->id() ? u : v;
+        COLA_ASSERT(p.second->getCentre() == original->getCentre());
+        COLA_ASSERT(p.second->getDimensions() == original->getDimensions());
+    }
+    COLA_ASSERT(copy->writeBinary(true) == graph.writeBinary());
+
+    // Comments, blank lines and Windows line endings are allowed in TGLF.
+    string tglf = "// Two nodes.\r\n0 0 0 10 10\r\n\r\n  1 20.5 +4 10 10\r\n#\r\n0 1 5 0 5 4\r\n#\r\n0 1 C E == 20.5";
+    Graph_SP parsed = buildGraphFromTglf(tglf);
+    COLA_ASSERT(parsed->writeTglf(true) == "0 0 0 10 10\n1 20.5 4 10 10\n#\n0 1 5 0 5 4\n#\n0 1 C E == 20.500\n");
+
+    // Malformed input is reported rather than misread.
+    vector<string> badTglf = {
+        "0 0 0 10\n",
+        "0 0 0 0 10\n",
+        "0 0 0 10 10\n#\n0 2\n",
+        "0 0 0 10 10\n1 5 5 10 10\n#\n#\n0 1 C Q == 5\n",
+        "0 0 0 10 10\n#\n#\n#\n",
+        "#7 0 0 10 10\n",
+        "0 0 0 10 10\n1 5 5 10 10\n# 0 1\n"
+    };
+    for (string &s : badTglf) {
+        COLA_ASSERT(throwsRuntimeError([&]() { buildGraphFromTglf(s); }));
+    }
+    string binary = graph.writeBinary();
+    string truncated = binary.substr(0, binary.size() - 1),
+           future = binary,
+           notBinary = "0 0 0 10 10\n",
+           hugeCount = binary,
+           noWidth = binary;
+    future[4] = (char) (binaryGraphFormatVersion + 1);
+    // The node count follows the magic number and version, and the first
+    // node's width follows its ID and centre.
+    hugeCount.replace(8, 4, 4, (char) 0xff);
+    noWidth.replace(12 + 4 + 16, 8, 8, (char) 0);
+    for (const string &s : {truncated, future, notBinary, hugeCount, noWidth}) {
+        COLA_ASSERT(throwsRuntimeError([&]() { buildGraphFromBinary(s); }));
+    }
+    COLA_ASSERT(throwsRuntimeError([]() { buildGraphFromTglfFile(TEST_DATA_PATH "graphs/" "no_such_file.tglf"); }));
+
+    // TGLF always uses a '.' decimal point, even if the C library is set to a
+    // locale that uses a comma.
+    const char *commaLocale = nullptr;
+    for (const char *name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR", "German", "French"}) {
+        if (setlocale(LC_NUMERIC, name) != nullptr && string(localeconv()->decimal_point) == ",") {
+            commaLocale = name;
+            break;
+        }
+    }
+    if (commaLocale != nullptr) {
+        string decimals = "0 0.5 1.25 10.5 10\n1 20.5 4 10 10\n#\n0 1 5.5 0 5.5 4.75\n#\n0 1 C E == 20.5\n";
+        Graph_SP fromDecimals = buildGraphFromTglf(decimals);
+        COLA_ASSERT(fromDecimals->writeTglf(true) == "0 0.5 1.25 10.5 10\n1 20.5 4 10 10\n#\n0 1 5.5 0 5.5 4.75\n#\n0 1 C E == 20.500\n");
+        checkRoundTrips(graph, "comma_locale");
+    } else {
+        std::printf("No locale with a comma decimal point; skipping the locale check.\n");
+    }
+    setlocale(LC_NUMERIC, "C");
+    return 0;
+}
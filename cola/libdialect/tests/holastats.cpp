@@ -0,0 +1,139 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libdialect - A library for computing DiAlEcT layouts:
+ *                 D = Decompose/Distribute
+ *                 A = Arrange
+ *                 E = Expand/Emend
+ *                 T = Transform
+ *
+ * Copyright (C) 2018  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Check that HolaStats records each stage of HOLA, with plausible timings and
+// counts.
+
+#include <string>
+#include <vector>
+#include <valarray>
+#include <iostream>
+
+#include "libvpsc/assertions.h"
+#include "libcola/cola.h"
+#include "libdialect/commontypes.h"
+#include "libdialect/io.h"
+#include "libdialect/graphs.h"
+#include "libdialect/opts.h"
+#include "libdialect/peeling.h"
+#include "libdialect/hola.h"
+
+using namespace dialect;
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+void layout(const string &path, HolaStats *stats) {
+    Graph_SP graph = buildGraphFromTglfFile(path);
+    HolaOpts opts;
+    doHOLA(*graph, opts, nullptr, stats);
+}
+
+// The default convergence test, counting the iterations of the layouts to which
+// it is passed.
+class CountingTest : public cola::TestConvergence {
+public:
+    bool operator()(const double new_stress, std::valarray<double> &X,
+                    std::valarray<double> &Y) override {
+        ++count;
+        return cola::TestConvergence::operator()(new_stress, X, Y);
+    }
+    unsigned count = 0;
+};
+
+// Repeat the first two destress stages of HOLA on the graph at path, returning
+// the number of iterations of each.
+vector<unsigned> countFirstDestressIterations(const string &path) {
+    Graph_SP graph = buildGraphFromTglfFile(path);
+    HolaOpts opts;
+    double padding = opts.nodePaddingScalar*graph->getIEL();
+    graph->padAllNodes(padding, padding);
+    Graph_SP core = std::make_shared<Graph>(*graph);
+    core->clearAllRoutes();
+    peel(*core);
+    vector<unsigned> counts;
+    CountingTest freeTest;
+    ColaOptions freeOpts;
+    freeOpts.doneTest = &freeTest;
+    core->destress(freeOpts);
+    counts.push_back(freeTest.count);
+    CountingTest opTest;
+    ColaOptions opOpts;
+    opOpts.preventOverlaps = true;
+    opOpts.doneTest = &opTest;
+    core->destress(opOpts);
+    counts.push_back(opTest.count);
+    return counts;
+}
+
+void checkStats(const string &path, const vector<string> &expectedStages) {
+    HolaStats stats;
+    layout(path, &stats);
+    cout << stats.writeTable();
+    COLA_ASSERT(stats.stages.size() == expectedStages.size());
+    double total = 0;
+    for (size_t i = 0; i < stats.stages.size(); ++i) {
+        const HolaStageStats &stage = stats.stages[i];
+        COLA_ASSERT(stage.name == expectedStages[i]);
+        COLA_ASSERT(stage.wallTimeMs >= 0);
+        COLA_ASSERT(stage.numNodes > 0);
+        total += stage.wallTimeMs;
+    }
+    COLA_ASSERT(stats.totalWallTimeMs() == total);
+    COLA_ASSERT(stats.getStage("no_such_stage") == nullptr);
+    // Recording into the same stats again starts afresh.
+    layout(path, &stats);
+    COLA_ASSERT(stats.stages.size() == expectedStages.size());
+}
+
+int main(void) {
+    cout << "HOLA stats" << endl;
+
+    string path = TEST_DATA_PATH "graphs/random/v30e33.tglf";
+    checkStats(path, {
+        "peel", "free_destress", "OP_destress", "ortho_hub", "EOP_destress", "link_config",
+        "pre_routing_destress", "leafless_routing", "planarise", "P_EOP_destress", "tree_layout",
+        "tree_placement", "tree_insertion", "nbr_destress", "near_alignment", "finishing", "final_routing"
+    });
+    HolaStats stats;
+    layout(path, &stats);
+    // Each destress stage counts the iterations of its layouts, and no more.
+    vector<unsigned> counts = countFirstDestressIterations(path);
+    COLA_ASSERT(stats.getStage("free_destress")->iterations == counts[0]);
+    COLA_ASSERT(stats.getStage("OP_destress")->iterations == counts[1]);
+    for (string name : {"free_destress", "OP_destress", "EOP_destress", "P_EOP_destress", "nbr_destress"}) {
+        COLA_ASSERT(stats.getStage(name)->iterations > 0);
+    }
+    COLA_ASSERT(stats.getStage("leafless_routing")->iterations >= 1);
+    COLA_ASSERT(stats.getStage("peel")->iterations == 0);
+    // Planarisation adds nodes at edge crossings and bends, and every edge of the
+    // planar graph is aligned.
+    COLA_ASSERT(stats.getStage("planarise")->numNodes >= stats.getStage("peel")->numNodes);
+    COLA_ASSERT(stats.getStage("P_EOP_destress")->numConstraints >= stats.getStage("planarise")->numEdges);
+
+    // When the whole graph is a tree, there are only two stages after peeling.
+    checkStats(TEST_DATA_PATH "graphs/trees/tree02.tglf", {"peel", "tree_layout", "routing"});
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libdialect - A library for computing DiAlEcT layouts:
+ *                 D = Decompose/Distribute
+ *                 A = Arrange
+ *                 E = Expand/Emend
+ *                 T = Transform
+ *
+ * Copyright (C) 2018  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+
+// Check that estimating the costs of candidate tree placements concurrently
+// chooses the same placements as estimating them one at a time, and that
+// trying expansions concurrently, in isolated copies of the faces, gives the
+// same layout as trying them one at a time.
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "libvpsc/assertions.h"
+#include "libdialect/commontypes.h"
+#include "libdialect/io.h"
+#include "libdialect/graphs.h"
+#include "libdialect/opts.h"
+#include "libdialect/routing.h"
+#include "libdialect/planarise.h"
+#include "libdialect/faces.h"
+#include "libdialect/peeling.h"
+#include "libdialect/trees.h"
+#include "libdialect/treeplacement.h"
+#include "libdialect/nodeconfig.h"
+#include "libdialect/hola.h"
+
+using namespace dialect;
+
+using Avoid::Point;
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+// Reads the test graph, peels its trees, and returns its routed, planarised core.
+Graph_SP buildCore(Trees &trees, const HolaOpts &opts) {
+    Graph_SP graph = buildGraphFromTglfFile(TEST_DATA_PATH "graphs/random/v40e44.tglf");
+    trees = peel(*graph);
+    COLA_ASSERT(trees.size() > 1);
+    double iel = graph->getIEL();
+    for (Tree_SP t : trees) t->symmetricLayout(CardinalDir::EAST, iel/4.0, iel, opts.preferConvexTrees);
+    LeaflessOrthoRouter lor(graph, opts);
+    lor.route();
+    OrthoPlanariser op(graph);
+    return op.planarise();
+}
+
+// As buildCore, for another graph, whose core is given an OrthoHub layout
+// first, as HOLA does, so that its trees can be reattached.
+Graph_SP buildLaidOutCore(Trees &trees, const HolaOpts &opts) {
+    Graph_SP graph = buildGraphFromTglfFile(TEST_DATA_PATH "graphs/special/expand03.tglf");
+    trees = peel(*graph);
+    COLA_ASSERT(trees.size() > 1);
+    OrthoHubLayoutOptions ohl_opts;
+    OrthoHubLayout ohl(graph, ohl_opts);
+    ohl.layout();
+    double iel = graph->getIEL();
+    for (Tree_SP t : trees) t->symmetricLayout(CardinalDir::EAST, iel/4.0, iel, opts.preferConvexTrees);
+    LeaflessOrthoRouter lor(graph, opts);
+    lor.setShapeBufferDistanceIELScalar(0.125);
+    lor.route();
+    OrthoPlanariser op(graph);
+    return op.planarise();
+}
+
+// Returns the index of the placement chosen from a fresh list of placements
+// for the given tree, so that no costs have been estimated beforehand.
+size_t choose(FaceSet &faceSet, Tree_SP tree, HolaOpts opts, unsigned k) {
+    TreePlacements tps = faceSet.listAllPossibleTreePlacements(tree);
+    opts.treePlacement_concurrentEstimates = k;
+    TreePlacement_SP best = chooseBestPlacement(tps, opts);
+    return std::find(tps.begin(), tps.end(), best) - tps.begin();
+}
+
+// Returns the centres of the Nodes of a HOLA layout of the given graph, in order
+// of ID, with k expansions tried at once when reattaching trees.
+vector<Point> layOut(string filename, unsigned k) {
+    HolaOpts opts;
+    opts.treePlacement_concurrentExpansions = k;
+    Graph_SP graph = buildGraphFromTglfFile(filename);
+    doHOLA(*graph, opts);
+    vector<Point> centres;
+    for (auto p : graph->getNodeLookup()) centres.push_back(p.second->getCentre());
+    return centres;
+}
+
+int main(void) {
+    cout << "Concurrent tree placement cost estimates" << endl;
+    HolaOpts opts;
+    Trees trees;
+    Graph_SP P = buildCore(trees, opts);
+    FaceSet faceSet(P);
+
+    // Compare both with the usual preferences, and with every placement
+    // being compared by cost.
+    for (bool favour : {true, false}) {
+        opts.treePlacement_favourCardinal = favour;
+        opts.treePlacement_favourExternal = favour;
+        opts.treePlacement_favourIsolation = favour;
+        for (Tree_SP t : trees) {
+            size_t expected = choose(faceSet, t, opts, 1);
+            for (unsigned k : {2, 8}) {
+                COLA_ASSERT(choose(faceSet, t, opts, k) == expected);
+            }
+        }
+    }
+
+    // Costs are estimated once per placement, so choosing again after
+    // removing the best one gives the same as a fresh list without it.
+    for (Tree_SP t : trees) {
+        TreePlacements tps = faceSet.listAllPossibleTreePlacements(t);
+        TreePlacements fresh = faceSet.listAllPossibleTreePlacements(t);
+        if (tps.size() < 2) continue;
+        size_t i = std::find(tps.begin(), tps.end(), chooseBestPlacement(tps, opts)) - tps.begin();
+        tps.erase(tps.begin() + i);
+        fresh.erase(fresh.begin() + i);
+        TreePlacement_SP next = chooseBestPlacement(tps, opts);
+        TreePlacement_SP freshNext = chooseBestPlacement(fresh, opts);
+        COLA_ASSERT(std::find(tps.begin(), tps.end(), next) - tps.begin() ==
+                    std::find(fresh.begin(), fresh.end(), freshNext) - fresh.begin());
+        COLA_ASSERT(next->estimateCost() == freshNext->estimateCost());
+    }
+
+    // An isolated copy of the faces, with the tree boxes inserted so far, must
+    // find the same projection sequences as the faces themselves, and leave
+    // the Nodes of the core where they are.
+    cout << "Isolated copies of the faces" << endl;
+    opts = HolaOpts();
+    Graph_SP Q = buildLaidOutCore(trees, opts);
+    Trees firstTrees(trees.begin(), trees.begin() + trees.size()/2);
+    FaceSet_SP faces = reattachTrees(Q, firstTrees, opts);
+    double padding = Q->getIEL()/4.0;
+    for (auto it = trees.begin() + trees.size()/2; it != trees.end(); ++it) {
+        for (TreePlacement_SP tp : faces->listAllPossibleTreePlacements(*it)) {
+            FaceSet_SP copy = faces->isolatedCopy();
+            TreePlacement_SP copied = copy->copyPlacement(*tp, *faces);
+            vector<Point> before;
+            for (auto p : Q->getNodeLookup()) before.push_back(p.second->getCentre());
+            ProjSeq_SP copiedPs = copied->buildBestProjSeq(padding);
+            size_t i = 0;
+            for (auto p : Q->getNodeLookup()) COLA_ASSERT(p.second->getCentre() == before[i++]);
+            ProjSeq_SP ps = tp->buildBestProjSeq(padding);
+            COLA_ASSERT((ps == nullptr) == (copiedPs == nullptr));
+            if (ps != nullptr) COLA_ASSERT(ps->violation() == copiedPs->violation());
+        }
+    }
+
+    // Trying expansions concurrently gives the same layout. In this graph the
+    // best placement for some trees has no feasible expansion.
+    cout << "Concurrent expansions" << endl;
+    string filename = TEST_DATA_PATH "graphs/special/GtsSlovakia_input.tglf";
+    vector<Point> expected = layOut(filename, 1);
+    for (unsigned k : {2, 4}) {
+        COLA_ASSERT(layOut(filename, k) == expected);
+    }
+
+    cout << "done" << endl;
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libdialect - A library for computing DiAlEcT layouts:
+ *                 D = Decompose/Distribute
+ *                 A = Arrange
+ *                 E = Expand/Emend
+ *                 T = Transform
+ *
+ * Copyright (C) 2018  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+// NOTE: This is an internal helper header that should not be used by the user.
+
+#ifndef DIALECT_TEXTIO_H
+#define DIALECT_TEXTIO_H
+
+#include <cstddef>
+#include <string>
+
+namespace dialect {
+
+// Formats a number with a printf format for a single double, with a '.'
+// decimal point whatever the C locale is.
+std::string formatTglfNumber(const char *format, double x);
+
+// Appends a number to a string as TGLF writes it, which is as an ostream with
+// default settings would write it ("%g"), with a '.' decimal point whatever
+// the C locale is.
+void appendTglfNumber(std::string &out, double x);
+
+// Parses a number from the null-terminated token as TGLF writes it, with a '.'
+// decimal point whatever the C locale is.  Returns the number of characters
+// read, or zero if the token does not begin with a number.
+size_t parseTglfNumber(const char *token, double &d);
+
+} // namespace dialect
+
+#endif // DIALECT_TEXTIO_H
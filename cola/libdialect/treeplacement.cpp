@@ -24,6 +24,8 @@
 
 #include <memory>
 #include <algorithm>
+#include <thread>
+#include <vector>
 #include <map>
 #include <limits>
 #include <sstream>
@@ -32,6 +34,7 @@
 #include "libvpsc/assertions.h"
 #include "libvpsc/rectangle.h"
 #include "libavoid/geomtypes.h"
+#include "libcola/parallel.h"
 
 #include "libdialect/commontypes.h"
 #include "libdialect/ortho.h"
@@ -51,6 +54,61 @@ using std::string;
 
 id_type TreePlacement::nextID = 0;
 
+// Remove up to k placements from tps, in the order in which chooseBestPlacement()
+// chooses them, and return them in that order.
+static TreePlacements takeBestPlacements(TreePlacements &tps, const HolaOpts &opts, unsigned k) {
+    TreePlacements best;
+    while (!tps.empty() && (best.empty() || best.size() < k)) {
+        TreePlacement_SP tp = chooseBestPlacement(tps, opts);
+        tps.erase(std::remove(tps.begin(), tps.end(), tp), tps.end());
+        best.push_back(tp);
+    }
+    return best;
+}
+
+// Build a projection sequence for the first of the given placements, in order, that has
+// a feasible one, and set best to that placement, or return nullptr if none has one. The
+// first placement is tried in place. If it is infeasible and there is more than one hardware
+// thread, the others are tried at once, each in an isolated copy of the faces, and the first
+// found feasible has its sequence built again in place. Otherwise they are tried in place
+// one by one.
+static ProjSeq_SP buildFirstFeasibleProjSeq(FaceSet &faceset, const TreePlacements &tps, double padding,
+                                            const HolaOpts &opts, TreePlacement_SP &best) {
+    auto build = [&](TreePlacement &tp)->ProjSeq_SP{
+        return tp.buildBestProjSeq(padding, opts.expansion_doCostlierDimensionFirst, opts.expansion_estimateMethod);
+    };
+    best = tps.front();
+    ProjSeq_SP ps = build(*best);
+    if (ps != nullptr || tps.size() == 1) return ps;
+    size_t n = tps.size() - 1;
+    unsigned threadCount = (unsigned) std::min<size_t>(n, std::max(std::thread::hardware_concurrency(), 1u));
+    std::vector<char> feasibleInCopy(n, 1);
+    if (threadCount > 1) {
+        // The copies are built here, on one thread, since Faces, Edges and TreePlacements
+        // are given IDs from counters that are not atomic.
+        std::vector<FaceSet_SP> copies(n);
+        TreePlacements copiedTps(n);
+        for (size_t i = 0; i < n; ++i) {
+            copies[i] = faceset.isolatedCopy();
+            copiedTps[i] = copies[i]->copyPlacement(*tps[i + 1], faceset);
+        }
+        cola::parallelFor(n, threadCount, [&](size_t i) {
+            try {
+                feasibleInCopy[i] = build(*copiedTps[i]) != nullptr;
+            } catch (...) {
+                // Leave it to be tried again, and the problem reported, in place.
+                feasibleInCopy[i] = 1;
+            }
+        });
+    }
+    for (size_t i = 0; ps == nullptr && i < n; ++i) {
+        if (!feasibleInCopy[i]) continue;
+        best = tps[i + 1];
+        ps = build(*best);
+    }
+    return ps;
+}
+
 FaceSet_SP dialect::reattachTrees(Graph_SP core, Trees trees, HolaOpts opts, Logger *logger) {
 
     // Set up for logging.
@@ -82,17 +140,14 @@ FaceSet_SP dialect::reattachTrees(Graph_SP core, Trees trees, HolaOpts opts, Log
         // Choose a best one.
         TreePlacement_SP best = nullptr;
         ProjSeq_SP ps = nullptr;
+        // Cost estimates are kept by the placements until we move on to the next
+        // tree, so retrying after an infeasible placement only has to compare them.
         while (!tps.empty()) {
-            best = chooseBestPlacement(tps, opts);
-            // Project, making room for the tree node.
-            ps = best->buildBestProjSeq(padding, opts.expansion_doCostlierDimensionFirst, opts.expansion_estimateMethod);
-            if (ps == nullptr) {
-                // Best placement had no feasible projection sequence.
-                // Delete it from `tps`, and try next best.
-                tps.erase(std::remove(tps.begin(), tps.end(), best), tps.end());
-            } else {
-                break;
-            }
+            // Take the next best placements, in order, and try to build projection
+            // sequences for them, making room for the tree node.
+            TreePlacements next = takeBestPlacements(tps, opts, opts.treePlacement_concurrentExpansions);
+            ps = buildFirstFeasibleProjSeq(*faceset, next, padding, opts, best);
+            if (ps != nullptr) break;
         }
         if (ps == nullptr) {
             // No placement had a feasible projection sequence.
@@ -109,6 +164,15 @@ FaceSet_SP dialect::reattachTrees(Graph_SP core, Trees trees, HolaOpts opts, Log
     return faceset;
 }
 
+// Estimate the costs of the given placements on up to threadCount threads.
+// Estimation only reads the Face and its Graph, apart from building temporary
+// tree box Nodes, whose IDs are drawn atomically.
+static void estimateCostsConcurrently(const TreePlacements &tps, unsigned threadCount) {
+    cola::parallelFor(tps.size(), threadCount, [&](size_t i) {
+        tps[i]->estimateCost();
+    });
+}
+
 TreePlacement_SP dialect::chooseBestPlacement(TreePlacements tps, HolaOpts opts) {
     TreePlacement_SP bestPlacement = nullptr;
 
@@ -171,6 +235,9 @@ TreePlacement_SP dialect::chooseBestPlacement(TreePlacements tps, HolaOpts opts)
     // If we still haven't chosen a best placement, then we finally come to the case in which we must
     // estimate the cost of each remaining potential placement. Then we choose a cheapest one.
     if (bestPlacement == nullptr) {
+        // Estimates are kept by the placements, so when we are called again after the
+        // best one turned out to be infeasible, only new ones need to be computed.
+        estimateCostsConcurrently(tps, opts.treePlacement_concurrentEstimates);
         double minCost = std::numeric_limits<double>::max();
         for (TreePlacement_SP tp : tps) {
             double cost = tp->estimateCost();
@@ -210,8 +277,11 @@ size_t TreePlacement::getNumPotentialNbrs(void) {
 }
 
 double TreePlacement::estimateCost(void) {
-    ExpansionManager em(shared_from_this());
-    m_cost = em.estimateCost();
+    if (!m_costEstimated) {
+        ExpansionManager em(shared_from_this());
+        m_cost = em.estimateCost();
+        m_costEstimated = true;
+    }
     return m_cost;
 }
 
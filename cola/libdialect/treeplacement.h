@@ -72,8 +72,27 @@ public:
           m_growthDir(dg),
           m_flip(flip),
           m_cost(0),
+          m_costEstimated(false),
           m_boxNode(nullptr) {}
 
+    //! @brief  Construct a placement like a given one, into a copy of its Face.
+    //! @param[in] tp  The TreePlacement to be copied.
+    //! @param[in] face  The copy of its Face.
+    //! @param[in] faceRoot  The copy of its root Node.
+    //! @sa FaceSet::isolatedCopy.
+    TreePlacement(const TreePlacement &tp, Face &face, Node_SP faceRoot)
+        : m_ID(nextID++),
+          m_tree(tp.m_tree),
+          m_face(face),
+          m_faceRoot(faceRoot),
+          m_placementDir(tp.m_placementDir),
+          m_growthDir(tp.m_growthDir),
+          m_flip(tp.m_flip),
+          m_cost(0),
+          m_costEstimated(false),
+          m_boxNode(nullptr),
+          m_rootAligns(tp.m_rootAligns) {}
+
     //! @brief  Get the placement direction.
     CompassDir getPlacementDir(void) const { return m_placementDir; }
 
@@ -93,6 +112,10 @@ public:
     size_t getNumPotentialNbrs(void);
 
     //! @brief  Estimate the cost of this placement.
+    //!
+    //! The estimate is computed on the first call and then reused, so it should
+    //! not be relied upon after the layout has changed, e.g. after a tree has
+    //! been inserted. (Placements are listed afresh for each tree anyway.)
     double estimateCost(void);
 
     //! @brief  Get the Node at which the Tree would be rooted:
@@ -209,6 +232,8 @@ private:
 
     //! An estimated cost of this placement:
     double m_cost;
+    //! Whether m_cost has been computed yet:
+    bool m_costEstimated;
     //! A node to represent the bounding box of the Tree:
     Node_SP m_boxNode = nullptr;
 
@@ -100,6 +100,12 @@ private:
  * refinement after blocks are moved.  This version is preferred if you are 
  * using VPSC in an interactive context.
  *
+ * The block structure is kept between calls to satisfy() or solve(), so
+ * after changing the desiredPosition of some variables, or adding or 
+ * removing constraints, calling them again warm-starts from the previous
+ * solution rather than solving the problem from scratch.  To change the
+ * gap of a constraint, remove it and add it again.
+ *
  * @sa Solver
  */
 class IncSolver : public Solver {
@@ -116,6 +122,16 @@ public:
     //!
     //! @param constraint The new additional constraint to add. 
     void addConstraint(Constraint *constraint);
+	//! @brief  Removes a constraint from the existing VPSC solver.
+	//!
+	//! If the constraint is active, the block containing it is split, so
+	//! the next call to satisfy() or solve() only has to rearrange the
+	//! two resulting blocks.  The caller remains responsible for removing
+	//! the constraint from the list passed to the constructor and for
+	//! freeing it.
+	//!
+	//! @param constraint The constraint to remove.
+	void removeConstraint(Constraint *constraint);
 private:
 	void moveBlocks();
 	void splitBlocks();
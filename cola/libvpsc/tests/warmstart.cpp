@@ -0,0 +1,163 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libvpsc - A solver for the problem of Variable Placement with
+ *           Separation Constraints.
+ *
+ * Copyright (C) 2005-2008  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+// Checks that an IncSolver kept between solves, while desired positions
+// are changed and constraints are added and removed, gives the same
+// solutions as solving each problem from scratch.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "libvpsc/variable.h"
+#include "libvpsc/constraint.h"
+#include "libvpsc/rectangle.h"
+#include "libvpsc/solve_VPSC.h"
+using namespace std;
+using namespace vpsc;
+
+static inline double getRand(const int range) {
+    return (double)range*rand()/(RAND_MAX+1.0);
+}
+
+static inline bool approxEquals(const double a, const double b) {
+    return fabs(a-b)<0.01;
+}
+
+// The same problem held twice, once for a solver that is kept between
+// solves and once for solving from scratch.
+struct Problem {
+    Variables vs[2];
+    Constraints cs[2];
+
+    ~Problem() {
+        for(int p=0;p<2;p++) {
+            for_each(vs[p].begin(),vs[p].end(),delete_object());
+            for_each(cs[p].begin(),cs[p].end(),delete_object());
+        }
+    }
+    void addVariable(double desiredPos) {
+        for(int p=0;p<2;p++) {
+            vs[p].push_back(new Variable(vs[p].size(),desiredPos,1));
+        }
+    }
+    // Adds a random constraint from a lower to a higher indexed variable,
+    // so the constraint graph stays acyclic.
+    void addConstraint(IncSolver *solver) {
+        unsigned l=getRand(vs[0].size()-1);
+        unsigned r=l+1+getRand(vs[0].size()-l-1);
+        double gap=getRand(4);
+        for(int p=0;p<2;p++) {
+            cs[p].push_back(new Constraint(vs[p][l],vs[p][r],gap));
+        }
+        if(solver) {
+            solver->addConstraint(cs[0].back());
+        }
+    }
+    void removeConstraint(IncSolver *solver, unsigned index) {
+        solver->removeConstraint(cs[0][index]);
+        for(int p=0;p<2;p++) {
+            delete cs[p][index];
+            cs[p].erase(cs[p].begin()+index);
+        }
+    }
+    void setDesiredPosition(unsigned index, double desiredPos) {
+        for(int p=0;p<2;p++) {
+            vs[p][index]->desiredPosition=desiredPos;
+        }
+    }
+    // Solves the warm-started problem with the given solver and the other
+    // from scratch, and checks they agree.
+    void solveAndCompare(IncSolver *solver) {
+        solver->solve();
+        IncSolver fresh(vs[1],cs[1]);
+        fresh.solve();
+        for(unsigned i=0;i<vs[0].size();i++) {
+            assert(approxEquals(vs[0][i]->finalPosition,
+                        vs[1][i]->finalPosition));
+        }
+        for(unsigned i=0;i<cs[0].size();i++) {
+            Constraint *c=cs[0][i];
+            assert(c->right->finalPosition-c->left->finalPosition
+                    >= c->gap-0.0001);
+        }
+    }
+    unsigned activeConstraintIndex() const {
+        for(unsigned i=0;i<cs[0].size();i++) {
+            if(cs[0][i]->active) {
+                return i;
+            }
+        }
+        return cs[0].size();
+    }
+};
+
+void test(unsigned seed) {
+    srand(seed);
+    const unsigned n=40;
+    Problem p;
+    for(unsigned i=0;i<n;i++) {
+        p.addVariable(getRand(50));
+    }
+    for(unsigned i=0;i<2*n;i++) {
+        p.addConstraint(nullptr);
+    }
+    IncSolver solver(p.vs[0],p.cs[0]);
+    p.solveAndCompare(&solver);
+    for(unsigned step=0;step<20;step++) {
+        // Move a few variables.
+        for(unsigned i=0;i<3;i++) {
+            p.setDesiredPosition(getRand(n),getRand(50));
+        }
+        p.solveAndCompare(&solver);
+
+        // Add some constraints.
+        for(unsigned i=0;i<3;i++) {
+            p.addConstraint(&solver);
+        }
+        p.solveAndCompare(&solver);
+
+        // Remove an active constraint, splitting its block, and another
+        // at random.
+        unsigned active=p.activeConstraintIndex();
+        if(active<p.cs[0].size()) {
+            p.removeConstraint(&solver,active);
+        }
+        p.removeConstraint(&solver,getRand(p.cs[0].size()));
+        p.solveAndCompare(&solver);
+    }
+}
+
+int main() {
+    cout << "Warm start test..." << endl;
+    for(unsigned seed=1;seed<=10;seed++) {
+        test(seed);
+    }
+    cout << "Warm start test... Success!" << endl;
+    return 0;
+}